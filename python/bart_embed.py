@@ -0,0 +1,171 @@
+# Copyright 2026. Institute for Biomedical Imaging. TU Graz.
+# All rights reserved. Use of this source code is governed by
+# a BSD-style license which can be found in the LICENSE file.
+#
+# In-process interface to BART. Commands run in the calling process
+# by calling bart_command() in libbart.so (make shared-lib). Arrays are
+# passed as in-memory CFLs (.mem) without copying.
+#
+# Ownership:
+#  - Inputs are registered as non-managed in-memory CFLs. NumPy arrays
+#    which are complex64 and Fortran-ordered are used directly, all other
+#    arrays are converted (copied) first. They must not be modified
+#    while the command runs.
+#  - Outputs are created by BART and detached after the command, i.e.
+#    the returned NumPy arrays own the memory and free it when they are
+#    garbage collected.
+#
+# The GIL is released while a command runs, so that several commands can
+# run concurrently from Python threads. Looping (bart -l/-p), streams,
+# and MPI should not be used concurrently. Errors are reported as
+# exceptions, except for errors inside OpenMP parallel regions, which
+# terminate the Python process.
+
+import ctypes
+import itertools
+import os
+import weakref
+
+import numpy as np
+
+_DIMS = 16
+
+_lib = None
+_counter = itertools.count()
+
+
+def _find_library():
+
+    path = os.environ.get('BART_LIBRARY')
+
+    if path:
+        return path
+
+    for var in ['BART_TOOLBOX_PATH', 'TOOLBOX_PATH']:
+
+        tpath = os.environ.get(var)
+
+        if tpath and os.path.isfile(os.path.join(tpath, 'libbart.so')):
+            return os.path.join(tpath, 'libbart.so')
+
+    return 'libbart.so'
+
+
+def _load():
+    global _lib
+
+    if _lib is not None:
+        return _lib
+
+    # ctypes releases the GIL during calls into the library
+    lib = ctypes.CDLL(_find_library())
+
+    lib.bart_command.argtypes = [ctypes.c_int, ctypes.c_char_p, ctypes.c_int, ctypes.POINTER(ctypes.c_char_p)]
+    lib.bart_command.restype = ctypes.c_int
+
+    lib.register_mem_cfl_non_managed.argtypes = [ctypes.c_char_p, ctypes.c_uint, ctypes.POINTER(ctypes.c_long), ctypes.c_void_p]
+    lib.register_mem_cfl_non_managed.restype = None
+
+    lib.detach_mem_cfl.argtypes = [ctypes.c_char_p, ctypes.c_uint, ctypes.POINTER(ctypes.c_long)]
+    lib.detach_mem_cfl.restype = ctypes.c_void_p
+
+    lib.unregister_mem_cfl.argtypes = [ctypes.c_char_p]
+    lib.unregister_mem_cfl.restype = None
+
+    lib.xfree.argtypes = [ctypes.c_void_p]
+    lib.xfree.restype = None
+
+    _lib = lib
+
+    return lib
+
+
+def _register(lib, name, array):
+
+    array = np.asfortranarray(array, dtype=np.complex64)
+
+    if array.ndim > _DIMS:
+        raise ValueError(f"Too many dimensions: {array.ndim}")
+
+    dims = (ctypes.c_long * _DIMS)(*(list(array.shape) + [1] * (_DIMS - array.ndim)))
+
+    lib.register_mem_cfl_non_managed(name.encode(), _DIMS, dims, array.ctypes.data)
+
+    return array
+
+
+def _detach(lib, name):
+
+    dims = (ctypes.c_long * _DIMS)()
+
+    ptr = lib.detach_mem_cfl(name.encode(), _DIMS, dims)
+
+    if not ptr:
+        return None
+
+    dims = list(dims)
+    n = int(np.prod(dims))
+
+    buf = (ctypes.c_char * (n * np.dtype(np.complex64).itemsize)).from_address(ptr)
+    weakref.finalize(buf, lib.xfree, ptr)
+
+    # remove singleton dimensions from the end (as cfl.readcfl)
+    dims = dims[:np.searchsorted(np.cumprod(dims), n) + 1]
+
+    return np.frombuffer(buf, dtype=np.complex64).reshape(dims, order='F')
+
+
+def bart(nargout, cmd, *args, **kwargs):
+
+    if type(nargout) != int or nargout < 0:
+        print("Usage: bart(<nargout>, <command>, <arguments...>)")
+        return
+
+    lib = _load()
+
+    name = f"py{os.getpid()}_{next(_counter)}_"
+
+    infiles = [name + 'in' + str(idx) + '.mem' for idx in range(len(args))]
+    infiles_kw = [name + 'in' + kw + '.mem' for kw in kwargs]
+    outfiles = [name + 'out' + str(idx) + '.mem' for idx in range(nargout)]
+
+    args_kw = [("--" if len(kw) > 1 else "-") + kw for kw in kwargs]
+    args_infiles_kw = [item for pair in zip(args_kw, infiles_kw) for item in pair]
+
+    argv = ['bart', *[item for item in cmd.split(" ") if len(item)], *args_infiles_kw, *infiles, *outfiles]
+    argv = (ctypes.c_char_p * (len(argv) + 1))(*[a.encode() for a in argv], None)
+
+    out = ctypes.create_string_buffer(1 << 16)
+
+    # keep (converted) inputs alive until the command has finished
+    arrays = [_register(lib, f, a) for f, a in zip(infiles + infiles_kw, [*args, *kwargs.values()])]
+
+    try:
+        ERR = lib.bart_command(len(out), out, len(argv) - 1, argv)
+
+    finally:
+        for f in infiles + infiles_kw:
+            lib.unregister_mem_cfl(f.encode())
+
+    del arrays
+
+    output = [_detach(lib, f) for f in outfiles]
+
+    stdout = out.value.decode(errors='replace')
+
+    if len(stdout):
+        print(stdout, end="")
+
+    # as in bart.py (not meaningful when called from several threads)
+    bart.ERR, bart.stdout = ERR, stdout
+
+    if ERR:
+        print(f"Command exited with error code {ERR}.")
+        return
+
+    if nargout == 0:
+        return
+    elif nargout == 1:
+        return output[0]
+    else:
+        return output
@@ -0,0 +1,111 @@
+#!/bin/bash
+# Copyright 2026. Institute of Biomedical Imaging. TU Graz.
+# All rights reserved. Use of this source code is governed by
+# a BSD-style license which can be found in the LICENSE file.
+#
+# Strong scaling of pics --mpi over MPI ranks and OpenMP threads
+#
+set -e
+
+helpstr=$(cat <<- EOF
+Runs the same reconstruction (as in tests/pics-mpi.mk, but larger)
+with an increasing number of MPI ranks and threads per rank and
+prints run time, speedup, and NRMSE to the single-process result.
+
+-r ranks	list of MPI ranks (default: "1 2 4")
+-t threads	list of threads per rank (default: "1")
+-s size		image size (default: 256)
+-c coils	number of coils (default: 8)
+-i iter		iterations (default: 30)
+-h help
+EOF
+)
+
+usage="Usage: $0 [-h] [-r ranks] [-t threads] [-s size] [-c coils] [-i iter]"
+
+RANKS="1 2 4"
+THREADS="1"
+SIZE=256
+COILS=8
+ITER=30
+
+while getopts "hr:t:s:c:i:" opt; do
+	case $opt in
+	h)
+		echo "$usage"
+		echo
+		echo "$helpstr"
+		exit 0
+	;;
+	r)
+		RANKS="$OPTARG"
+	;;
+	t)
+		THREADS="$OPTARG"
+	;;
+	s)
+		SIZE=$OPTARG
+	;;
+	c)
+		COILS=$OPTARG
+	;;
+	i)
+		ITER=$OPTARG
+	;;
+	\?)
+		echo "$usage" >&2
+		exit 1
+	;;
+	esac
+done
+
+if [ ! -e "$BART_TOOLBOX_PATH"/bart ] ; then
+	if [ -e "$TOOLBOX_PATH"/bart ] ; then
+		BART_TOOLBOX_PATH="$TOOLBOX_PATH"
+	else
+		echo "\$BART_TOOLBOX_PATH is not set correctly!" >&2
+		exit 1
+	fi
+fi
+
+BART="$BART_TOOLBOX_PATH"/bart
+
+WORKDIR=`mktemp -d 2>/dev/null || mktemp -d -t 'mytmpdir'`
+trap 'rm -rf "$WORKDIR"' EXIT
+cd $WORKDIR
+
+# only cfl files can be distributed
+
+(
+$BART phantom -x$SIZE -k -s$COILS ksp
+$BART phantom -x$SIZE -S$COILS sens
+$BART poisson -Y$SIZE -Z$SIZE -y2 -z2 -v -e pat
+$BART transpose 0 2 pat pat2
+$BART fmac ksp pat2 ksp_us
+
+$BART pics -S -i$ITER -r0.001 ksp_us sens reco_ref
+) > /dev/null
+
+printf "%6s %8s %10s %8s %10s\n" ranks threads time speedup nrmse
+
+T0=""
+
+for t in $THREADS ; do
+	for r in $RANKS ; do
+
+		start=$(date +%s.%N)
+
+		if [ 1 -eq $r ] ; then
+			OMP_NUM_THREADS=$t $BART pics -S -i$ITER -r0.001 ksp_us sens reco > /dev/null
+		else
+			OMP_NUM_THREADS=$t mpirun -n $r --bind-to none $BART pics --mpi=8 -S -i$ITER -r0.001 ksp_us sens reco > /dev/null
+		fi
+
+		end=$(date +%s.%N)
+
+		T=$(awk "BEGIN { print $end - $start }")
+		T0=${T0:-$T}
+
+		printf "%6d %8d %10.2f %8.2f %10s\n" $r $t $T $(awk "BEGIN { print $T0 / $T }") $($BART nrmse reco_ref reco)
+	done
+done
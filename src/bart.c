@@ -7,6 +7,7 @@
  */
 
 #include <stdlib.h>
+#include <stdbool.h>
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
@@ -29,6 +30,7 @@
 #include "misc/debug.h"
 #include "misc/cppmap.h"
 #include "misc/stream.h"
+#include "misc/opcache.h"
 
 #include "num/mpi_ops.h"
 #include "num/multind.h"
@@ -63,18 +65,18 @@
 #define DIMS 16
 #endif
 
-extern FILE* bart_output;	// src/misc.c
+extern _Thread_local FILE* bart_output;	// src/misc.c
 
+// number of bart_command() calls running concurrently
+static int bart_active = 0;
 
-static void bart_exit_cleanup(void)
-{
-	if (NULL != command_line)
-		XFREE(command_line);
-
-	io_memory_cleanup();
 
+static void bart_cleanup_shared(void)
+{
 	opt_free_strdup();
 
+	opcache_clear();
+
 	stream_unmap_all();
 
 #ifdef FFTWTHREADS
@@ -88,6 +90,27 @@ static void bart_exit_cleanup(void)
 #endif
 }
 
+
+static void bart_exit_cleanup(bool release)
+{
+	if (NULL != command_line)
+		XFREE(command_line);
+
+	io_memory_cleanup();
+
+	// the remaining state is shared with other running commands,
+	// the counter is only changed inside this critical section
+
+#pragma omp critical (bart_active)
+	{
+		if (release)
+			bart_active--;
+
+		if (0 == bart_active)
+			bart_cleanup_shared();
+	}
+}
+
 typedef int (main_fun_t)(int argc, char* argv[]);
 
 struct {
@@ -300,6 +323,13 @@ static void parse_bart_opts(int* argcp, char*** argvp, int order[DIMS], stream_t
 		}
 	}
 
+	// With MPI, loop iterations are distributed over the ranks and only
+	// the main thread communicates. The ranks keep their OpenMP threads
+	// for the compute kernels (see init_mpi).
+
+	if (1 < mpi_get_num_procs())
+		omp_threads = 1;
+
 #ifdef _OPENMP
 	if (0 == omp_threads) {
 
@@ -313,9 +343,6 @@ static void parse_bart_opts(int* argcp, char*** argvp, int order[DIMS], stream_t
 	omp_threads = MAX(omp_threads, 1);
 	omp_threads = MIN(omp_threads, md_calc_size(DIMS, loop_dims));
 
-	if (1 < mpi_get_num_procs())
-		omp_threads = 1;
-
 	init_cfl_loop_desc(DIMS, loop_dims, offs_size, flags, omp_threads, 0);
 }
 
@@ -540,7 +567,7 @@ int main_bart(int argc, char* argv[argc])
 		}
 
 		deinit_mpi();
-		bart_exit_cleanup();
+		bart_exit_cleanup(false);
 
 		return final_ret;
 
@@ -624,6 +651,9 @@ int bart_command(int len, char* buf, int argc, char* argv[])
 {
 	int save = debug_level;
 
+#pragma omp critical (bart_active)
+	bart_active++;
+
 	if (NULL != buf) {
 
 		buf[0] = '\0';
@@ -632,7 +662,7 @@ int bart_command(int len, char* buf, int argc, char* argv[])
 
 	int ret = error_catcher(main_bart, argc, argv);
 
-	bart_exit_cleanup();
+	bart_exit_cleanup(true);
 
 	debug_level = save;
 
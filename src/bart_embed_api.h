@@ -83,6 +83,34 @@ extern "C" {
       *  end with the '.mem' extension will be unreachable by user code
       */
      void register_mem_cfl_non_managed(const char* name, unsigned int D, const long dims[], void* ptr);
+
+     //! Remove some in-memory CFL from the list and return its data
+     /*!
+      *  This is used to retrieve outputs without copying them.
+      *  If the data was managed by BART (e.g. the output of a command), the
+      *  caller takes *ownership* and has to free it using free(...)
+      *
+      *  \param name       Name used to refer to in-memory CFL
+      *  \param D          Size of the dimensions array (should be < 16)
+      *  \param dimensions Array holding the dimensions of the data
+      *                    (will get modified)
+      *
+      *  \return Pointer to the data or NULL if no matching in-memory CFL file
+      *  was found
+      *
+      *  \warning The in-memory CFL must not be in use by a running command
+      */
+     void* detach_mem_cfl(const char* name, unsigned int D, long dimensions[]);
+
+     //! Remove some in-memory CFL from the list
+     /*!
+      *  Data managed by BART is freed, non-managed data is left alone.
+      *
+      *  \param name       Name used to refer to in-memory CFL
+      *
+      *  \warning The in-memory CFL must not be in use by a running command
+      */
+     void unregister_mem_cfl(const char* name);
      
      //! BART's main function
      /*!
@@ -105,6 +133,14 @@ extern "C" {
       *  \param argc Same as for the main function
       *  \param argv Same as for the main function
       *
+      *  \note Several commands may run concurrently from different threads
+      *  as long as they use distinct in-memory CFLs. Looping (-l/-p),
+      *  streams, and MPI are not supported for concurrent commands.
+      *
+      *  \note Errors are caught per calling thread. An error raised inside
+      *  an OpenMP parallel region of a command cannot be caught and
+      *  terminates the process.
+      *
       *  \warning Be aware that if MEMONLY_CFL is not defined, names that do not
       *  end with the '.mem' extension will be unreachable by user code
       */
@@ -113,8 +149,9 @@ extern "C" {
      //! Deallocate any memory CFLs
      /*!
       * \note It is safe to call this function multiple times.
+      * In-memory CFLs in use by a running command are kept.
       */
-     void deallocate_all_mem_cfl();
+     void deallocate_all_mem_cfl(void);
 #ifdef __cplusplus
 }
 #endif
@@ -22,11 +22,17 @@
 #include "num/ops_p.h"
 #include "num/mdfft.h"
 #include "num/fft.h"
+#include "num/convcorr.h"
 #include "num/ode.h"
 #include "num/filter.h"
+#include "num/wavelet.h"
 
 #include "wavelet/wavthresh.h"
 
+#include "linops/linop.h"
+
+#include "noncart/nufft.h"
+
 #include "misc/debug.h"
 #include "misc/misc.h"
 #include "misc/mmio.h"
@@ -35,6 +41,9 @@
 #define DIMS 8
 
 
+// floating point operations of the last benchmark run (if known)
+static double bench_flops = 0.;
+
 
 
 static double bench_generic_copy(long dims[DIMS])
@@ -89,6 +98,7 @@ static double bench_generic_matrix_multiply(long dims[DIMS])
 
 	double toc = timestamp();
 
+	bench_flops = 8. * md_calc_size(DIMS, dims);
 
 	md_free(x);
 	md_free(y);
@@ -98,6 +108,39 @@ static double bench_generic_matrix_multiply(long dims[DIMS])
 }
 
 
+static double bench_generic_contraction(long dims[DIMS], unsigned long oflags, unsigned long flags1, unsigned long flags2)
+{
+	long odims[DIMS];
+	long idims1[DIMS];
+	long idims2[DIMS];
+
+	md_select_dims(DIMS, oflags, odims, dims);
+	md_select_dims(DIMS, flags1, idims1, dims);
+	md_select_dims(DIMS, flags2, idims2, dims);
+
+	complex float* out = md_alloc(DIMS, odims, CFL_SIZE);
+	complex float* in1 = md_alloc(DIMS, idims1, CFL_SIZE);
+	complex float* in2 = md_alloc(DIMS, idims2, CFL_SIZE);
+
+	md_gaussian_rand(DIMS, idims1, in1);
+	md_gaussian_rand(DIMS, idims2, in2);
+
+	double tic = timestamp();
+
+	md_ztenmul(DIMS, odims, out, idims1, in1, idims2, in2);
+
+	double toc = timestamp();
+
+	bench_flops = 8. * md_calc_size(DIMS, dims);
+
+	md_free(out);
+	md_free(in1);
+	md_free(in2);
+
+	return toc - tic;
+}
+
+
 static double bench_generic_add(long dims[DIMS], unsigned long flags, bool forloop)
 {
 	long dimsX[DIMS];
@@ -248,6 +291,38 @@ static double bench_tall_matmul2(long scale)
 }
 
 
+static double bench_coilcomp(long scale)
+{
+	// x y z coils vcoils
+	long dims[DIMS] = { 128 * scale, 128, 1, 16, 8, 1, 1, 1 };
+	return bench_generic_contraction(dims, 1 + 2 + 16, 1 + 2 + 8, 8 + 16);
+}
+
+
+static double bench_coilcomp_frames(long scale)
+{
+	// x frames y coils vcoils, frame-wise compression matrices
+	long dims[DIMS] = { 64 * scale, 16, 64, 16, 8, 1, 1, 1 };
+	return bench_generic_contraction(dims, 1 + 2 + 4 + 16, 1 + 2 + 4 + 8, 2 + 8 + 16);
+}
+
+
+static double bench_subspace(long scale)
+{
+	// x y coils ... time coeff
+	long dims[DIMS] = { 64 * scale, 64, 8, 1, 1, 100, 4, 1 };
+	return bench_generic_contraction(dims, 1 + 2 + 4 + 32, 1 + 2 + 4 + 64, 32 + 64);
+}
+
+
+static double bench_subspace_adj(long scale)
+{
+	// x y coils ... time coeff
+	long dims[DIMS] = { 64 * scale, 64, 8, 1, 1, 100, 4, 1 };
+	return bench_generic_contraction(dims, 1 + 2 + 4 + 64, 1 + 2 + 4 + 32, 32 + 64);
+}
+
+
 static double bench_add(long scale)
 {
 	long dims[DIMS] = { 65536 * scale, 1, 50 * scale, 1, 1, 1, 1, 1 };
@@ -454,6 +529,26 @@ static double bench_wavelet(long scale)
 }
 
 
+static double bench_cdf97(long scale)
+{
+	long dims[DIMS] = { 256 * scale, 256 * scale, 1, 16, 1, 1, 1, 1 };
+
+	complex float* x = md_alloc(DIMS, dims, CFL_SIZE);
+	md_gaussian_rand(DIMS, dims, x);
+
+	double tic = timestamp();
+
+	md_cdf97z(DIMS, dims, 3, x);
+	md_icdf97z(DIMS, dims, 3, x);
+
+	double toc = timestamp();
+
+	md_free(x);
+
+	return toc - tic;
+}
+
+
 static double bench_generic_mdfft(long dims[DIMS], unsigned long flags)
 {
 	complex float* x = md_alloc(DIMS, dims, CFL_SIZE);
@@ -539,6 +634,75 @@ static double bench_fftmod(long scale)
 }
 
 
+static double bench_generic_conv(long scale, long C, long X, long Y, long Z, long K)
+{
+	long kx = K;
+	long ky = K;
+	long kz = (1 < Z) ? K : 1;
+
+	long odims[DIMS] = { C, 1, X * scale, Y * scale, Z, 1, 1, 1 };
+	long idims[DIMS] = { 1, C, X * scale + kx - 1, Y * scale + ky - 1, Z + kz - 1, 1, 1, 1 };
+	long kdims[DIMS] = { C, C, kx, ky, kz, 1, 1, 1 };
+
+	complex float* out = md_alloc(DIMS, odims, CFL_SIZE);
+	complex float* in = md_alloc(DIMS, idims, CFL_SIZE);
+	complex float* krn = md_alloc(DIMS, kdims, CFL_SIZE);
+
+	md_gaussian_rand(DIMS, idims, in);
+	md_gaussian_rand(DIMS, kdims, krn);
+
+	// as in nlops/conv.c
+
+	long mdims[2 * DIMS];
+	long ostrs2[2 * DIMS];
+	long kstrs2[2 * DIMS];
+	long istrs2[2 * DIMS];
+
+	calc_convcorr_geom(DIMS, 28UL, mdims, ostrs2, kstrs2, istrs2,
+			   odims, MD_STRIDES(DIMS, odims, CFL_SIZE),
+			   kdims, MD_STRIDES(DIMS, kdims, CFL_SIZE),
+			   idims, MD_STRIDES(DIMS, idims, CFL_SIZE), false);
+
+	md_clear(DIMS, odims, out, CFL_SIZE);
+
+	double tic = timestamp();
+
+	md_zfmac2(2 * DIMS, mdims, ostrs2, out, istrs2, in, kstrs2, krn);
+
+	double toc = timestamp();
+
+	bench_flops = 8. * md_calc_size(DIMS, odims) * C * kx * ky * kz;
+
+	md_free(out);
+	md_free(in);
+	md_free(krn);
+
+	return toc - tic;
+}
+
+
+static double bench_conv3x3(long scale)
+{
+	return bench_generic_conv(scale, 32, 128, 128, 1, 3);
+}
+
+static double bench_conv7x7(long scale)
+{
+	return bench_generic_conv(scale, 8, 128, 128, 1, 7);
+}
+
+static double bench_conv5x5x5(long scale)
+{
+	return bench_generic_conv(scale, 8, 32, 32, 32, 5);
+}
+
+static double bench_conv31x31(long scale)
+{
+	return bench_generic_conv(scale, 4, 128, 128, 1, 31);
+}
+
+
+
 enum bench_typ { BENCH_ZFILL, BENCH_ZSMUL, BENCH_LINPHASE };
 
 static double bench_generic_expand(enum bench_typ typ, long scale)
@@ -595,6 +759,128 @@ static double bench_linphase(long scale)
 
 
 
+static double bench_generic_median(long scale, bool geom)
+{
+	// as in the filter command: window of 15 along time
+
+	enum { L = 15 };
+
+	long dims[DIMS] = { 64, 64, 1, 1, 1, 1, 1, 1 };
+	dims[5] = 100 * scale + L - 1;
+
+	long wdims[DIMS + 1];
+	md_copy_dims(DIMS, wdims, dims);
+	wdims[5] = dims[5] - L + 1;
+	wdims[DIMS] = L;
+
+	long istrs[DIMS + 1];
+	md_calc_strides(DIMS, istrs, dims, CFL_SIZE);
+	istrs[DIMS] = istrs[5];
+
+	long odims[DIMS + 1];
+	md_copy_dims(DIMS, odims, wdims);
+	odims[DIMS] = 1;
+
+	long ostrs[DIMS + 1];
+	md_calc_strides(DIMS + 1, ostrs, odims, CFL_SIZE);
+
+	complex float* in = md_alloc(DIMS, dims, CFL_SIZE);
+	complex float* out = md_alloc(DIMS + 1, odims, CFL_SIZE);
+
+	md_gaussian_rand(DIMS, dims, in);
+
+	double tic = timestamp();
+
+	(geom ? md_geometric_medianz2 : md_medianz2)(DIMS + 1, DIMS, wdims, ostrs, out, istrs, in);
+
+	double toc = timestamp();
+
+	md_free(in);
+	md_free(out);
+
+	return toc - tic;
+}
+
+static double bench_median(long scale)
+{
+	return bench_generic_median(scale, false);
+}
+
+static double bench_geometric_median(long scale)
+{
+	return bench_generic_median(scale, true);
+}
+
+
+
+static double bench_generic_nufft_update(long scale, bool partial)
+{
+	// radial trajectory with twofold oversampled readout and Toeplitz
+	// embedding; shift part or all of the spokes as in a delay correction
+
+	enum { X = 128, R = 2 * X, S = 201 };
+
+	long ksp_dims[DIMS] = { 1, R, S * scale, 1, 1, 1, 1, 1 };
+	long cim_dims[DIMS] = { X, X, 1, 1, 1, 1, 1, 1 };
+	long trj_dims[DIMS] = { 3, R, S * scale, 1, 1, 1, 1, 1 };
+
+	complex float* traj = md_alloc(DIMS, trj_dims, CFL_SIZE);
+	complex float* traj2 = md_alloc(DIMS, trj_dims, CFL_SIZE);
+
+	for (int s = 0; s < trj_dims[2]; s++) {
+
+		float angle = s * M_PI / ((1. + sqrt(5.)) / 2.);
+
+		for (int r = 0; r < R; r++) {
+
+			float k = (r - R / 2) * 0.5;
+			complex float* t = traj + 3 * (s * R + r);
+			complex float* t2 = traj2 + 3 * (s * R + r);
+
+			t[0] = k * cosf(angle);
+			t[1] = k * sinf(angle);
+			t[2] = 0.;
+
+			float d = (!partial || (0 == s % 16)) ? 0.1 : 0.;
+
+			t2[0] = (k + d) * cosf(angle);
+			t2[1] = (k + d) * sinf(angle);
+			t2[2] = 0.;
+		}
+	}
+
+	struct nufft_conf_s conf = nufft_conf_defaults;
+	conf.toeplitz = true;
+	conf.cache_psf_grdding = true;
+
+	const struct linop_s* op = nufft_create2(DIMS, ksp_dims, cim_dims, trj_dims, traj, NULL, NULL, NULL, NULL, conf);
+
+	double tic = timestamp();
+
+	nufft_update_traj(op, DIMS, trj_dims, traj2, NULL, NULL, NULL, NULL);
+
+	double toc = timestamp();
+
+	linop_free(op);
+
+	md_free(traj);
+	md_free(traj2);
+
+	return toc - tic;
+}
+
+static double bench_nufft_update(long scale)
+{
+	return bench_generic_nufft_update(scale, false);
+}
+
+static double bench_nufft_update_partial(long scale)
+{
+	return bench_generic_nufft_update(scale, true);
+}
+
+
+
 static double bench_ode(long scale)
 {
 	float mat[2][2] = { { 0., +1. }, { -1., 0. } };
@@ -630,6 +916,8 @@ static void do_test(const long dims[BENCH_DIMS], complex float* out, long scale,
 	double min = 1.E10;
 	double max = 0.;
 
+	bench_flops = 0.;
+
 	for (int i = 0; i < N; i++) {
 
 		double dt = fun(scale);
@@ -644,7 +932,12 @@ static void do_test(const long dims[BENCH_DIMS], complex float* out, long scale,
 		out[i] = dt;
 	}
 
-	printf(" | Avg: %3.4f Max: %3.4f Min: %3.4f\n", (float)(sum / N), max, min); 
+	printf(" | Avg: %3.4f Max: %3.4f Min: %3.4f", (float)(sum / N), max, min); 
+
+	if (0. < bench_flops)
+		printf(" | %3.2f GFLOP/s", bench_flops / min * 1.E-9);
+
+	printf("\n");
 }
 
 
@@ -683,6 +976,19 @@ const struct benchmark_s {
 	{ bench_fft,		"FFT" },
 	{ bench_fftmod,		"fftmod" },
 	{ bench_ode,		"ODE" },
+	{ bench_cdf97,		"cdf97 wavelet" },
+	{ bench_coilcomp,	"coil compression" },
+	{ bench_coilcomp_frames,	"coil compression (frames)" },
+	{ bench_subspace,	"subspace projection" },
+	{ bench_subspace_adj,	"subspace projection (adj)" },
+	{ bench_conv3x3,	"convolution 3x3" },
+	{ bench_conv7x7,	"convolution 7x7" },
+	{ bench_conv5x5x5,	"convolution 5x5x5" },
+	{ bench_conv31x31,	"convolution 31x31" },
+	{ bench_median,		"median filter (sliding)" },
+	{ bench_geometric_median,	"geom. median filter (sliding)" },
+	{ bench_nufft_update,	"NUFFT update traj." },
+	{ bench_nufft_update_partial,	"NUFFT update traj. (partial)" },
 };
 
 
@@ -702,12 +1008,14 @@ int main_bench(int argc, char* argv[argc])
 	bool threads = false;
 	bool scaling = false;
 	unsigned long flags = ~0UL;
+	bool autotune = false;
 
 	const struct opt_s opts[] = {
 
 		OPT_SET('T', &threads, "varying number of threads"),
 		OPT_SET('S', &scaling, "varying problem size"),
 		OPT_ULONG('s', &flags, "flags", "select benchmarks"),
+		OPT_SET('C', &autotune, "autotune convolutions and print the selected algorithms"),
 	};
 
 	cmdline(&argc, argv, ARRAY_SIZE(args), args, help_str, ARRAY_SIZE(opts), opts);
@@ -728,6 +1036,9 @@ int main_bench(int argc, char* argv[argc])
 
 	num_init();
 
+	if (autotune)
+		use_convcorr_autotune = true;
+
 	md_clear(BENCH_DIMS, dims, out, CFL_SIZE);
 
 	do {
@@ -745,6 +1056,9 @@ int main_bench(int argc, char* argv[argc])
 
 	} while (md_next(BENCH_DIMS, dims, ~MD_BIT(REPETITION_IND), pos));
 
+	if (autotune)
+		zconvcorr_print_algo_selection(DP_INFO);
+
 	unmap_cfl(BENCH_DIMS, dims, out);
 
 	return 0;
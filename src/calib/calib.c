@@ -32,6 +32,7 @@
 #include "num/flpmath.h"
 #include "num/linalg.h"
 #include "num/lapack.h"
+#include "num/blas.h"
 #include "num/casorati.h"
 #include "num/rand.h"
 
@@ -64,7 +65,7 @@
 #endif
 
 
-static void eigen_herm3(int M, int N, float val[M], complex float matrix[N][N], int num_orthiter) // ordering might be different to herm2
+static void eigen_herm3(int M, int N, float val[M], complex float matrix[N][N], int num_orthiter, const complex float* init) // ordering might be different to herm2
 {
 	complex float mout[M][N];
 
@@ -72,8 +73,18 @@ static void eigen_herm3(int M, int N, float val[M], complex float matrix[N][N],
 		for (int lj = 0; lj < li; lj++)
 			matrix[lj][li] = conj(matrix[li][lj]);
 
-	//mat_identity(M, N, mout);
-	orthiter(M, N, num_orthiter, val, mout, matrix);
+	if (NULL == init) {
+
+		mat_identity(M, N, mout);
+
+	} else {
+
+		for (int i = 0; i < M; i++)
+			for (int j = 0; j < N; j++)
+				mout[i][j] = init[i * N + j];
+	}
+
+	orthiter_noinit(M, N, num_orthiter, val, mout, matrix);
 
 	for (int i = 0; i < M; i++)
 		for (int j = 0; j < N; j++)
@@ -82,6 +93,58 @@ static void eigen_herm3(int M, int N, float val[M], complex float matrix[N][N],
 
 
 
+/* State carried from one frame of a series to the next.
+ *
+ * For dynamic or multi-slice data the null-space of the calibration
+ * matrix and the point-wise eigenvectors change only slowly. We keep
+ * the signal subspace of the previous frame (with some margin) and
+ * the eigenvectors of the previous maps and use them as initial guess
+ * for a few subspace iterations instead of decomposing from scratch.
+ */
+struct calib_warmstart {
+
+	long N;
+	long P;
+	complex float* kernels;		// [P][N]
+
+	long evec_dims[5];		// x, y, z, channels, maps
+	complex float* evecs;		// [z][y][x][maps][channels]
+};
+
+#define WARM_KERNEL_ITER 3
+#define WARM_ORTHITER 10
+#define WARM_MARGIN 8
+#define RAND_KERNEL_ITER 10
+
+struct calib_warmstart* calib_warmstart_create(void)
+{
+	PTR_ALLOC(struct calib_warmstart, ws);
+
+	ws->N = 0;
+	ws->P = 0;
+	ws->kernels = NULL;
+
+	for (int i = 0; i < 5; i++)
+		ws->evec_dims[i] = 0;
+
+	ws->evecs = NULL;
+
+	return PTR_PASS(ws);
+}
+
+void calib_warmstart_free(struct calib_warmstart* ws)
+{
+	xfree(ws->kernels);
+	xfree(ws->evecs);
+	xfree(ws);
+}
+
+
+static void compute_kernels2(const struct ecalib_conf* conf, struct calib_warmstart* ws, long nskerns_dims[5], complex float** nskerns_ptr, int SN, float val[SN], const long caldims[DIMS], const complex float* caldata);
+
+
+
+
 static void md_scurve(int N, const long dims[N], float* dst, const float* src)
 {
 	float* tmp1 = md_alloc_sameplace(N, dims, FL_SIZE, src);
@@ -377,14 +440,14 @@ static float sure_crop(float var, const long evec_dims[DIMS], complex float* eve
 
 
 
-void calone(const struct ecalib_conf* conf, const long cov_dims[4], complex float* imgcov, int SN, float svals[SN], const long calreg_dims[DIMS], const complex float* data)
+static void calone2(const struct ecalib_conf* conf, struct calib_warmstart* ws, const long cov_dims[4], complex float* imgcov, int SN, float svals[SN], const long calreg_dims[DIMS], const complex float* data)
 {
 	assert(1 == md_calc_size(DIMS - 5, calreg_dims + 5));
 
 #if 1
 	long nskerns_dims[5];
 	complex float* nskerns;
-	compute_kernels(conf, nskerns_dims, &nskerns, SN, svals, calreg_dims, data);
+	compute_kernels2(conf, ws, nskerns_dims, &nskerns, SN, svals, calreg_dims, data);
 #else
 	long channels = calreg_dims[3];
 
@@ -410,6 +473,11 @@ void calone(const struct ecalib_conf* conf, const long cov_dims[4], complex floa
 	md_free(nskerns);
 }
 
+void calone(const struct ecalib_conf* conf, const long cov_dims[4], complex float* imgcov, int SN, float svals[SN], const long calreg_dims[DIMS], const complex float* data)
+{
+	calone2(conf, NULL, cov_dims, imgcov, SN, svals, calreg_dims, data);
+}
+
 
 
 
@@ -420,7 +488,7 @@ void calone(const struct ecalib_conf* conf, const long cov_dims[4], complex floa
 /* calculate point-wise maps 
  *
  */
-void eigenmaps(const long out_dims[DIMS], complex float* optr, complex float* eptr, const complex float* imgcov2, const long msk_dims[3], const bool* msk, bool orthiter, int num_orthiter, bool ecal_usegpu)
+static void eigenmaps2(const long out_dims[DIMS], complex float* optr, complex float* eptr, const complex float* imgcov2, const long msk_dims[3], const bool* msk, bool orthiter, int num_orthiter, bool ecal_usegpu, struct calib_warmstart* ws)
 {
 #ifdef USE_CUDA
 	if (ecal_usegpu) {
@@ -456,6 +524,29 @@ void eigenmaps(const long out_dims[DIMS], complex float* optr, complex float* ep
 
 	md_clear(5, out_dims, optr, CFL_SIZE);
 
+	// the eigenvectors of the previous frame are only reused
+	// when all of them have been computed
+
+	complex float* wvecs = NULL;
+	bool warm = false;
+
+	if ((NULL != ws) && orthiter && (NULL == msk)) {
+
+		warm = md_check_equal_dims(5, ws->evec_dims, out_dims, ~0UL);
+
+		if (!warm) {
+
+			xfree(ws->evecs);
+			ws->evecs = xmalloc((size_t)md_calc_size(5, out_dims) * CFL_SIZE);
+			md_copy_dims(5, ws->evec_dims, out_dims);
+		}
+
+		wvecs = ws->evecs;
+
+		if (warm)
+			debug_printf(DP_DEBUG1, "Warm-started orthogonal iterations (%d).\n", WARM_ORTHITER);
+	}
+
 #pragma omp parallel for collapse(3)
 	for (int k = 0; k < zz; k++) {
 		for (int j = 0; j < yy; j++) {
@@ -473,11 +564,18 @@ void eigenmaps(const long out_dims[DIMS], complex float* optr, complex float* ep
 
 					unpack_tri_matrix(channels, cov, tmp);
 
-					if (orthiter) 
-						eigen_herm3(maps, channels, val, cov, num_orthiter);
-					else 
+					complex float* wvec = (NULL != wvecs) ? (wvecs + (long)(i + xx * (j + yy * k)) * maps * channels) : NULL;
+
+					if (orthiter)
+						eigen_herm3(maps, channels, val, cov, warm ? WARM_ORTHITER : num_orthiter, warm ? wvec : NULL);
+					else
 						lapack_eig(channels, val, cov);
 
+					if (NULL != wvec)
+						for (int u = 0; u < maps; u++)
+							for (int v = 0; v < channels; v++)
+								wvec[u * channels + v] = cov[u][v];
+
 					for (int u = 0; u < maps; u++) {
 
 						int ru = (orthiter ? maps : channels) - 1 - u;
@@ -494,6 +592,11 @@ void eigenmaps(const long out_dims[DIMS], complex float* optr, complex float* ep
 	}
 }
 
+void eigenmaps(const long out_dims[DIMS], complex float* optr, complex float* eptr, const complex float* imgcov2, const long msk_dims[3], const bool* msk, bool orthiter, int num_orthiter, bool ecal_usegpu)
+{
+	eigenmaps2(out_dims, optr, eptr, imgcov2, msk_dims, msk, orthiter, num_orthiter, ecal_usegpu, NULL);
+}
+
 
 
 
@@ -502,7 +605,7 @@ void eigenmaps(const long out_dims[DIMS], complex float* optr, complex float* ep
 
 
 
-void caltwo(const struct ecalib_conf* conf, const long out_dims[DIMS], complex float* out_data, complex float* emaps, const long in_dims[4], complex float* in_data, const long msk_dims[3], const bool* msk)
+static void caltwo2(const struct ecalib_conf* conf, struct calib_warmstart* ws, const long out_dims[DIMS], complex float* out_data, complex float* emaps, const long in_dims[4], complex float* in_data, const long msk_dims[3], const bool* msk)
 {
 	long xx = out_dims[0];
 	long yy = out_dims[1];
@@ -538,11 +641,16 @@ void caltwo(const struct ecalib_conf* conf, const long out_dims[DIMS], complex f
 
 	debug_printf(DP_DEBUG1, "Point-wise eigen-decomposition...\n");
 
-	eigenmaps(out_dims, out_data, emaps, imgcov2, msk_dims, msk, conf->orthiter, conf->num_orthiter, conf->usegpu);
+	eigenmaps2(out_dims, out_data, emaps, imgcov2, msk_dims, msk, conf->orthiter, conf->num_orthiter, conf->usegpu, ws);
 
 	md_free(imgcov2);
 }
 
+void caltwo(const struct ecalib_conf* conf, const long out_dims[DIMS], complex float* out_data, complex float* emaps, const long in_dims[4], complex float* in_data, const long msk_dims[3], const bool* msk)
+{
+	caltwo2(conf, NULL, out_dims, out_data, emaps, in_dims, in_data, msk_dims, msk);
+}
+
 
 
 
@@ -577,6 +685,8 @@ const struct ecalib_conf ecalib_defaults = {
 	.rotphase = true,
 	.var = -1.,
 	.automate = false,
+	.fft_gram = false,
+	.subspace = 0,
 };
 
 
@@ -584,7 +694,7 @@ const struct ecalib_conf ecalib_defaults = {
 
 
 
-void calib2(const struct ecalib_conf* conf, const long out_dims[DIMS], complex float* out_data, complex float* eptr, int SN, float svals[SN], const long calreg_dims[DIMS], const complex float* data, const long msk_dims[3], const bool* msk)
+void calib3(const struct ecalib_conf* conf, struct calib_warmstart* ws, const long out_dims[DIMS], complex float* out_data, complex float* eptr, int SN, float svals[SN], const long calreg_dims[DIMS], const complex float* data, const long msk_dims[3], const bool* msk)
 {
 	long channels = calreg_dims[3];
 	long maps = out_dims[4];
@@ -619,9 +729,9 @@ void calib2(const struct ecalib_conf* conf, const long out_dims[DIMS], complex f
 
 	complex float* imgcov = md_alloc(4, cov_dims, CFL_SIZE);
 
-	calone(conf, cov_dims, imgcov, SN, svals, calreg_dims, data);
+	calone2(conf, ws, cov_dims, imgcov, SN, svals, calreg_dims, data);
 
-	caltwo(conf, out_dims, out_data, eptr, cov_dims, imgcov, msk_dims, msk);
+	caltwo2(conf, ws, out_dims, out_data, eptr, cov_dims, imgcov, msk_dims, msk);
 
 	/* Intensity and phase normalization similar as proposed
 	 * for adaptive combine (Walsh's method) in
@@ -665,6 +775,11 @@ void calib2(const struct ecalib_conf* conf, const long out_dims[DIMS], complex f
 	md_free(imgcov);
 }
 
+void calib2(const struct ecalib_conf* conf, const long out_dims[DIMS], complex float* out_data, complex float* eptr, int SN, float svals[SN], const long calreg_dims[DIMS], const complex float* data, const long msk_dims[3], const bool* msk)
+{
+	calib3(conf, NULL, out_dims, out_data, eptr, SN, svals, calreg_dims, data, msk_dims, msk);
+}
+
 
 
 void calib(const struct ecalib_conf* conf, const long out_dims[DIMS], complex float* out_data, complex float* eptr, int SN, float svals[SN], const long calreg_dims[DIMS], const complex float* data)
@@ -748,7 +863,113 @@ static long number_of_kernels(const struct ecalib_conf* conf, long N, const floa
 }
 
 
-void compute_kernels(const struct ecalib_conf* conf, long nskerns_dims[5], complex float** nskerns_ptr, int SN, float val[SN], const long caldims[DIMS], const complex float* caldata)
+/* Subspace iteration for the leading eigenvectors of the covariance
+ * matrix followed by a Rayleigh-Ritz step. Produces the same layout
+ * as lapack_eig, i.e. ascending eigenvalues with the eigenvectors in
+ * the rows. Everything outside of the subspace is set to zero.
+ */
+static void subspace_eig(long N, long P, int iter, complex float sub[P][N], float val[N], complex float cov[N][N])
+{
+	PTR_ALLOC(complex float[P][N], tmp);
+
+	float nrm[P];
+
+	for (int it = 0; it < iter; it++) {
+
+		blas_matrix_multiply(N, P, N, *tmp, cov, sub);
+		mat_copy(P, N, sub, *tmp);
+		gram_schmidt(P, N, nrm, sub);
+	}
+
+	PTR_ALLOC(complex float[N][P], adj);
+	PTR_ALLOC(complex float[P][P], red);
+
+	blas_matrix_multiply(N, P, N, *tmp, cov, sub);
+	mat_adjoint(P, N, *adj, sub);
+	blas_matrix_multiply(P, P, N, *red, *adj, *tmp);
+
+	float rval[P];
+	lapack_eig(P, rval, *red);
+
+	blas_matrix_multiply(N, P, P, *tmp, sub, *red);
+
+	for (long i = 0; i < N - P; i++) {
+
+		val[i] = 0.;
+
+		for (long j = 0; j < N; j++)
+			cov[i][j] = 0.;
+	}
+
+	for (long i = 0; i < P; i++) {
+
+		val[N - P + i] = rval[i];
+
+		for (long j = 0; j < N; j++)
+			cov[N - P + i][j] = (*tmp)[i][j];
+	}
+
+	PTR_FREE(tmp);
+	PTR_FREE(adj);
+	PTR_FREE(red);
+}
+
+
+// started from the kernels of the previous frame
+
+static bool warm_eig(const struct calib_warmstart* ws, long N, float val[N], complex float cov[N][N])
+{
+	if ((NULL == ws) || (NULL == ws->kernels) || (N != ws->N))
+		return false;
+
+	long P = ws->P;
+
+	debug_printf(DP_DEBUG1, "Warm-started subspace iteration... (size: %ld/%ld)\n", P, N);
+
+	PTR_ALLOC(complex float[P][N], sub);
+
+	mat_copy(P, N, *sub, (const complex float (*)[N])ws->kernels);
+
+	subspace_eig(N, P, WARM_KERNEL_ITER, *sub, val, cov);
+
+	PTR_FREE(sub);
+
+	return true;
+}
+
+
+/* Randomized partial eigen decomposition: subspace iteration
+ * started from a Gaussian random matrix. Only the leading P
+ * eigenvalues are computed, which is sufficient unless the
+ * complete spectrum is needed (soft-weighting).
+ */
+static void rand_eig(long N, long P, float val[N], complex float cov[N][N])
+{
+	debug_printf(DP_DEBUG1, "Randomized subspace iteration... (size: %ld/%ld)\n", P, N);
+
+	PTR_ALLOC(complex float[P][N], sub);
+
+	gaussian_rand_vec(2 * P * N, (float*)*sub);
+
+	float nrm[P];
+	gram_schmidt(P, N, nrm, *sub);
+
+	subspace_eig(N, P, RAND_KERNEL_ITER, *sub, val, cov);
+
+	PTR_FREE(sub);
+}
+
+
+static void calib_gram(const struct ecalib_conf* conf, long N, complex float cov[N][N], const long caldims[DIMS], const complex float* caldata)
+{
+	if (conf->fft_gram)
+		covariance_function_fft(conf->kdims, N, cov, caldims, caldata);
+	else
+		covariance_function(conf->kdims, N, cov, caldims, caldata);
+}
+
+
+static void compute_kernels2(const struct ecalib_conf* conf, struct calib_warmstart* ws, long nskerns_dims[5], complex float** nskerns_ptr, int SN, float val[SN], const long caldims[DIMS], const complex float* caldata)
 {
 	assert(1 == md_calc_size(DIMS - 5, caldims + 5));
 
@@ -772,6 +993,8 @@ void compute_kernels(const struct ecalib_conf* conf, long nskerns_dims[5], compl
 
 	debug_printf(DP_DEBUG1, "Build calibration matrix and SVD...\n");
 
+	long n = -1;
+
 #ifdef CALMAT_SVD
 	calmat_svd(conf->kdims, N, *vec, val, caldims, caldata);
 
@@ -786,19 +1009,70 @@ void compute_kernels(const struct ecalib_conf* conf, long nskerns_dims[5], compl
 			nskerns[i * N + j] = ((*vec)[j][N - 1 - i]) * (conf->weighting ? val[N - 1 - i] : 1.);
 #endif
 #else
-	covariance_function(conf->kdims, N, *vec, caldims, caldata);
+	// soft-weighting needs the complete spectrum
+
+	if (conf->weighting)
+		ws = NULL;
 
-	debug_printf(DP_DEBUG1, "Eigen decomposition... (size: %ld)\n", N);
+	calib_gram(conf, N, *vec, caldims, caldata);
 
-	// we could apply Nystroem method here to speed it up
+	long P_rand = (conf->weighting || (0 >= conf->subspace)) ? N : MIN(N, conf->subspace);
 
 	float tmp_val[N];
-	lapack_eig(N, tmp_val, *vec);
+	bool warm = warm_eig(ws, N, tmp_val, *vec);
+
+again:
+	if (!warm) {
+
+		if (P_rand < N) {
+
+			rand_eig(N, P_rand, tmp_val, *vec);
+
+		} else {
+
+			debug_printf(DP_DEBUG1, "Eigen decomposition... (size: %ld)\n", N);
+
+			lapack_eig(N, tmp_val, *vec);
+		}
+	}
 
 	// reverse and square root, test for smaller null to avoid NaNs
 	for (int i = 0; i < N; i++)
 		val[i] = (tmp_val[N - 1 - i] < 0.) ? 0. : sqrtf(tmp_val[N - 1 - i]);
 
+	if ((P_rand < N) && (number_of_kernels(conf, N, val) >= P_rand))
+		debug_printf(DP_WARN, "Signal subspace might be larger than the computed subspace (%ld).\n", P_rand);
+
+	if (NULL != ws) {
+
+		n = number_of_kernels(conf, N, val);
+		long P = MIN(P_rand, n + 2 * MAX(n / 4, (long)WARM_MARGIN));
+
+		if (warm && (n + MAX(n / 4, (long)WARM_MARGIN) > ws->P)) {
+
+			// signal subspace has grown, start over
+
+			debug_printf(DP_DEBUG1, "Subspace too small.\n");
+
+			calib_gram(conf, N, *vec, caldims, caldata);
+			warm = false;
+
+			goto again;
+		}
+
+		if (!warm) {
+
+			xfree(ws->kernels);
+			ws->kernels = xmalloc((size_t)(P * N) * CFL_SIZE);
+			ws->N = N;
+			ws->P = P;
+		}
+
+		for (long i = 0; i < ws->P; i++)
+			for (long j = 0; j < N; j++)
+				ws->kernels[i * N + j] = (*vec)[N - 1 - i][j];
+	}
+
 	if (conf->weighting)
 		soft_weight_singular_vectors(N, conf-> var, conf->kdims, caldims, val, val);
 
@@ -818,7 +1092,7 @@ void compute_kernels(const struct ecalib_conf* conf, long nskerns_dims[5], compl
 	}
 
 #ifndef FLIP
-	nskerns_dims[4] = number_of_kernels(conf, N, val);
+	nskerns_dims[4] = (-1 != n) ? n : number_of_kernels(conf, N, val);
 #else
 	nskerns_dims[4] = N - number_of_kernels(conf, N, val);
 #endif
@@ -826,6 +1100,11 @@ void compute_kernels(const struct ecalib_conf* conf, long nskerns_dims[5], compl
 	PTR_FREE(vec);
 }
 
+void compute_kernels(const struct ecalib_conf* conf, long nskerns_dims[5], complex float** nskerns_ptr, int SN, float val[SN], const long caldims[DIMS], const complex float* caldata)
+{
+	compute_kernels2(conf, NULL, nskerns_dims, nskerns_ptr, SN, val, caldims, caldata);
+}
+
 
 
 
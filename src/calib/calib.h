@@ -26,6 +26,8 @@ struct ecalib_conf {
 	_Bool rotphase;
 	float var;
 	_Bool automate;
+	_Bool fft_gram;
+	int subspace;
 };
 
 extern const struct ecalib_conf ecalib_defaults;
@@ -33,6 +35,12 @@ extern const struct ecalib_conf ecalib_defaults;
 extern void calib(const struct ecalib_conf* conf, const long out_dims[DIMS], _Complex float* out_data, _Complex float* eptr, 
 			int SN, float svals[__VLA2(SN)], const long calreg_dims[DIMS], const _Complex float* calreg_data);
 
+struct calib_warmstart;
+extern struct calib_warmstart* calib_warmstart_create(void);
+extern void calib_warmstart_free(struct calib_warmstart* ws);
+
+extern void calib3(const struct ecalib_conf* conf, struct calib_warmstart* ws, const long out_dims[DIMS], _Complex float* out_data, _Complex float* eptr, int SN, float svals[__VLA2(SN)], const long calreg_dims[DIMS], const _Complex float* data, const long msk_dims[3], const _Bool* msk);
+
 extern void calib2(const struct ecalib_conf* conf, const long out_dims[DIMS], _Complex float* out_data, _Complex float* eptr, int SN, float svals[__VLA2(SN)], const long calreg_dims[DIMS], const _Complex float* data, const long msk_dims[3], const _Bool* msk);
 
 extern void eigenmaps(const long out_dims[DIMS], _Complex float* out_data, _Complex float* eptr, const _Complex float* imgcov, const long msk_dims[3], const _Bool* msk, _Bool orthiter, int num_orthiter, _Bool usegpu);
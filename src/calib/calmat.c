@@ -11,6 +11,8 @@
 
 #include "num/multind.h"
 #include "num/flpmath.h"
+#include "num/fft.h"
+#include "num/ops.h"
 #include "num/casorati.h"
 #include "num/lapack.h"
 #include "num/linalg.h"
@@ -176,6 +178,100 @@ void covariance_function(const long kdims[3], int N, complex float cov[N][N], co
 
 
 
+/**
+ * Gram matrix A^H A of the calibration matrix A computed from
+ * FFT-based cross-correlations of the calibration data, without
+ * forming A. For a kernel position k1 and channel c1, the row of
+ * A^H A is the correlation of all channels with the data of c1
+ * restricted to the patch positions seen by k1:
+ *
+ * cov[k1, c1][k2, c2] = sum_p conj(x_c1(p + k1)) x_c2(p + k2)
+ *
+ * As k2 + p never leaves the calibration region, circular
+ * correlation without zero-padding is exact. Memory is
+ * O(calreg * channels) instead of O(calreg * N).
+ */
+void covariance_function_fft(const long kdims[3], int N, complex float cov[N][N], const long calreg_dims[4], const complex float* data)
+{
+	long C = calreg_dims[3];
+	long K = md_calc_size(3, kdims);
+
+	assert(N == K * C);
+
+	long img_dims[4];
+	md_select_dims(4, 7, img_dims, calreg_dims);
+
+	long win_dims[4];
+
+	for (int i = 0; i < 3; i++)
+		win_dims[i] = calreg_dims[i] - kdims[i] + 1;
+
+	win_dims[3] = C;
+
+	long strs[4];
+	long img_strs[4];
+	md_calc_strides(4, strs, calreg_dims, CFL_SIZE);
+	md_calc_strides(4, img_strs, img_dims, CFL_SIZE);
+
+	complex float* xf = md_alloc(4, calreg_dims, CFL_SIZE);
+	complex float* yf = md_alloc(4, calreg_dims, CFL_SIZE);
+	complex float* zf = md_alloc(4, calreg_dims, CFL_SIZE);
+
+	const struct operator_s* fwd = fft_create(4, calreg_dims, 7, yf, yf, false);
+	const struct operator_s* bwd = fft_create(4, calreg_dims, 7, zf, zf, true);
+
+	// plans are in-place
+
+	md_copy(4, calreg_dims, xf, data, CFL_SIZE);
+	fft_exec(fwd, xf, xf);
+
+	float scale = 1. / md_calc_size(3, calreg_dims);
+
+	long k1[3] = { };
+
+	do {
+		long pos[4] = { k1[0], k1[1], k1[2], 0 };
+
+		md_clear(4, calreg_dims, yf, CFL_SIZE);
+		md_copy2(4, win_dims, strs, &MD_ACCESS(4, strs, pos, yf), strs, &MD_ACCESS(4, strs, pos, data), CFL_SIZE);
+		fft_exec(fwd, yf, yf);
+
+		long k1i = (k1[2] * kdims[1] + k1[1]) * kdims[0] + k1[0];
+
+		for (long c1 = 0; c1 < C; c1++) {
+
+			md_zmulc2(4, calreg_dims, strs, zf, strs, xf, img_strs, yf + c1 * md_calc_size(3, calreg_dims));
+			fft_exec(bwd, zf, zf);
+
+			long k2[3] = { };
+
+			do {
+				long d[3];
+
+				for (int i = 0; i < 3; i++)
+					d[i] = (k2[i] - k1[i] + calreg_dims[i]) % calreg_dims[i];
+
+				long k2i = (k2[2] * kdims[1] + k2[1]) * kdims[0] + k2[0];
+				long di = (d[2] * calreg_dims[1] + d[1]) * calreg_dims[0] + d[0];
+
+				for (long c2 = 0; c2 < C; c2++)
+					cov[k1i + K * c1][k2i + K * c2] = scale * zf[di + c2 * md_calc_size(3, calreg_dims)];
+
+			} while (md_next(3, kdims, 7, k2));
+		}
+
+	} while (md_next(3, kdims, 7, k1));
+
+	operator_free(fwd);
+	operator_free(bwd);
+
+	md_free(xf);
+	md_free(yf);
+	md_free(zf);
+}
+
+
+
 void calmat_svd(const long kdims[3], int N, complex float cov[N][N], float* S, const long calreg_dims[4], const complex float* data)
 {
 	long calmat_dims[2];
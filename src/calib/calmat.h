@@ -9,6 +9,7 @@ extern complex float* calibration_matrix_mask2(long calmat_dims[2], const long k
 
 #ifndef __cplusplus
 extern void covariance_function(const long kdims[3], int N, complex float cov[static N][N], const long calreg_dims[4], const complex float* data);
+extern void covariance_function_fft(const long kdims[3], int N, complex float cov[static N][N], const long calreg_dims[4], const complex float* data);
 extern void calmat_svd(const long kdims[3], int N, complex float cov[static N][N], float* S, const long calreg_dims[4], const complex float* data);
 #endif
 
@@ -242,64 +242,193 @@ void grog_calib(int D, const long lnG_dims[D], complex float* lnG, const long td
 }
 
 
-static void apply_Gshift(int D, const long dims[D], complex float* data,
-		complex float* lnG_axis, float shift[3])
+// Build ln(G) for the shift of a sample as linear combination of the axis operators
+static void shift_lnG(int C, complex float lnG[C][C], const complex float* lnG_axis, const float shift[3])
 {
-	int C = dims[COIL_DIM];
+	for (int i = 0; i < C; i++)
+		for (int j = 0; j < C; j++)
+			lnG[i][j] = 0.;
 
-	assert(1 == dims[READ_DIM]);
-	assert(1 == dims[MAPS_DIM]);
+	for (int d = 0; d < 3; d++) { // dimension
 
-	long single_lnG_dims[D];
-	md_singleton_dims(D, single_lnG_dims);
+		if (0. == shift[d])
+			continue;
 
-	single_lnG_dims[COIL_DIM] = C;
-	single_lnG_dims[MAPS_DIM] = C;
+		for (int i = 0; i < C; i++)
+			for (int j = 0; j < C; j++)
+				lnG[i][j] += lnG_axis[(i * C + j) * 3 + d] * shift[d];
+	}
+}
 
-	long dimsT[D];
-	md_transpose_dims(D, COIL_DIM, MAPS_DIM, dimsT, dims);
 
-	complex float* tmp = md_alloc(D, dims, CFL_SIZE); //for tenmul operation
+// Apply G = exp(ln(G)) to a single coil vector
+static void apply_Gshift(int C, complex float out[C], const complex float in[C], const complex float* lnG_axis, const float shift[3])
+{
+	if ((0. == shift[0]) && (0. == shift[1]) && (0. == shift[2])) {
+
+		for (int i = 0; i < C; i++)
+			out[i] = in[i];
+
+		return;
+	}
 
 	complex float lnG[C][C];
+	shift_lnG(C, lnG, lnG_axis, shift);
 
-	for (int i = 0; i < C; i++)
-		for (int j = 0; j < C; j++)
-			lnG[i][j] = 0.;
+	// integrate d/dt x = ln(G) x instead of computing G
 
-	// Find shift operator for the specific sampling point (d, r, s)
+	zmat_expv(C, 1., out, lnG, in);
+}
 
-	for (int d = 0; d < 3; d++) { // dimension
 
-		if (0. == shift[d])
+/*
+ * Table of shift operators G(s) = exp(sum_d s_d ln(G_d)) on the grid of
+ * quantized shifts s_d = (off_d + k_d) / Q. In between, the operators are
+ * interpolated multilinearly. Axes without any shift have a single entry.
+ */
+struct grog_table_s {
+
+	int C;
+	long Q;
+	long off[3];
+	long K[3];
+	complex float* G;
+};
+
+
+static void grog_table_init(struct grog_table_s* tab, int C, long Q, long S, const float (*shift)[3], const complex float* lnG_axis)
+{
+	tab->C = C;
+	tab->Q = Q;
+
+	for (int d = 0; d < 3; d++) {
+
+		float min = 0.;
+		float max = 0.;
+
+		for (long i = 0; i < S; i++) {
+
+			min = MIN(min, shift[i][d]);
+			max = MAX(max, shift[i][d]);
+		}
+
+		tab->off[d] = (long)floorf(min * Q);
+		tab->K[d] = (long)ceilf(max * Q) - tab->off[d] + 1;
+	}
+
+	long N = tab->K[0] * tab->K[1] * tab->K[2];
+
+	debug_printf(DP_DEBUG2, "GROG table: %ldx%ldx%ld entries\n", tab->K[0], tab->K[1], tab->K[2]);
+
+	tab->G = xmalloc((size_t)(N * C * C) * sizeof(complex float));
+
+#pragma omp parallel for
+	for (long k = 0; k < N; k++) {
+
+		complex float (*G)[C] = (complex float (*)[C])(tab->G + k * C * C);
+
+		float s[3];
+		long kk = k;
+
+		for (int d = 0; d < 3; d++) {
+
+			s[d] = (float)(tab->off[d] + kk % tab->K[d]) / (float)Q;
+			kk /= tab->K[d];
+		}
+
+		if ((0. == s[0]) && (0. == s[1]) && (0. == s[2])) {
+
+			for (int i = 0; i < C; i++)
+				for (int j = 0; j < C; j++)
+					G[i][j] = (i == j) ? 1. : 0.;
+
 			continue;
+		}
 
+		complex float lnG[C][C];
+		shift_lnG(C, lnG, lnG_axis, s);
 
-		for (int i = 0; i < C; i++)
-			for (int j = 0; j < C; j++)
-				lnG[i][j] += lnG_axis[(i * C + j) * 3 + d] * shift[d];
+		// G[i] = exp(ln(G)) e_i
+
+		zmat_exp(C, 1., G, lnG);
 	}
+}
 
-	// Matrix exponential to find operator G from ln(G)
 
-	complex float G_shift[C][C];
-	zmat_exp(C, 1., G_shift, lnG);
+static void grog_table_free(struct grog_table_s* tab)
+{
+	xfree(tab->G);
+}
 
-	// Transform data with calculated shift operator
 
-	md_transpose(D, COIL_DIM, MAPS_DIM, dimsT, tmp, dims, data, CFL_SIZE);
-	md_ztenmul(D, dims, data, single_lnG_dims, &G_shift[0][0], dimsT, tmp);
+// out += scale G^T x with G stored as in zmat_exp
+static void grog_matvec(int C, complex float out[C], float scale, const complex float G[C][C], const complex float x[C])
+{
+	for (int i = 0; i < C; i++) {
 
-	md_free(tmp);
+		complex float xi = scale * x[i];
+
+		for (int j = 0; j < C; j++)
+			out[j] += G[i][j] * xi;
+	}
 }
 
 
+// Apply the shift operator interpolated from the neighboring table entries
+static void apply_Gshift_table(const struct grog_table_s* tab, complex float out[tab->C], const complex float in[tab->C], const float shift[3])
+{
+	int C = tab->C;
+
+	long k[3];
+	float t[3];
+
+	for (int d = 0; d < 3; d++) {
+
+		k[d] = 0;
+		t[d] = 0.;
+
+		if (1 == tab->K[d])
+			continue;
+
+		float pos = shift[d] * tab->Q - tab->off[d];
+
+		k[d] = MIN(MAX(0, (long)floorf(pos)), tab->K[d] - 2);
+		t[d] = pos - k[d];
+	}
+
+	for (int i = 0; i < C; i++)
+		out[i] = 0.;
+
+	for (int c = 0; c < 8; c++) {
+
+		float w = 1.;
+		long idx = 0;
+		long str = 1;
+
+		for (int d = 0; d < 3; d++) {
+
+			int u = (c >> d) & 1;
+
+			w *= u ? t[d] : (1. - t[d]);
+			idx += (k[d] + u) * str;
+			str *= tab->K[d];
+		}
+
+		if (0. == w)
+			continue;
+
+		grog_matvec(C, out, w, (const complex float (*)[C])(tab->G + idx * C * C), in);
+	}
+}
 
 
 // Gridding, following Eq. 2
+//
+// If table_size > 0, shift operators are precomputed on a grid with
+// table_size steps per unit shift and interpolated.
 void grog_grid(int D, const long tdims[D], const complex float* traj_shift,
 		const long ddims[D], complex float* data_grid, const complex float* data,
-		const long lnG_dims[D], complex float* lnG)
+		const long lnG_dims[D], complex float* lnG, long table_size)
 {
 	assert(3 == tdims[READ_DIM]);
 	assert(!md_check_dimensions(D, tdims, READ_FLAG|PHS1_FLAG|PHS2_FLAG));
@@ -313,44 +442,70 @@ void grog_grid(int D, const long tdims[D], const complex float* traj_shift,
 	assert(C == lnG_dims[MAPS_DIM]);
 	assert(3L * C * C == md_calc_size(D, lnG_dims));
 
-	long tstrs[D];
-	md_calc_strides(D, tstrs, tdims, CFL_SIZE);
+	assert(0 <= table_size);
 
-	long tmp_data_dims[D];
-	md_select_dims(D, ~(PHS1_FLAG|PHS2_FLAG), tmp_data_dims, ddims);
+	long S = ddims[PHS1_DIM] * ddims[PHS2_DIM];
 
-#pragma omp parallel for collapse(2)
-	for (int s = 0; s < ddims[PHS2_DIM]; s++) {		// Spoke
-		for (int r = 0; r < ddims[PHS1_DIM]; r++) {	// Readout sample
+	// shifts of all samples
 
-			long pos[D];
-			for (int i = 0; i < D; i++)
-				pos[i] = 0;
+	float (*shift)[3] = xmalloc((size_t)S * sizeof *shift);
+
+	for (long i = 0; i < S; i++)
+		for (int d = 0; d < 3; d++)
+			shift[i][d] = crealf(traj_shift[i * 3 + d]);
 
-			pos[PHS1_DIM] = r;
-			pos[PHS2_DIM] = s;
+	// reorder data so that coil vectors are contiguous
 
-			// Allocate data of data HERE avoids even more allocations within the most inner dimension-loop
+	long dstrs[D];
+	md_calc_strides(D, dstrs, ddims, CFL_SIZE);
 
-			complex float* tmp_data = md_alloc(D, tmp_data_dims, CFL_SIZE);
+	// data may have further dimensions which share the trajectory
 
-			md_copy_block(D, pos, tmp_data_dims, tmp_data, ddims, data, CFL_SIZE);
+	long E = md_calc_size(D, ddims) / (S * C);
 
-			float shift[3];
+	long cstrs[D];
+	long str = (long)CFL_SIZE;
 
-			for (int d = 0; d < 3; d++)
-				shift[d] = crealf(MD_ACCESS(D, (pos[READ_DIM] = d, pos), tstrs, traj_shift));
+	for (int i = 0; i < D; i++) {
 
-			pos[READ_DIM] = 0;
+		int j = (0 == i) ? COIL_DIM : ((COIL_DIM >= i) ? i - 1 : i);
 
-			apply_Gshift(D, tmp_data_dims, tmp_data, lnG, shift);
+		cstrs[j] = str;
+		str *= ddims[j];
+	}
 
-			md_copy_block(D, pos, ddims, data_grid, tmp_data_dims, tmp_data, CFL_SIZE);
+	complex float* cdata = md_alloc(D, ddims, CFL_SIZE);
 
-			md_free(tmp_data);
-		}
+	md_copy2(D, ddims, cstrs, cdata, dstrs, data, CFL_SIZE);
+
+	struct grog_table_s tab;
+
+	if (0 < table_size)
+		grog_table_init(&tab, C, table_size, S, (const float (*)[3])shift, lnG);
+
+#pragma omp parallel for
+	for (long i = 0; i < S * E; i++) {
+
+		complex float tmp[C];
+		complex float* x = cdata + i * C;
+
+		if (0 < table_size)
+			apply_Gshift_table(&tab, tmp, x, shift[i % S]);
+		else
+			apply_Gshift(C, tmp, x, lnG, shift[i % S]);
+
+		for (int c = 0; c < C; c++)
+			x[c] = tmp[c];
 	}
 
+	md_copy2(D, ddims, dstrs, data_grid, cstrs, cdata, CFL_SIZE);
+
+	if (0 < table_size)
+		grog_table_free(&tab);
+
+	md_free(cdata);
+	xfree(shift);
+
 	debug_printf(DP_DEBUG2, "Finished GROG gridding.\n");
 }
 
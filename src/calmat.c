@@ -23,7 +23,7 @@
 #include "calib/calmat.h"
 
 
-static const char help_str[] = "Compute calibration matrix.";
+static const char help_str[] = "Compute calibration matrix (or its Gram matrix).";
 
 
 
@@ -43,6 +43,7 @@ int main_calmat(int argc, char* argv[argc])
 	long calsize[3] = { 24, 24, 24 };
 	long kdims[3] = { 5, 5, 5 };
 	bool calcen = false;
+	bool gram = false;
 
 	const struct opt_s opts[] = {
 
@@ -51,6 +52,7 @@ int main_calmat(int argc, char* argv[argc])
 		OPT_VEC3('r', &calsize, "cal_size", "Limits the size of the calibration region."),
 		OPT_VEC3('R', &calsize, "", "()"),
 		OPT_SET('C', &calcen, "()"),
+		OPT_SET('G', &gram, "compute Gram matrix A^H A using FFTs (without the calibration matrix)"),
 	};
 
 	cmdline(&argc, argv, ARRAY_SIZE(args), args, help_str, ARRAY_SIZE(opts), opts);
@@ -103,7 +105,22 @@ int main_calmat(int argc, char* argv[argc])
 
 	long calmat_dims[N];
 	md_singleton_dims(N, calmat_dims);
-	complex float* cm = calibration_matrix(calmat_dims, kdims, cal_dims, cal_data);
+
+	complex float* cm = NULL;
+
+	if (gram) {
+
+		calmat_dims[0] = md_calc_size(3, kdims) * cal_dims[COIL_DIM];
+		calmat_dims[1] = calmat_dims[0];
+
+		cm = md_alloc(N, calmat_dims, CFL_SIZE);
+
+		covariance_function_fft(kdims, calmat_dims[0], MD_CAST_ARRAY2(complex float, N, calmat_dims, cm, 0, 1), cal_dims, cal_data);
+
+	} else {
+
+		cm = calibration_matrix(calmat_dims, kdims, cal_dims, cal_data);
+	}
 	md_free(cal_data);
 
 	complex float* out_data = create_cfl(out_file, N, calmat_dims);
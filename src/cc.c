@@ -17,6 +17,7 @@
 #include "misc/misc.h"
 #include "misc/debug.h"
 #include "misc/opts.h"
+#include "misc/stream.h"
 
 #include "num/multind.h"
 #include "num/flpmath.h"
@@ -31,6 +32,49 @@
 static const char help_str[] = "Performs coil compression.";
 
 
+// project one block of k-space onto the first P virtual channels
+
+static void cc_project(bool fft, const long in_dims[DIMS], const long in_strs[DIMS], const complex float* in_data,
+			const long out_strs[DIMS], complex float* out_data, const long mat_dims[DIMS], const complex float* mat)
+{
+	long P = mat_dims[MAPS_DIM];
+
+	long trans_dims[DIMS];
+	md_copy_dims(DIMS, trans_dims, in_dims);
+	trans_dims[COIL_DIM] = P;
+
+	long fake_trans_dims[DIMS];
+	md_select_dims(DIMS, ~COIL_FLAG, fake_trans_dims, in_dims);
+	fake_trans_dims[MAPS_DIM] = P;
+
+	long fake_trans_strs[DIMS];
+	md_transpose_dims(DIMS, COIL_DIM, MAPS_DIM, fake_trans_strs, out_strs);
+
+	complex float* in2_data = NULL;
+	long in2_strs[DIMS];
+
+	if (fft) {
+
+		in2_data = anon_cfl(NULL, DIMS, in_dims);
+		md_calc_strides(DIMS, in2_strs, in_dims, CFL_SIZE);
+
+		ifftuc2(DIMS, in_dims, READ_FLAG, in2_strs, in2_data, in_strs, in_data);
+
+		in_strs = in2_strs;
+		in_data = in2_data;
+	}
+
+	md_zmatmulc2(DIMS, fake_trans_dims, fake_trans_strs, out_data, mat_dims, MD_STRIDES(DIMS, mat_dims, CFL_SIZE), mat, in_dims, in_strs, in_data);
+
+	if (fft) {
+
+		fftuc2(DIMS, trans_dims, READ_FLAG, out_strs, out_data, out_strs, out_data);
+
+		unmap_cfl(DIMS, in_dims, in2_data);
+	}
+}
+
+
 int main_cc(int argc, char* argv[argc])
 {
 	const char* in_file = NULL;
@@ -47,6 +91,7 @@ int main_cc(int argc, char* argv[argc])
 	long P = -1;
 	bool all = false;
 	enum cc_type { SCC, GCC, ECC } cc_type = SCC;
+	unsigned long stream_flags = 0UL;
 
 	const struct opt_s opts[] = {
 
@@ -58,6 +103,7 @@ int main_cc(int argc, char* argv[argc])
 		OPT_SELECT('S', enum cc_type, &cc_type, SCC, "type: SVD"),
 		OPT_SELECT('G', enum cc_type, &cc_type, GCC, "type: Geometric"),
 		OPT_SELECT('E', enum cc_type, &cc_type, ECC, "type: ESPIRiT"),
+		OPTL_ULONG(0, "stream", &stream_flags, "flags", "Loop over <flags> while streaming (calibrate on the first block)."),
 	};
 
 	cmdline(&argc, argv, ARRAY_SIZE(args), args, help_str, ARRAY_SIZE(opts), opts);
@@ -70,13 +116,37 @@ int main_cc(int argc, char* argv[argc])
 		proj = false;
 	}
 
+	bool is_stream = (0 != stream_flags);
+
+	if (is_stream && (SCC != cc_type) && MD_IS_SET(stream_flags, READ_DIM))
+		error("Cannot stream along the readout for geometric or ESPIRiT coil compression.\n");
+
+	if (0 != (stream_flags & (COIL_FLAG | MAPS_FLAG)))
+		error("Cannot stream along coil or maps dimension.\n");
+
 	long in_dims[DIMS];
 
-	complex float* in_data = load_cfl(in_file, DIMS, in_dims);
+	complex float* in_data = (is_stream ? load_async_cfl : load_cfl)(in_file, DIMS, in_dims);
 
 	if (1 != in_dims[MAPS_DIM])
 		error("MAPS dimension must be one");
 
+	stream_t strm_in = stream_lookup(in_data);
+
+	long in_strs[DIMS];
+	md_calc_strides(DIMS, in_strs, in_dims, CFL_SIZE);
+
+	// one block when not streaming
+
+	long blk_dims[DIMS];
+	md_select_dims(DIMS, ~stream_flags, blk_dims, in_dims);
+
+	long pos[DIMS] = { [0 ... DIMS - 1] = 0 };
+
+	if (is_stream && strm_in)
+		stream_sync_slice(strm_in, DIMS, in_dims, stream_flags, pos);
+
+
 	long channels = in_dims[COIL_DIM];
 
 	if (0 == P)
@@ -95,12 +165,18 @@ int main_cc(int argc, char* argv[argc])
 
 	if (all) {
 
-		md_copy_dims(DIMS, caldims, in_dims);
+		md_copy_dims(DIMS, caldims, blk_dims);
 		cal_data = in_data;
 
+		if (is_stream) {
+
+			cal_data = md_alloc(DIMS, caldims, CFL_SIZE);
+			md_copy2(DIMS, caldims, MD_STRIDES(DIMS, caldims, CFL_SIZE), cal_data, in_strs, in_data, CFL_SIZE);
+		}
+
 	} else {
 		
-		cal_data = extract_calib(caldims, calsize, in_dims, in_data, false);
+		cal_data = extract_calib2(caldims, calsize, blk_dims, in_strs, in_data, false);
 	}
 
 	if (0. == md_znorm(DIMS, caldims, cal_data))
@@ -117,7 +193,7 @@ int main_cc(int argc, char* argv[argc])
 	case ECC: ecc(out_dims, out_data, caldims, cal_data); break;
 	}
 
-	if (!all)
+	if (!all || is_stream)
 		md_free(cal_data);
 
 
@@ -129,46 +205,41 @@ int main_cc(int argc, char* argv[argc])
 		md_copy_dims(DIMS, trans_dims, in_dims);
 		trans_dims[COIL_DIM] = P;
 
-		complex float* trans_data = create_cfl(out_file, DIMS, trans_dims);
+		complex float* trans_data = (is_stream ? create_async_cfl(out_file, stream_flags, DIMS, trans_dims) : create_cfl(out_file, DIMS, trans_dims));
 
-		long fake_trans_dims[DIMS];
-		md_select_dims(DIMS, ~COIL_FLAG, fake_trans_dims, in_dims);
-		fake_trans_dims[MAPS_DIM] = P;
+		stream_t strm_out = stream_lookup(trans_data);
+
+		long trans_strs[DIMS];
+		md_calc_strides(DIMS, trans_strs, trans_dims, CFL_SIZE);
 
 		long out2_dims[DIMS];
 		md_copy_dims(DIMS, out2_dims, out_dims);
 		out2_dims[MAPS_DIM] = P;
 
-		if (SCC != cc_type) {
-
-			complex float* in2_data = anon_cfl(NULL, DIMS, in_dims);
-
-			ifftuc(DIMS, in_dims, READ_FLAG, in2_data, in_data);
-
-			unmap_cfl(DIMS, in_dims, in_data);
-			in_data = in2_data;
-
+		complex float* out2 = anon_cfl(NULL, DIMS, out2_dims);
 
-			complex float* out2 = anon_cfl(NULL, DIMS, out2_dims);
-			align_ro(out2_dims, out2, out_data);
+		if (SCC != cc_type)
+			align_ro(out2_dims, out2, out_data);	// sequential alignment along the readout
+		else
+			md_copy_block(DIMS, (long[DIMS]){ }, out2_dims, out2, out_dims, out_data, CFL_SIZE);
 
-			unmap_cfl(DIMS, out_dims, out_data);
-			out_data = out2;
-		}
+		unmap_cfl(DIMS, out_dims, out_data);
 
-		md_zmatmulc(DIMS, fake_trans_dims, trans_data, out2_dims, out_data, in_dims, in_data);
+		// only the compressed channels of each block are written
 
-		if (SCC != cc_type) {
+		do {
+			if (is_stream && strm_in)
+				stream_sync_slice(strm_in, DIMS, in_dims, stream_flags, pos);
 
-			fftuc(DIMS, trans_dims, READ_FLAG, trans_data, trans_data);
+			cc_project(SCC != cc_type, blk_dims, in_strs, &MD_ACCESS(DIMS, in_strs, pos, in_data),
+					trans_strs, &MD_ACCESS(DIMS, trans_strs, pos, trans_data), out2_dims, out2);
 
-			unmap_cfl(DIMS, out2_dims, out_data);
+			if (is_stream && strm_out)
+				stream_sync_slice(strm_out, DIMS, trans_dims, stream_flags, pos);
 
-		} else {
-
-			unmap_cfl(DIMS, out_dims, out_data);
-		}
+		} while (md_next(DIMS, in_dims, stream_flags, pos));
 
+		unmap_cfl(DIMS, out2_dims, out2);
 		unmap_cfl(DIMS, trans_dims, trans_data);
 		unmap_cfl(DIMS, in_dims, in_data);
 
@@ -182,4 +253,3 @@ int main_cc(int argc, char* argv[argc])
 
 	return 0;
 }
-
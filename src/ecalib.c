@@ -42,6 +42,35 @@ static const char help_str[] =
 
 
 
+static complex float* calib_region(long cal_dims[DIMS], const long calsize[3], bool calcen, const long ksp_dims[DIMS], const complex float* in_data)
+{
+	complex float* cal_data = NULL;
+
+	if (!calcen) {
+
+#ifdef USE_CC_EXTRACT_CALIB
+		cal_data = cc_extract_calib(cal_dims, calsize, ksp_dims, in_data);
+#else
+		cal_data = extract_calib(cal_dims, calsize, ksp_dims, in_data, false);
+#endif
+	} else {
+
+		for (int i = 0; i < 3; i++)
+			cal_dims[i] = (calsize[i] < ksp_dims[i]) ? calsize[i] : ksp_dims[i];
+
+		for (int i = 3; i < DIMS; i++)
+			cal_dims[i] = ksp_dims[i];
+
+		cal_data = md_alloc(5, cal_dims, CFL_SIZE);
+
+		md_resize_center(5, cal_dims, cal_data, ksp_dims, in_data, CFL_SIZE);
+	}
+
+	return cal_data;
+}
+
+
+
 int main_ecalib(int argc, char* argv[argc])
 {
 	const char* in_file = NULL;
@@ -60,6 +89,7 @@ int main_ecalib(int argc, char* argv[argc])
 	bool one = false;
 	bool calcen = false;
 	bool print_svals = false;
+	bool warm_start = false;
 
 	struct ecalib_conf conf = ecalib_defaults;
 
@@ -87,6 +117,9 @@ int main_ecalib(int argc, char* argv[argc])
 		OPT_INT('n', &conf.numsv, "", "()"),
 		OPT_FLOAT('v', &conf.var, "variance", "Variance of noise in data."),
 		OPT_SET('a', &conf.automate, "Automatically pick thresholds."),
+		OPTL_SET(0, "warm-start", &warm_start, "initialize calibration of each frame (dims >= 5) with the previous one"),
+		OPTL_SET(0, "fft-gram", &conf.fft_gram, "compute the Gram matrix of the calibration matrix with FFTs"),
+		OPTL_INT(0, "subspace", &conf.subspace, "size", "compute only the leading eigenvectors (randomized subspace iteration)"),
 		OPT_INT('d', &debug_level, "level", "Debug level"),
 	};
 
@@ -124,30 +157,17 @@ int main_ecalib(int argc, char* argv[argc])
 		error("MAPS dimension is not of size one.\n");
 
 
-	long cal_dims[N];
-	complex float* cal_data = NULL;
+	// frames of a dynamic or multi-slice series are calibrated one after another
 
-	if (!calcen) {
+	long frames = md_calc_size(N - 5, ksp_dims + 5);
 
-#ifdef USE_CC_EXTRACT_CALIB
-		cal_data = cc_extract_calib(cal_dims, calsize, ksp_dims, in_data);
-#else
-		cal_data = extract_calib(cal_dims, calsize, ksp_dims, in_data, false);
-#endif
-	} else {
-	
-		for (int i = 0; i < 3; i++)
-			cal_dims[i] = (calsize[i] < ksp_dims[i]) ? calsize[i] : ksp_dims[i];
-
-		for (int i = 3; i < N; i++)
-			cal_dims[i] = ksp_dims[i];
-
-		cal_data = md_alloc(5, cal_dims, CFL_SIZE);
-
-		md_resize_center(5, cal_dims, cal_data, ksp_dims, in_data, CFL_SIZE);
-	 }
+	long ksp1_dims[N];
+	md_select_dims(N, (1UL << 5) - 1, ksp1_dims, ksp_dims);
 
+	long ksp1_size = md_calc_size(N, ksp1_dims);
 
+	long cal_dims[N];
+	complex float* cal_data = calib_region(cal_dims, calsize, calcen, ksp1_dims, in_data);
 
 	 for (int i = 0; i < 3; i++)
 		 if (1 == ksp_dims[i])
@@ -184,6 +204,9 @@ int main_ecalib(int argc, char* argv[argc])
 
 	if (one) {
 
+		if (1 != frames)
+			error("Only a single frame is supported with -1.\n");
+
 #if 0
 		long maps = out_dims[4];
 
@@ -216,7 +239,7 @@ int main_ecalib(int argc, char* argv[argc])
 			out_dims[i] = 1;
 			map_dims[i] = 1;
 
-			if ((i < 3) && (1 < conf.kdims[i])) {
+			if (((i < 3) && (1 < conf.kdims[i])) || (5 <= i)) {
 
 				out_dims[i] = ksp_dims[i];
 				map_dims[i] = ksp_dims[i];
@@ -235,7 +258,34 @@ int main_ecalib(int argc, char* argv[argc])
 		complex float* out_data = create_cfl(out_file, N, out_dims);
 		complex float* emaps = (emaps_file ? create_cfl : anon_cfl)(emaps_file, N, map_dims);
 
-		calib(&conf, out_dims, out_data, emaps, K, svals, cal_dims, cal_data); 
+		long out1_dims[N];
+		long map1_dims[N];
+
+		md_select_dims(N, (1UL << 5) - 1, out1_dims, out_dims);
+		md_select_dims(N, (1UL << 5) - 1, map1_dims, map_dims);
+
+		long out1_size = md_calc_size(N, out1_dims);
+		long map1_size = md_calc_size(N, map1_dims);
+
+		struct calib_warmstart* ws = warm_start ? calib_warmstart_create() : NULL;
+
+		for (long f = 0; f < frames; f++) {
+
+			if (1 < frames)
+				debug_printf(DP_DEBUG1, "Frame %ld/%ld\n", f + 1, frames);
+
+			if (0 < f) {
+
+				md_free(cal_data);
+				cal_data = calib_region(cal_dims, calsize, calcen, ksp1_dims, in_data + f * ksp1_size);
+			}
+
+			calib3(&conf, ws, out1_dims, out_data + f * out1_size, emaps + f * map1_size,
+				K, svals, cal_dims, cal_data, NULL, NULL);
+		}
+
+		if (NULL != ws)
+			calib_warmstart_free(ws);
 
 		unmap_cfl(N, out_dims, out_data);
 		unmap_cfl(N, map_dims, emaps);
@@ -25,6 +25,8 @@ struct iter6_conf_s iter6_conf_unset = {
 	.batchgen_type = BATCH_GEN_SAME,
 	.batch_seed = 123,
 	.dump_flag = 0,
+	.checkpoint_filename = NULL,
+	.checkpoint_mod = 1,
 	.monitor_averaged_objective = false,
 };
 
@@ -42,6 +44,8 @@ struct iter6_conf_s iter6_conf_opts = {
 	.batchgen_type = BATCH_GEN_SAME,
 	.batch_seed = 123,
 	.dump_flag = 0,
+	.checkpoint_filename = NULL,
+	.checkpoint_mod = 1,
 	.monitor_averaged_objective = false,
 };
 
@@ -86,6 +90,9 @@ struct opt_s iter6_opts[] = {
 
 	OPTL_LONG(0, "dump-mod", &(iter6_conf_opts.dump_mod), "mod", "dump weights to file every \"mod\" epochs"),
 
+	OPTL_STRING(0, "checkpoint", &(iter6_conf_opts.checkpoint_filename), "file", "checkpoint training state to file and resume from it"),
+	OPTL_LONG(0, "checkpoint-mod", &(iter6_conf_opts.checkpoint_mod), "mod", "write checkpoint every \"mod\" epochs (default: 1)"),
+
 	OPTL_FLOAT(0, "batchnorm-momentum", &(iter6_conf_opts.batchnorm_momentum), "f", "momentum for batch normalization (default: 0.95)"),
 
 	OPTL_SELECT_DEF(0, "batchgen-same", enum BATCH_GEN_TYPE, &(iter6_conf_opts.batchgen_type), BATCH_GEN_SAME, BATCH_GEN_SAME, "use the same batches in the same order for each epoch"),
@@ -159,6 +166,10 @@ void iter6_copy_config_from_opts(struct iter6_conf_s* result)
 		result->dump_filename = iter6_conf_opts.dump_filename;
 	if (iter6_conf_opts.dump_mod != iter6_conf_unset.dump_mod)
 		result->dump_mod = iter6_conf_opts.dump_mod;
+	if (iter6_conf_opts.checkpoint_filename != iter6_conf_unset.checkpoint_filename)
+		result->checkpoint_filename = iter6_conf_opts.checkpoint_filename;
+	if (iter6_conf_opts.checkpoint_mod != iter6_conf_unset.checkpoint_mod)
+		result->checkpoint_mod = iter6_conf_opts.checkpoint_mod;
 	if (iter6_conf_opts.batchnorm_momentum != iter6_conf_unset.batchnorm_momentum)
 		result->batchnorm_momentum = iter6_conf_opts.batchnorm_momentum;
 	if (iter6_conf_opts.batchgen_type != iter6_conf_unset.batchgen_type)
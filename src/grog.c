@@ -15,7 +15,6 @@
  * (Add DOI here), https://github.com/MagneticResonanceImaging/MRFingerprintingRecon.jl
  *
  * ToDo:
- * - Benchmark and speed up GROG gridding: Allocations and/or matrix exponential increase computational cost markedly
  * - Move SVD based pseudo-inverse from stack to heap -> increase number of spokes for calibration
  */
 
@@ -94,7 +93,7 @@ static void grog_calib2(int calib_spokes, int D, const long lnG_dims[D], complex
 }
 
 
-static void grog_grid2(int D, const long tdims[D], const complex float* traj_shift, const long ddims[D], complex float* data_grid, const complex float* data, const long lnG_dims[D], complex float* lnG)
+static void grog_grid2(int D, const long tdims[D], const complex float* traj_shift, const long ddims[D], complex float* data_grid, const complex float* data, const long lnG_dims[D], complex float* lnG, long table_size)
 {
 	unsigned long tflags = md_nontriv_dims(D, tdims);
 	unsigned long dflags = md_nontriv_dims(D, ddims);
@@ -104,7 +103,7 @@ static void grog_grid2(int D, const long tdims[D], const complex float* traj_shi
 	unsigned long loop_flags = tflags & dflags & ~(PHS1_FLAG|PHS2_FLAG);
 
 	if (0UL == loop_flags)
-		return grog_grid(D, tdims, traj_shift, ddims, data_grid, data, lnG_dims, lnG);
+		return grog_grid(D, tdims, traj_shift, ddims, data_grid, data, lnG_dims, lnG, table_size);
 
 	long tdims1[D];
 	long ddims1[D];
@@ -123,7 +122,7 @@ static void grog_grid2(int D, const long tdims[D], const complex float* traj_shi
 		md_copy_block(D, pos, ddims1, data1, ddims, data, CFL_SIZE);
 		md_copy_block(D, pos, tdims1, shift1, tdims, traj_shift, CFL_SIZE);
 
-		grog_grid(D, tdims1, shift1, ddims1, data_grid1, data1, lnG_dims, lnG);
+		grog_grid(D, tdims1, shift1, ddims1, data_grid1, data1, lnG_dims, lnG, table_size);
 
 		md_copy_block(D, pos, ddims, data_grid, ddims1, data_grid1, CFL_SIZE);
 
@@ -146,6 +145,7 @@ int main_grog(int argc, char* argv[argc])
 	const char* grid_data_file = NULL;
 
 	int calib_spokes = -1;
+	long table_size = 0;
 
 	struct arg_s args[] = {
 
@@ -158,6 +158,7 @@ int main_grog(int argc, char* argv[argc])
 	const struct opt_s opts[] = {
 
 		OPTL_INT('s', "calib-spokes", &calib_spokes, "num", "Number of spokes for GROG calibration"),
+		OPTL_LONG('q', "table", &table_size, "num", "Tabulate shift operators with <num> steps per unit shift (0: exact)"),
 	};
 
 	cmdline(&argc, argv, ARRAY_SIZE(args), args, help_str, ARRAY_SIZE(opts), opts);
@@ -219,7 +220,7 @@ int main_grog(int argc, char* argv[argc])
 
 	md_zsub(DIMS, tdims, shift, traj_grid, traj);
 
-	grog_grid2(DIMS, tdims, shift, ddims, data_grid, data, lnG_dims, lnG);
+	grog_grid2(DIMS, tdims, shift, ddims, data_grid, data, lnG_dims, lnG, table_size);
 
 	md_free(shift);
 
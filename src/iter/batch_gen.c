@@ -20,6 +20,7 @@
 #include "misc/version.h"
 
 #include "iter/iter6.h"
+#include "iter/checkpoint.h"
 
 #include "batch_gen.h"
 
@@ -416,6 +417,28 @@ const struct nlop_s* batch_generator_create2(struct bat_gen_conf_s* config, int
 	return result;
 }
 
+/**
+ * Register the random state and the current permutation
+ * such that training continues with the same batches.
+ */
+void batch_gen_checkpoint(const struct nlop_s* nlop, struct iter_checkpoint_s* cp)
+{
+	if ((NULL == cp) || (NULL == nlop))
+		return;
+
+	auto data = CAST_MAYBE(batch_gen_data_s, nlop_get_data(nlop));
+
+	if (NULL == data) {
+
+		debug_printf(DP_WARN, "Batch generator not checkpointed, batches after resuming differ.\n");
+		return;
+	}
+
+	iter_checkpoint_register(cp, rand_state_size(), data->rand_state);
+	iter_checkpoint_register(cp, data->Nt * (long)sizeof(long), data->perm);
+	iter_checkpoint_register(cp, (long)sizeof(long), &data->start);
+}
+
 const struct nlop_s* batch_generator_create(struct bat_gen_conf_s* config, int D, int N, const long bat_dims[D][N], const long tot_dims[D][N], const complex float* data[D])
 {
 	long tot_strs[D][N];
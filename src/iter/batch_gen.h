@@ -10,6 +10,7 @@ enum BATCH_GEN_TYPE {
 	BATCH_GEN_RANDOM_DATA		// batches: 7, 3, 7 | 4, 9, 9 | 1, 8, 3
 	};
 struct iter6_conf_s;
+struct iter_checkpoint_s;
 
 struct bat_gen_conf_s {
 
@@ -29,4 +30,6 @@ extern const struct nlop_s* batch_generator_create(struct bat_gen_conf_s* config
 extern const struct nlop_s* batch_gen_create_from_iter(struct iter6_conf_s* iter_conf, int D, const int Ns[__VLA(D)], const long* bat_dims[__VLA(D)], const long* tot_dims[__VLA(D)], const _Complex float* data[__VLA(D)], long Nc);
 extern const struct nlop_s* batch_gen_create(int D, const int Ns[__VLA(D)], const long* bat_dims[__VLA(D)], const long* tot_dims[__VLA(D)], const _Complex float* data[__VLA(D)], long Nc, enum BATCH_GEN_TYPE type, unsigned long long seed);
 
+extern void batch_gen_checkpoint(const struct nlop_s* nlop, struct iter_checkpoint_s* cp);
+
 #endif
@@ -0,0 +1,330 @@
+/* Copyright 2026. Institute of Biomedical Imaging. TU Graz.
+ * All rights reserved. Use of this source code is governed by
+ * a BSD-style license which can be found in the LICENSE file.
+ *
+ * Checkpoint/restart of iterative algorithms.
+ *
+ * An algorithm registers all memory which makes up its state
+ * (iterates, momenta, step sizes, counters, random states) and
+ * then restores it from the checkpoint file, which returns the
+ * iteration to continue with. Every 'mod' iterations, the state
+ * is copied into the memory-mapped checkpoint file and written
+ * to disk in the background. As the same registrations are made
+ * when the same command is run again, it continues exactly where
+ * the last checkpoint was taken.
+ *
+ * The file contains two slots which are written alternately, so
+ * that a valid snapshot exists if the process is stopped while
+ * writing. Only the outermost algorithm writes checkpoints, nested
+ * algorithms (e.g. CG in IRGNM) just run again. The state of the
+ * global random number generator is included for them. Commands
+ * must not enable checkpoints when the outermost algorithm does not
+ * support them, as a nested algorithm would be checkpointed instead.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <complex.h>
+
+#include "misc/misc.h"
+#include "misc/debug.h"
+#include "misc/list.h"
+#include "misc/mmio.h"
+#include "misc/writeback.h"
+
+#include "num/multind.h"
+#include "num/rand.h"
+
+#include "checkpoint.h"
+
+
+#define CHECKPOINT_MAGIC "BARTCKP1"
+
+struct checkpoint_header_s {
+
+	char magic[8];
+	char algo[24];
+	long call;
+	long size;
+	long iter;
+	long pad[3];
+};
+
+struct checkpoint_region_s {
+
+	long size;
+	void* ptr;
+};
+
+struct iter_checkpoint_s {
+
+	const char* name;
+	const char* algo;
+
+	long mod;
+	long call;
+	bool global;
+
+	list_t regions;
+	long size;
+
+	long dims[1];
+	complex float* data;
+	struct writeback_s* writeback;
+
+	int slot;
+	bool readonly;
+};
+
+
+static _Thread_local const char* checkpoint_name = NULL;
+static _Thread_local long checkpoint_mod = 1;
+static _Thread_local long checkpoint_calls = 0;
+static _Thread_local bool checkpoint_active = false;
+
+
+/*
+ * Checkpoint iterative algorithms started by a command
+ * (see iter_checkpoint_begin).
+ */
+void iter_checkpoint_configure(const char* name, long mod)
+{
+	checkpoint_name = name;
+	checkpoint_mod = MAX(1, mod);
+	checkpoint_calls = 0;
+}
+
+
+struct iter_checkpoint_s* iter_checkpoint_create(const char* name, long mod, const char* algo)
+{
+	PTR_ALLOC(struct iter_checkpoint_s, cp);
+
+	cp->name = strdup(name);
+	cp->algo = strdup(algo);
+	cp->mod = MAX(1, mod);
+	cp->call = 0;
+	cp->global = false;
+
+	cp->regions = list_create();
+	cp->size = 0;
+
+	cp->data = NULL;
+	cp->writeback = NULL;
+
+	cp->slot = 0;
+	cp->readonly = false;
+
+	return PTR_PASS(cp);
+}
+
+
+/*
+ * Returns NULL if no checkpoint is configured or if called
+ * from within another algorithm which is checkpointed.
+ * Algorithms are identified by the order in which they
+ * are started by the command.
+ */
+struct iter_checkpoint_s* iter_checkpoint_begin(const char* algo)
+{
+	if ((NULL == checkpoint_name) || checkpoint_active)
+		return NULL;
+
+	checkpoint_active = true;
+
+	struct iter_checkpoint_s* cp = iter_checkpoint_create(checkpoint_name, checkpoint_mod, algo);
+
+	cp->call = checkpoint_calls++;
+	cp->global = true;
+
+	// e.g. random shifts of wavelets
+
+	iter_checkpoint_register(cp, rand_state_size(), rand_state_global());
+
+	return cp;
+}
+
+
+void iter_checkpoint_register(struct iter_checkpoint_s* cp, long size, void* ptr)
+{
+	if (NULL == cp)
+		return;
+
+	assert(NULL == cp->data);
+
+	PTR_ALLOC(struct checkpoint_region_s, r);
+
+	r->size = size;
+	r->ptr = ptr;
+
+	list_append(cp->regions, PTR_PASS(r));
+
+	cp->size += size;
+}
+
+
+static long slot_size(const struct iter_checkpoint_s* cp)
+{
+	// keep slots aligned for the payload
+
+	return (long)sizeof(struct checkpoint_header_s) + ((cp->size + 63) / 64) * 64;
+}
+
+static struct checkpoint_header_s* slot_header(const struct iter_checkpoint_s* cp, int slot)
+{
+	return (void*)cp->data + slot * slot_size(cp);
+}
+
+static void* slot_payload(const struct iter_checkpoint_s* cp, int slot)
+{
+	return (void*)slot_header(cp, slot) + sizeof(struct checkpoint_header_s);
+}
+
+static bool slot_valid(const struct iter_checkpoint_s* cp, int slot)
+{
+	const struct checkpoint_header_s* h = slot_header(cp, slot);
+
+	return (0 == memcmp(h->magic, CHECKPOINT_MAGIC, 8))
+		&& (0 == strncmp(h->algo, cp->algo, sizeof h->algo - 1))
+		&& (h->size == cp->size)
+		&& (0 <= h->iter);
+}
+
+
+/*
+ * Map the checkpoint file and restore the registered state from the
+ * most recent valid snapshot. Returns the iteration to continue with.
+ */
+long iter_checkpoint_restore(struct iter_checkpoint_s* cp)
+{
+	if (NULL == cp)
+		return 0;
+
+	assert(NULL == cp->data);
+
+	long bytes = 2 * slot_size(cp);
+
+	cp->dims[0] = bytes / (long)sizeof(complex float);
+	cp->data = shared_cfl(1, cp->dims, cp->name);
+	cp->writeback = writeback_create(cp->name, (size_t)bytes);
+
+	int slot = -1;
+	long call = -1;
+
+	for (int i = 0; i < 2; i++) {
+
+		if (!slot_valid(cp, i))
+			continue;
+
+		const struct checkpoint_header_s* h = slot_header(cp, i);
+
+		if (   (h->call > call)
+		    || ((h->call == call) && (h->iter > slot_header(cp, slot)->iter))) {
+
+			slot = i;
+			call = h->call;
+		}
+	}
+
+	// a later algorithm of the same command wrote the checkpoint
+
+	cp->readonly = (call > cp->call);
+
+	if ((-1 == slot) || (call != cp->call)) {
+
+		cp->slot = 0;
+		return 0;
+	}
+
+	const void* src = slot_payload(cp, slot);
+
+	list_t regions = cp->regions;
+
+	for (int i = 0; i < list_count(regions); i++) {
+
+		const struct checkpoint_region_s* r = list_get_item(regions, i);
+
+		md_copy(1, MD_DIMS(r->size), r->ptr, src, 1);
+		src += r->size;
+	}
+
+	long iter = slot_header(cp, slot)->iter;
+
+	debug_printf(DP_INFO, "Resuming %s from checkpoint %s (iteration %ld).\n", cp->algo, cp->name, iter);
+
+	cp->slot = 1 - slot;
+
+	return iter;
+}
+
+
+/*
+ * Snapshot the registered state after 'iter' iterations. The state is
+ * copied synchronously, writing it to disk happens in the background.
+ */
+void iter_checkpoint_save(struct iter_checkpoint_s* cp, long iter)
+{
+	if ((NULL == cp) || cp->readonly || (0 != iter % cp->mod))
+		return;
+
+	assert(NULL != cp->data);
+
+	struct checkpoint_header_s* h = slot_header(cp, cp->slot);
+
+	// invalidate slot while writing
+
+	h->iter = -1;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	void* dst = slot_payload(cp, cp->slot);
+
+	list_t regions = cp->regions;
+
+	for (int i = 0; i < list_count(regions); i++) {
+
+		const struct checkpoint_region_s* r = list_get_item(regions, i);
+
+		md_copy(1, MD_DIMS(r->size), dst, r->ptr, 1);
+		dst += r->size;
+	}
+
+	memcpy(h->magic, CHECKPOINT_MAGIC, 8);
+	memset(h->algo, 0, sizeof h->algo);
+	strncpy(h->algo, cp->algo, sizeof h->algo - 1);
+	h->call = cp->call;
+	h->size = cp->size;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	h->iter = iter;
+
+	writeback_push(cp->writeback, h, (size_t)slot_size(cp));
+
+	debug_printf(DP_DEBUG2, "Checkpoint %s: iteration %ld.\n", cp->name, iter);
+
+	cp->slot = 1 - cp->slot;
+}
+
+
+void iter_checkpoint_free(struct iter_checkpoint_s* cp)
+{
+	if (NULL == cp)
+		return;
+
+	if (NULL != cp->data) {
+
+		writeback_free(cp->writeback);
+		unmap_shared_cfl(1, cp->dims, cp->data);
+	}
+
+	while (0 < list_count(cp->regions))
+		xfree(list_pop(cp->regions));
+
+	list_free(cp->regions);
+
+	if (cp->global)
+		checkpoint_active = false;
+
+	xfree(cp->name);
+	xfree(cp->algo);
+	xfree(cp);
+}
+
@@ -0,0 +1,17 @@
+
+#ifndef __ITER_CHECKPOINT_H
+#define __ITER_CHECKPOINT_H
+
+struct iter_checkpoint_s;
+
+extern void iter_checkpoint_configure(const char* name, long mod);
+
+extern struct iter_checkpoint_s* iter_checkpoint_create(const char* name, long mod, const char* algo);
+extern struct iter_checkpoint_s* iter_checkpoint_begin(const char* algo);
+
+extern void iter_checkpoint_register(struct iter_checkpoint_s* cp, long size, void* ptr);
+extern long iter_checkpoint_restore(struct iter_checkpoint_s* cp);
+extern void iter_checkpoint_save(struct iter_checkpoint_s* cp, long iter);
+extern void iter_checkpoint_free(struct iter_checkpoint_s* cp);
+
+#endif // __ITER_CHECKPOINT_H
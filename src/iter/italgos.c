@@ -49,6 +49,7 @@
 
 // FIXME: shouldn't this be a monitor?
 #include "iter/iter_dump.h"
+#include "iter/checkpoint.h"
 
 #include "italgos.h"
 #include "misc/types.h"
@@ -197,8 +198,13 @@ void ist(int maxiter, float epsilon, float tau, long N,
 
 	itrdata.rsnot = vops->norm(N, b);
 
+	struct iter_checkpoint_s* cp = iter_checkpoint_begin("ist");
 
-	for (itrdata.iter = 0; itrdata.iter < maxiter; itrdata.iter++) {
+	iter_checkpoint_register(cp, N * (long)sizeof(float), x);
+	iter_checkpoint_register(cp, sizeof itrdata.tau, &itrdata.tau);
+	iter_checkpoint_register(cp, sizeof itrdata.scale, &itrdata.scale);
+
+	for (itrdata.iter = iter_checkpoint_restore(cp); itrdata.iter < maxiter; itrdata.iter++) {
 
 		iter_monitor(monitor, vops, x);
 
@@ -218,10 +224,14 @@ void ist(int maxiter, float epsilon, float tau, long N,
 			break;
 
 		vops->axpy(N, x, itrdata.tau, r);
+
+		iter_checkpoint_save(cp, itrdata.iter + 1);
 	}
 
 	debug_printf(DP_DEBUG3, "\n");
 
+	iter_checkpoint_free(cp);
+
 	vops->del(r);
 }
 
@@ -271,8 +281,15 @@ void fista(int maxiter, float epsilon, float tau, float alpha,
 
 	itrdata.rsnot = vops->norm(N, b);
 
+	struct iter_checkpoint_s* cp = iter_checkpoint_begin("fista");
 
-	for (itrdata.iter = 0; itrdata.iter < maxiter; itrdata.iter++) {
+	iter_checkpoint_register(cp, N * (long)sizeof(float), x);
+	iter_checkpoint_register(cp, N * (long)sizeof(float), o);
+	iter_checkpoint_register(cp, sizeof ra, &ra);
+	iter_checkpoint_register(cp, sizeof itrdata.tau, &itrdata.tau);
+	iter_checkpoint_register(cp, sizeof itrdata.scale, &itrdata.scale);
+
+	for (itrdata.iter = iter_checkpoint_restore(cp); itrdata.iter < maxiter; itrdata.iter++) {
 
 		iter_monitor(monitor, vops, x);
 
@@ -293,8 +310,12 @@ void fista(int maxiter, float epsilon, float tau, float alpha,
 			break;
 
 		vops->axpy(N, x, itrdata.tau, r);
+
+		iter_checkpoint_save(cp, itrdata.iter + 1);
 	}
 
+	iter_checkpoint_free(cp);
+
 	if (!last) {
 
 		iter_monitor(monitor, vops, x);
@@ -421,24 +442,36 @@ float conjgrad(int maxiter, float l2lambda, float epsilon,
 	float* p = vops->allocate(N);
 	float* Ap = vops->allocate(N);
 
+	float rsold = 0.;
+	float rsnew = 0.;
 
-	// The first calculation of the residual might not
-	// be necessary in some cases...
+	struct iter_checkpoint_s* cp = iter_checkpoint_begin("conjgrad");
 
-	iter_op_call(linop, r, x);		// r = A x
-	vops->axpy(N, r, l2lambda, x);
+	iter_checkpoint_register(cp, N * (long)sizeof(float), x);
+	iter_checkpoint_register(cp, N * (long)sizeof(float), r);
+	iter_checkpoint_register(cp, N * (long)sizeof(float), p);
+	iter_checkpoint_register(cp, sizeof rsold, &rsold);
+	iter_checkpoint_register(cp, sizeof rsnew, &rsnew);
 
-	vops->xpay(N, -1., r, b);	// r = b - r = b - A x
-	vops->copy(N, p, r);		// p = r
+	int i = iter_checkpoint_restore(cp);
 
-	float rsnot = (float)pow(vops->norm(N, r), 2.);
-	float rsold = rsnot;
-	float rsnew = rsnot;
+	if (0 == i) {
 
-	float eps_squared = pow(epsilon, 2.);
+		// The first calculation of the residual might not
+		// be necessary in some cases...
 
+		iter_op_call(linop, r, x);		// r = A x
+		vops->axpy(N, r, l2lambda, x);
+
+		vops->xpay(N, -1., r, b);	// r = b - r = b - A x
+		vops->copy(N, p, r);		// p = r
+
+		rsold = (float)pow(vops->norm(N, r), 2.);
+		rsnew = rsold;
+	}
+
+	float eps_squared = pow(epsilon, 2.);
 
-	int i = 0;
 
 	if (0. == rsold) {
 
@@ -446,7 +479,7 @@ float conjgrad(int maxiter, float l2lambda, float epsilon,
 		goto cleanup;
 	}
 
-	for (i = 0; i < maxiter; i++) {
+	for (; i < maxiter; i++) {
 
 		iter_monitor(monitor, vops, x);
 
@@ -475,9 +508,13 @@ float conjgrad(int maxiter, float l2lambda, float epsilon,
 			break;
 
 		vops->xpay(N, beta, p, r);	// p = beta * p + r
+
+		iter_checkpoint_save(cp, i + 1);
 	}
 
 cleanup:
+	iter_checkpoint_free(cp);
+
 	vops->del(Ap);
 	vops->del(p);
 	vops->del(r);
@@ -621,7 +658,12 @@ void irgnm(int iter, float alpha, float alpha_min, float redu, long N, long M,
 	float* p = vops->allocate(N);
 	float* h = vops->allocate(N);
 
-	for (int i = 0; i < iter; i++) {
+	struct iter_checkpoint_s* cp = iter_checkpoint_begin("irgnm");
+
+	iter_checkpoint_register(cp, N * (long)sizeof(float), x);
+	iter_checkpoint_register(cp, sizeof alpha, &alpha);
+
+	for (int i = iter_checkpoint_restore(cp); i < iter; i++) {
 
 		iter_monitor(monitor, vops, x);
 
@@ -646,8 +688,12 @@ void irgnm(int iter, float alpha, float alpha_min, float redu, long N, long M,
 
 		if (NULL != callback.fun)
 			iter_op_call(callback, x, x);
+
+		iter_checkpoint_save(cp, i + 1);
 	}
 
+	iter_checkpoint_free(cp);
+
 	vops->del(h);
 	vops->del(p);
 	vops->del(r);
@@ -677,7 +723,12 @@ void irgnm2(int iter, float alpha, float alpha_min, float alpha_min0, float redu
 {
 	float* r = vops->allocate(M);
 
-	for (int i = 0; i < iter; i++) {
+	struct iter_checkpoint_s* cp = iter_checkpoint_begin("irgnm2");
+
+	iter_checkpoint_register(cp, N * (long)sizeof(float), x);
+	iter_checkpoint_register(cp, sizeof alpha, &alpha);
+
+	for (int i = iter_checkpoint_restore(cp); i < iter; i++) {
 
 		iter_monitor(monitor, vops, x);
 
@@ -710,8 +761,12 @@ void irgnm2(int iter, float alpha, float alpha_min, float alpha_min0, float redu
 
 		if (NULL != callback.fun)
 			iter_op_call(callback, x, x);
+
+		iter_checkpoint_save(cp, i + 1);
 	}
 
+	iter_checkpoint_free(cp);
+
 	vops->del(r);
 }
 
@@ -1179,7 +1234,8 @@ void sgd(	int epochs, int batches,
 		struct iter_op_p_s prox[NI],
 		struct iter_nlop_s nlop_batch_gen,
 		struct iter_op_s /*callback*/,
-		struct monitor_iter6_s* monitor, const struct iter_dump_s* dump)
+		struct monitor_iter6_s* monitor, const struct iter_dump_s* dump,
+		struct iter_checkpoint_s* checkpoint)
 {
 	float* grad[NI];
 	float* dxs[NI];
@@ -1251,7 +1307,13 @@ void sgd(	int epochs, int batches,
 	for (int i = 0; i < NI; i++)
 		x2[i] = x[i];
 
-	for (int epoch = 0; epoch < epochs; epoch++) {
+	// state of update operators and batch generator is registered by the caller
+
+	for (int i = 0; i < NI; i++)
+		if ((IN_OPTIMIZE == in_type[i]) || (IN_BATCHNORM == in_type[i]))
+			iter_checkpoint_register(checkpoint, isize[i] * (long)sizeof(float), x[i]);
+
+	for (int epoch = iter_checkpoint_restore(checkpoint); epoch < epochs; epoch++) {
 
 		iter_dump(dump, epoch, NI, x2);
 
@@ -1309,6 +1371,8 @@ void sgd(	int epochs, int batches,
 		for (int i = 0; i < NI; i++)
 			if (in_type[i] == IN_BATCH)
 				args[NO + i] -= isize[i] * (N_total / N_batch);
+
+		iter_checkpoint_save(checkpoint, epoch + 1);
 	}
 
 	for (int i = 0; i < NI; i++) {
@@ -1381,7 +1445,8 @@ void iPALM(	long NI, long isize[NI], enum IN_TYPE in_type[NI], float* x[const NI
 		float batchnorm_momentum,
 		struct iter_nlop_s nlop_batch_gen,
 		struct iter_op_s /*callback*/,
-		struct monitor_iter6_s* monitor, const struct iter_dump_s* dump)
+		struct monitor_iter6_s* monitor, const struct iter_dump_s* dump,
+		struct iter_checkpoint_s* checkpoint)
 {
 	float* x_batch_gen[NI]; //arrays which are filled by batch generator
 	long N_batch_gen = 0;
@@ -1471,7 +1536,18 @@ void iPALM(	long NI, long isize[NI], enum IN_TYPE in_type[NI], float* x[const NI
 	for (int i = 0; i < NI; i++)
 		x2[i] = x[i];
 
-	for (int epoch = epoch_start; epoch < epoch_end; epoch++) {
+	for (int i = 0; i < NI; i++) {
+
+		if ((IN_OPTIMIZE == in_type[i]) || (IN_BATCHNORM == in_type[i]))
+			iter_checkpoint_register(checkpoint, isize[i] * (long)sizeof(float), x[i]);
+
+		if (IN_OPTIMIZE == in_type[i])
+			iter_checkpoint_register(checkpoint, isize[i] * (long)sizeof(float), x_old[i]);
+	}
+
+	iter_checkpoint_register(checkpoint, NI * (long)sizeof(float), L);
+
+	for (int epoch = MAX(epoch_start, iter_checkpoint_restore(checkpoint)); epoch < epoch_end; epoch++) {
 
 		iter_dump(dump, epoch, NI, x2);
 
@@ -1635,6 +1711,8 @@ void iPALM(	long NI, long isize[NI], enum IN_TYPE in_type[NI], float* x[const NI
 
 			monitor_iter6(monitor, epoch, batch, N_batch, r_i, NI, x2, post_string);
 		}
+
+		iter_checkpoint_save(checkpoint, epoch + 1);
 	}
 
 
@@ -21,6 +21,7 @@ enum OUT_TYPE { OUT_UNDEFINED, OUT_STATIC, OUT_OPTIMIZE, OUT_BATCHNORM };
 
 struct vec_iter_s;
 struct iter_dump_s;
+struct iter_checkpoint_s;
 
 #ifndef MD_IS_SET
 #define MD_BIT(x) (1UL << (x))
@@ -144,7 +145,8 @@ void sgd(int epochs, int batches,
 	struct iter_nlop_s nlop_batch_gen,
 	struct iter_op_s callback,
 	struct monitor_iter6_s* monitor,
-	const struct iter_dump_s* dump);
+	const struct iter_dump_s* dump,
+	struct iter_checkpoint_s* checkpoint);
 
 /**
  * Store information about iterative algorithm.
@@ -266,7 +268,8 @@ void iPALM(	long NI, long isize[__VLA(NI)], enum IN_TYPE in_type[__VLA(NI)], flo
 		struct iter_op_p_s prox[__VLA(NI)],
 		float batchnorm_momentum,
 		struct iter_nlop_s nlop_batch_gen,
-		struct iter_op_s callback, struct monitor_iter6_s* monitor, const struct iter_dump_s* dump);
+		struct iter_op_s callback, struct monitor_iter6_s* monitor, const struct iter_dump_s* dump,
+		struct iter_checkpoint_s* checkpoint);
 
 void lbfgs(int maxiter, int M, float step, float ftol, float gtol, float c1, float c2, struct iter_op_s op, struct iter_op_s adj, int N, float *x, const struct vec_iter_s* vops);
 
@@ -27,6 +27,7 @@
 #include "iter/iter6_ops.h"
 #include "iter/monitor_iter6.h"
 #include "iter/iter_dump.h"
+#include "iter/checkpoint.h"
 #include "iter/prox.h"
 
 #include "iter6.h"
@@ -66,6 +67,8 @@ DEF_TYPEID(iter6_iPALM_conf);
 	.super.batchgen_type = BATCH_GEN_SAME,		\
 	.super.batch_seed = 123,			\
 	.super.dump_flag = 0,				\
+	.super.checkpoint_filename = NULL,		\
+	.super.checkpoint_mod = 1,			\
 	.super.min_learning_rate = 0.,			\
 	.super.epochs_warmup = 0.,			\
 	.super.monitor_averaged_objective = false,	\
@@ -328,6 +331,22 @@ void iter6_sgd_like(	const iter6_conf* conf,
 	long isize[NI];
 	long osize[NO];
 
+	//gpu ref (dst[i] can be null if batch_gen)
+	float* gpu_ref = NULL;
+
+	for (int i = 0; i < NI; i++)
+		if (IN_OPTIMIZE == in_type[i])
+			gpu_ref = dst[i];
+
+	assert(NULL != gpu_ref);
+
+	struct iter_checkpoint_s* checkpoint = NULL;
+
+	if (NULL != conf->checkpoint_filename)
+		checkpoint = iter_checkpoint_create(conf->checkpoint_filename, conf->checkpoint_mod, "sgd");
+
+	batch_gen_checkpoint(nlop_batch_gen, checkpoint);
+
 	//array of update operators
 	const struct operator_p_s* upd_ops[NI];
 
@@ -340,6 +359,8 @@ void iter6_sgd_like(	const iter6_conf* conf,
 
 		upd_ops[i] = get_update_operator(conf, nlop_generic_domain(nlop, i)->N, nlop_generic_domain(nlop, i)->dims, numbatches);
 
+		operator_update_checkpoint(upd_ops[i], checkpoint, gpu_ref);
+
 		if ((0. != conf->clip_norm) || (0. != conf->clip_val)) {
 
 			const struct operator_s* tmp1 = operator_clip_create(nlop_generic_domain(nlop, i)->N, nlop_generic_domain(nlop, i)->dims, conf->clip_norm, conf->clip_val);
@@ -363,15 +384,6 @@ void iter6_sgd_like(	const iter6_conf* conf,
 	for (int o = 0; o < NO; o++)
 		osize[o] = 2 * md_calc_size(nlop_generic_codomain(nlop, o)->N, nlop_generic_codomain(nlop, o)->dims);
 
-	//gpu ref (dst[i] can be null if batch_gen)
-	float* gpu_ref = NULL;
-
-	for (int i = 0; i < NI; i++)
-		if (IN_OPTIMIZE == in_type[i])
-			gpu_ref = dst[i];
-
-	assert(NULL != gpu_ref);
-
 	bool free_monitor = (NULL == monitor);
 
 	if (free_monitor)
@@ -422,7 +434,9 @@ void iter6_sgd_like(	const iter6_conf* conf,
 		upd_iter_ops,
 		prox_iter,
 		nlop_batch_gen_iter,
-		(struct iter_op_s){ NULL, NULL }, monitor, dump);
+		(struct iter_op_s){ NULL, NULL }, monitor, dump, checkpoint);
+
+	iter_checkpoint_free(checkpoint);
 
 	for (int i = 0; i < NI; i++)
 		operator_p_free(upd_ops[i]);
@@ -592,6 +606,13 @@ void iter6_iPALM(	const iter6_conf* _conf,
 	    && (0 < conf->super.dump_mod))
 		dump = iter6_dump_default_create(conf->super.dump_filename,conf->super.dump_mod, nlop, conf->super.dump_flag, NI, in_type);
 
+	struct iter_checkpoint_s* checkpoint = NULL;
+
+	if (NULL != conf->super.checkpoint_filename)
+		checkpoint = iter_checkpoint_create(conf->super.checkpoint_filename, conf->super.checkpoint_mod, "ipalm");
+
+	batch_gen_checkpoint(nlop_batch_gen, checkpoint);
+
 	iPALM(	NI, isize, in_type, dst, x_old,
 		NO, osize, out_type,
 		numbatches, 0, conf->super.epochs,
@@ -602,7 +623,9 @@ void iter6_iPALM(	const iter6_conf* _conf,
 		prox_iter,
 		conf->super.batchnorm_momentum,
 		nlop_batch_gen_iter,
-		(struct iter_op_s){ NULL, NULL }, monitor, dump);
+		(struct iter_op_s){ NULL, NULL }, monitor, dump, checkpoint);
+
+	iter_checkpoint_free(checkpoint);
 
 	if (NULL != conf->super.history_filename)
 		monitor_iter6_dump_record(monitor, conf->super.history_filename);
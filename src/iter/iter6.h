@@ -29,6 +29,9 @@ typedef struct iter6_conf_s {
 	long dump_mod;
 	unsigned long dump_flag;
 
+	const char* checkpoint_filename;
+	long checkpoint_mod;
+
 	enum BATCH_GEN_TYPE batchgen_type;
 	unsigned int batch_seed;
 
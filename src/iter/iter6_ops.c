@@ -20,6 +20,7 @@
 #include "misc/types.h"
 
 #include "iter/iter6.h"
+#include "iter/checkpoint.h"
 #include "iter6_ops.h"
 
 
@@ -167,10 +168,8 @@ static void adam_update_apply(const operator_data_t* _data, float learning_rate,
 	if (d->t == d->t_reset) {
 
 		d->t = 0;
-		md_free(d->first_mom);
-		md_free(d->second_mom);
-		d->first_mom = NULL;
-		d->second_mom = NULL;
+		md_clear(d->dom->N, d->dom->dims, d->first_mom, d->dom->size);
+		md_clear(d->dom->N, d->dom->dims, d->second_mom, d->dom->size);
 	}
 }
 
@@ -206,6 +205,55 @@ const struct operator_p_s* operator_adam_update_create(int N, const long dims[N]
 }
 
 
+/**
+ * Register the internal state of Adam and AdaDelta update operators.
+ * Moments are allocated here (next to 'ref') so that they can be
+ * restored before the first update.
+ */
+void operator_update_checkpoint(const struct operator_p_s* op, struct iter_checkpoint_s* cp, const void* ref)
+{
+	if (NULL == cp)
+		return;
+
+	auto adam = CAST_MAYBE(adam_update_s, operator_p_get_data(op));
+
+	if (NULL != adam) {
+
+		long size = md_calc_size(adam->dom->N, adam->dom->dims) * (long)adam->dom->size;
+
+		if (NULL == adam->first_mom) {
+
+			adam->first_mom = md_alloc_sameplace(adam->dom->N, adam->dom->dims, adam->dom->size, ref);
+			adam->second_mom = md_alloc_sameplace(adam->dom->N, adam->dom->dims, adam->dom->size, ref);
+			md_clear(adam->dom->N, adam->dom->dims, adam->first_mom, adam->dom->size);
+			md_clear(adam->dom->N, adam->dom->dims, adam->second_mom, adam->dom->size);
+		}
+
+		iter_checkpoint_register(cp, size, adam->first_mom);
+		iter_checkpoint_register(cp, size, adam->second_mom);
+		iter_checkpoint_register(cp, (long)sizeof(adam->t), &adam->t);
+	}
+
+	auto adadelta = CAST_MAYBE(adadelta_update_s, operator_p_get_data(op));
+
+	if (NULL != adadelta) {
+
+		long size = md_calc_size(adadelta->dom->N, adadelta->dom->dims) * (long)adadelta->dom->size;
+
+		if (NULL == adadelta->floating_g) {
+
+			adadelta->floating_g = md_alloc_sameplace(adadelta->dom->N, adadelta->dom->dims, adadelta->dom->size, ref);
+			adadelta->floating_dx = md_alloc_sameplace(adadelta->dom->N, adadelta->dom->dims, adadelta->dom->size, ref);
+			md_clear(adadelta->dom->N, adadelta->dom->dims, adadelta->floating_g, adadelta->dom->size);
+			md_clear(adadelta->dom->N, adadelta->dom->dims, adadelta->floating_dx, adadelta->dom->size);
+		}
+
+		iter_checkpoint_register(cp, size, adadelta->floating_g);
+		iter_checkpoint_register(cp, size, adadelta->floating_dx);
+	}
+}
+
+
 struct clip_s {
 
 	operator_data_t super;
@@ -4,3 +4,6 @@ extern const struct operator_p_s* operator_adadelta_update_create(int N, const l
 extern const struct operator_p_s* operator_adam_update_create(int N, const long dims[__VLA(N)], float beta1, float beta2, float epsilon, long reset_mod);
 extern const struct operator_p_s* operator_sgd_update_create(int N, const long dims[__VLA(N)]);
 
+struct iter_checkpoint_s;
+extern void operator_update_checkpoint(const struct operator_p_s* op, struct iter_checkpoint_s* cp, const void* ref);
+
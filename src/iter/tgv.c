@@ -35,6 +35,7 @@
 #include "linops/grad.h"
 
 #include "iter/thresh.h"
+#include "misc/misc.h"
 #include "misc/debug.h"
 #include "misc/mri.h"
 
@@ -82,25 +83,19 @@ struct reg tv_reg(unsigned long flags, unsigned long jflags, float lambda, int N
 		md_copy_dims(N, in2_dims, img_dims);
 	}
 
-	reg.linop = linop_grad_create(N, in2_dims, N, flags);
-
-	if (NULL != lop_trafo)
-		reg.linop = linop_chain_FF(lop_trafo, reg.linop);
-
 	if (0 < tvscales_N) {
 
 		debug_printf(DP_INFO, "TV anisotropic scaling: %d\n", tvscales_N);
 
-		assert(tvscales_N == linop_codomain(reg.linop)->dims[N]);
+		assert(tvscales_N == bitcount(flags));
+	}
 
-		complex float ztvscales[tvscales_N];
+	// finite differences and scaling in one sweep
 
-		for (int i = 0; i < tvscales_N; i++)
-			ztvscales[i] = tvscales[i];
+	reg.linop = linop_grad_fused_create(N, in2_dims, flags, tvscales_N, tvscales);
 
-		reg.linop = linop_chain_FF(reg.linop,
-				linop_cdiag_create(N + 1, linop_codomain(reg.linop)->dims, MD_BIT(N), ztvscales));
-	}
+	if (NULL != lop_trafo)
+		reg.linop = linop_chain_FF(lop_trafo, reg.linop);
 
 	reg.prox = prox_thresh_create(N + 1,
 			linop_codomain(reg.linop)->dims,
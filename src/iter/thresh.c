@@ -14,12 +14,18 @@
 #include <complex.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <math.h>
+#include <strings.h>
 
 #include "num/multind.h"
 #include "num/flpmath.h"
 #include "num/ops_p.h"
 #include "num/ops.h"
 #include "num/iovec.h"
+#ifdef USE_CUDA
+#include "num/gpuops.h"
+#endif
+#include "num/vptr.h"
 
 #include "linops/linop.h"
 
@@ -62,14 +68,112 @@ static DEF_TYPEID(thresh_s);
 
 
 
+enum { THRESH_BLOCK = 1024 };
+
+static void block_offsets(int D, const long dims[D], long offs[], const long strs[D])
+{
+	long pos[D];
+	md_set_dims(D, pos, 0);
+
+	long i = 0;
+
+	do {
+		offs[i++] = md_calc_offset(D, strs, pos);
+
+	} while (md_next(D, dims, ~0UL, pos));
+}
+
+/*
+ * Joint soft-thresholding in one sweep (contiguous arrays on the CPU):
+ * The norm is accumulated for a block of positions, which is
+ * then scaled while it is still in cache.
+ */
+static void softthresh_joint_cpu(int D, const long dim[D], unsigned long flags, float lambda, complex float* optr, const complex float* iptr)
+{
+	int f = ffsl((long)flags) - 1;
+
+	long strs[D];
+	md_calc_strides(D, strs, dim, 1);
+
+	long B = md_calc_size(f, dim);
+
+	long jdims[D];
+	md_select_dims(D, flags, jdims, dim);
+
+	long udims[D];
+	md_select_dims(D, ~flags & ~(MD_BIT(f) - 1), udims, dim);
+
+	long J = md_calc_size(D, jdims);
+	long U = md_calc_size(D, udims);
+
+	long* joffs = xmalloc((size_t)J * sizeof(long));
+	long* uoffs = xmalloc((size_t)U * sizeof(long));
+
+	block_offsets(D, jdims, joffs, strs);
+	block_offsets(D, udims, uoffs, strs);
+
+	long nblocks = (B + THRESH_BLOCK - 1) / THRESH_BLOCK;
+
+#pragma omp parallel for collapse(2)
+	for (long u = 0; u < U; u++) {
+		for (long b = 0; b < nblocks; b++) {
+
+			long o = uoffs[u] + b * THRESH_BLOCK;
+			long n = MIN(THRESH_BLOCK, B - b * THRESH_BLOCK);
+
+			float red[THRESH_BLOCK];
+
+			for (long i = 0; i < n; i++)
+				red[i] = 0.;
+
+			for (long j = 0; j < J; j++) {
+
+				const complex float* in = iptr + o + joffs[j];
+
+				for (long i = 0; i < n; i++)
+					red[i] += crealf(in[i]) * crealf(in[i]) + cimagf(in[i]) * cimagf(in[i]);
+			}
+
+			for (long i = 0; i < n; i++) {
+
+				float norm = sqrtf(red[i]);
+
+				red[i] = (norm > lambda) ? ((norm - lambda) / norm) : 0.;
+			}
+
+			for (long j = 0; j < J; j++) {
+
+				const complex float* in = iptr + o + joffs[j];
+				complex float* out = optr + o + joffs[j];
+
+				for (long i = 0; i < n; i++)
+					out[i] = red[i] * in[i];
+			}
+		}
+	}
+
+	xfree(joffs);
+	xfree(uoffs);
+}
+
+
 static void softthresh_apply(const operator_data_t* _data, float mu, complex float* optr, const complex float* iptr)
 {
 	const auto data = CAST_DOWN(thresh_s, _data);
 
+	bool fallback = is_vptr(optr) || is_vptr(iptr);
+#ifdef USE_CUDA
+	fallback = fallback || cuda_ondevice(iptr);
+#endif
+
 	if (0. == mu) {
 
 		md_copy(data->D, data->dim, optr, iptr, CFL_SIZE);
 
+	} else if ((0 != data->flags) && !fallback) {
+
+		softthresh_joint_cpu(data->D, data->dim, data->flags, data->lambda * mu, optr, iptr);
+
 	} else {
 
 		complex float* tmp_norm = md_alloc_sameplace(data->D, data->norm_dim, CFL_SIZE, optr);
@@ -18,6 +18,11 @@
 
 #include "misc/misc.h"
 
+#ifdef USE_CUDA
+#include "num/gpuops.h"
+#endif
+#include "num/vptr.h"
+
 #include "grad.h"
 
 #ifdef __MINGW32__
@@ -251,3 +256,334 @@ struct linop_s* linop_grad_create(long N, const long dims[N], int d, unsigned lo
 	return linop_grad_backward_create(N, dims, d, flags);
 }
 
+
+
+
+/*
+ * Fused finite differences for TV
+ *
+ * Same as linop_grad_create(N, dims, N, flags) followed by a scaling
+ * of each direction, but all directions are computed in one sweep
+ * over the image. The image is processed in rows which consist of
+ * all dimensions up to the first flagged one, so that neighbors in
+ * the other directions are whole rows away and stay in cache. The
+ * adjoint (divergence) and normal operator (Laplacian) do not need
+ * temporary arrays.
+ */
+struct grad_fused_s {
+
+	linop_data_t super;
+
+	int N;
+	long* dims;
+	long* strs;
+	unsigned long flags;
+	float* scales;
+};
+
+static DEF_TYPEID(grad_fused_s);
+
+
+static long grad_fused_row(const struct grad_fused_s* data)
+{
+	int f = ffsl((long)data->flags) - 1;
+
+	return data->strs[f] * data->dims[f];
+}
+
+// offset to the next/previous neighbor of row 'o' in direction i (circular)
+
+static long grad_fused_next(const struct grad_fused_s* data, int i, long o)
+{
+	long c = (o / data->strs[i]) % data->dims[i];
+
+	return (c < data->dims[i] - 1) ? data->strs[i] : -(data->dims[i] - 1) * data->strs[i];
+}
+
+static long grad_fused_prev(const struct grad_fused_s* data, int i, long o)
+{
+	long c = (o / data->strs[i]) % data->dims[i];
+
+	return (0 < c) ? -data->strs[i] : (data->dims[i] - 1) * data->strs[i];
+}
+
+
+static void grad_fused_forward_cpu(const struct grad_fused_s* data, complex float* dst, const complex float* src)
+{
+	long size = md_calc_size(data->N, data->dims);
+	int f = ffsl((long)data->flags) - 1;
+	long L = grad_fused_row(data);
+
+#pragma omp parallel for
+	for (long o = 0; o < size; o += L) {
+
+		const complex float* in = src + o;
+
+		for (int i = 0, k = 0; i < data->N; i++) {
+
+			if (!MD_IS_SET(data->flags, i))
+				continue;
+
+			complex float* out = dst + k * size + o;
+			float s = data->scales[k++];
+
+			if (i == f) {
+
+				long sh = data->strs[i];
+
+				for (long j = 0; j < L - sh; j++)
+					out[j] = s * (in[j + sh] - in[j]);
+
+				for (long j = L - sh; j < L; j++)
+					out[j] = s * (in[j - (L - sh)] - in[j]);
+
+			} else {
+
+				long nb = grad_fused_next(data, i, o);
+
+				for (long j = 0; j < L; j++)
+					out[j] = s * (in[j + nb] - in[j]);
+			}
+		}
+	}
+}
+
+
+static void grad_fused_adjoint_cpu(const struct grad_fused_s* data, complex float* dst, const complex float* src)
+{
+	long size = md_calc_size(data->N, data->dims);
+	int f = ffsl((long)data->flags) - 1;
+	long L = grad_fused_row(data);
+
+#pragma omp parallel for
+	for (long o = 0; o < size; o += L) {
+
+		complex float* out = dst + o;
+
+		for (long j = 0; j < L; j++)
+			out[j] = 0.;
+
+		for (int i = 0, k = 0; i < data->N; i++) {
+
+			if (!MD_IS_SET(data->flags, i))
+				continue;
+
+			const complex float* in = src + k * size + o;
+			float s = data->scales[k++];
+
+			if (i == f) {
+
+				long sh = data->strs[i];
+
+				for (long j = 0; j < sh; j++)
+					out[j] += s * (in[j + (L - sh)] - in[j]);
+
+				for (long j = sh; j < L; j++)
+					out[j] += s * (in[j - sh] - in[j]);
+
+			} else {
+
+				long pb = grad_fused_prev(data, i, o);
+
+				for (long j = 0; j < L; j++)
+					out[j] += s * (in[j + pb] - in[j]);
+			}
+		}
+	}
+}
+
+
+static void grad_fused_normal_cpu(const struct grad_fused_s* data, complex float* dst, const complex float* src)
+{
+	long size = md_calc_size(data->N, data->dims);
+	int f = ffsl((long)data->flags) - 1;
+	long L = grad_fused_row(data);
+
+#pragma omp parallel for
+	for (long o = 0; o < size; o += L) {
+
+		const complex float* in = src + o;
+		complex float* out = dst + o;
+
+		for (long j = 0; j < L; j++)
+			out[j] = 0.;
+
+		for (int i = 0, k = 0; i < data->N; i++) {
+
+			if (!MD_IS_SET(data->flags, i))
+				continue;
+
+			float s2 = data->scales[k] * data->scales[k];
+			k++;
+
+			if (i == f) {
+
+				long sh = data->strs[i];
+
+				for (long j = 0; j < L; j++) {
+
+					long n = (j < L - sh) ? (j + sh) : (j - (L - sh));
+					long p = (j >= sh) ? (j - sh) : (j + (L - sh));
+
+					out[j] += s2 * (2. * in[j] - in[n] - in[p]);
+				}
+
+			} else {
+
+				long nb = grad_fused_next(data, i, o);
+				long pb = grad_fused_prev(data, i, o);
+
+				for (long j = 0; j < L; j++)
+					out[j] += s2 * (2. * in[j] - in[j + nb] - in[j + pb]);
+			}
+		}
+	}
+}
+
+
+// generic implementation (GPU and virtual pointers)
+
+static void grad_fused_scale(const struct grad_fused_s* data, complex float* dst)
+{
+	long size = md_calc_size(data->N, data->dims);
+
+	for (int k = 0; k < bitcount(data->flags); k++)
+		if (1. != data->scales[k])
+			md_zsmul(data->N, data->dims, dst + k * size, dst + k * size, data->scales[k]);
+}
+
+static void grad_fused_forward_gen(const struct grad_fused_s* data, complex float* dst, const complex float* src)
+{
+	long odims[data->N + 1];
+	md_copy_dims(data->N, odims, data->dims);
+	odims[data->N] = bitcount(data->flags);
+
+	grad_op(md_zfdiff_b_core2, data->N + 1, odims, data->N, data->flags, dst, src);
+	grad_fused_scale(data, dst);
+}
+
+static void grad_fused_adjoint_gen(const struct grad_fused_s* data, complex float* dst, const complex float* src)
+{
+	long odims[data->N + 1];
+	md_copy_dims(data->N, odims, data->dims);
+	odims[data->N] = bitcount(data->flags);
+
+	complex float* tmp = md_alloc_sameplace(data->N + 1, odims, CFL_SIZE, src);
+
+	md_copy(data->N + 1, odims, tmp, src, CFL_SIZE);
+	grad_fused_scale(data, tmp);
+
+	grad_adjoint(md_zfdiff_b_core2, data->N + 1, odims, data->N, data->flags, dst, tmp);
+
+	md_free(tmp);
+}
+
+
+static void grad_fused_apply(const linop_data_t* _data, complex float* dst, const complex float* src)
+{
+	const auto data = CAST_DOWN(grad_fused_s, _data);
+	bool gen = is_vptr(src) || is_vptr(dst);
+#ifdef USE_CUDA
+	gen = gen || cuda_ondevice(src);
+#endif
+	if (gen) {
+
+		grad_fused_forward_gen(data, dst, src);
+		return;
+	}
+
+	grad_fused_forward_cpu(data, dst, src);
+}
+
+static void grad_fused_adjoint(const linop_data_t* _data, complex float* dst, const complex float* src)
+{
+	const auto data = CAST_DOWN(grad_fused_s, _data);
+	bool gen = is_vptr(src) || is_vptr(dst);
+#ifdef USE_CUDA
+	gen = gen || cuda_ondevice(src);
+#endif
+	if (gen) {
+
+		grad_fused_adjoint_gen(data, dst, src);
+		return;
+	}
+
+	grad_fused_adjoint_cpu(data, dst, src);
+}
+
+static void grad_fused_normal(const linop_data_t* _data, complex float* dst, const complex float* src)
+{
+	const auto data = CAST_DOWN(grad_fused_s, _data);
+	bool gen = is_vptr(src) || is_vptr(dst);
+#ifdef USE_CUDA
+	gen = gen || cuda_ondevice(src);
+#endif
+	if (gen) {
+
+		long odims[data->N + 1];
+		md_copy_dims(data->N, odims, data->dims);
+		odims[data->N] = bitcount(data->flags);
+
+		complex float* tmp = md_alloc_sameplace(data->N + 1, odims, CFL_SIZE, src);
+
+		grad_fused_forward_gen(data, tmp, src);
+		grad_fused_adjoint_gen(data, dst, tmp);
+
+		md_free(tmp);
+		return;
+	}
+
+	grad_fused_normal_cpu(data, dst, src);
+}
+
+static void grad_fused_free(const linop_data_t* _data)
+{
+	const auto data = CAST_DOWN(grad_fused_s, _data);
+
+	xfree(data->dims);
+	xfree(data->strs);
+	xfree(data->scales);
+	xfree(data);
+}
+
+
+/**
+ * Finite differences along all flagged dimensions, with the
+ * directions stacked along dimension N of the output. Each
+ * direction is multiplied by scales[k] (if S > 0).
+ */
+struct linop_s* linop_grad_fused_create(long N, const long dims[N], unsigned long flags, int S, const float scales[S])
+{
+	int D = bitcount(flags);
+
+	assert(0 < D);
+	assert((0 == S) || (D == S));
+	assert(0 == (flags & ~(MD_BIT(N) - 1)));
+
+	PTR_ALLOC(struct grad_fused_s, data);
+	SET_TYPEID(grad_fused_s, data);
+
+	data->N = N;
+	data->flags = flags;
+
+	data->dims = *TYPE_ALLOC(long[N]);
+	md_copy_dims(N, data->dims, dims);
+
+	// element strides (also for singleton dimensions)
+
+	data->strs = *TYPE_ALLOC(long[N]);
+
+	for (int i = 0; i < N; i++)
+		data->strs[i] = md_calc_size(i, dims);
+
+	data->scales = *TYPE_ALLOC(float[D]);
+
+	for (int k = 0; k < D; k++)
+		data->scales[k] = (0 < S) ? scales[k] : 1.;
+
+	long odims[N + 1];
+	md_copy_dims(N, odims, dims);
+	odims[N] = D;
+
+	return linop_create(N + 1, odims, N, dims, CAST_UP(PTR_PASS(data)), grad_fused_apply, grad_fused_adjoint, grad_fused_normal, NULL, grad_fused_free);
+}
@@ -11,5 +11,7 @@ extern struct linop_s* linop_grad_zentral_create(long N, const long dims[__VLA(N
 
 extern struct linop_s* linop_grad_create(long N, const long dims[__VLA(N)], int d, unsigned long flags);
 
+extern struct linop_s* linop_grad_fused_create(long N, const long dims[__VLA(N)], unsigned long flags, int S, const float scales[__VLA2(S)]);
+
 #include "misc/cppwrap.h"
 
@@ -1921,6 +1921,27 @@ struct linop_s* linop_ifftc_create(int N, const long dims[N], unsigned long flag
 	return linop_fft_create_priv(N, dims, flags, false, flags, flags, 0, NULL, 0, NULL);
 }
 
+
+/**
+ * Fourier interpolation: centered zero-padding or cropping in k-space
+ * between a centered unitary FFT and its inverse.
+ * The adjoint maps to the coarser grid by cropping the k-space center.
+ *
+ * @param N number of dimensions
+ * @param out_dims output dimensions
+ * @param in_dims input dimensions
+ * @param flags bitmask of the dimensions to resize
+ */
+struct linop_s* linop_resize_fourier_create(int N, const long out_dims[N], const long in_dims[N], unsigned long flags)
+{
+	assert(md_check_equal_dims(N, out_dims, in_dims, ~flags));
+
+	struct linop_s* fft = linop_fftc_create(N, in_dims, flags & md_nontriv_dims(N, in_dims));
+	struct linop_s* ifft = linop_ifftc_create(N, out_dims, flags & md_nontriv_dims(N, out_dims));
+
+	return linop_chain_FF(linop_chain_FF(fft, linop_resize_center_create(N, out_dims, in_dims)), ifft);
+}
+
 /**
  * Centered forward Fourier transform linear operator chained with cdiag operator from both sides
  *
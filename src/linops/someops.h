@@ -42,6 +42,7 @@ extern struct linop_s* linop_fft_create(int N, const long dims[__VLA(N)], unsign
 extern struct linop_s* linop_ifft_create(int N, const long dims[__VLA(N)], unsigned long flags);
 extern struct linop_s* linop_fftc_create(int N, const long dims[__VLA(N)], unsigned long flags);
 extern struct linop_s* linop_ifftc_create(int N, const long dims[__VLA(N)], unsigned long flags);
+extern struct linop_s* linop_resize_fourier_create(int N, const long out_dims[__VLA(N)], const long in_dims[__VLA(N)], unsigned long flags);
 
 extern struct linop_s* linop_fft_generic_create(int N, const long dims[N], unsigned long flags, unsigned long center_flags, unsigned long unitary_flags, unsigned long pre_flag, const _Complex float* pre_diag, unsigned long post_flag, const _Complex float* post_diag);
 extern struct linop_s* linop_ifft_generic_create(int N, const long dims[N], unsigned long flags, unsigned long center_flags, unsigned long unitary_flags, unsigned long pre_flag, const _Complex float* pre_diag, unsigned long post_flag, const _Complex float* post_diag);
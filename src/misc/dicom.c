@@ -50,6 +50,7 @@
 #define DGRP_IMAGE		0x0028
 #define DTAG_IMAGE_SAMPLES_PER_PIXEL	0x0002
 #define DTAG_IMAGE_PHOTOM_INTER		0x0004
+#define DTAG_IMAGE_NUM_FRAMES		0x0008
 #define DTAG_IMAGE_ROWS			0x0010
 #define DTAG_IMAGE_COLS			0x0011
 #define DTAG_IMAGE_BITS_ALLOC		0x0100
@@ -83,6 +84,7 @@ enum eoffset {
 	ITAG_COMMENT, 
 	ITAG_IMAGE_SAMPLES_PER_PIXEL, 
 	ITAG_IMAGE_PHOTOM_INTER, 
+	ITAG_IMAGE_NUM_FRAMES, 
 	ITAG_IMAGE_ROWS, 
 	ITAG_IMAGE_COLS, 
 	ITAG_IMAGE_BITS_ALLOC, 
@@ -117,6 +119,7 @@ struct element dicom_elements_default[EOFF_END] = {
 	{ ITAG_COMMENT, DGRP_IMAGE2, DTAG_COMMENT, _S2("LT"), 22, "NOT FOR DIAGNOSTIC USE\0\0" },
 	{ ITAG_IMAGE_SAMPLES_PER_PIXEL, DGRP_IMAGE, DTAG_IMAGE_SAMPLES_PER_PIXEL, _S2("US"), 2, &(uint16_t){ 1 } }, 		// gray scale
 	{ ITAG_IMAGE_PHOTOM_INTER, DGRP_IMAGE, DTAG_IMAGE_PHOTOM_INTER, _S2("CS"), sizeof(MONOCHROME2) - 1, MONOCHROME2 },	// 0 is black
+	{ ITAG_IMAGE_NUM_FRAMES, DGRP_IMAGE, DTAG_IMAGE_NUM_FRAMES, _S2("IS"), 0, NULL },				// only multi-frame
 	{ ITAG_IMAGE_ROWS, DGRP_IMAGE, DTAG_IMAGE_ROWS, _S2("US"), 2, &(uint16_t){ 0 } },
 	{ ITAG_IMAGE_COLS, DGRP_IMAGE, DTAG_IMAGE_COLS, _S2("US"), 2, &(uint16_t){ 0 } },
 	{ ITAG_IMAGE_BITS_ALLOC, DGRP_IMAGE, DTAG_IMAGE_BITS_ALLOC, _S2("US"), 2, &(uint16_t){ 16 } },			//
@@ -179,7 +182,7 @@ static int dicom_write_element(int len, char buf[static 8 + len], struct element
 
 
 
-int dicom_write(const char* name, int cols, int rows, long inum, const unsigned char* img)
+static int dicom_write_frames(const char* name, int cols, int rows, int frames, long inum, const unsigned char* img)
 {
 	int fd;
 	void* addr;
@@ -230,14 +233,33 @@ int dicom_write(const char* name, int cols, int rows, long inum, const unsigned
 	dicom_elements[ITAG_IMAGE_INSTANCE_NUM].data = inst_num;
 	dicom_elements[ITAG_IMAGE_INSTANCE_NUM].len = ilen;
 
+	char num_frames[13];
+
+	if (1 < frames) {
+
+		int flen = snprintf(num_frames, 13, "%d", frames);
+
+		assert(flen < 13);
+
+		if (1 == flen % 2)
+			num_frames[flen++] = ' ';
+
+		dicom_elements[ITAG_IMAGE_NUM_FRAMES].data = num_frames;
+		dicom_elements[ITAG_IMAGE_NUM_FRAMES].len = flen;
+	}
+
+	if ((long)rows * cols * frames >= (1L << 30))
+		error("DICOM pixel data too large.\n");
+
 	dicom_elements[ITAG_PIXEL_DATA].data = img;
-	dicom_elements[ITAG_PIXEL_DATA].len = 2 * rows * cols;
+	dicom_elements[ITAG_PIXEL_DATA].len = 2 * rows * cols * frames;
 
 
 	size += 4;	// the pixel data element is larger
 
 	for (int i = 0; i < entries; i++)
-		size += (size_t)(8 + dicom_elements[i].len);
+		if (NULL != dicom_elements[i].data)
+			size += (size_t)(8 + dicom_elements[i].len);
 
 
 	if (-1 == ftruncate(fd, (long)size))
@@ -257,6 +279,9 @@ int dicom_write(const char* name, int cols, int rows, long inum, const unsigned
 	// make sure tags are in ascending order
 	for (int i = 0; i < entries; i++) {
 
+		if (NULL == dicom_elements[i].data)
+			continue;
+
 		assert(((last_group == dicom_elements[i].group) && (last_element < dicom_elements[i].element))
 			|| (last_group < dicom_elements[i].group));
 
@@ -281,3 +306,14 @@ cleanup:
 }
 
 
+
+
+int dicom_write(const char* name, int cols, int rows, long inum, const unsigned char* img)
+{
+	return dicom_write_frames(name, cols, rows, 1, inum, img);
+}
+
+int dicom_write_multiframe(const char* name, int cols, int rows, int frames, const unsigned char* img)
+{
+	return dicom_write_frames(name, cols, rows, frames, 0, img);
+}
@@ -2,4 +2,5 @@
 
 
 extern int dicom_write(const char* name, int cols, int rows, long inum, const unsigned char* img);
+extern int dicom_write_multiframe(const char* name, int cols, int rows, int frames, const unsigned char* img);
 
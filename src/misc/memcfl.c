@@ -11,6 +11,8 @@
 
 #include "misc/misc.h"
 
+#include "bart_embed_api.h"
+
 #include "memcfl.h"
 
 struct memcfl {
@@ -27,6 +29,7 @@ struct memcfl {
 	struct memcfl* next;
 };
 
+// the list is shared by all threads (see bart_command)
 static struct memcfl* memcfl_list = NULL;
 
 void memcfl_register(const char* name, int D, const long dims[D], complex float* data, bool managed)
@@ -35,7 +38,6 @@ void memcfl_register(const char* name, int D, const long dims[D], complex float*
 
 	mem->name = strdup(name);
 	mem->D = D;
-	mem->next = memcfl_list;
 
 	long* ndims = *TYPE_ALLOC(long[D]);
 
@@ -47,7 +49,13 @@ void memcfl_register(const char* name, int D, const long dims[D], complex float*
 	mem->refcount = 1;
 	mem->managed = managed;
 
-	memcfl_list = PTR_PASS(mem);
+#pragma omp critical (bart_memcfl)
+	{
+		mem->next = memcfl_list;
+		memcfl_list = mem;
+	}
+
+	PTR_PASS(mem);
 }
 
 complex float* memcfl_create(const char* name, int D, const long dims[D])
@@ -58,22 +66,33 @@ complex float* memcfl_create(const char* name, int D, const long dims[D])
 }
 
 
-bool memcfl_exists(const char* name)
+static struct memcfl** memcfl_find(const char* name)
 {
-	struct memcfl* mem = memcfl_list;
+	struct memcfl** mem = &memcfl_list;
 
-	while (NULL != mem) {
+	while (NULL != *mem) {
 
-		if (0 == strcmp(mem->name, name))
-			return true;
+		if (0 == strcmp((*mem)->name, name))
+			break;
 
-		mem = mem->next;
+		mem = &(*mem)->next;
 	}
 
-	return false;
+	return mem;
 }
 
-const char** memcfl_list_all(void)
+
+bool memcfl_exists(const char* name)
+{
+	bool ret;
+
+#pragma omp critical (bart_memcfl)
+	ret = (NULL != *memcfl_find(name));
+
+	return ret;
+}
+
+static const char** memcfl_list_all_locked(void)
 {
 	struct memcfl* mem = memcfl_list;
 	int count = 0;
@@ -103,83 +122,254 @@ const char** memcfl_list_all(void)
 	return *list;
 }
 
+const char** memcfl_list_all(void)
+{
+	const char** ret;
+
+#pragma omp critical (bart_memcfl)
+	ret = memcfl_list_all_locked();
+
+	return ret;
+}
+
 
 complex float* memcfl_load(const char* name, int D, long dims[D])
 {
-	struct memcfl* mem = memcfl_list;
+	struct memcfl* mem;
+	bool ok = false;
 
-	while (NULL != mem) {
+#pragma omp critical (bart_memcfl)
+	{
+		mem = *memcfl_find(name);
 
-		if (0 == strcmp(mem->name, name))
-			break;
+		if ((NULL != mem) && (D >= mem->D)) {
 
-		mem = mem->next;
+			for (int i = 0; i < D; i++)
+				dims[i] = (i < mem->D) ? mem->dims[i] : 1;
+
+			mem->refcount++;
+			ok = true;
+		}
 	}
 
-	if (NULL == mem)
+	if (!ok)
 		error("Error loading mem cfl %s\n", name);
 
-	if (D < mem->D)
-		error("Error loading mem cfl %s\n", name);
+	return mem->data;
+}
 
-	for (int i = 0; i < D; i++)
-		dims[i] = (i < mem->D) ? mem->dims[i] : 1;
 
-	mem->refcount++;
+bool memcfl_unmap(const complex float* p)
+{
+	struct memcfl* mem;
+	bool ok = true;
 
-	return mem->data;
+#pragma omp critical (bart_memcfl)
+	{
+		mem = memcfl_list;
+
+		// the same memory may be registered under several names
+
+		struct memcfl* found = NULL;
+
+		for (; NULL != mem; mem = mem->next) {
+
+			if (mem->data != p)
+				continue;
+
+			found = mem;
+
+			if (0 < mem->refcount)
+				break;
+		}
+
+		mem = found;
+
+		if (NULL != mem) {
+
+			if (0 < mem->refcount)
+				mem->refcount--;
+			else
+				ok = false;
+		}
+	}
+
+	if (!ok)
+		error("Error unmapping mem cfl\n");
+
+	return (NULL != mem);
 }
 
 
-bool memcfl_unmap(const complex float* p)
+// remove from list and return it, if it is not mapped anymore (or forced)
+static struct memcfl* memcfl_remove(const char* name, bool force)
 {
-	struct memcfl* mem = memcfl_list;
+	struct memcfl* o = NULL;
 
-	while (NULL != mem) {
+#pragma omp critical (bart_memcfl)
+	{
+		struct memcfl** mem = memcfl_find(name);
 
-		if (mem->data == p)
-			break;
+		// for regular files this is not a problem
 
-		mem = mem->next;
+		if ((NULL != *mem) && (force || (0 == (*mem)->refcount))) {
+
+			o = *mem;
+			*mem = o->next;
+		}
 	}
 
-	if (NULL == mem)
-		return false;
+	return o;
+}
 
-	if (0 >= mem->refcount)
-		error("Error unmapping mem cfl\n");
+static void memcfl_free(struct memcfl* o, bool data)
+{
+	xfree(o->name);
+	xfree(o->dims);
 
-	mem->refcount--;
+	if (data && o->managed)
+		xfree(o->data);
 
-	return true;
+	xfree(o);
 }
 
+
 void memcfl_unlink(const char* name)
 {
-	struct memcfl** mem = &memcfl_list;
+	struct memcfl* o = memcfl_remove(name, false);
 
-	while (NULL != *mem) {
+	if (NULL == o)
+		error("Error unlinking mem cfl %s\n", name);
 
-		if (0 == strcmp((*mem)->name, name))
-			break;
+	memcfl_free(o, true);
+}
 
-		mem = &(*mem)->next;
+
+// as memcfl_remove, but it is kept if it has more than D dimensions
+
+static complex float* memcfl_detach2(const char* name, int D, long dims[D], bool force)
+{
+	struct memcfl* o = NULL;
+
+#pragma omp critical (bart_memcfl)
+	{
+		struct memcfl** mem = memcfl_find(name);
+
+		if ((NULL != *mem) && (force || (0 == (*mem)->refcount)) && (D >= (*mem)->D)) {
+
+			o = *mem;
+			*mem = o->next;
+		}
 	}
 
-	struct memcfl* o = *mem;
+	if (NULL == o)
+		return NULL;
 
-	*mem = (*mem)->next;
+	for (int i = 0; i < D; i++)
+		dims[i] = (i < o->D) ? o->dims[i] : 1;
 
-	// for regular files this is not a problem
+	complex float* data = o->data;
 
-	if (0 < o->refcount)
-		error("Error unlinking mem cfl\n");
+	memcfl_free(o, false);
 
-	xfree(o->name);
-	xfree(o->dims);
-	if (o->managed)
-		xfree(o->data);
-	xfree(o);
+	return data;
 }
 
+complex float* memcfl_detach(const char* name, int D, long dims[D])
+{
+	complex float* data = memcfl_detach2(name, D, dims, false);
+
+	if (NULL == data)
+		error("Error detaching mem cfl %s\n", name);
+
+	return data;
+}
+
+
+// embedding API (bart_embed_api.h)
+
+void* load_mem_cfl(const char* name, unsigned int D, long dimensions[])
+{
+	complex float* data = NULL;
+
+#pragma omp critical (bart_memcfl)
+	{
+		struct memcfl* mem = *memcfl_find(name);
+
+		if ((NULL != mem) && ((int)D >= mem->D)) {
+
+			for (int i = 0; i < (int)D; i++)
+				dimensions[i] = (i < mem->D) ? mem->dims[i] : 1;
 
+			data = mem->data;
+		}
+	}
+
+	return data;
+}
+
+static void register_mem_cfl(const char* name, unsigned int D, const long dimensions[], void* ptr, bool managed)
+{
+	memcfl_register(name, (int)D, dimensions, ptr, managed);
+
+	// not mapped by anybody yet
+	memcfl_unmap(ptr);
+}
+
+void register_mem_cfl_malloc(const char* name, unsigned int D, const long dimensions[], void* ptr)
+{
+	register_mem_cfl(name, D, dimensions, ptr, true);
+}
+
+void register_mem_cfl_non_managed(const char* name, unsigned int D, const long dims[], void* ptr)
+{
+	register_mem_cfl(name, D, dims, ptr, false);
+}
+
+// the following do not call error(), as they are used outside of bart_command
+
+void* detach_mem_cfl(const char* name, unsigned int D, long dimensions[])
+{
+	return memcfl_detach2(name, (int)D, dimensions, true);
+}
+
+void unregister_mem_cfl(const char* name)
+{
+	struct memcfl* o = memcfl_remove(name, true);
+
+	if (NULL != o)
+		memcfl_free(o, true);
+}
+
+void deallocate_all_mem_cfl(void)
+{
+	struct memcfl* unused = NULL;
+
+#pragma omp critical (bart_memcfl)
+	{
+		struct memcfl** mem = &memcfl_list;
+
+		while (NULL != *mem) {
+
+			struct memcfl* o = *mem;
+
+			if (0 < o->refcount) {
+
+				mem = &o->next;
+				continue;
+			}
+
+			*mem = o->next;
+			o->next = unused;
+			unused = o;
+		}
+	}
+
+	while (NULL != unused) {
+
+		struct memcfl* o = unused;
+
+		unused = o->next;
+		memcfl_free(o, true);
+	}
+}
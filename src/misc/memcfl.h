@@ -8,5 +8,6 @@ extern complex float* memcfl_create(const char* name, int D, const long dims[D])
 extern complex float* memcfl_load(const char* name, int D, long dims[D]);
 extern bool memcfl_unmap(const complex float* p);
 extern void memcfl_unlink(const char* name);
+extern complex float* memcfl_detach(const char* name, int D, long dims[D]);
 extern const char** memcfl_list_all(void);
 
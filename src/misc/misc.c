@@ -49,9 +49,11 @@ struct error_jumper_s {
 	jmp_buf buf;
 };
 
-extern struct error_jumper_s error_jumper;	// FIXME should not be extern
+extern _Thread_local struct error_jumper_s error_jumper;	// FIXME should not be extern
 
-struct error_jumper_s error_jumper = { .initialized = false };
+// per thread, so that commands can run concurrently (see bart_command),
+// error() on a thread without an active error_catcher() aborts
+_Thread_local struct error_jumper_s error_jumper = { .initialized = false };
 
 
 
@@ -138,8 +140,8 @@ int error_catcher(int fun(int argc, char* argv[argc]), int argc, char* argv[argc
 }
 
 
-extern FILE* bart_output;
-FILE* bart_output = NULL;
+extern _Thread_local FILE* bart_output;
+_Thread_local FILE* bart_output = NULL;
 
 int bart_printf(const char* fmt, ...)
 {
@@ -548,7 +550,8 @@ static const char* quote(const char* str)
 	return *qstr;
 }
 
-const char* command_line = NULL;
+// per thread, so that concurrent commands do not mix up headers
+_Thread_local const char* command_line = NULL;
 
 char* stdin_command_line = NULL;
 
@@ -583,17 +586,18 @@ void* save_command_line(int argc, char* argv[static argc])
 
 	(*buf)[pos] = '\0';
 
-#pragma omp critical (bart_opts_commandline)
-	{
-		if (NULL == command_line) {
+	// worker threads may still have the one of a previous command
 
-			command_line = *buf;
+	if ((NULL != command_line) && (0 == strcmp(*buf, command_line))) {
 
-		} else {
+		xfree(*buf);
 
-			assert(0 == strcmp(*buf, command_line));
-			xfree(*buf);
-		}
+	} else {
+
+		if (NULL != command_line)
+			xfree(command_line);
+
+		command_line = *buf;
 	}
 
 	// FIXME: workaround analyzer detecting a leak
@@ -121,7 +121,11 @@ extern void print_complex(int D, const _Complex float arr[__VLA(D)]);
 
 extern int bitcount(unsigned long flags);
 
-extern const char* command_line;
+#ifdef __cplusplus
+extern thread_local const char* command_line;
+#else
+extern _Thread_local const char* command_line;
+#endif
 extern char* stdin_command_line;
 extern void* save_command_line(int argc, char* argv[__VLA(argc)]);
 
@@ -910,6 +910,15 @@ static complex float* create_cfl_internal(const char* name, int D, const long di
 		addr = create_cfl_typed(type, name, D, dims, stream_flags);
 	}
 
+	// write finished slices of regular files in the background
+	// (useful for network file systems)
+
+	if (   (0 == strcmp("1", getenv("BART_WRITEBACK") ? : ""))
+	    && (0 != (md_nontriv_dims(D, dims) & stream_flags))
+	    && !cfl_loop_desc_active() && mpi_is_main_proc()
+	    && ((FILE_TYPE_CFL == type) || (FILE_TYPE_RA == type)))
+		stream_create_writeback(D, dims, stream_flags, name, addr);
+
 	return create_worker_buffer(D, dims, addr, true);
 }
 
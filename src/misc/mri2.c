@@ -297,3 +297,29 @@ void estimate_fast_sq_im_dims(int N, long dims[3], const long tdims[N], const co
 		dims[j] = (0. == max_dims[j]) ? 1 : fast_size;
 }
 
+
+
+/**
+ * Dimensions of a coarse grid for multilevel reconstruction.
+ * Non-trivial dimensions in flags are scaled by f and rounded
+ * so that the parity (and thus the k-space center) is preserved.
+ */
+void multilevel_dims(int N, unsigned long flags, long ldims[N], const long dims[N], float f)
+{
+	assert((0. < f) && (f <= 1.));
+
+	md_copy_dims(N, ldims, dims);
+
+	for (int i = 0; i < N; i++) {
+
+		if (!MD_IS_SET(flags, i) || (1 == dims[i]))
+			continue;
+
+		long d = lround(f * dims[i]);
+
+		if ((d - dims[i]) % 2)
+			d++;
+
+		ldims[i] = MIN(MAX(d, 2 + dims[i] % 2), dims[i]);
+	}
+}
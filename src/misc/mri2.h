@@ -17,6 +17,8 @@ extern void calib_geom(long caldims[DIMS], long calpos[DIMS], const long calsize
 extern void estimate_im_dims(int N, unsigned long flags, long dims[__VLA(N)], const long tdims[__VLA(N)], const _Complex float* traj);
 extern void estimate_fast_sq_im_dims(int N, long dims[3], const long tdims[__VLA(N)], const _Complex float* traj);
 
+extern void multilevel_dims(int N, unsigned long flags, long ldims[__VLA(N)], const long dims[__VLA(N)], float f);
+
 #include "misc/cppwrap.h"
 
 #endif	// __MRI2_H
@@ -0,0 +1,182 @@
+/* Copyright 2026. Institute of Biomedical Imaging. TU Graz.
+ * All rights reserved. Use of this source code is governed by
+ * a BSD-style license which can be found in the LICENSE file.
+ *
+ * Cache for operators across iterations of bart loop mode.
+ *
+ * With 'bart -l/-p', a command is run once for every slice or frame.
+ * Operators which only depend on dimensions and auxiliary inputs
+ * which are identical for all iterations (e.g. a trajectory) can
+ * be kept alive instead of being rebuilt every time. Every loop
+ * worker keeps at most one object per name, identified by a key
+ * describing its structure (dimensions, configuration). Objects are
+ * responsible for checking whether their data needs to be updated.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "misc/misc.h"
+#include "misc/debug.h"
+#include "misc/list.h"
+#include "misc/lock.h"
+#include "misc/mmio.h"
+
+#include "opcache.h"
+
+
+struct opcache_entry_s {
+
+	const char* name;
+	int worker;
+
+	uint64_t key;
+
+	const void* obj;
+	opcache_del_t del;
+};
+
+static list_t opcache = NULL;
+static bart_lock_t* opcache_lock = NULL;
+
+
+bool opcache_enabled(void)
+{
+	return cfl_loop_desc_active();
+}
+
+
+/*
+ * FNV-1a style hash, processing eight bytes at a time.
+ */
+uint64_t opcache_hash(uint64_t h, size_t size, const void* data)
+{
+	const uint64_t prime = 0x100000001b3ULL;
+	const unsigned char* p = data;
+
+	if (0 == h)
+		h = 0xcbf29ce484222325ULL;
+
+	for (; size >= 8; size -= 8, p += 8) {
+
+		uint64_t w;
+		memcpy(&w, p, 8);
+
+		h = (h ^ w) * prime;
+		h ^= h >> 29;
+	}
+
+	for (; size > 0; size--, p++)
+		h = (h ^ *p) * prime;
+
+	return h;
+}
+
+
+static void opcache_init(void)
+{
+#pragma omp critical(opcache_init)
+	if (NULL == opcache_lock) {
+
+		opcache = list_create();
+		opcache_lock = bart_lock_create();
+	}
+}
+
+
+static bool entry_cmp(const void* _e, const void* _ref)
+{
+	const struct opcache_entry_s* e = _e;
+	const struct opcache_entry_s* ref = _ref;
+
+	return (e->worker == ref->worker) && (0 == strcmp(e->name, ref->name));
+}
+
+
+static void entry_free(struct opcache_entry_s* e)
+{
+	e->del(e->obj);
+
+	xfree(e->name);
+	xfree(e);
+}
+
+
+/*
+ * Returns the object stored by this loop worker under 'name' if
+ * its structure key matches (NULL otherwise). The object is owned
+ * by the cache.
+ */
+const void* opcache_get(const char* name, uint64_t key)
+{
+	opcache_init();
+
+	struct opcache_entry_s ref = { .name = name, .worker = cfl_loop_worker_id() };
+
+	const void* obj = NULL;
+
+	bart_lock(opcache_lock);
+
+	int idx = list_get_first_index(opcache, &ref, entry_cmp);
+
+	if (0 <= idx) {
+
+		const struct opcache_entry_s* e = list_get_item(opcache, idx);
+
+		if (e->key == key)
+			obj = e->obj;
+	}
+
+	bart_unlock(opcache_lock);
+
+	debug_printf(DP_DEBUG2, "Operator cache %s (worker %d): %s.\n", name, ref.worker, (NULL != obj) ? "hit" : "miss");
+
+	return obj;
+}
+
+
+/*
+ * Store an object (replacing the previous one of this loop worker).
+ * The cache takes ownership and releases it with 'del'.
+ */
+void opcache_put(const char* name, uint64_t key, const void* obj, opcache_del_t del)
+{
+	opcache_init();
+
+	PTR_ALLOC(struct opcache_entry_s, e);
+
+	e->name = strdup(name);
+	e->worker = cfl_loop_worker_id();
+	e->key = key;
+	e->obj = obj;
+	e->del = del;
+
+	bart_lock(opcache_lock);
+
+	int idx = list_get_first_index(opcache, e, entry_cmp);
+
+	struct opcache_entry_s* old = (0 <= idx) ? list_remove_item(opcache, idx) : NULL;
+
+	list_append(opcache, PTR_PASS(e));
+
+	bart_unlock(opcache_lock);
+
+	if (NULL != old)
+		entry_free(old);
+}
+
+
+void opcache_clear(void)
+{
+	if (NULL == opcache_lock)
+		return;
+
+	while (0 < list_count(opcache))
+		entry_free(list_pop(opcache));
+
+	list_free(opcache);
+	bart_lock_destroy(opcache_lock);
+
+	opcache = NULL;
+	opcache_lock = NULL;
+}
@@ -0,0 +1,22 @@
+
+#ifndef _MISC_OPCACHE_H
+#define _MISC_OPCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "misc/cppwrap.h"
+
+typedef void (*opcache_del_t)(const void* obj);
+
+extern _Bool opcache_enabled(void);
+
+extern uint64_t opcache_hash(uint64_t h, size_t size, const void* data);
+
+extern const void* opcache_get(const char* name, uint64_t key);
+extern void opcache_put(const char* name, uint64_t key, const void* obj, opcache_del_t del);
+extern void opcache_clear(void);
+
+#include "misc/cppwrap.h"
+
+#endif // _MISC_OPCACHE_H
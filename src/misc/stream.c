@@ -28,6 +28,7 @@
 #include "misc/lock.h"
 #include "misc/shrdptr.h"
 #include "misc/list.h"
+#include "misc/writeback.h"
 
 #include "stream.h"
 
@@ -62,6 +63,8 @@ struct stream {
 
 	int pipefd;
 
+	struct writeback_s* writeback;
+
 	bool busy;
 	bart_lock_t *lock;
 	bart_cond_t *cond;
@@ -422,6 +425,11 @@ static void stream_del(const struct shared_obj_s* sptr)
 		long dims[D];
 		pcfl_get_dimensions(s->data, D, dims);
 
+		// wait for data which is currently written back
+
+		if (NULL != s->writeback)
+			writeback_free(s->writeback);
+
 		if (s->unmap)
 			unmap_shared_cfl(D, dims, s->ptr);
 
@@ -438,6 +446,23 @@ static void stream_del(const struct shared_obj_s* sptr)
 	xfree(s);
 }
 
+/**
+ * Creates a stream for a memory mapped output file.
+ *
+ * Slices which are synchronized are written back to the file in
+ * the background (see misc/writeback.c).
+ */
+stream_t stream_create_writeback(int D, const long dims[D], unsigned long flags, const char* name, complex float* ptr)
+{
+	stream_t s = stream_create(D, dims, -1, false, false, flags, name, false);
+
+	s->writeback = writeback_create(name, (size_t)md_calc_size(D, dims) * sizeof(complex float));
+
+	stream_attach(s, ptr, true, true);
+
+	return s;
+}
+
 stream_t stream_clone(stream_t s)
 {
 	shared_obj_ref(&s->sptr);
@@ -799,8 +824,48 @@ static bool stream_receive_idx_locked(stream_t s)
 	return ret;
 }
 
+static void stream_mark_synced_locked(stream_t s, long index)
+{
+	s->data->synced[index] = true;
+
+	while ((s->data->index < s->data->tot - 1) && (s->data->synced[s->data->index + 1]))
+		s->data->index++;
+}
+
+static void stream_writeback_index_locked(stream_t s, long index)
+{
+	int D = s->data->D;
+
+	long strs[D];
+	md_calc_strides(D, strs, s->data->dims, sizeof(complex float));
+
+	long pos[D];
+	md_set_dims(D, pos, 0);
+	md_unravel_index(D, pos, s->data->stream_flags, s->data->dims, index);
+
+	long start = md_calc_offset(D, strs, pos);
+
+	for (int i = 0; i < D; i++)
+		if (!MD_IS_SET(s->data->stream_flags, i))
+			pos[i] = s->data->dims[i] - 1;
+
+	long end = md_calc_offset(D, strs, pos) + (long)sizeof(complex float);
+
+	// the region covers the slice (which does not need to be contiguous)
+
+	writeback_push(s->writeback, (char*)s->ptr + start, (size_t)(end - start));
+
+	stream_mark_synced_locked(s, index);
+}
+
 static bool stream_send_index_locked(stream_t s, long index)
 {
+	if (NULL != s->writeback) {
+
+		stream_writeback_index_locked(s, index);
+		return true;
+	}
+
 	// if sending, save timestamp before starting sending of index.
 	stream_log_index(s, index, timestamp());
 
@@ -862,10 +927,7 @@ static bool stream_send_index_locked(stream_t s, long index)
 	if (!stream_send_msg(s->pipefd, &(struct stream_msg){ .type = STREAM_MSG_BREAK }))
 		return false;
 
-	s->data->synced[index] = true;
-
-	while ((s->data->index < s->data->tot - 1) && (s->data->synced[s->data->index + 1]))
-		s->data->index++;
+	stream_mark_synced_locked(s, index);
 
 	debug_printf(DP_DEBUG3, "data offset sent: %ld\n", s->data->index);
 	return true;
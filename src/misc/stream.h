@@ -31,6 +31,7 @@ extern _Bool* stream_get_synced(stream_t s);
 
 
 extern stream_t stream_create(int N, const long dims[__VLA(N)], int pipefd, _Bool input, _Bool binary, unsigned long flags, const char* name, _Bool call_msync);
+extern stream_t stream_create_writeback(int D, const long dims[__VLA(D)], unsigned long flags, const char* name, _Complex float* ptr);
 extern stream_t stream_clone(stream_t s);
 
 extern void stream_free(stream_t s);
@@ -0,0 +1,192 @@
+/* Copyright 2026. Institute of Biomedical Imaging. TU Graz.
+ * All rights reserved. Use of this source code is governed by
+ * a BSD-style license which can be found in the LICENSE file.
+ *
+ * Background writeback of memory mapped output files.
+ *
+ * Regions of a shared mapping which a command has finished writing
+ * are queued and flushed with msync by a writer thread, overlapping
+ * I/O with computation. Without this, the kernel writes all dirty pages
+ * when the file is closed or the process exits (which on network file
+ * systems happens synchronously).
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <threads.h>
+#endif
+
+#include "misc/misc.h"
+#include "misc/debug.h"
+#include "misc/lock.h"
+#include "misc/list.h"
+
+#include "writeback.h"
+
+
+struct writeback_region_s {
+
+	void* ptr;
+	size_t size;
+};
+
+struct writeback_s {
+
+	const char* name;
+
+	bart_lock_t* lock;
+	bart_cond_t* cond;
+
+	list_t queue;
+	bool done;
+
+	size_t size;
+	size_t bytes_background;
+
+#ifdef _OPENMP
+	thrd_t thread;
+#endif
+};
+
+
+#ifdef _OPENMP
+static void writeback_region(struct writeback_s* wb, struct writeback_region_s* r)
+{
+	if (0 != msync(r->ptr, r->size, MS_SYNC))
+		debug_printf(DP_WARN, "Writeback of %s failed: %s\n", wb->name, strerror(errno));
+
+	bart_lock(wb->lock);
+	wb->bytes_background += r->size;
+	bart_unlock(wb->lock);
+
+	xfree(r);
+}
+
+
+static int writeback_thread(void* _wb)
+{
+	struct writeback_s* wb = _wb;
+
+	bart_lock(wb->lock);
+
+	while (true) {
+
+		while (!wb->done && (0 == list_count(wb->queue)))
+			bart_cond_wait(wb->cond, wb->lock);
+
+		if (wb->done)
+			break;
+
+		struct writeback_region_s* r = list_pop(wb->queue);
+
+		bart_unlock(wb->lock);
+
+		writeback_region(wb, r);
+
+		bart_lock(wb->lock);
+	}
+
+	bart_unlock(wb->lock);
+
+	return 0;
+}
+#endif
+
+
+struct writeback_s* writeback_create(const char* name, size_t size)
+{
+	PTR_ALLOC(struct writeback_s, wb);
+
+	wb->name = strdup(name);
+	wb->lock = bart_lock_create();
+	wb->cond = bart_cond_create();
+	wb->queue = list_create();
+	wb->done = false;
+
+	wb->size = size;
+	wb->bytes_background = 0;
+
+#ifdef _OPENMP
+	if (thrd_success != thrd_create(&wb->thread, writeback_thread, wb))
+		error("Creating writeback thread for %s\n", name);
+#endif
+
+	return PTR_PASS(wb);
+}
+
+
+/*
+ * Queue a region which will not be modified anymore.
+ * The region is extended to full pages, so it may
+ * also flush parts of neighboring regions.
+ */
+void writeback_push(struct writeback_s* wb, const void* ptr, size_t size)
+{
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+	uintptr_t start = (uintptr_t)ptr & ~(page - 1);
+	uintptr_t end = (uintptr_t)ptr + size;
+
+#ifdef _OPENMP
+	PTR_ALLOC(struct writeback_region_s, r);
+
+	r->ptr = (void*)start;
+	r->size = end - start;
+
+	bart_lock(wb->lock);
+
+	list_append(wb->queue, PTR_PASS(r));
+
+	bart_cond_notify_all(wb->cond);
+	bart_unlock(wb->lock);
+#else
+	(void)wb;
+	(void)start;
+	(void)end;
+#endif
+}
+
+
+/*
+ * Wait for the region currently written. Regions which are still
+ * queued are left to the kernel, as for any other output file.
+ */
+void writeback_free(struct writeback_s* wb)
+{
+	double start = timestamp();
+
+	bart_lock(wb->lock);
+
+	while (0 < list_count(wb->queue))
+		xfree(list_pop(wb->queue));
+
+	wb->done = true;
+
+	bart_cond_notify_all(wb->cond);
+	bart_unlock(wb->lock);
+
+#ifdef _OPENMP
+	thrd_join(wb->thread, NULL);
+#endif
+
+	// regions are extended to full pages
+	size_t background = MIN(wb->bytes_background, wb->size);
+
+	debug_printf(DP_DEBUG1, "Writeback %s: %.1f MB in background, %.1f MB left at unmap (overlap: %.0f%%), waited %.3fs.\n",
+		     wb->name, background / 1.E6, (wb->size - background) / 1.E6,
+		     (0 == wb->size) ? 0. : 100. * background / wb->size, timestamp() - start);
+
+	list_free(wb->queue);
+	bart_cond_destroy(wb->cond);
+	bart_lock_destroy(wb->lock);
+
+	xfree(wb->name);
+	xfree(wb);
+}
+
@@ -0,0 +1,9 @@
+
+#include <stddef.h>
+
+struct writeback_s;
+
+extern struct writeback_s* writeback_create(const char* name, size_t size);
+extern void writeback_push(struct writeback_s* wb, const void* ptr, size_t size);
+extern void writeback_free(struct writeback_s* wb);
+
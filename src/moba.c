@@ -35,6 +35,7 @@
 #include "linops/someops.h"
 
 #include "iter/iter2.h"
+#include "iter/checkpoint.h"
 
 #include "grecon/optreg.h"
 #include "grecon/italgo.h"
@@ -198,6 +199,9 @@ int main_moba(int argc, char* argv[argc])
 
 	bool t2_old_flag = false;
 
+	const char* checkpoint_file = NULL;
+	long checkpoint_mod = 10;
+
 	const struct opt_s opts[] = {
 
                 //FIXME: Sort options into optimization and others interface
@@ -251,6 +255,8 @@ int main_moba(int argc, char* argv[argc])
 		OPTL_FLOAT(0, "scale_data", &scaling, "", "scaling factor for data"),
 		OPTL_FLOAT(0, "scale_psf", &scaling_psf, "", "(scaling factor for PSF)"),
 		OPTL_SET(0, "normalize_scaling", &normalize_scaling, "(normalize scaling by data / PSF)"),
+		OPTL_STRING(0, "checkpoint", &checkpoint_file, "file", "checkpoint solver state to file and resume from it"),
+		OPTL_LONG(0, "checkpoint-mod", &checkpoint_mod, "mod", "write checkpoint every mod iterations (default: 10)"),
                 OPTL_SUBOPT(0, "seq", "...", "configure sequence parameters", ARRAY_SIZE(seq_opts), seq_opts),
                 OPTL_SUBOPT(0, "sim", "...", "configure simulation parameters", ARRAY_SIZE(sim_opts), sim_opts),
                 OPTL_SUBOPT(0, "other", "...", "configure other parameters", ARRAY_SIZE(other_opts), other_opts),
@@ -258,6 +264,14 @@ int main_moba(int argc, char* argv[argc])
 
 	cmdline(&argc, argv, ARRAY_SIZE(args), args, help_str, ARRAY_SIZE(opts), opts);
 
+	if (NULL != checkpoint_file) {
+
+		if (cfl_loop_desc_active())
+			error("Checkpoints are not supported with looping.\n");
+
+		iter_checkpoint_configure(checkpoint_file, checkpoint_mod);
+	}
+
 	if (0 != conf.num_gpu)
 		error("Multi-GPU only supported by MPI!\n");
 
@@ -714,6 +728,8 @@ int main_moba(int argc, char* argv[argc])
 
 	debug_printf(DP_DEBUG2, "Total Time: %.2f s\n", recosecs);
 
+	iter_checkpoint_configure(NULL, 0);
+
 	return 0;
 }
 
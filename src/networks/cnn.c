@@ -285,18 +285,11 @@ static nn_t network_resnet_create(const struct network_s* _config, int NO, const
 		}
 	}
 
-	result = nn_append_convcorr_layer_generic(	result, 0, NULL, wnames[0],
-							config->conv_flag, tchannel_flag, tgroup_flag,
-							N, kdims, NULL, config->dilations,
-							false, PAD_SAME, initializer_clone(conv_init));
-
-	if (config->batch_norm && config->batch_norm_lf)
-		result = nn_append_batchnorm_layer(result, 0, NULL, wnames[7], ~(config->channel_flag | config->group_flag), status, NULL);
-
-	if (config->bias)
-		result = nn_append_activation_bias(result, 0, NULL, wnames[3], config->activation, MD_BIT(0));
-	else
-		result = nn_append_activation(result, 0, NULL, config->activation, MD_BIT(0));
+	result = nn_append_convcorr_bias_act_layer_generic(	result, 0, NULL, wnames[0], wnames[7], wnames[3],
+								config->conv_flag, tchannel_flag, tgroup_flag,
+								N, kdims, NULL, config->dilations,
+								false, PAD_SAME, initializer_clone(conv_init),
+								config->batch_norm && config->batch_norm_lf, config->bias, config->activation, status);
 
 
 	for (int i = 0; i < config->Nl - 2; i++) {
@@ -307,18 +300,11 @@ static nn_t network_resnet_create(const struct network_s* _config, int NO, const
 		result = nn_mark_stack_output_if_exists_F(result, wnames[8]);
 
 
-		result = nn_append_convcorr_layer_generic(result, 0, NULL, wnames[1],
+		result = nn_append_convcorr_bias_act_layer_generic(result, 0, NULL, wnames[1], wnames[8], wnames[4],
 				config->conv_flag, config->channel_flag, config->group_flag,
 				N, kdims, NULL, config->dilations,
-				false, PAD_SAME, initializer_clone(conv_init));
-
-		if (config->batch_norm)
-			result = nn_append_batchnorm_layer(result, 0, NULL, wnames[8], ~(config->channel_flag | config->group_flag), status, NULL);
-
-		if (config->bias)
-			result = nn_append_activation_bias(result, 0, NULL, wnames[4], config->activation, MD_BIT(0));
-		else
-			result = nn_append_activation(result, 0, NULL, config->activation, MD_BIT(0));
+				false, PAD_SAME, initializer_clone(conv_init),
+				config->batch_norm, config->bias, config->activation, status);
 
 		result = nn_append_singleton_dim_in_if_exists_F(result, wnames[1]);
 		result = nn_append_singleton_dim_in_if_exists_F(result, wnames[4]);
@@ -350,16 +336,13 @@ static nn_t network_resnet_create(const struct network_s* _config, int NO, const
 
 	const struct initializer_s* conv_init_last = (config->batch_norm || !config->zero_init) ? initializer_clone(conv_init) : init_const_create(0);
 
-	result = nn_append_convcorr_layer_generic(	result, 0, NULL, wnames[2],
-							config->conv_flag, tchannel_flag, tgroup_flag,
-							N, ldims, NULL, config->dilations,
-							false, PAD_SAME, initializer_clone(conv_init));
-
-	initializer_free(conv_init);
-	initializer_free(conv_init_last);
-
 	if (config->batch_norm && config->batch_norm_lf) {
 
+		result = nn_append_convcorr_layer_generic(	result, 0, NULL, wnames[2],
+								config->conv_flag, tchannel_flag, tgroup_flag,
+								N, ldims, NULL, config->dilations,
+								false, PAD_SAME, initializer_clone(conv_init));
+
 		result = nn_append_batchnorm_layer(result, 0, NULL, wnames[9], ~(config->channel_flag | config->group_flag), status, NULL);
 
 		//append gamma for batchnorm
@@ -374,12 +357,23 @@ static nn_t network_resnet_create(const struct network_s* _config, int NO, const
 		result = nn_set_initializer_F(result, 0, wnames[6], init_const_create(0));
 		result = nn_set_in_type_F(result, 0, wnames[6], IN_OPTIMIZE);
 		result = nn_set_dup_F(result, 0, wnames[6], false);
+
+		if (config->bias)
+			result = nn_append_activation_bias(result, 0, NULL, wnames[5], config->last_activation, MD_BIT(0));
+		else
+			result = nn_append_activation(result, 0, NULL, config->last_activation, MD_BIT(0));
+
+	} else {
+
+		result = nn_append_convcorr_bias_act_layer_generic(	result, 0, NULL, wnames[2], NULL, wnames[5],
+									config->conv_flag, tchannel_flag, tgroup_flag,
+									N, ldims, NULL, config->dilations,
+									false, PAD_SAME, initializer_clone(conv_init),
+									false, config->bias, config->last_activation, status);
 	}
 
-	if (config->bias)
-		result = nn_append_activation_bias(result, 0, NULL, wnames[5], config->last_activation, MD_BIT(0));
-	else
-		result = nn_append_activation(result, 0, NULL, config->last_activation, MD_BIT(0));
+	initializer_free(conv_init);
+	initializer_free(conv_init_last);
 
 	//this scale is for compatibility as resdidual should sum for resnet but -1 is used above
 	result = nn_chain2_FF(result, 0, NULL, nn_from_nlop_F(nlop_from_linop_F(linop_scale_create(N, odims, -1))), 0, NULL);
@@ -547,10 +541,15 @@ static nn_t network_mnist_create(const struct network_s* /*_config*/, int NO, co
 
 	bool conv = false;
 
-	network = nn_append_convcorr_layer(network, 0, NULL, "conv_", 32, kernel_size, conv, PAD_VALID, true, NULL, NULL, NULL);
-	network = nn_append_activation_bias(network, 0, NULL, "conv_bias_", ACT_RELU, MD_BIT(0));
-	network = nn_append_convcorr_layer(network, 0, NULL, "conv_", 64, kernel_size, conv, PAD_VALID, true, NULL, NULL, NULL);
-	network = nn_append_activation_bias(network, 0, NULL, "conv_bias_", ACT_RELU, MD_BIT(0));
+	for (int i = 0; i < 2; i++) {
+
+		long kdims[5] = { 32 << i, kernel_size[0], kernel_size[1], kernel_size[2], 1 };
+
+		network = nn_append_convcorr_bias_act_layer_generic(network, 0, NULL, "conv_", NULL, "conv_bias_",
+								    14, MD_BIT(0), 0, 5, kdims, NULL, NULL, conv, PAD_VALID,
+								    init_kaiming_create(in_flag_conv(true), true, false, 0),
+								    false, true, ACT_RELU, status);
+	}
 	network = nn_append_maxpool_layer(network, 0, NULL, pool_size, PAD_VALID, true);
 
 	network = nn_append_flatten_layer(network, 0, NULL);
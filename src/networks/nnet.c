@@ -40,6 +40,7 @@
 #include "nn/chain.h"
 #include "nn/weights.h"
 #include "nn/layers.h"
+#include "nn/quantize.h"
 
 #include "networks/unet.h"
 #include "networks/losses.h"
@@ -67,6 +68,9 @@ struct nnet_s nnet_init = {
 	.graph_file = NULL,
 
 	.N_segm_labels = -1,
+
+	.quantize = QUANT_NONE,
+	.quant_report = false,
 };
 
 static int get_no_odims_mnist(const struct nnet_s* /*config*/, int NI, const long /*idims*/[NI])
@@ -303,15 +307,10 @@ void train_nnet(struct nnet_s* config,
 }
 
 
-void apply_nnet(	const struct nnet_s* config,
-			int NO, const long odims[NO], complex float* out,
-			int NI, const long idims[NI], const complex float* in)
+static void apply_nnet_op(	const struct nnet_s* config, nn_t nnet,
+				int NO, const long odims[NO], complex float* out,
+				int NI, const long idims[NI], const complex float* in)
 {
-	if (config->gpu)
-		move_gpu_nn_weights(config->weights);
-
-	auto nnet = nnet_apply_op_create(config, NO, odims, NI, idims);
-
 	static bool export = true;
 
 	if (export && (NULL != config->graph_file)) {
@@ -331,20 +330,43 @@ void apply_nnet(	const struct nnet_s* config,
 
 	md_copy(NO, odims, out, out_tmp, CFL_SIZE);
 
-	nn_free(nnet);
-
 	md_free(in_tmp);
 	md_free(out_tmp);
 }
 
 
-void apply_nnet_batchwise(	const struct nnet_s* config,
+void apply_nnet(	const struct nnet_s* config,
+			int NO, const long odims[NO], complex float* out,
+			int NI, const long idims[NI], const complex float* in)
+{
+	if (config->gpu)
+		move_gpu_nn_weights(config->weights);
+
+	auto nnet = nnet_apply_op_create(config, NO, odims, NI, idims);
+
+	apply_nnet_op(config, nnet, NO, odims, out, NI, idims, in);
+
+	nn_free(nnet);
+}
+
+
+static void apply_nnet_batchwise_int(	const struct nnet_s* config,
 				int NO, const long odims[NO], complex float* out,
 				int NI, const long idims[NI], const complex float* in,
 				long Nb)
 {
+	if (config->gpu)
+		move_gpu_nn_weights(config->weights);
+
 	long Nt = odims[NO - 1];
 
+	const complex float* in0 = in;
+
+	// one network for each batch size (full batches and the remainder)
+
+	nn_t nnet = NULL;
+	long Nn = 0;
+
 	while (0 < Nt) {
 
 		long odims1[NO];
@@ -358,13 +380,67 @@ void apply_nnet_batchwise(	const struct nnet_s* config,
 		odims1[NO - 1] = Nb_tmp;
 		idims1[NI - 1] = Nb_tmp;
 
-		apply_nnet(config, NO, odims1, out, NI, idims1, in);
+		if (Nn != Nb_tmp) {
+
+			if (NULL != nnet)
+				nn_free(nnet);
+
+			nnet = nnet_apply_op_create(config, NO, odims1, NI, idims1);
+			Nn = Nb_tmp;
+
+			// calibrate activation ranges of quantized layers on the leading samples
+
+			if (QUANT_NONE != nn_quantize_active()) {
+
+				nn_quantize_calibrate(true);
+				apply_nnet_op(config, nnet, NO, odims1, out, NI, idims1, in0);
+				nn_quantize_calibrate(false);
+			}
+		}
+
+		apply_nnet_op(config, nnet, NO, odims1, out, NI, idims1, in);
 
 		out += md_calc_size(NO, odims1);
 		in += md_calc_size(NI, idims1);
 
 		Nt -= Nb_tmp;
 	}
+
+	if (NULL != nnet)
+		nn_free(nnet);
+}
+
+
+void apply_nnet_batchwise(	const struct nnet_s* config,
+				int NO, const long odims[NO], complex float* out,
+				int NI, const long idims[NI], const complex float* in,
+				long Nb)
+{
+	if (QUANT_NONE == config->quantize) {
+
+		apply_nnet_batchwise_int(config, NO, odims, out, NI, idims, in, Nb);
+		return;
+	}
+
+	complex float* ref = NULL;
+
+	if (config->quant_report) {
+
+		ref = md_alloc(NO, odims, CFL_SIZE);
+		apply_nnet_batchwise_int(config, NO, odims, ref, NI, idims, in, Nb);
+	}
+
+	nn_quantize_begin(config->quantize);
+
+	apply_nnet_batchwise_int(config, NO, odims, out, NI, idims, in, Nb);
+
+	nn_quantize_end();
+
+	if (NULL != ref) {
+
+		debug_printf(DP_INFO, "NRMSE %s vs fp32: %e\n", quant_type_name(config->quantize), md_znrmse(NO, odims, ref, out));
+		md_free(ref);
+	}
 }
 
 
@@ -1,5 +1,7 @@
 
 
+#include "nn/quantize.h"
+
 struct loss_config_s;
 struct nn_weights_s;
 struct network_s;
@@ -28,6 +30,9 @@ struct nnet_s {
 	const char* graph_file;
 
 	long N_segm_labels;
+
+	enum QUANT_TYPE quantize;
+	_Bool quant_report;
 };
 
 extern struct nnet_s nnet_init;
@@ -41,6 +41,7 @@
 #include "nlops/mri_ops.h"
 #include "nlops/const.h"
 #include "nlops/stack.h"
+#include "nlops/checkpointing.h"
 
 #include "nn/activation.h"
 #include "nn/layers.h"
@@ -103,12 +104,16 @@ struct reconet_s reconet_config_opts = {
 
 	.gpu = false,
 	.low_mem = false,
+	.mem_budget = 0.,
 
 	.graph_file = NULL,
 
 	.coil_image = false,
 
 	.normalize_rss = false,
+
+	.quantize = QUANT_NONE,
+	.quant_report = false,
 };
 
 static void reconet_init_default(struct reconet_s* reconet) {
@@ -612,48 +617,47 @@ static nn_t reconet_cell_create(const struct reconet_s* config, int Nb, struct s
 }
 
 
-static nn_t reconet_iterations_create(const struct reconet_s* config, int Nb, struct sense_model_s* models[Nb], enum NETWORK_STATUS status)
+/**
+ * Chain two sequences of reconet cells
+ *
+ * Inputs of b are shared with or stacked to those of a,
+ * outputs (batchnorm) are stacked.
+ */
+static nn_t reconet_chain_FF(const struct reconet_s* config, nn_t a, nn_t b)
 {
-	auto result = reconet_cell_create(config, Nb, models, status);
-
-	int N_in_names = nn_get_nr_named_in_args(result);
-	int N_out_names = nn_get_nr_named_out_args(result);
+	int N_in_names = nn_get_nr_named_in_args(a);
+	int N_out_names = nn_get_nr_named_out_args(a);
 
 	const char* in_names[N_in_names?:1];
 	const char* out_names[N_out_names?:1];
 
-	nn_get_in_names_copy(N_in_names, in_names, result);
-	nn_get_out_names_copy(N_out_names, out_names, result);
-
-	for (int i = 1; i < config->Nt; i++) {
-
-		auto tmp = reconet_cell_create(config, Nb, models, status);
+	nn_get_in_names_copy(N_in_names, in_names, a);
+	nn_get_out_names_copy(N_out_names, out_names, a);
 
-		tmp = nn_mark_dup_if_exists_F(tmp, "adjoint");
-		tmp = nn_mark_dup_if_exists_F(tmp, "coil");
-		tmp = nn_mark_dup_if_exists_F(tmp, "psf");
+	b = nn_mark_dup_if_exists_F(b, "adjoint");
+	b = nn_mark_dup_if_exists_F(b, "coil");
+	b = nn_mark_dup_if_exists_F(b, "psf");
 
-		tmp = (config->share_lambda ? nn_mark_dup_if_exists_F : nn_mark_stack_input_if_exists_F)(tmp, "lambda");
+	b = (config->share_lambda ? nn_mark_dup_if_exists_F : nn_mark_stack_input_if_exists_F)(b, "lambda");
 
-		// batchnorm weights are always stacked
-		for (int i = 0; i < N_in_names; i++) {
+	// batchnorm weights are always stacked
+	for (int i = 0; i < N_in_names; i++) {
 
-			if (!nn_is_name_in_in_args(tmp, in_names[i]))
-				continue;
+		if (!nn_is_name_in_in_args(b, in_names[i]))
+			continue;
 
-			if (nn_get_dup(tmp, 0, in_names[i]) && config->share_weights)
-				tmp = nn_mark_dup_F(tmp, in_names[i]);
-			else
-				tmp = nn_mark_stack_input_F(tmp, in_names[i]);
-		}
+		if (nn_get_dup(b, 0, in_names[i]) && config->share_weights)
+			b = nn_mark_dup_F(b, in_names[i]);
+		else
+			b = nn_mark_stack_input_F(b, in_names[i]);
+	}
 
-		for (int i = 0; i < N_out_names; i++)
-			tmp = nn_mark_stack_output_if_exists_F(tmp, out_names[i]);
+	for (int i = 0; i < N_out_names; i++)
+		b = nn_mark_stack_output_if_exists_F(b, out_names[i]);
 
-		result = nn_chain2_FF(result, 0, NULL, tmp, 0, NULL);
+	auto result = nn_chain2_FF(a, 0, NULL, b, 0, NULL);
 
-		result = nn_stack_dup_by_name_F(result);
-	}
+	result = nn_stack_dup_by_name_F(result);
 
 	result = nn_sort_inputs_by_list_F(result, N_in_names, in_names);
 	result = nn_sort_outputs_by_list_F(result, N_out_names, out_names);
@@ -668,6 +672,107 @@ static nn_t reconet_iterations_create(const struct reconet_s* config, int Nb, st
 }
 
 
+static nn_t reconet_cells_create(const struct reconet_s* config, int Nb, struct sense_model_s* models[Nb], enum NETWORK_STATUS status, int Nt)
+{
+	auto result = reconet_cell_create(config, Nb, models, status);
+
+	for (int i = 1; i < Nt; i++)
+		result = reconet_chain_FF(config, result, reconet_cell_create(config, Nb, models, status));
+
+	return result;
+}
+
+
+/**
+ * Returns Nt reconet cells
+ *
+ * For training with a memory budget, the cells are grouped into
+ * segments of which the first ones are checkpointed, i.e. only their
+ * inputs are kept and the derivatives are recomputed when needed.
+ */
+static nn_t reconet_iterations_create(const struct reconet_s* config, int Nb, struct sense_model_s* models[Nb], enum NETWORK_STATUS status)
+{
+	if ((0. >= config->mem_budget) || (STAT_TRAIN != status) || (1 >= config->Nt))
+		return reconet_cells_create(config, Nb, models, status, config->Nt);
+
+	// the cell is applied once to measure its memory, which needs coils and pattern
+
+	int N = sense_model_get_N(models[0]);
+
+	long img_dims[N];
+	sense_model_get_img_dims(models[0], N, img_dims);
+	img_dims[BATCH_DIM] = Nb;
+
+	auto set_data = nlop_sense_model_set_data_batch_create(N, img_dims, Nb, models);
+
+	int Nargs = nlop_get_nr_in_args(set_data) + nlop_get_nr_out_args(set_data);
+	void* args[Nargs];
+
+	for (int i = 0; i < Nargs; i++) {
+
+		auto iov = (0 == i) ? nlop_generic_codomain(set_data, 0) : nlop_generic_domain(set_data, i - 1);
+
+		args[i] = md_alloc(iov->N, iov->dims, iov->size);
+		md_zfill(iov->N, iov->dims, args[i], 1.);
+	}
+
+	nlop_generic_apply_unchecked(set_data, Nargs, args);
+
+	for (int i = 0; i < Nargs; i++)
+		md_free(args[i]);
+
+	nlop_free(set_data);
+
+	auto cell = reconet_cell_create(config, Nb, models, status);
+
+	// derivatives are needed for the weights and along the chain of iterations
+
+	int II = nn_get_nr_in_args(cell);
+	int OO = nn_get_nr_out_args(cell);
+
+	enum IN_TYPE in_types[II];
+	enum OUT_TYPE out_types[OO];
+
+	nn_get_in_types(cell, II, in_types);
+	nn_get_out_types(cell, OO, out_types);
+
+	unsigned long in_der_flag = 0;
+	unsigned long out_der_flag = 0;
+
+	for (int i = 0; i < II; i++)
+		if ((IN_OPTIMIZE == in_types[i]) || (NULL == nn_get_in_name_from_arg_index(cell, i, false)))
+			in_der_flag = MD_SET(in_der_flag, i);
+
+	for (int o = 0; o < OO; o++)
+		if ((OUT_OPTIMIZE == out_types[o]) || (NULL == nn_get_out_name_from_arg_index(cell, o, false)))
+			out_der_flag = MD_SET(out_der_flag, o);
+
+	auto plan = nlop_checkpoint_plan(config->Nt, nn_get_nlop(cell), out_der_flag, in_der_flag, (long)(config->mem_budget * 1.E6));
+
+	nn_free(cell);
+
+	nn_t result = NULL;
+
+	for (int i = 0; i < plan.segments; i++) {
+
+		auto segment = nn_checkpoint_F(reconet_cells_create(config, Nb, models, status, plan.length), true, true);
+
+		result = (NULL == result) ? segment : reconet_chain_FF(config, result, segment);
+	}
+
+	int rest = config->Nt - plan.segments * plan.length;
+
+	if (0 < rest) {
+
+		auto cells = reconet_cells_create(config, Nb, models, status, rest);
+
+		result = (NULL == result) ? cells : reconet_chain_FF(config, result, cells);
+	}
+
+	return result;
+}
+
+
 static nn_t reconet_create(const struct reconet_s* config, int N, const long max_dims[N], int ND, const long psf_dims[ND], enum NETWORK_STATUS status)
 {
 	int Nb = max_dims[BATCH_DIM];
@@ -933,6 +1038,7 @@ static nn_t reconet_apply_op_create(const struct reconet_s* config, int N, const
 		nn_apply = reconet_normalization(config, nn_apply);
 	
 	nn_apply = reconet_sort_args(nn_apply);
+
 	nn_apply = nn_get_wo_weights_F(nn_apply, config->weights, false);
 
 	if (config->coil_image) {
@@ -1167,12 +1273,58 @@ void apply_reconet(struct reconet_s* config, int N, const long max_dims[N], int
 	config->coil_image = (1 != ref_iov->dims[COIL_DIM]);
 	iovec_free(ref_iov);
 
+	complex float* ref = NULL;
+
+	if ((QUANT_NONE != config->quantize) && config->quant_report) {
+
+		auto nn_ref = reconet_apply_op_create(config, N, max_dims1, ND, psf_dims1);
+
+		nlop_unset_derivatives(nn_get_nlop(nn_ref));
+
+		nn_apply_named_list(nn_ref, data, config->weights->tensors[0]);
+
+		nn_free(nn_ref);
+
+		auto dom_rec = named_data_list_get_iovec(data, "reconstruction");
+
+		ref = md_alloc(dom_rec->N, dom_rec->dims, CFL_SIZE);
+		md_copy(dom_rec->N, dom_rec->dims, ref, named_data_list_get_data(data, "reconstruction"), CFL_SIZE);
+
+		iovec_free(dom_rec);
+	}
+
 	auto nn_apply = reconet_apply_op_create(config, N, max_dims1, ND, psf_dims1);
 
+	// no derivatives needed for inference (allows fused layers)
+	nlop_unset_derivatives(nn_get_nlop(nn_apply));
+
+	nn_quantize_begin(config->quantize);
+
+	// calibrate activation ranges of quantized layers on the first batch
+	if (QUANT_NONE != config->quantize) {
+
+		nn_quantize_calibrate(true);
+		nn_apply_named_list_first(nn_apply, data, config->weights->tensors[0]);
+		nn_quantize_calibrate(false);
+	}
+
 	nn_apply_named_list(nn_apply, data, config->weights->tensors[0]);
 
+	nn_quantize_end();
+
 	nn_free(nn_apply);
 
+	if (NULL != ref) {
+
+		auto dom_rec = named_data_list_get_iovec(data, "reconstruction");
+
+		debug_printf(DP_INFO, "NRMSE %s vs fp32: %e\n", quant_type_name(config->quantize),
+				md_znrmse(dom_rec->N, dom_rec->dims, ref, named_data_list_get_data(data, "reconstruction")));
+
+		iovec_free(dom_rec);
+		md_free(ref);
+	}
+
 	if (config->normalize_rss) {
 
 		auto dom_rec =  named_data_list_get_iovec(data, "reconstruction");
@@ -1,4 +1,5 @@
 
+#include "nn/quantize.h"
 
 struct nn_weights_s;
 struct loss_config_s;
@@ -42,6 +43,7 @@ struct reconet_s {
 	struct loss_config_s* valid_loss;
 
 	_Bool low_mem;
+	float mem_budget;	// MB, automatic checkpointing for training
 	_Bool gpu;
 
 	const char* graph_file;
@@ -49,6 +51,9 @@ struct reconet_s {
 	_Bool coil_image;
 
 	_Bool normalize_rss;
+
+	enum QUANT_TYPE quantize;
+	_Bool quant_report;
 };
 
 extern struct reconet_s reconet_config_opts;
@@ -36,6 +36,7 @@
 
 #include "noncart/nufft.h"
 #include "linops/linop.h"
+#include "linops/someops.h"
 
 #include "misc/mri.h"
 #include "misc/mri2.h"
@@ -46,6 +47,8 @@
 #include "misc/opts.h"
 #include "misc/debug.h"
 
+#include "iter/checkpoint.h"
+
 #include "grecon/optreg.h"
 
 #include "noir/recon2.h"
@@ -62,6 +65,144 @@ static const char help_str[] =
 
 
 
+/*
+ * Coarse-to-fine warm start for Cartesian NLINV. The first Newton steps
+ * are computed on the center of k-space and a reduced grid. Image and
+ * coil coefficients are zero-padded in k-space to the next level, and
+ * the regularization continues where the coarser level stopped. The
+ * Sobolev parameter a is scaled with the grid, so that the weights of
+ * the coil coefficients are the same on all levels.
+ */
+static void nlinv_multilevel(int L, const float levels[L], int iter, struct noir2_conf_s* conf, float restrict_fov,
+		const long img_dims[DIMS], complex float* img,
+		const long sens_dims[DIMS], complex float* ksens,
+		const long ksp_dims[DIMS], const complex float* kspace,
+		const long pat_dims[DIMS], const complex float* pattern,
+		const long cim_dims[DIMS])
+{
+	if (0. > conf->scaling)
+		conf->scaling = -conf->scaling / md_znorm(DIMS, ksp_dims, kspace);
+
+	struct noir2_conf_s lconf = *conf;
+	lconf.iter = (unsigned int)iter;
+	lconf.regs = NULL;
+	lconf.undo_scaling = false;
+	lconf.normalize_lowres = false;
+
+	long x_dims[DIMS];
+	long xs_dims[DIMS];
+	complex float* x = NULL;
+	complex float* xs = NULL;
+
+	for (int l = 0; l <= L; l++) {
+
+		long limg_dims[DIMS];
+		long lsens_dims[DIMS];
+
+		if (l < L) {
+
+			multilevel_dims(DIMS, FFT_FLAGS, limg_dims, img_dims, levels[l]);
+			multilevel_dims(DIMS, FFT_FLAGS, lsens_dims, sens_dims, levels[l]);
+
+		} else {
+
+			md_copy_dims(DIMS, limg_dims, img_dims);
+			md_copy_dims(DIMS, lsens_dims, sens_dims);
+		}
+
+		complex float* limg = (l < L) ? md_alloc(DIMS, limg_dims, CFL_SIZE) : img;
+		complex float* lksens = (l < L) ? md_alloc(DIMS, lsens_dims, CFL_SIZE) : ksens;
+
+		if (NULL == x) {
+
+			md_zfill(DIMS, limg_dims, limg, 1.);
+			md_clear(DIMS, lsens_dims, lksens, CFL_SIZE);
+
+		} else {
+
+			const struct linop_s* res_op = linop_resize_fourier_create(DIMS, limg_dims, x_dims, FFT_FLAGS);
+			linop_forward(res_op, DIMS, limg_dims, limg, DIMS, x_dims, x);
+			linop_free(res_op);
+
+			// zero-pad the centered coil coefficients, keeping the values of the coils
+
+			ifftmod(DIMS, xs_dims, FFT_FLAGS, xs, xs);
+			md_resize_center(DIMS, lsens_dims, lksens, xs_dims, xs, CFL_SIZE);
+			fftmod(DIMS, lsens_dims, FFT_FLAGS, lksens, lksens);
+
+			float sc = sqrtf((float)md_calc_size(3, lsens_dims) / (float)md_calc_size(3, xs_dims));
+
+			md_zsmul(DIMS, lsens_dims, lksens, lksens, sc);
+
+			md_free(x);
+			md_free(xs);
+		}
+
+		if (l == L)
+			break;
+
+		float f = levels[l];
+
+		long lksp_dims[DIMS];
+		long lpat_dims[DIMS];
+		long lcim_dims[DIMS];
+		long lmsk_dims[DIMS];
+
+		multilevel_dims(DIMS, FFT_FLAGS, lksp_dims, ksp_dims, f);
+		multilevel_dims(DIMS, FFT_FLAGS, lpat_dims, pat_dims, f);
+		multilevel_dims(DIMS, FFT_FLAGS, lcim_dims, cim_dims, f);
+		md_select_dims(DIMS, FFT_FLAGS, lmsk_dims, limg_dims);
+
+		debug_printf(DP_DEBUG1, "Multilevel: %ld %ld %ld\n", limg_dims[0], limg_dims[1], limg_dims[2]);
+
+		complex float* lksp = md_alloc(DIMS, lksp_dims, CFL_SIZE);
+		md_resize_center(DIMS, lksp_dims, lksp, ksp_dims, kspace, CFL_SIZE);
+
+		complex float* lpat = md_alloc(DIMS, lpat_dims, CFL_SIZE);
+		md_resize_center(DIMS, lpat_dims, lpat, pat_dims, pattern, CFL_SIZE);
+
+		complex float* lmask = NULL;
+
+		if (-1. != restrict_fov) {
+
+			float restrict_dims[DIMS] = { [0 ... DIMS - 1] = 1. };
+			restrict_dims[0] = restrict_fov;
+			restrict_dims[1] = restrict_fov;
+			restrict_dims[2] = restrict_fov;
+			lmask = compute_mask(DIMS, lmsk_dims, restrict_dims);
+		}
+
+		lconf.a = conf->a * f * f;
+
+		noir2_recon_cart(&lconf, DIMS,
+			limg_dims, limg, NULL,
+			lsens_dims, NULL,
+			lsens_dims, lksens, NULL,
+			lksp_dims, lksp,
+			lpat_dims, lpat,
+			MD_SINGLETON_DIMS(DIMS), NULL,
+			lmsk_dims, lmask,
+			lcim_dims);
+
+		for (int i = 0; i < iter; i++)
+			lconf.alpha = (lconf.alpha - lconf.alpha_min) / lconf.redu + lconf.alpha_min;
+
+		md_free(lmask);
+		md_free(lpat);
+		md_free(lksp);
+
+		md_copy_dims(DIMS, x_dims, limg_dims);
+		md_copy_dims(DIMS, xs_dims, lsens_dims);
+		x = limg;
+		xs = lksens;
+	}
+
+	conf->alpha = lconf.alpha;
+	conf->iter -= (unsigned int)(L * iter);
+}
+
+
+
 int main_nlinv(int argc, char* argv[argc])
 {
 	double start_time = timestamp();
@@ -105,6 +246,12 @@ int main_nlinv(int argc, char* argv[argc])
 	bool pattern_for_each_coil = false;
 	float oversampling_coils = -1.;
 
+	const char* checkpoint_file = NULL;
+	long checkpoint_mod = 10;
+
+	float ml_levels[8] = { 0. };
+	int ml_iter = 2;
+
 	const char *rR = use_compat_to_version("v0.9.00") ? "R\0" : "\0R";
 
 	const struct opt_s opts[] = {
@@ -146,10 +293,22 @@ int main_nlinv(int argc, char* argv[argc])
 		OPTL_SET(0, "real-time", &(conf.realtime), "Use real-time (temporal l2) regularization"),
 		OPTL_SET(0, "fast", &(conf.optimized), "Use tuned but less generic model"),
 		OPTL_SET(0, "legacy-early-stopping", &(conf.legacy_early_stoppping), "(legacy mode for irgnm early stopping)"),
+		OPTL_STRING(0, "checkpoint", &checkpoint_file, "file", "checkpoint solver state to file and resume from it"),
+		OPTL_LONG(0, "checkpoint-mod", &checkpoint_mod, "mod", "write checkpoint every mod iterations (default: 10)"),
+		OPTL_FLVECN(0, "multilevel", ml_levels, "Start on coarse levels (fractions of the resolution, coarse to fine)"),
+		OPTL_PINT(0, "multilevel-iter", &ml_iter, "iter", "Newton steps on each coarse level (default: 2)"),
 	};
 
 	cmdline(&argc, argv, ARRAY_SIZE(args), args, help_str, ARRAY_SIZE(opts), opts);
 
+	if (NULL != checkpoint_file) {
+
+		if (cfl_loop_desc_active())
+			error("Checkpoints are not supported with looping.\n");
+
+		iter_checkpoint_configure(checkpoint_file, checkpoint_mod);
+	}
+
 	num_init_gpu_support();
 	conf.gpu = bart_use_gpu;
 
@@ -450,6 +609,27 @@ int main_nlinv(int argc, char* argv[argc])
 		mask = compute_mask(DIMS, msk_dims, restrict_dims);
 	}
 
+	int ml_L = 0;
+
+	while ((ml_L < (int)ARRAY_SIZE(ml_levels)) && (0. != ml_levels[ml_L]))
+		ml_L++;
+
+	if (0 < ml_L) {
+
+		if (conf.noncart || conf.sms || conf.realtime || (NULL != basis) || (NULL != init_file))
+			error("Multilevel reconstruction is only supported for Cartesian single-slice data.\n");
+
+		if ((1. != conf.oversampling_coils) || conf.ret_os_coils || !md_check_equal_dims(DIMS, sens_dims, ksens_dims, ~0UL))
+			error("Multilevel reconstruction requires sensitivities on the image grid.\n");
+
+		for (int l = 0; l < ml_L; l++)
+			if ((1. <= ml_levels[l]) || ((0 < l) && (ml_levels[l] <= ml_levels[l - 1])))
+				error("Multilevel fractions must be increasing and smaller than one.\n");
+
+		if ((int)conf.iter <= ml_L * ml_iter + ((0 < conf.regs->r) ? MAX(conf.iter_reg, 0) : 0))
+			error("Not enough Newton steps left for the full resolution.\n");
+	}
+
 	complex float* ref_img = NULL;
 	complex float* ref_sens = NULL;
 
@@ -476,6 +656,11 @@ int main_nlinv(int argc, char* argv[argc])
 
 	} else {
 
+		if (0 < ml_L)
+			nlinv_multilevel(ml_L, ml_levels, ml_iter, &conf, restrict_fov,
+					img_dims, img, sens_dims, ksens, ksp_dims, kspace,
+					pat_dims, pattern, cim_dims);
+
 		noir2_recon_cart(&conf, DIMS,
 			img_dims, img, ref_img,
 			sens_dims, sens,
@@ -543,6 +728,8 @@ int main_nlinv(int argc, char* argv[argc])
 
 	debug_printf(DP_DEBUG2, "Total time: %.2f s\n", recosecs);
 
+	iter_checkpoint_configure(NULL, 0);
+
 	return 0;
 }
 
@@ -7,6 +7,10 @@
 
 #include <complex.h>
 
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
 #include "misc/types.h"
 #include "misc/misc.h"
 #include "misc/debug.h"
@@ -678,8 +682,190 @@ const struct nlop_s* nlop_loop_F(int N, const struct nlop_s* nlop, unsigned long
 
 
 
+#if defined(__GLIBC__) && ((2 < __GLIBC__) || (33 <= __GLIBC_MINOR__))
+static long heap_in_use(void)
+{
+	struct mallinfo2 mi = mallinfo2();
+
+	return (long)(mi.uordblks + mi.hblkhd);
+}
+#endif
+
+
+/**
+ * Estimate the memory an nlop keeps for computing derivatives
+ *
+ * The nlop is applied once (with constant inputs) and the selected
+ * derivatives are requested. The increase of allocated memory
+ * remaining after the forward pass is returned. The derivatives
+ * are cleared afterwards. Only CPU memory is measured.
+ *
+ * @param nlop
+ * @param out_der_flag outputs for which derivatives are requested
+ * @param in_der_flag inputs for which derivatives are requested
+ *
+ * @returns memory in bytes or -1 if it can not be measured
+ */
+long nlop_der_memory(const struct nlop_s* nlop, unsigned long out_der_flag, unsigned long in_der_flag)
+{
+#if defined(__GLIBC__) && ((2 < __GLIBC__) || (33 <= __GLIBC_MINOR__))
+	int II = nlop_get_nr_in_args(nlop);
+	int OO = nlop_get_nr_out_args(nlop);
+
+	void* args[OO + II];
+
+	for (int o = 0; o < OO; o++) {
+
+		auto iov = nlop_generic_codomain(nlop, o);
+		args[o] = md_alloc(iov->N, iov->dims, iov->size);
+	}
+
+	for (int i = 0; i < II; i++) {
+
+		auto iov = nlop_generic_domain(nlop, i);
+		args[OO + i] = md_alloc(iov->N, iov->dims, iov->size);
+		md_zfill(iov->N, iov->dims, args[OO + i], 1.);
+	}
+
+	long before = heap_in_use();
+
+	nlop_generic_apply_select_derivative_unchecked(nlop, OO + II, args, out_der_flag, in_der_flag);
+
+	long result = heap_in_use() - before;
+
+	nlop_clear_derivatives(nlop);
+
+	for (int i = 0; i < OO + II; i++)
+		md_free(args[i]);
+
+	return MAX(0, result);
+#else
+	(void)nlop;
+	(void)out_der_flag;
+	(void)in_der_flag;
+	return -1;
+#endif
+}
+
+
+static long plan_memory(int N, int segments, int length, long der_mem, long in_mem)
+{
+	if (0 == segments)
+		return N * der_mem;
+
+	// inputs of all segments are stored and the derivatives of one
+	// segment are recomputed while those of the remaining blocks are kept
+
+	return segments * in_mem + (N - segments * length + length) * der_mem;
+}
+
+
+/**
+ * Plan checkpointing of a chain of N blocks
+ *
+ * The first 'segments' segments of 'length' blocks are each
+ * wrapped in a checkpoint, the remaining blocks are not. Each
+ * block in a checkpoint is evaluated a second time when computing
+ * derivatives. Among the plans fitting the budget, the one with
+ * the least recomputations is chosen. If no plan fits, the one
+ * using least memory is chosen (for the optimal length of about
+ * sqrt(N * in_mem / der_mem)).
+ *
+ * @param N number of blocks
+ * @param der_mem memory kept for derivatives of one block
+ * @param in_mem memory for storing the inputs of one block
+ * @param budget memory budget (bytes)
+ */
+struct checkpoint_plan_s checkpoint_plan(int N, long der_mem, long in_mem, long budget)
+{
+	struct checkpoint_plan_s best = {
+
+		.N = N,
+		.segments = 0,
+		.length = 1,
+		.memory = plan_memory(N, 0, 1, der_mem, in_mem),
+		.recompute = 0,
+	};
+
+	for (int length = 1; length <= N; length++) {
+
+		for (int segments = 1; segments * length <= N; segments++) {
+
+			struct checkpoint_plan_s plan = {
+
+				.N = N,
+				.segments = segments,
+				.length = length,
+				.memory = plan_memory(N, segments, length, der_mem, in_mem),
+				.recompute = segments * length,
+			};
 
+			bool fits = (plan.memory <= budget);
+			bool best_fits = (best.memory <= budget);
 
+			if (fits && !best_fits)
+				best = plan;
 
+			if (fits && best_fits && (   (plan.recompute < best.recompute)
+						  || ((plan.recompute == best.recompute) && (plan.memory < best.memory))))
+				best = plan;
+
+			if (!fits && !best_fits && (plan.memory < best.memory))
+				best = plan;
+		}
+	}
+
+	return best;
+}
 
 
+/**
+ * Plan checkpointing of a chain of N copies of 'block'
+ *
+ * The memory for derivatives is measured by applying the block once.
+ * The chosen trade-off is reported.
+ *
+ * @param N number of blocks
+ * @param block
+ * @param out_der_flag outputs for which derivatives are requested
+ * @param in_der_flag inputs for which derivatives are requested
+ * @param budget memory budget (bytes)
+ */
+struct checkpoint_plan_s nlop_checkpoint_plan(int N, const struct nlop_s* block, unsigned long out_der_flag, unsigned long in_der_flag, long budget)
+{
+	long der_mem = nlop_der_memory(block, out_der_flag, in_der_flag);
+	long in_mem = 0;
+
+	for (int i = 0; i < nlop_get_nr_in_args(block); i++) {
+
+		auto iov = nlop_generic_domain(block, i);
+		in_mem += md_calc_size(iov->N, iov->dims) * (long)iov->size;
+	}
+
+	if (0 > der_mem) {
+
+		debug_printf(DP_WARN, "Memory for derivatives can not be measured. Checkpointing every block.\n");
+
+		return (struct checkpoint_plan_s){
+
+			.N = N,
+			.segments = N,
+			.length = 1,
+			.memory = -1,
+			.recompute = N,
+		};
+	}
+
+	auto plan = checkpoint_plan(N, der_mem, in_mem, budget);
+
+	if (plan.memory > budget)
+		debug_printf(DP_WARN, "Memory budget of %.1f MB can not be met.\n", budget / 1.E6);
+
+	debug_printf(DP_INFO, "Checkpointing: %d segments of %d blocks (%d blocks without).\n",
+			plan.segments, plan.length, N - plan.segments * plan.length);
+
+	debug_printf(DP_INFO, "Checkpointing: %.1f MB for derivatives (%.1f MB without checkpointing, budget %.1f MB), %ld of %d blocks recomputed.\n",
+			plan.memory / 1.E6, N * der_mem / 1.E6, budget / 1.E6, plan.recompute, N);
+
+	return plan;
+}
@@ -7,4 +7,19 @@ extern const struct nlop_s* nlop_checkpoint_create_F(const struct nlop_s* nlop,
 extern const struct nlop_s* nlop_loop_generic_F(int N, const struct nlop_s* nlop, int II, int iloop_dim[__VLA(II)], int OO, int oloop_dim[__VLA(OO)]);
 extern const struct nlop_s* nlop_loop_F(int N, const struct nlop_s* nlop, unsigned long dup_flag, int loop_dim);
 
-extern _Bool nlop_is_checkpoint(const struct nlop_s* nlop);
\ No newline at end of file
+extern _Bool nlop_is_checkpoint(const struct nlop_s* nlop);
+
+extern long nlop_der_memory(const struct nlop_s* nlop, unsigned long out_der_flag, unsigned long in_der_flag);
+
+struct checkpoint_plan_s {
+
+	int N;
+	int segments;	// checkpointed segments
+	int length;	// blocks per segment
+
+	long memory;	// estimated peak memory (bytes)
+	long recompute;	// recomputed blocks
+};
+
+extern struct checkpoint_plan_s checkpoint_plan(int N, long der_mem, long in_mem, long budget);
+extern struct checkpoint_plan_s nlop_checkpoint_plan(int N, const struct nlop_s* block, unsigned long out_der_flag, unsigned long in_der_flag, long budget);
\ No newline at end of file
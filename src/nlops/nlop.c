@@ -521,8 +521,12 @@ nlop_data_t* nlop_get_data(const struct nlop_s* op)
 	if (NULL == data2)
 		return NULL;
 #if 1
-	auto data3 = CAST_DOWN(nlop_linop_data_s, linop_get_data(op->derivative[0]));
-	assert(data3->data == data2->data);
+	// operators without inputs (e.g. batch generators) have no derivatives
+	if (0 < nlop_get_nr_in_args(op)) {
+
+		auto data3 = CAST_DOWN(nlop_linop_data_s, linop_get_data(op->derivative[0]));
+		assert(data3->data == data2->data);
+	}
 #endif
 	return data2->data;
 }
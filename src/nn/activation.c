@@ -289,8 +289,9 @@ static void relu_apply(const nlop_data_t* _data, complex float* _dst, const comp
 
 	float* der = md_alloc_sameplace(N, dims, FL_SIZE, src);
 
-	if ((0 == d->slope_param) && (NULL != der))
-		md_greatequal(N, dims, der, src, dst);
+	// dst = max(src, 0), i.e. der = (src >= 0) also for the leaky RELU
+
+	md_greatequal(N, dims, der, src, dst);
 
 	md_free(d->der);
 
@@ -263,3 +263,79 @@ void nn_apply_named_list(nn_t nn_apply, struct named_data_list_s* data, const vo
 	for (int i = 0; i < II; i++)
 		iovec_free(dom[i]);
 }
+
+
+/*
+ * Apply nn_apply only to the first position of the loop performed by
+ * nn_apply_named_list, e.g. to calibrate a network on the first batch.
+ * The result is written to the corresponding part of the outputs.
+ */
+void nn_apply_named_list_first(nn_t nn_apply, struct named_data_list_s* data, const void* reference)
+{
+	int OO = nn_get_nr_out_args(nn_apply);
+	int II = nn_get_nr_in_args(nn_apply);
+
+	const struct named_tensor_s* oten[OO];
+	const struct named_tensor_s* iten[II];
+
+	unsigned long loop_flags = 0;
+
+	for (int i = 0; i < OO; i++) {
+
+		oten[i] = get_tensor_by_name(data, nn_get_out_names(nn_apply)[i]);
+		loop_flags |= md_nontriv_dims(oten[i]->N, oten[i]->dims) & ~md_nontriv_dims(oten[i]->N, nn_generic_codomain(nn_apply, 0, oten[i]->name)->dims);
+	}
+
+	for (int i = 0; i < II; i++) {
+
+		iten[i] = get_tensor_by_name(data, nn_get_in_names(nn_apply)[i]);
+		loop_flags |= md_nontriv_dims(iten[i]->N, iten[i]->dims) & ~md_nontriv_dims(iten[i]->N, nn_generic_domain(nn_apply, 0, iten[i]->name)->dims);
+	}
+
+	int DO[OO];
+	int DI[II];
+
+	long (*odims[OO])[];
+	long (*idims[II])[];
+
+	complex float* dst[OO];
+	complex float* src[II];
+
+	for (int i = 0; i < OO; i++) {
+
+		DO[i] = oten[i]->N;
+		odims[i] = xmalloc((size_t)DO[i] * sizeof(long));
+		md_select_dims(DO[i], ~loop_flags, *odims[i], oten[i]->dims);
+
+		dst[i] = md_alloc_sameplace(DO[i], *odims[i], sizeof(complex float), reference);
+	}
+
+	for (int i = 0; i < II; i++) {
+
+		DI[i] = iten[i]->N;
+		idims[i] = xmalloc((size_t)DI[i] * sizeof(long));
+		md_select_dims(DI[i], ~loop_flags, *idims[i], iten[i]->dims);
+
+		src[i] = md_alloc_sameplace(DI[i], *idims[i], sizeof(complex float), reference);
+		md_resize(DI[i], *idims[i], src[i], iten[i]->dims, iten[i]->data, sizeof(complex float));
+	}
+
+	nlop_generic_apply_loop_sameplace(nn_get_nlop(nn_apply), 0, OO, DO, (const long**)odims, dst, II, DI, (const long**)idims, (const complex float**)src, reference);
+
+	for (int i = 0; i < OO; i++) {
+
+		long pos[DO[i]];
+		md_set_dims(DO[i], pos, 0);
+
+		md_copy_block(DO[i], pos, oten[i]->dims, oten[i]->data, *odims[i], dst[i], sizeof(complex float));
+
+		md_free(dst[i]);
+		xfree(odims[i]);
+	}
+
+	for (int i = 0; i < II; i++) {
+
+		md_free(src[i]);
+		xfree(idims[i]);
+	}
+}
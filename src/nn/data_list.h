@@ -19,4 +19,5 @@ extern const struct nlop_s* nn_batchgen_create(struct bat_gen_conf_s* config, nn
 extern nn_t nn_valid_create(nn_t network, struct named_data_list_s* valid_data);
 
 extern void nn_apply_named_list(nn_t nn_apply, struct named_data_list_s* data, const void* reference);
+extern void nn_apply_named_list_first(nn_t nn_apply, struct named_data_list_s* data, const void* reference);
 #endif
\ No newline at end of file
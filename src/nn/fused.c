@@ -0,0 +1,548 @@
+/* Copyright 2026. Institute of Biomedical Imaging. TU Graz.
+ * All rights reserved. Use of this source code is governed by
+ * a BSD-style license which can be found in the LICENSE file.
+ *
+ * Fused convolution layer for inference on the CPU.
+ *
+ * A correlation layer (channel first) followed by batch normalization
+ * with fixed statistics, bias and a (leaky) ReLU is evaluated in one
+ * pass: im2col and GEMM are computed for tiles of output positions
+ * and normalization, bias, and activation are applied to each tile
+ * while it is still in cache. No intermediate activations are stored.
+ *
+ * With post-training quantization (see nn/quantize.c), the input is
+ * quantized to int8 once and im2col and GEMM use int8 operands. The
+ * calibrated range and the quantized weights are kept in the layer.
+ *
+ * The unfused layer is kept and used whenever derivatives are
+ * requested or the data is not in CPU memory.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <complex.h>
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "misc/misc.h"
+#include "misc/types.h"
+#include "misc/debug.h"
+#include "misc/graph.h"
+
+#include "num/multind.h"
+#include "num/iovec.h"
+#include "num/flpmath.h"
+#include "num/blas.h"
+#include "num/ops.h"
+#include "num/ops_graph.h"
+#ifdef USE_CUDA
+#include "num/gpuops.h"
+#endif
+
+#include "linops/linop.h"
+
+#include "nlops/nlop.h"
+
+#include "nn/quantize.h"
+
+#include "fused.h"
+
+
+// size of im2col tiles (complex floats)
+#define FUSED_TILE_SIZE 16384
+
+
+struct fused_conv_s {
+
+	nlop_data_t super;
+
+	const struct nlop_s* nlop;
+
+	int II;
+	int OO;
+
+	long idims[5];	// (in_channel, x, y, z, batch)
+	long odims[5];	// (out_channel, x, y, z, batch)
+	long kdims[5];	// (out_channel, in_channel, kx, ky, kz)
+	long pad[3];
+
+	bool batchnorm;
+	float epsilon;
+	bool bias;
+	enum ACTIVATION activation;
+
+	struct quant_layer_s quant;
+};
+
+DEF_TYPEID(fused_conv_s);
+
+
+static void fused_conv_unfused(const struct fused_conv_s* d, int N, complex float* args[N])
+{
+	bool der[d->II][d->OO];
+
+	for (int i = 0; i < d->II; i++)
+		for (int o = 0; o < d->OO; o++)
+			der[i][o] = nlop_der_requested(CAST_UP(d), i, o);
+
+	nlop_unset_derivatives(d->nlop);
+	nlop_set_derivatives(d->nlop, d->II, d->OO, der);
+
+	nlop_generic_apply_unchecked(d->nlop, N, (void**)args);
+}
+
+
+/*
+ * im2col for a tile of T output positions starting at p0
+ * (columns of length K1 = Ci * kx * ky * kz, elements of size el)
+ */
+static void fused_conv_im2col(const struct fused_conv_s* d, long p0, long T, size_t el, char* col, const char* in)
+{
+	long Ci = d->idims[0];
+	long K1 = Ci * d->kdims[2] * d->kdims[3] * d->kdims[4];
+
+	const long* id = d->idims;
+	const long* od = d->odims;
+	const long* kd = d->kdims;
+
+	for (long t = 0; t < T; t++) {
+
+		long p = p0 + t;
+
+		long x = p % od[1];
+		long y = (p / od[1]) % od[2];
+		long z = p / (od[1] * od[2]);
+
+		char* dst = col + (size_t)(K1 * t) * el;
+
+		for (long kz = 0; kz < kd[4]; kz++) {
+
+			long iz = z + kz - d->pad[2];
+
+			for (long ky = 0; ky < kd[3]; ky++) {
+
+				long iy = y + ky - d->pad[1];
+
+				for (long kx = 0; kx < kd[2]; kx++, dst += (size_t)Ci * el) {
+
+					long ix = x + kx - d->pad[0];
+
+					if (   (0 > ix) || (ix >= id[1])
+					    || (0 > iy) || (iy >= id[2])
+					    || (0 > iz) || (iz >= id[3])) {
+
+						memset(dst, 0, (size_t)Ci * el);
+						continue;
+					}
+
+					memcpy(dst, in + (size_t)(Ci * (ix + id[1] * (iy + id[2] * iz))) * el, (size_t)Ci * el);
+				}
+			}
+		}
+	}
+}
+
+
+/*
+ * normalization, bias, and activation for a tile of T output positions
+ */
+static void fused_conv_epilogue(const struct fused_conv_s* d, long T, complex float* out, const float* scale, const complex float* shift)
+{
+	long Co = d->odims[0];
+
+	float slope = (ACT_LRELU == d->activation) ? 0.01 : 0.;
+
+	for (long t = 0; t < T; t++) {
+
+		float* o = (float*)(out + Co * t);
+
+		for (long c = 0; c < Co; c++) {
+
+			float re = o[2 * c + 0] * scale[c] + crealf(shift[c]);
+			float im = o[2 * c + 1] * scale[c] + cimagf(shift[c]);
+
+			if (ACT_LIN != d->activation) {
+
+				re = (0. <= re) ? re : slope * re;
+				im = (0. <= im) ? im : slope * im;
+			}
+
+			o[2 * c + 0] = re;
+			o[2 * c + 1] = im;
+		}
+	}
+}
+
+
+static void fused_conv_tile(const struct fused_conv_s* d, long b, long p0, long T, complex float* col,
+			    complex float* out, const complex float* in, const complex float* krn,
+			    const float* scale, const complex float* shift)
+{
+	long Ci = d->idims[0];
+	long Co = d->odims[0];
+	long K1 = Ci * d->kdims[2] * d->kdims[3] * d->kdims[4];
+
+	in += Ci * d->idims[1] * d->idims[2] * d->idims[3] * b;
+	out += Co * (d->odims[1] * d->odims[2] * d->odims[3] * b + p0);
+
+	fused_conv_im2col(d, p0, T, sizeof(complex float), (char*)col, (const char*)in);
+
+	memset(out, 0, (size_t)(Co * T) * sizeof(complex float));
+
+	blas_matrix_zfmac(Co, T, K1, out, krn, 'N', col, 'N');
+
+	fused_conv_epilogue(d, T, out, scale, shift);
+}
+
+
+static void fused_conv_tile_int8(const struct fused_conv_s* d, long b, long p0, long T, int8_t* col_re, int8_t* col_im,
+				 complex float* out, const int8_t* in_re, const int8_t* in_im,
+				 const struct quant_layer_s* layer, float xscale,
+				 const float* scale, const complex float* shift)
+{
+	long Ci = d->idims[0];
+	long Co = d->odims[0];
+	long K1 = Ci * d->kdims[2] * d->kdims[3] * d->kdims[4];
+
+	long ioff = Ci * d->idims[1] * d->idims[2] * d->idims[3] * b;
+
+	out += Co * (d->odims[1] * d->odims[2] * d->odims[3] * b + p0);
+
+	fused_conv_im2col(d, p0, T, sizeof(int8_t), (char*)col_re, (const char*)(in_re + ioff));
+	fused_conv_im2col(d, p0, T, sizeof(int8_t), (char*)col_im, (const char*)(in_im + ioff));
+
+	quant_zgemm_int8(Co, T, K1, out, layer, xscale, col_re, col_im);
+
+	fused_conv_epilogue(d, T, out, scale, shift);
+}
+
+
+static void fused_conv_fun(const nlop_data_t* _data, int N, complex float* args[N])
+{
+	const auto d = CAST_DOWN(fused_conv_s, _data);
+
+	assert(d->II + d->OO == N);
+
+	bool der = false;
+
+	for (int i = 0; i < d->II; i++)
+		for (int o = 0; o < d->OO; o++)
+			der = der || nlop_der_requested(_data, i, o);
+
+#ifdef USE_CUDA
+	der = der || cuda_ondevice(args[0]);
+#endif
+
+	if (der) {
+
+		fused_conv_unfused(d, N, args);
+		return;
+	}
+
+	complex float* out = args[0];
+	const complex float* in = args[d->OO + 0];
+	const complex float* krn = args[d->OO + 1];
+	const complex float* stats = d->batchnorm ? args[d->OO + 2] : NULL;
+	const complex float* bias = d->bias ? args[N - 1] : NULL;
+
+	long Co = d->odims[0];
+
+	// y = act((x - mean) / sqrt(var + epsilon) + bias) = act(x * scale + shift)
+
+	float scale[Co];
+	complex float shift[Co];
+
+	for (long c = 0; c < Co; c++) {
+
+		scale[c] = 1.;
+		shift[c] = 0.;
+
+		if (d->batchnorm) {
+
+			scale[c] = 1. / sqrtf(crealf(stats[Co + c]) + d->epsilon);
+			shift[c] = -stats[c] * scale[c];
+		}
+
+		if (d->bias)
+			shift[c] += bias[c];
+	}
+
+	if (d->batchnorm)
+		md_copy(1, MD_DIMS(2 * Co), args[1], stats, CFL_SIZE);
+
+	long K1 = d->kdims[1] * d->kdims[2] * d->kdims[3] * d->kdims[4];
+	long P = d->odims[1] * d->odims[2] * d->odims[3];
+	long T = MIN(P, MAX(1, FUSED_TILE_SIZE / K1));
+
+	long tiles = (P + T - 1) / T;
+
+	long isize = md_calc_size(5, d->idims);
+
+	if ((QUANT_NONE != nn_quantize_active()) || nn_quantize_calibrating()) {
+
+		// state of an earlier session is discarded
+
+		long session = nn_quantize_session();
+
+#pragma omp critical (bart_fused_quant)
+		if (session != d->quant.session)
+			quant_layer_reset(&d->quant, session);
+	}
+
+	if (nn_quantize_calibrating()) {
+
+		float amax = md_zabsmax_parts(isize, in);
+
+#pragma omp critical (bart_fused_quant)
+		d->quant.amax = MAX(d->quant.amax, amax);
+	}
+
+	if (QUANT_INT8 == nn_quantize_active()) {
+
+		// the weights are constant during inference and quantized only once
+
+#pragma omp critical (bart_fused_quant)
+		if (!d->quant.frozen)
+			quant_layer_freeze(&d->quant, Co, K1, krn);
+
+		const struct quant_layer_s* layer = &d->quant;
+
+		// layers not seen during calibration use the range of the current input
+
+		float amax = (0. < layer->amax) ? layer->amax : md_zabsmax_parts(isize, in);
+		float xscale = amax / 127.f;
+
+		int8_t* in_re = xmalloc((size_t)isize * sizeof(int8_t));
+		int8_t* in_im = xmalloc((size_t)isize * sizeof(int8_t));
+
+		quant_int8(isize, in_re, in_im, xscale, in);
+
+#pragma omp parallel for
+		for (long j = 0; j < tiles * d->odims[4]; j++) {
+
+			long b = j / tiles;
+			long p0 = (j % tiles) * T;
+
+			int8_t* col_re = xmalloc((size_t)(K1 * T) * sizeof(int8_t));
+			int8_t* col_im = xmalloc((size_t)(K1 * T) * sizeof(int8_t));
+
+			fused_conv_tile_int8(d, b, p0, MIN(T, P - p0), col_re, col_im, out, in_re, in_im, layer, xscale, scale, shift);
+
+			xfree(col_re);
+			xfree(col_im);
+		}
+
+		xfree(in_re);
+		xfree(in_im);
+
+		debug_printf(DP_DEBUG3, "conv by %s (int8)\n", __func__);
+		return;
+	}
+
+#pragma omp parallel for
+	for (long j = 0; j < tiles * d->odims[4]; j++) {
+
+		long b = j / tiles;
+		long p0 = (j % tiles) * T;
+
+		complex float* col = xmalloc((size_t)(K1 * T) * sizeof(complex float));
+
+		fused_conv_tile(d, b, p0, MIN(T, P - p0), col, out, in, krn, scale, shift);
+
+		xfree(col);
+	}
+
+	debug_printf(DP_DEBUG3, "conv by %s\n", __func__);
+}
+
+
+static void fused_conv_der(const nlop_data_t* _data, int o, int i, complex float* dst, const complex float* src)
+{
+	const auto d = CAST_DOWN(fused_conv_s, _data);
+
+	linop_forward_unchecked(nlop_get_derivative(d->nlop, o, i), dst, src);
+}
+
+static void fused_conv_adj(const nlop_data_t* _data, int o, int i, complex float* dst, const complex float* src)
+{
+	const auto d = CAST_DOWN(fused_conv_s, _data);
+
+	linop_adjoint_unchecked(nlop_get_derivative(d->nlop, o, i), dst, src);
+}
+
+static void fused_conv_clear_der(const nlop_data_t* _data)
+{
+	const auto d = CAST_DOWN(fused_conv_s, _data);
+
+	nlop_clear_derivatives(d->nlop);
+}
+
+static void fused_conv_del(const nlop_data_t* _data)
+{
+	const auto d = CAST_DOWN(fused_conv_s, _data);
+
+	nlop_free(d->nlop);
+
+	quant_layer_free(&d->quant);
+
+	xfree(d);
+}
+
+static const struct graph_s* fused_conv_get_graph(const struct operator_s* op, const nlop_data_t* _data)
+{
+	const auto d = CAST_DOWN(fused_conv_s, _data);
+
+	return create_graph_container(op, "fused convolution", operator_get_graph(d->nlop->op));
+}
+
+
+/**
+ * Check if a convolution layer can be fused
+ *
+ * Only channel first correlations with spatial dimensions 1-3, without
+ * strides and dilations, and zero padding (same or valid) are fused.
+ */
+bool convcorr_fusable(unsigned long conv_flag, unsigned long channel_flag, unsigned long group_flag,
+		      int N, const long kernel_dims[N], const long strides[N], const long dilations[N],
+		      bool conv, enum PADDING conv_pad, enum ACTIVATION activation)
+{
+	if ((5 != N) || (MD_BIT(0) != channel_flag) || (0 != group_flag) || (0 != (conv_flag & ~14UL)))
+		return false;
+
+	if (conv || ((PAD_SAME != conv_pad) && (PAD_VALID != conv_pad)))
+		return false;
+
+	if ((ACT_LIN != activation) && (ACT_RELU != activation) && (ACT_LRELU != activation))
+		return false;
+
+	for (int i = 0; i < N; i++) {
+
+		if ((NULL != strides) && (1 != strides[i]))
+			return false;
+
+		if ((NULL != dilations) && (1 != dilations[i]))
+			return false;
+
+		if (!MD_IS_SET(conv_flag | channel_flag, i) && (1 != kernel_dims[i]))
+			return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * Create fused convolution layer
+ *
+ * @param nlop unfused layer (freed) with
+ *	inputs [x, kernel, (batchnorm statistics), (bias)] and outputs [y, (batchnorm statistics)]
+ * @param idims (in_channel, x, y, z, batch)
+ * @param kdims kernel (out_channel, in_channel, kx, ky, kz)
+ * @param conv_pad PAD_SAME or PAD_VALID
+ * @param batchnorm normalization with fixed statistics (inference)
+ * @param epsilon of batch normalization
+ * @param bias bias per channel
+ * @param activation ACT_LIN, ACT_RELU, or ACT_LRELU
+ */
+const struct nlop_s* nlop_convcorr_fused_create_F(const struct nlop_s* nlop, const long idims[5], const long kdims[5],
+						  enum PADDING conv_pad, bool batchnorm, float epsilon, bool bias, enum ACTIVATION activation)
+{
+	PTR_ALLOC(struct fused_conv_s, d);
+	SET_TYPEID(fused_conv_s, d);
+
+	int II = nlop_get_nr_in_args(nlop);
+	int OO = nlop_get_nr_out_args(nlop);
+
+	assert(II == 2 + (batchnorm ? 1 : 0) + (bias ? 1 : 0));
+	assert(OO == 1 + (batchnorm ? 1 : 0));
+
+	d->II = II;
+	d->OO = OO;
+
+	quant_layer_init(&d->quant);
+
+	md_copy_dims(5, d->idims, idims);
+	md_copy_dims(5, d->kdims, kdims);
+	md_copy_dims(5, d->odims, nlop_generic_codomain(nlop, 0)->dims);
+
+	assert(5 == nlop_generic_codomain(nlop, 0)->N);
+	assert(d->odims[0] == kdims[0]);
+	assert(idims[0] == kdims[1]);
+
+	for (int i = 0; i < 3; i++) {
+
+		long ks = kdims[2 + i];
+		long is = idims[1 + i];
+
+		// same as padding in nlop_convcorr_geom_create
+		d->pad[i] = (PAD_SAME == conv_pad) ? ((is + ks - 1) / 2 - is / 2) : 0;
+
+		assert(d->odims[1 + i] == ((PAD_SAME == conv_pad) ? is : (is - ks + 1)));
+	}
+
+	d->batchnorm = batchnorm;
+	d->epsilon = epsilon;
+	d->bias = bias;
+	d->activation = activation;
+
+	d->nlop = nlop;
+
+	int max_DO = 0;
+	int max_DI = 0;
+
+	for (int o = 0; o < OO; o++)
+		max_DO = MAX(max_DO, nlop_generic_codomain(nlop, o)->N);
+
+	for (int i = 0; i < II; i++)
+		max_DI = MAX(max_DI, nlop_generic_domain(nlop, i)->N);
+
+	long nl_odims[OO][max_DO];
+	long nl_idims[II][max_DI];
+
+	for (int o = 0; o < OO; o++) {
+
+		auto iov = nlop_generic_codomain(nlop, o);
+
+		md_singleton_dims(max_DO, nl_odims[o]);
+		md_copy_dims(iov->N, nl_odims[o], iov->dims);
+	}
+
+	for (int i = 0; i < II; i++) {
+
+		auto iov = nlop_generic_domain(nlop, i);
+
+		md_singleton_dims(max_DI, nl_idims[i]);
+		md_copy_dims(iov->N, nl_idims[i], iov->dims);
+	}
+
+	nlop_der_fun_t der[II][OO];
+	nlop_der_fun_t adj[II][OO];
+
+	for (int i = 0; i < II; i++) {
+
+		for (int o = 0; o < OO; o++) {
+
+			der[i][o] = fused_conv_der;
+			adj[i][o] = fused_conv_adj;
+		}
+	}
+
+	const struct nlop_s* result = nlop_generic_managed_create(OO, max_DO, nl_odims, II, max_DI, nl_idims, CAST_UP(PTR_PASS(d)),
+								   fused_conv_fun, der, adj, NULL, NULL, fused_conv_del,
+								   fused_conv_clear_der, fused_conv_get_graph);
+
+	for (int o = 0; o < OO; o++) {
+
+		auto iov = nlop_generic_codomain(nlop, o);
+		result = nlop_reshape_out_F(result, o, iov->N, iov->dims);
+	}
+
+	for (int i = 0; i < II; i++) {
+
+		auto iov = nlop_generic_domain(nlop, i);
+		result = nlop_reshape_in_F(result, i, iov->N, iov->dims);
+	}
+
+	return result;
+}
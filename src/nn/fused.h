@@ -0,0 +1,18 @@
+
+#ifndef _NN_FUSED_H
+#define _NN_FUSED_H
+
+#include "nn/activation.h"
+#include "nlops/conv.h"
+#include "misc/cppwrap.h"
+
+extern _Bool convcorr_fusable(unsigned long conv_flag, unsigned long channel_flag, unsigned long group_flag,
+			      int N, const long kernel_dims[__VLA(N)], const long strides[__VLA2(N)], const long dilations[__VLA2(N)],
+			      _Bool conv, enum PADDING conv_pad, enum ACTIVATION activation);
+
+extern const struct nlop_s* nlop_convcorr_fused_create_F(const struct nlop_s* nlop, const long idims[5], const long kdims[5],
+							 enum PADDING conv_pad, _Bool batchnorm, float epsilon, _Bool bias, enum ACTIVATION activation);
+
+#include "misc/cppwrap.h"
+
+#endif // _NN_FUSED_H
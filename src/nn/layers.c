@@ -27,7 +27,9 @@
 #include "nlops/tenmul.h"
 #include "nlops/conv.h"
 
+#include "nn/activation.h"
 #include "nn/batchnorm.h"
+#include "nn/fused.h"
 #include "nn/nn_ops.h"
 
 #include "layers.h"
@@ -753,3 +755,63 @@ const struct nlop_s* append_normalize_layer(const struct nlop_s* network, int o,
 
 	return network;
 }
+
+
+/**
+ * Append convolution/correlation layer followed by batch normalization, bias, and activation
+ *
+ * The arguments are ordered as if the layers were appended one after the other.
+ * For inference (STAT_TEST), supported layers are evaluated by a fused kernel
+ * (see nn/fused.c).
+ *
+ * @param network operator to append the layer (the operator is freed)
+ * @param o output index of network, the layer is appended
+ * @param conv_flag, channel_flag, group_flag, kernel_dims, strides, dilations, conv, conv_pad see append_convcorr_layer_generic
+ * @param batchnorm append batch normalization over ~(channel_flag | group_flag)
+ * @param bias append bias over first dimension
+ * @param activation type of activation
+ * @param status STAT_TRAIN or STAT_TEST
+ */
+const struct nlop_s* append_convcorr_bias_act_layer_generic(const struct nlop_s* network, int o,
+						unsigned long conv_flag, unsigned long channel_flag, unsigned long group_flag,
+						int N, long const kernel_dims[N], const long strides[N], const long dilations[N],
+						bool conv, enum PADDING conv_pad,
+						bool batchnorm, bool bias, enum ACTIVATION activation, enum NETWORK_STATUS status)
+{
+	int NO = nlop_get_nr_out_args(network);
+
+	assert(o < NO);
+	assert((nlop_generic_codomain(network, o))->N == N);
+
+	long idims[N];
+	md_copy_dims(N, idims, nlop_generic_codomain(network, o)->dims);
+
+	const struct nlop_s* block = nlop_from_linop_F(linop_identity_create(N, idims));
+
+	block = append_convcorr_layer_generic(block, 0, conv_flag, channel_flag, group_flag, N, kernel_dims, strides, dilations, conv, conv_pad);
+
+	if (batchnorm)
+		block = append_batchnorm_layer(block, 0, ~(channel_flag | group_flag), status);
+
+	if (bias)
+		block = append_activation_bias(block, 0, activation, MD_BIT(0));
+	else
+		block = append_activation(block, 0, activation, MD_BIT(0));
+
+	if (   (STAT_TEST == status)
+	    && convcorr_fusable(conv_flag, channel_flag, group_flag, N, kernel_dims, strides, dilations, conv, conv_pad, activation)) {
+
+		long kdims[5] = { kernel_dims[0], idims[0], kernel_dims[1], kernel_dims[2], kernel_dims[3] };
+
+		block = nlop_convcorr_fused_create_F(block, idims, kdims, conv_pad, batchnorm, 1.e-3, bias, activation);
+	}
+
+	network = nlop_chain2_swap_FF(network, o, block, 0);
+
+	if (batchnorm)
+		network = nlop_shift_output_F(network, NO, 1);
+
+	network = nlop_shift_output_F(network, o, 0);
+
+	return network;
+}
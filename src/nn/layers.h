@@ -3,6 +3,7 @@
 
 #include "nlops/conv.h"
 #include "misc/cppwrap.h"
+#include "nn/activation.h"
 
 enum NETWORK_STATUS {STAT_TRAIN, STAT_TEST};
 
@@ -23,6 +24,8 @@ extern const struct nlop_s* append_dropout_layer(const struct nlop_s* network, i
 extern const struct nlop_s* append_flatten_layer(const struct nlop_s* network, int o);
 
 extern const struct nlop_s* append_batchnorm_layer(const struct nlop_s* network, int o, unsigned long norm_flags, enum NETWORK_STATUS status);
+extern const struct nlop_s* append_convcorr_bias_act_layer_generic(const struct nlop_s* network, int o, unsigned long conv_flag, unsigned long channel_flag, unsigned long group_flag, int N, long const kernel_dims[__VLA(N)], const long strides[__VLA2(N)], const long dilations[__VLA2(N)], _Bool conv, enum PADDING conv_pad, _Bool batchnorm, _Bool bias, enum ACTIVATION activation, enum NETWORK_STATUS status);
+
 extern const struct nlop_s* append_normalize_layer(const struct nlop_s* network, int o, unsigned long norm_flags, float epsilon);
 
 #include "misc/cppwrap.h"
@@ -5,9 +5,17 @@
  * Authors: Moritz Blumenthal
  */
 
+#include <stdbool.h>
+#include <assert.h>
+
+#include "num/multind.h"
+#include "num/iovec.h"
+
 #include "iter/italgos.h"
 #include "nlops/nlop.h"
 
+#include "nn/activation_nn.h"
+#include "nn/fused.h"
 #include "nn/layers.h"
 #include "nn/nn.h"
 
@@ -57,6 +65,78 @@ nn_t nn_append_convcorr_layer_generic(
 }
 
 
+/**
+ * Append convolution/correlation layer followed by batch normalization, bias, and activation
+ *
+ * Equivalent to appending the layers one after the other. For inference,
+ * supported layers are evaluated by a fused kernel (see nn/fused.c).
+ *
+ * @param network operator to append the layer (the operator is freed)
+ * @param o output index of network, the layer is appended
+ * @param oname
+ * @param ker_name name for the kernel input
+ * @param bn_name name for the batchnorm statistics
+ * @param bias_name name for the bias input
+ * @param conv_flag, channel_flag, group_flag, kernel_dims, strides, dilations, conv, conv_pad see nn_append_convcorr_layer_generic
+ * @param init initializer for the kernel (NULL falls back to default)
+ * @param batchnorm append batch normalization over ~(channel_flag | group_flag)
+ * @param bias append bias over first dimension
+ * @param activation type of activation
+ * @param status STAT_TRAIN or STAT_TEST
+ */
+nn_t nn_append_convcorr_bias_act_layer_generic(
+				nn_t network, int o, const char* oname, const char* ker_name, const char* bn_name, const char* bias_name,
+				unsigned long conv_flag, unsigned long channel_flag, unsigned long group_flag,
+				int N, long const kernel_dims[N], const long strides[N], const long dilations[N],
+				bool conv, enum PADDING conv_pad, const struct initializer_s* init,
+				bool batchnorm, bool bias, enum ACTIVATION activation, enum NETWORK_STATUS status)
+{
+	o = nn_get_out_arg_index(network, o, oname);
+
+	const struct nlop_s* nlop = NULL;
+
+	if (   (STAT_TEST == status)
+	    && convcorr_fusable(conv_flag, channel_flag, group_flag, N, kernel_dims, strides, dilations, conv, conv_pad, activation))
+		nlop = append_convcorr_bias_act_layer_generic(nlop_clone(nn_get_nlop(network)), o,
+							      conv_flag, channel_flag, group_flag, N, kernel_dims, strides, dilations,
+							      conv, conv_pad, batchnorm, bias, activation, status);
+
+	// arguments and their types, names, and initializers
+
+	network = nn_append_convcorr_layer_generic(network, o, NULL, ker_name, conv_flag, channel_flag, group_flag, N, kernel_dims, strides, dilations, conv, conv_pad, init);
+
+	if (batchnorm)
+		network = nn_append_batchnorm_layer(network, o, NULL, bn_name, ~(channel_flag | group_flag), status, NULL);
+
+	if (bias)
+		network = nn_append_activation_bias(network, o, NULL, bias_name, activation, MD_BIT(0));
+	else
+		network = nn_append_activation(network, o, NULL, activation, MD_BIT(0));
+
+	if (NULL != nlop) {
+
+		// the fused operator replaces the unfused one, which defines the
+		// arguments of the nn, so both must have the same signature
+
+		const struct nlop_s* unfused = nn_get_nlop(network);
+
+		assert(nlop_get_nr_in_args(nlop) == nlop_get_nr_in_args(unfused));
+		assert(nlop_get_nr_out_args(nlop) == nlop_get_nr_out_args(unfused));
+
+		for (int i = 0; i < nlop_get_nr_in_args(nlop); i++)
+			assert(iovec_compare(nlop_generic_domain(nlop, i), nlop_generic_domain(unfused, i)));
+
+		for (int i = 0; i < nlop_get_nr_out_args(nlop); i++)
+			assert(iovec_compare(nlop_generic_codomain(nlop, i), nlop_generic_codomain(unfused, i)));
+
+		nlop_free(unfused);
+		nn_set_nlop(network, nlop);
+	}
+
+	return network;
+}
+
+
 /**
  * Append transposed convolution/correlation layer
  *
@@ -6,6 +6,7 @@
 #include "nn/init.h"
 
 extern nn_t nn_append_convcorr_layer_generic(nn_t network, int o, const char* oname, const char* ker_name, unsigned long conv_flag, unsigned long channel_flag, unsigned long group_flag, int N, long const kernel_dims[__VLA2(N)], const long strides[__VLA2(N)], const long dilations[__VLA2(N)], _Bool conv, enum PADDING conv_pad, const struct initializer_s* init);
+extern nn_t nn_append_convcorr_bias_act_layer_generic(nn_t network, int o, const char* oname, const char* ker_name, const char* bn_name, const char* bias_name, unsigned long conv_flag, unsigned long channel_flag, unsigned long group_flag, int N, long const kernel_dims[__VLA(N)], const long strides[__VLA2(N)], const long dilations[__VLA2(N)], _Bool conv, enum PADDING conv_pad, const struct initializer_s* init, _Bool batchnorm, _Bool bias, enum ACTIVATION activation, enum NETWORK_STATUS status);
 extern nn_t nn_append_transposed_convcorr_layer_generic(nn_t network, int o, const char* oname, const char* ker_name, unsigned long conv_flag, unsigned long channel_flag, unsigned long group_flag, int N, long const kernel_dims[__VLA(N)], const long strides[__VLA(N)], const long dilations[__VLA(N)], _Bool conv, enum PADDING conv_pad, _Bool adjoint, const struct initializer_s* init);
 
 extern nn_t nn_append_maxpool_layer_generic(nn_t network, int o, const char* oname, int N, const long pool_size[__VLA(N)], enum PADDING conv_pad);
@@ -0,0 +1,246 @@
+/* Copyright 2026. Institute of Biomedical Imaging. TU Graz.
+ * All rights reserved. Use of this source code is governed by
+ * a BSD-style license which can be found in the LICENSE file.
+ *
+ * Post-training int8 quantization for inference on the CPU.
+ *
+ * Fused convolution layers (see nn/fused.c) compute im2col and GEMM
+ * with int8 operands and int32 accumulation. Weights are quantized
+ * with one symmetric scale per output channel (absmax), activations
+ * with one scale per layer, which is taken from the range of the layer
+ * input observed on calibration data. Real and imaginary parts are
+ * quantized separately, bias, batch normalization, and activation are
+ * applied in fp32 after the GEMM.
+ *
+ * The quantization state (input range and quantized weights) is kept
+ * in the data of each fused layer. It belongs to one session between
+ * nn_quantize_begin() and nn_quantize_end(): layers record the range of
+ * their input while calibrating, and quantize their (constant) weights
+ * on the first quantized call, which freezes them for the session.
+ * The weights of the caller are never modified.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <complex.h>
+#include <math.h>
+
+#include "misc/misc.h"
+
+#include "quantize.h"
+
+
+const char* quant_type_name(enum QUANT_TYPE type)
+{
+	switch (type) {
+
+	case QUANT_NONE: return "fp32";
+	case QUANT_INT8: return "int8";
+	}
+
+	assert(0);
+}
+
+
+static struct {
+
+	enum QUANT_TYPE type;
+	bool calibrating;
+	long session;
+
+} quant_state = { .type = QUANT_NONE, .calibrating = false, .session = 0 };
+
+
+/*
+ * Start a session of quantized inference.
+ */
+void nn_quantize_begin(enum QUANT_TYPE type)
+{
+	assert(QUANT_NONE == quant_state.type);
+
+	quant_state.type = type;
+	quant_state.calibrating = false;
+	quant_state.session++;
+}
+
+
+/*
+ * While calibrating, fused layers are evaluated in fp32 and
+ * record the range of their input.
+ */
+void nn_quantize_calibrate(bool on)
+{
+	quant_state.calibrating = on && (QUANT_NONE != quant_state.type);
+}
+
+
+void nn_quantize_end(void)
+{
+	quant_state.type = QUANT_NONE;
+	quant_state.calibrating = false;
+}
+
+
+bool nn_quantize_calibrating(void)
+{
+	return quant_state.calibrating;
+}
+
+
+enum QUANT_TYPE nn_quantize_active(void)
+{
+	return quant_state.calibrating ? QUANT_NONE : quant_state.type;
+}
+
+
+long nn_quantize_session(void)
+{
+	return quant_state.session;
+}
+
+
+float md_zabsmax_parts(long N, const complex float* src)
+{
+	const float* s = (const float*)src;
+
+	float amax = 0.;
+
+#pragma omp parallel for reduction(max:amax)
+	for (long i = 0; i < 2 * N; i++)
+		amax = MAX(amax, fabsf(s[i]));
+
+	return amax;
+}
+
+
+void quant_layer_init(struct quant_layer_s* l)
+{
+	*l = (struct quant_layer_s){ .session = 0, .amax = 0., .frozen = false, .Co = 0, .K = 0, .wscale = NULL, .wre = NULL, .wim = NULL };
+}
+
+
+void quant_layer_free(struct quant_layer_s* l)
+{
+	xfree(l->wscale);
+	xfree(l->wre);
+	xfree(l->wim);
+
+	quant_layer_init(l);
+}
+
+
+/*
+ * Start a new session: discard calibration and quantized weights.
+ */
+void quant_layer_reset(struct quant_layer_s* l, long session)
+{
+	quant_layer_free(l);
+
+	l->session = session;
+}
+
+
+static int8_t quant_int8_1(float x, float iscale)
+{
+	return (int8_t)MAX(-127.f, MIN(127.f, rintf(x * iscale)));
+}
+
+
+/*
+ * Quantize weights of shape (Co, K), column-major, to rows of int8
+ * with one scale per output channel.
+ */
+void quant_layer_freeze(struct quant_layer_s* l, long Co, long K, const complex float* krn)
+{
+	assert(!l->frozen);
+
+	l->Co = Co;
+	l->K = K;
+
+	l->wscale = xmalloc((size_t)Co * sizeof(float));
+	l->wre = xmalloc((size_t)(Co * K) * sizeof(int8_t));
+	l->wim = xmalloc((size_t)(Co * K) * sizeof(int8_t));
+
+	for (long c = 0; c < Co; c++) {
+
+		float amax = 0.;
+
+		for (long k = 0; k < K; k++)
+			amax = MAX(amax, MAX(fabsf(crealf(krn[c + Co * k])), fabsf(cimagf(krn[c + Co * k]))));
+
+		float scale = amax / 127.f;
+		float iscale = (0. == scale) ? 0. : (1. / scale);
+
+		l->wscale[c] = scale;
+
+		for (long k = 0; k < K; k++) {
+
+			l->wre[c * K + k] = quant_int8_1(crealf(krn[c + Co * k]), iscale);
+			l->wim[c * K + k] = quant_int8_1(cimagf(krn[c + Co * k]), iscale);
+		}
+	}
+
+	l->frozen = true;
+}
+
+
+void quant_int8(long N, int8_t* re, int8_t* im, float scale, const complex float* src)
+{
+	float iscale = (0. == scale) ? 0. : (1. / scale);
+
+	for (long i = 0; i < N; i++) {
+
+		re[i] = quant_int8_1(crealf(src[i]), iscale);
+		im[i] = quant_int8_1(cimagf(src[i]), iscale);
+	}
+}
+
+
+/*
+ * out[m + M * t] = sum_k W[m, k] * X[t, k]
+ *
+ * with int8 weights W (rows of layer) and int8 activations X (rows of
+ * length K). Products are accumulated in int32 and scaled back to fp32.
+ */
+void quant_zgemm_int8(long M, long T, long K, complex float* out, const struct quant_layer_s* layer, float xscale,
+		      const int8_t* xre, const int8_t* xim)
+{
+	assert(layer->frozen && (M == layer->Co) && (K == layer->K));
+	assert(K < (1L << 16));	// no overflow of int32 accumulators
+
+	for (long t = 0; t < T; t++) {
+
+		const int8_t* br = xre + K * t;
+		const int8_t* bi = xim + K * t;
+
+		for (long m = 0; m < M; m++) {
+
+			const int8_t* ar = layer->wre + K * m;
+			const int8_t* ai = layer->wim + K * m;
+
+			int32_t rr = 0;
+			int32_t ii = 0;
+			int32_t ri = 0;
+			int32_t ir = 0;
+
+#pragma omp simd reduction(+:rr,ii,ri,ir)
+			for (long k = 0; k < K; k++) {
+
+				int16_t a_r = ar[k];
+				int16_t a_i = ai[k];
+				int16_t b_r = br[k];
+				int16_t b_i = bi[k];
+
+				rr += a_r * b_r;
+				ii += a_i * b_i;
+				ri += a_r * b_i;
+				ir += a_i * b_r;
+			}
+
+			float sc = layer->wscale[m] * xscale;
+
+			out[m + M * t] = (float)(rr - ii) * sc + 1.i * (float)(ri + ir) * sc;
+		}
+	}
+}
@@ -0,0 +1,50 @@
+
+#ifndef _NN_QUANTIZE_H
+#define _NN_QUANTIZE_H
+
+#include <stdint.h>
+
+#include "misc/cppwrap.h"
+
+enum QUANT_TYPE { QUANT_NONE, QUANT_INT8 };
+
+struct quant_layer_s {
+
+	long session;	// nn_quantize_session() the state belongs to
+
+	float amax;	// calibrated range of the layer input (0: not calibrated)
+
+	_Bool frozen;	// weights quantized
+
+	long Co;
+	long K;
+
+	float* wscale;	// [Co] scale of each output channel
+	int8_t* wre;	// [Co][K]
+	int8_t* wim;	// [Co][K]
+};
+
+extern const char* quant_type_name(enum QUANT_TYPE type);
+
+extern void nn_quantize_begin(enum QUANT_TYPE type);
+extern void nn_quantize_calibrate(_Bool on);
+extern void nn_quantize_end(void);
+
+extern _Bool nn_quantize_calibrating(void);
+extern enum QUANT_TYPE nn_quantize_active(void);
+extern long nn_quantize_session(void);
+
+extern float md_zabsmax_parts(long N, const _Complex float* src);
+
+extern void quant_layer_init(struct quant_layer_s* l);
+extern void quant_layer_reset(struct quant_layer_s* l, long session);
+extern void quant_layer_freeze(struct quant_layer_s* l, long Co, long K, const _Complex float* krn);
+extern void quant_layer_free(struct quant_layer_s* l);
+
+extern void quant_int8(long N, int8_t* re, int8_t* im, float scale, const _Complex float* src);
+extern void quant_zgemm_int8(long M, long T, long K, _Complex float* out, const struct quant_layer_s* layer, float xscale,
+			     const int8_t* xre, const int8_t* xim);
+
+#include "misc/cppwrap.h"
+
+#endif // _NN_QUANTIZE_H
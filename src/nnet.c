@@ -131,6 +131,9 @@ int main_nnet(int argc, char* argv[argc])
 		OPTL_SET(0, "load-memory", &(load_mem), "load files into memory"),
 
 		OPTL_STRING(0, "export-graph", &graph_filename, "<file.dot>", "export graph for visualization"),
+
+		OPTL_SELECT(0, "quantize-int8", enum QUANT_TYPE, &(config.quantize), QUANT_INT8, "int8 inference of fused convolution layers (calibrated on first batch)"),
+		OPTL_SET(0, "quantize-report", &(config.quant_report), "compare quantized network with fp32"),
 	};
 
 	const char* filename_in;
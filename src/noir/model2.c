@@ -223,7 +223,7 @@ struct noir2_s noir2_noncart_create(int N,
 	else
 		md_copy_dims(N, mod_wgh_dims, ret.pat_dims);
 
-	ret.lop_fft = nufft_create2(N, ret.ksp_dims, ret.cim_dims, ret.trj_dims, traj, mod_wgh_dims, weights, basis ? ret.bas_dims : NULL, basis, nufft_conf);
+	ret.lop_fft = nufft_create2_cached(N, ret.ksp_dims, ret.cim_dims, ret.trj_dims, traj, mod_wgh_dims, weights, basis ? ret.bas_dims : NULL, basis, nufft_conf);
 
 	ret.lop_nufft = linop_clone(ret.lop_fft);
 
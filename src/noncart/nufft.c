@@ -20,6 +20,7 @@
 #include "misc/debug.h"
 #include "misc/types.h"
 #include "misc/version.h"
+#include "misc/opcache.h"
 
 #include "num/multind.h"
 #include "num/flpmath.h"
@@ -290,11 +291,13 @@ static struct nufft_conf_s compute_psf_nufft_conf(bool periodic, bool lowmem, bo
 }
 
 
-complex float* compute_psf_cached(int N, const long img_dims[N], const long trj_dims[N], const complex float* traj,
+// sgn (optional) has the dimensions of trj_dims restricted to dim 2
+// and multiplies each spoke by +1 or -1
+static complex float* compute_psf_signed(int N, const long img_dims[N], const long trj_dims[N], const complex float* traj,
 				const long bas_dims[N], const complex float* basis,
 				const long wgh_dims[N], const complex float* weights,
 				bool periodic, bool lowmem,
-				struct linop_s** _lop_nufft)
+				struct linop_s** _lop_nufft, const complex float* sgn)
 {
 	long ksp_dims[N];
 	md_select_dims(N, ~MD_BIT(0), ksp_dims, trj_dims);
@@ -321,6 +324,14 @@ complex float* compute_psf_cached(int N, const long img_dims[N], const long trj_
 	complex float* ones = md_alloc_sameplace(N, ksp_dims, CFL_SIZE, traj);
 	md_zfill(N, ksp_dims, ones, 1.);
 
+	if (NULL != sgn) {
+
+		long sgn_dims[N];
+		md_select_dims(N, MD_BIT(2), sgn_dims, trj_dims);
+
+		md_zmul2(N, ksp_dims, MD_STRIDES(N, ksp_dims, CFL_SIZE), ones, MD_STRIDES(N, ksp_dims, CFL_SIZE), ones, MD_STRIDES(N, sgn_dims, CFL_SIZE), sgn);
+	}
+
 	struct nufft_conf_s conf = compute_psf_nufft_conf(periodic, lowmem, NULL != _lop_nufft);
 	struct linop_s* lop_nufft = (NULL == _lop_nufft) ? NULL : *_lop_nufft;
 
@@ -351,6 +362,15 @@ complex float* compute_psf_cached(int N, const long img_dims[N], const long trj_
 	return psf;
 }
 
+complex float* compute_psf_cached(int N, const long img_dims[N], const long trj_dims[N], const complex float* traj,
+				const long bas_dims[N], const complex float* basis,
+				const long wgh_dims[N], const complex float* weights,
+				bool periodic, bool lowmem,
+				struct linop_s** _lop_nufft)
+{
+	return compute_psf_signed(N, img_dims, trj_dims, traj, bas_dims, basis, wgh_dims, weights, periodic, lowmem, _lop_nufft, NULL);
+}
+
 complex float* compute_psf(int N, const long img_dims[N], const long trj_dims[N], const complex float* traj,
 				const long bas_dims[N], const complex float* basis,
 				const long wgh_dims[N], const complex float* weights,
@@ -479,10 +499,10 @@ static complex float* compute_psf2_decomposed(int N, const long psf_dims[N + 1],
 
 
 
-static complex float* compute_psf2(int N, const long psf_dims[N + 1], unsigned long flags, const long trj_dims[N + 1], const complex float* traj,
+static complex float* compute_psf2_signed(int N, const long psf_dims[N + 1], unsigned long flags, const long trj_dims[N + 1], const complex float* traj,
 				const long bas_dims[N + 1], const complex float* basis, const long wgh_dims[N + 1], const complex float* weights,
 				bool periodic, bool lowmem,
-				struct linop_s** lop_nufft, struct linop_s** lop_fftuc)
+				struct linop_s** lop_nufft, struct linop_s** lop_fftuc, const complex float* sgn)
 {
 
 #ifdef USE_CUDA
@@ -491,6 +511,8 @@ static complex float* compute_psf2(int N, const long psf_dims[N + 1], unsigned l
 	bool gpu = false;
 #endif
 
+	assert((NULL == sgn) || !(lowmem || gpu));
+
 	if (lowmem || gpu)
 		return compute_psf2_decomposed(N, psf_dims, flags,
 					       trj_dims, traj, bas_dims, basis, wgh_dims, weights,
@@ -521,7 +543,7 @@ static complex float* compute_psf2(int N, const long psf_dims[N + 1], unsigned l
 
 	md_zsmul(ND, trj_dims, traj2, traj, 2.);
 
-	complex float* psft = compute_psf_cached(ND, img2_dims, trj_dims, traj2, bas_dims, basis, wgh_dims, weights, periodic, lowmem, lop_nufft);
+	complex float* psft = compute_psf_signed(ND, img2_dims, trj_dims, traj2, bas_dims, basis, wgh_dims, weights, periodic, lowmem, lop_nufft, sgn);
 
 	md_free(traj2);
 
@@ -567,6 +589,14 @@ static complex float* compute_psf2(int N, const long psf_dims[N + 1], unsigned l
 	return psf;
 }
 
+static complex float* compute_psf2(int N, const long psf_dims[N + 1], unsigned long flags, const long trj_dims[N + 1], const complex float* traj,
+				const long bas_dims[N + 1], const complex float* basis, const long wgh_dims[N + 1], const complex float* weights,
+				bool periodic, bool lowmem,
+				struct linop_s** lop_nufft, struct linop_s** lop_fftuc)
+{
+	return compute_psf2_signed(N, psf_dims, flags, trj_dims, traj, bas_dims, basis, wgh_dims, weights, periodic, lowmem, lop_nufft, lop_fftuc, NULL);
+}
+
 
 static struct nufft_data* nufft_create_data(int N,
 			const long cim_dims[N], bool basis,
@@ -622,6 +652,8 @@ static struct nufft_data* nufft_create_data(int N,
 	data->lop_nufft_psf = NULL;
 	data->lop_fftuc_psf = NULL;
 
+	data->psf_incr = 0;
+
 	data->conf = conf;
 	data->flags = conf.flags;
 
@@ -798,6 +830,9 @@ static void nufft_set_traj(struct nufft_data* data, int N,
 {
 	int ND = N + 1;
 
+	data->data_key = 0;
+	data->psf_incr = 0;
+
 	if (NULL != traj) {
 
 		assert(md_check_equal_dims(N, trj_dims, data->trj_dims, ~0UL));
@@ -1045,6 +1080,127 @@ struct linop_s* nufft_create2(int N,
 			bas_dims, basis, conf);
 }
 
+static uint64_t nufft_conf_hash(uint64_t h, const struct nufft_conf_s* conf)
+{
+	// hash fields separately, the padding of the struct is undefined
+
+	bool bools[] = { conf->toeplitz, conf->pcycle, conf->periodic, conf->lowmem, conf->decomp, conf->nopsf,
+			 conf->cache_psf_grdding, conf->precomp_linphase, conf->precomp_fftmod, conf->precomp_roll,
+			 conf->zero_overhead };
+
+	h = opcache_hash(h, sizeof bools, bools);
+	h = opcache_hash(h, sizeof conf->loopdim, &conf->loopdim);
+	h = opcache_hash(h, sizeof conf->flags, &conf->flags);
+	h = opcache_hash(h, sizeof conf->cfft, &conf->cfft);
+	h = opcache_hash(h, sizeof conf->width, &conf->width);
+	h = opcache_hash(h, sizeof conf->os, &conf->os);
+
+	return h;
+}
+
+static uint64_t nufft_dims_hash(uint64_t h, int N, const long dims[N], const void* data)
+{
+	long none[N];
+	md_singleton_dims(N, none);
+
+	return opcache_hash(h, (size_t)N * sizeof(long), (NULL != data) ? dims : none);
+}
+
+static uint64_t nufft_data_hash(uint64_t h, int N, const long dims[N], const complex float* data)
+{
+	if (NULL == data)
+		return h;
+
+	return opcache_hash(h, (size_t)md_calc_size(N, dims) * CFL_SIZE, data);
+}
+
+/*
+ * Hash of trajectory, weights and basis in bart loop mode
+ * (0 otherwise), so that unchanged data is not set again.
+ */
+static uint64_t nufft_data_key(int N,
+			const long trj_dims[N], const complex float* traj,
+			const long wgh_dims[N], const complex float* weights,
+			const long bas_dims[N], const complex float* basis)
+{
+	if (!opcache_enabled() || (NULL == traj))
+		return 0;
+#ifdef USE_CUDA
+	if (cuda_ondevice(traj) || ((NULL != weights) && cuda_ondevice(weights)) || ((NULL != basis) && cuda_ondevice(basis)))
+		return 0;
+#endif
+	uint64_t h = nufft_data_hash(0, N, trj_dims, traj);
+
+	h = nufft_data_hash(h, N, wgh_dims, weights);
+	h = nufft_data_hash(h, N, bas_dims, basis);
+
+	return h;
+}
+
+static void nufft_cache_del(const void* op)
+{
+	linop_free(op);
+}
+
+/*
+ * Same as nufft_create2, but in bart loop mode the operator (including
+ * the PSF for Toeplitz embedding and cached gridding operators) is kept
+ * for the next iteration. Only if the trajectory, weights or basis
+ * changed, these are updated (see nufft_update_traj).
+ */
+struct linop_s* nufft_create2_cached(int N,
+			     const long ksp_dims[N],
+			     const long cim_dims[N],
+			     const long traj_dims[N],
+			     const complex float* traj,
+			     const long wgh_dims[N],
+			     const complex float* weights,
+			     const long bas_dims[N],
+			     const complex float* basis,
+			     struct nufft_conf_s conf)
+{
+	if (!opcache_enabled() || (0 <= conf.loopdim))
+		return nufft_create2(N, ksp_dims, cim_dims, traj_dims, traj, wgh_dims, weights, bas_dims, basis, conf);
+
+	uint64_t key = opcache_hash(0, sizeof N, &N);
+
+	key = opcache_hash(key, (size_t)N * sizeof(long), ksp_dims);
+	key = opcache_hash(key, (size_t)N * sizeof(long), cim_dims);
+	key = opcache_hash(key, (size_t)N * sizeof(long), traj_dims);
+	key = nufft_dims_hash(key, N, traj_dims, traj);
+	key = nufft_dims_hash(key, N, wgh_dims, weights);
+	key = nufft_dims_hash(key, N, bas_dims, basis);
+	key = nufft_conf_hash(key, &conf);
+
+	// without trajectory, weights and basis cannot be updated
+
+	if (NULL == traj) {
+
+		key = nufft_data_hash(key, N, wgh_dims, weights);
+		key = nufft_data_hash(key, N, bas_dims, basis);
+	}
+
+	const struct linop_s* op = opcache_get("nufft", key);
+
+	if (NULL != op) {
+
+		if (NULL != traj)
+			nufft_update_traj(op, N, traj_dims, traj, wgh_dims, weights, bas_dims, basis);
+
+		return (struct linop_s*)linop_clone(op);
+	}
+
+	struct linop_s* ret = nufft_create2(N, ksp_dims, cim_dims, traj_dims, traj, wgh_dims, weights, bas_dims, basis, conf);
+
+	auto data = CAST_DOWN(nufft_data, linop_get_data_nested(ret));
+	data->data_key = nufft_data_key(N, traj_dims, traj, wgh_dims, weights, bas_dims, basis);
+
+	opcache_put("nufft", key, linop_clone(ret), nufft_cache_del);
+
+	return ret;
+}
+
+
 static void nufft_normal_only(const linop_data_t* /*_data*/, complex float* /*dst*/, const complex float* /*src*/)
 {
 	error("NuFFT with normal operator only!\n");
@@ -1734,6 +1890,173 @@ void nufft_get_psf(const struct linop_s* nufft, int N, const long psf_dims[N], c
 	nufft_get_psf2(nufft, N, psf_dims, MD_STRIDES(N, psf_dims, CFL_SIZE), psf);
 }
 
+/*
+ * The PSF is linear in the samples. If only a few spokes (dim 2) of
+ * the trajectory change, we grid the new positions of these spokes
+ * with positive and the old positions with negative sign and add the
+ * result to the existing PSF instead of gridding all samples again.
+ * Returns false if this is not possible and a full update is needed.
+ */
+#define PSF_INCR_MAX 16
+
+static bool nufft_update_traj_spokes(struct nufft_data* data, int N,
+			const long trj_dims[N], const complex float* traj,
+			const long wgh_dims[N], const complex float* weights,
+			const complex float* basis)
+{
+	int ND = N + 1;
+
+	if (!data->conf.toeplitz || data->conf.nopsf || data->conf.lowmem)
+		return false;
+
+	if ((NULL == traj) || (NULL == data->traj) || (NULL == data->psf))
+		return false;
+
+	if ((NULL != basis) || (NULL != data->basis))
+		return false;
+
+	// the PSF sums over all samples of a spoke
+
+	if (!MD_IS_SET(data->flags, 1) || !MD_IS_SET(data->flags, 2) || (1 == trj_dims[2]))
+		return false;
+
+	if (PSF_INCR_MAX <= data->psf_incr)
+		return false;
+
+#ifdef USE_CUDA
+	if (cuda_ondevice(traj))
+		return false;
+#endif
+
+	assert(md_check_equal_dims(N, trj_dims, data->trj_dims, ~0UL));
+
+	const complex float* wgh = NULL;
+
+	if (NULL != data->weights) {
+
+		wgh = multiplace_read(data->weights, traj);
+
+		if (   (NULL != weights)
+		    && (   !md_check_equal_dims(N, wgh_dims, data->wgh_dims, ~0UL)
+			|| !md_compare(N, wgh_dims, weights, wgh, CFL_SIZE)))
+			return false;
+
+	} else if (NULL != weights) {
+
+		return false;
+	}
+
+	const complex float* otraj = multiplace_read(data->traj, traj);
+
+	long S = trj_dims[2];
+	long spoke_size = trj_dims[0] * trj_dims[1];
+	long size = md_calc_size(N, trj_dims);
+
+	bool changed[S];
+
+	for (long j = 0; j < S; j++)
+		changed[j] = false;
+
+	for (long i = 0; i < size; i++)
+		if (otraj[i] != traj[i])
+			changed[(i / spoke_size) % S] = true;
+
+	long n = 0;
+
+	for (long j = 0; j < S; j++)
+		if (changed[j])
+			n++;
+
+	// gridding 2n instead of S spokes
+
+	if (4 * n > S)
+		return false;
+
+	debug_printf(DP_DEBUG2, "NUFFT: incremental PSF update (%ld of %ld spokes changed)\n", n, S);
+
+	if (0 < n) {
+
+		long ctrj_dims[ND];
+		md_copy_dims(ND, ctrj_dims, data->trj_dims);
+		ctrj_dims[2] = 2 * n;
+
+		long cwgh_dims[ND];
+		md_copy_dims(ND, cwgh_dims, data->wgh_dims);
+
+		if (1 < cwgh_dims[2])
+			cwgh_dims[2] = 2 * n;
+
+		long sdims[ND];
+		md_select_dims(ND, ~MD_BIT(2), sdims, ctrj_dims);
+
+		long wsdims[ND];
+		md_select_dims(ND, ~MD_BIT(2), wsdims, cwgh_dims);
+
+		long tstrs[ND];
+		md_calc_strides(ND, tstrs, data->trj_dims, CFL_SIZE);
+
+		long ctstrs[ND];
+		md_calc_strides(ND, ctstrs, ctrj_dims, CFL_SIZE);
+
+		long wstrs[ND];
+		md_calc_strides(ND, wstrs, data->wgh_dims, CFL_SIZE);
+
+		long cwstrs[ND];
+		md_calc_strides(ND, cwstrs, cwgh_dims, CFL_SIZE);
+
+		complex float* ctraj = md_alloc(ND, ctrj_dims, CFL_SIZE);
+		complex float* cwgh = (NULL != wgh) ? md_alloc(ND, cwgh_dims, CFL_SIZE) : NULL;
+		long sgn_dims[ND];
+		md_select_dims(ND, MD_BIT(2), sgn_dims, ctrj_dims);
+
+		complex float* sgn = md_alloc(ND, sgn_dims, CFL_SIZE);
+
+		for (long j = 0, k = 0; j < S; j++) {
+
+			if (!changed[j])
+				continue;
+
+			md_copy2(ND, sdims, ctstrs, (void*)ctraj + k * ctstrs[2], tstrs, (void*)traj + j * tstrs[2], CFL_SIZE);
+			md_copy2(ND, sdims, ctstrs, (void*)ctraj + (n + k) * ctstrs[2], tstrs, (void*)otraj + j * tstrs[2], CFL_SIZE);
+
+			if ((NULL != cwgh) && (1 < cwgh_dims[2])) {
+
+				md_copy2(ND, wsdims, cwstrs, (void*)cwgh + k * cwstrs[2], wstrs, (void*)wgh + j * wstrs[2], CFL_SIZE);
+				md_copy2(ND, wsdims, cwstrs, (void*)cwgh + (n + k) * cwstrs[2], wstrs, (void*)wgh + j * wstrs[2], CFL_SIZE);
+			}
+
+			sgn[k] = +1.;
+			sgn[n + k] = -1.;
+			k++;
+		}
+
+		if ((NULL != cwgh) && (1 == cwgh_dims[2]))
+			md_copy(ND, cwgh_dims, cwgh, wgh, CFL_SIZE);
+
+		complex float* psf = compute_psf2_signed(N, data->psf_dims, data->flags, ctrj_dims, ctraj,
+					data->bas_dims, NULL, cwgh_dims, cwgh,
+					true /*conf.periodic*/, false, NULL, NULL, sgn);
+
+		md_free(ctraj);
+		md_free(cwgh);
+		md_free(sgn);
+
+		md_zadd(ND, data->psf_dims, psf, psf, multiplace_read(data->psf, traj));
+
+		multiplace_free(data->psf);
+
+		data->psf = multiplace_move_F(ND, data->psf_dims, CFL_SIZE, psf);
+
+		data->psf_incr++;
+	}
+
+	multiplace_free(data->traj);
+
+	data->traj = multiplace_move(N, trj_dims, CFL_SIZE, traj);
+
+	return true;
+}
+
 void nufft_update_traj(	const struct linop_s* nufft, int N,
 			const long trj_dims[N], const complex float* traj,
 			const long wgh_dims[N], const complex float* weights,
@@ -1746,7 +2069,18 @@ void nufft_update_traj(	const struct linop_s* nufft, int N,
 
 	assert(data->N == N);
 
-	nufft_set_traj(data, N, trj_dims, traj, wgh_dims, weights, bas_dims, basis);
+	uint64_t data_key = nufft_data_key(N, trj_dims, traj, wgh_dims, weights, bas_dims, basis);
+
+	if ((0 != data_key) && (data->data_key == data_key)) {
+
+		debug_printf(DP_DEBUG2, "NUFFT: trajectory unchanged\n");
+		return;
+	}
+
+	if (!nufft_update_traj_spokes(data, N, trj_dims, traj, wgh_dims, weights, basis))
+		nufft_set_traj(data, N, trj_dims, traj, wgh_dims, weights, bas_dims, basis);
+
+	data->data_key = data_key;
 }
 
 void nufft_update_psf2(const struct linop_s* nufft, int ND, const long psf_dims[ND], const long psf_strs[ND], const complex float* psf)
@@ -1758,6 +2092,8 @@ void nufft_update_psf2(const struct linop_s* nufft, int ND, const long psf_dims[
 
 	assert(md_check_equal_dims(ND, data->psf_dims, psf_dims, ~0UL));
 
+	data->data_key = 0;
+
 	multiplace_free(data->psf);
 
 	data->psf = multiplace_move2(ND, psf_dims, psf_strs, CFL_SIZE, psf);
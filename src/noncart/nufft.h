@@ -54,6 +54,17 @@ extern struct linop_s* nufft_create2(int N,
 			     const complex float* basis,
 			     struct nufft_conf_s conf);
 
+extern struct linop_s* nufft_create2_cached(int N,
+			     const long ksp_dims[N],
+			     const long cim_dims[N],
+			     const long traj_dims[N],
+			     const complex float* traj,
+			     const long wgh_dims[N],
+			     const complex float* weights,
+			     const long bas_dims[N],
+			     const complex float* basis,
+			     struct nufft_conf_s conf);
+
 extern _Complex float* compute_psf(int N,
 				   const long img2_dims[__VLA(N)],
 				   const long trj_dims[__VLA(N)],
@@ -1,4 +1,6 @@
 
+#include <stdint.h>
+
 #include "noncart/grid.h"
 
 struct multiplace_array_s;
@@ -64,6 +66,9 @@ struct nufft_data {
 
 	struct linop_s* lop_nufft_psf;
 	struct linop_s* lop_fftuc_psf;
+
+	uint64_t data_key;		///< Hash of trajectory, weights and basis (0 if unknown)
+	int psf_incr;			///< Incremental PSF updates since last full computation
 };
 
 
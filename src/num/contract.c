@@ -0,0 +1,513 @@
+/* Copyright 2026. Institute of Biomedical Imaging. TU Graz.
+ * All rights reserved. Use of this source code is governed by
+ * a BSD-style license which can be found in the LICENSE file.
+ */
+
+
+/**
+ * Planner for complex tensor contractions
+ *
+ *	out[b, m, n] (+)= sum_k in1[b, m, k] * in2[b, k, n]
+ *
+ * where b, m, n, k each stand for an arbitrary set of dimensions.
+ * A dimension is classified by which of the three arrays have a
+ * non-zero stride along it:
+ *
+ *	out in1 in2
+ *	 x   x   x	batch
+ *	 x   x   -	M
+ *	 x   -   x	N
+ *	 -   x   x	K
+ *
+ * Each operand is then viewed as a (batch of) column-major matrices.
+ * If the dimensions of a group are not laid out contiguously or
+ * the matrix has no unit stride along rows or columns, the operand
+ * is packed into a temporary array first. The batch is then processed
+ * by calls to cgemm.
+ *
+ * Plans only depend on dimensions and strides and are cached.
+ */
+
+#include <stdbool.h>
+#include <complex.h>
+#include <string.h>
+#include <limits.h>
+
+#include "misc/misc.h"
+#include "misc/debug.h"
+
+#include "num/multind.h"
+#include "num/flpmath.h"
+#include "num/optimize.h"
+#include "num/blas.h"
+#include "num/vptr.h"
+#ifdef USE_CUDA
+#include "num/gpuops.h"
+#endif
+
+#include "contract.h"
+
+
+#define CONTRACT_MAX_DIMS 32
+#define CONTRACT_CACHE_SIZE 16
+
+// minimum number of multiply-adds
+#define CONTRACT_MIN_SIZE 4096
+// minimum number of multiply-adds per element moved
+#define CONTRACT_MIN_INTENSITY 2
+// below this size, a packed output does not pay off
+#define CONTRACT_PACK_SIZE (32 * 32 * 32)
+
+
+enum { OP_OUT, OP_A, OP_B, OP_NUM };
+
+struct operand_s {
+
+	bool pack;
+	char trans;
+	long ld;
+
+	long strs[CONTRACT_MAX_DIMS];	// (simplified) strides of operand
+	long pstrs[CONTRACT_MAX_DIMS];	// strides of packed operand
+	long bstrs[CONTRACT_MAX_DIMS];	// strides of batch loop
+};
+
+struct zcontract_plan_s {
+
+	// signature
+	bool valid;
+	int D;
+	long dims[CONTRACT_MAX_DIMS];
+	long strs[OP_NUM][CONTRACT_MAX_DIMS];
+
+	bool applicable;
+	bool swap;	// in1 and in2 exchanged
+
+	long M;
+	long N;
+	long K;
+	long B;
+
+	int ND;
+	long ndims[CONTRACT_MAX_DIMS];
+
+	int NB;
+	long bdims[CONTRACT_MAX_DIMS];
+
+	struct operand_s op[OP_NUM];
+};
+
+
+static struct zcontract_plan_s plan_cache[CONTRACT_CACHE_SIZE];
+static int plan_cache_next = 0;
+
+
+void zcontract_plan_cache_clear(void)
+{
+#pragma omp critical(zcontract_plan_cache)
+	for (int i = 0; i < CONTRACT_CACHE_SIZE; i++)
+		plan_cache[i].valid = false;
+}
+
+
+static long group_size(int N, const long dims[N], unsigned long flags)
+{
+	long size = 1;
+
+	for (int i = 0; i < N; i++)
+		if (MD_IS_SET(flags, i))
+			size *= dims[i];
+
+	return size;
+}
+
+
+/*
+ * Stride (in elements) of the first dimension of a group, if all dimensions
+ * are contiguous in memory, 0 for an empty group and -1 otherwise.
+ */
+static long group_stride(int N, const long dims[N], const long strs[N], unsigned long flags)
+{
+	long base = 0;
+	long next = 0;
+
+	for (int i = 0; i < N; i++) {
+
+		if (!MD_IS_SET(flags, i))
+			continue;
+
+		if (0 == base)
+			base = strs[i];
+		else if (strs[i] != next)
+			return -1;
+
+		next = strs[i] * dims[i];
+	}
+
+	return base / (long)CFL_SIZE;
+}
+
+
+/*
+ * Checks if the array is a column-major matrix with unit row stride.
+ */
+static bool mat_layout(long rows, long rstr, long cols, long cstr, long* ld)
+{
+	if ((0 > rstr) || (0 > cstr))
+		return false;
+
+	if ((1 < rows) && (1 != rstr))
+		return false;
+
+	if (1 == cols) {
+
+		*ld = MAX(1, rows);
+		return true;
+	}
+
+	if (cstr < rows)
+		return false;
+
+	*ld = cstr;
+
+	return true;
+}
+
+
+static void packed_strides(int N, long pstrs[N], const long dims[N], unsigned long rflags, unsigned long cflags, unsigned long bflags)
+{
+	long str = (long)CFL_SIZE;
+
+	for (int i = 0; i < N; i++)
+		pstrs[i] = 0;
+
+	unsigned long flags[3] = { rflags, cflags, bflags };
+
+	for (int j = 0; j < 3; j++) {
+
+		for (int i = 0; i < N; i++) {
+
+			if (!MD_IS_SET(flags[j], i))
+				continue;
+
+			pstrs[i] = str;
+			str *= dims[i];
+		}
+	}
+}
+
+
+static void plan_operand(struct operand_s* op, int N, const long dims[N],
+		long rows, unsigned long rflags, long cols, unsigned long cflags, unsigned long bflags, bool allow_trans)
+{
+	long rstr = group_stride(N, dims, op->strs, rflags);
+	long cstr = group_stride(N, dims, op->strs, cflags);
+
+	op->pack = false;
+	op->trans = 'N';
+
+	if (mat_layout(rows, rstr, cols, cstr, &op->ld))
+		return;
+
+	op->trans = 'T';
+
+	if (allow_trans && mat_layout(cols, cstr, rows, rstr, &op->ld))
+		return;
+
+	op->pack = true;
+	op->trans = 'N';
+	op->ld = MAX(1, rows);
+
+	packed_strides(N, op->pstrs, dims, rflags, cflags, bflags);
+}
+
+
+static void plan_create(struct zcontract_plan_s* plan)
+{
+	plan->applicable = false;
+
+	long (*strs[OP_NUM])[CONTRACT_MAX_DIMS] = { &plan->op[OP_OUT].strs, &plan->op[OP_A].strs, &plan->op[OP_B].strs };
+
+	md_copy_dims(plan->D, plan->ndims, plan->dims);
+
+	for (int j = 0; j < OP_NUM; j++)
+		md_copy_strides(plan->D, *strs[j], plan->strs[j]);
+
+	int N = simplify_dims(OP_NUM, plan->D, plan->ndims, strs);
+
+	plan->ND = N;
+
+	const long* dims = plan->ndims;
+	const long* ostrs = plan->op[OP_OUT].strs;
+	const long* astrs = plan->op[OP_A].strs;
+	const long* bstrs = plan->op[OP_B].strs;
+
+	unsigned long bflags = 0;
+	unsigned long mflags = 0;
+	unsigned long nflags = 0;
+	unsigned long kflags = 0;
+
+	for (int i = 0; i < N; i++) {
+
+		if (1 == dims[i])
+			continue;
+
+		if ((0 > ostrs[i]) || (0 > astrs[i]) || (0 > bstrs[i]))
+			return;
+
+		if ((0 != ostrs[i]) && (0 != astrs[i]) && (0 != bstrs[i]))
+			bflags = MD_SET(bflags, i);
+		else if ((0 != ostrs[i]) && (0 != astrs[i]))
+			mflags = MD_SET(mflags, i);
+		else if ((0 != ostrs[i]) && (0 != bstrs[i]))
+			nflags = MD_SET(nflags, i);
+		else if ((0 != astrs[i]) && (0 != bstrs[i]))
+			kflags = MD_SET(kflags, i);
+		else
+			return;
+	}
+
+	long M = group_size(N, dims, mflags);
+	long K = group_size(N, dims, kflags);
+	long Nn = group_size(N, dims, nflags);
+
+	plan->B = group_size(N, dims, bflags);
+
+	if ((1 == K) || (1 == M * Nn))
+		return;
+
+	// the cost of packing must be amortized
+
+	if (M * Nn * K < CONTRACT_MIN_INTENSITY * (M * K + K * Nn + M * Nn))
+		return;
+
+	// BLAS uses 32 bit integers
+
+	if ((INT_MAX / 2 < M * K) || (INT_MAX / 2 < K * Nn) || (INT_MAX / 2 < M * Nn))
+		return;
+
+	// orientation of output: make it column-major
+
+	long ld;
+	long mstr = group_stride(N, dims, ostrs, mflags);
+	long nstr = group_stride(N, dims, ostrs, nflags);
+
+	plan->swap = (!mat_layout(M, mstr, Nn, nstr, &ld) && mat_layout(Nn, nstr, M, mstr, &ld));
+
+	if (plan->swap) {
+
+		SWAP(mflags, nflags);
+		SWAP(M, Nn);
+
+		struct operand_s tmp = plan->op[OP_A];
+		plan->op[OP_A] = plan->op[OP_B];
+		plan->op[OP_B] = tmp;
+	}
+
+	plan->M = M;
+	plan->N = Nn;
+	plan->K = K;
+
+	plan_operand(&plan->op[OP_OUT], N, dims, M, mflags, Nn, nflags, bflags, false);
+	plan_operand(&plan->op[OP_A], N, dims, M, mflags, K, kflags, bflags, true);
+	plan_operand(&plan->op[OP_B], N, dims, K, kflags, Nn, nflags, bflags, true);
+
+	// e.g. batch dimensions inside of small matrices are
+	// better handled by the element-wise kernels
+
+	if (plan->op[OP_OUT].pack && (M * Nn * K < CONTRACT_PACK_SIZE))
+		return;
+
+	plan->NB = 0;
+
+	for (int i = 0; i < N; i++) {
+
+		if (!MD_IS_SET(bflags, i))
+			continue;
+
+		for (int j = 0; j < OP_NUM; j++) {
+
+			const struct operand_s* op = &plan->op[j];
+			plan->op[j].bstrs[plan->NB] = (op->pack ? op->pstrs : op->strs)[i];
+		}
+
+		plan->bdims[plan->NB++] = dims[i];
+	}
+
+	plan->applicable = true;
+
+	debug_printf(DP_DEBUG4, "contraction: M=%ld N=%ld K=%ld batch=%ld (pack: %d%d%d, trans: %c%c, swap: %d)\n",
+			plan->M, plan->N, plan->K, plan->B,
+			plan->op[OP_OUT].pack, plan->op[OP_A].pack, plan->op[OP_B].pack,
+			plan->op[OP_A].trans, plan->op[OP_B].trans, plan->swap);
+}
+
+
+static bool plan_matches(const struct zcontract_plan_s* plan, int D, const long dims[D], const long* strs[OP_NUM])
+{
+	if (!plan->valid || (D != plan->D))
+		return false;
+
+	if (0 != memcmp(plan->dims, dims, (size_t)D * sizeof(long)))
+		return false;
+
+	for (int j = 0; j < OP_NUM; j++)
+		if (0 != memcmp(plan->strs[j], strs[j], (size_t)D * sizeof(long)))
+			return false;
+
+	return true;
+}
+
+
+static void plan_get(struct zcontract_plan_s* plan, int D, const long dims[D], const long* strs[OP_NUM])
+{
+	bool found = false;
+
+#pragma omp critical(zcontract_plan_cache)
+	for (int i = 0; i < CONTRACT_CACHE_SIZE; i++) {
+
+		if (plan_matches(&plan_cache[i], D, dims, strs)) {
+
+			*plan = plan_cache[i];
+			found = true;
+			break;
+		}
+	}
+
+	if (found)
+		return;
+
+	memset(plan, 0, sizeof *plan);
+
+	plan->D = D;
+	md_copy_dims(D, plan->dims, dims);
+
+	for (int j = 0; j < OP_NUM; j++)
+		md_copy_strides(D, plan->strs[j], strs[j]);
+
+	plan_create(plan);
+
+	plan->valid = true;
+
+#pragma omp critical(zcontract_plan_cache)
+	{
+		plan_cache[plan_cache_next] = *plan;
+		plan_cache_next = (plan_cache_next + 1) % CONTRACT_CACHE_SIZE;
+	}
+}
+
+
+static void zcontract_batch(const struct zcontract_plan_s* plan, complex float* out, const complex float* A, const complex float* B, bool accumulate)
+{
+	const struct operand_s* op = plan->op;
+
+	long pos[plan->NB ?: 1];
+
+	for (int j = 0; j < plan->NB; j++)
+		pos[j] = 0;
+
+	for (long b = 0; b < plan->B; b++) {
+
+		long off[OP_NUM] = { 0 };
+
+		for (int j = 0; j < plan->NB; j++)
+			for (int o = 0; o < OP_NUM; o++)
+				off[o] += pos[j] * op[o].bstrs[j];
+
+		blas_cgemm(op[OP_A].trans, op[OP_B].trans, plan->M, plan->N, plan->K, 1.,
+				op[OP_A].ld, (const void*)A + off[OP_A],
+				op[OP_B].ld, (const void*)B + off[OP_B],
+				accumulate ? 1. : 0., op[OP_OUT].ld, (void*)out + off[OP_OUT]);
+
+		md_next(plan->NB, plan->bdims, ~0UL, pos);
+	}
+}
+
+
+static complex float* pack(const struct zcontract_plan_s* plan, const struct operand_s* op, const complex float* ptr)
+{
+	long dims[plan->ND];
+	md_select_dims(plan->ND, md_nontriv_strides(plan->ND, op->strs), dims, plan->ndims);
+
+	complex float* tmp = md_alloc(plan->ND, dims, CFL_SIZE);
+
+	md_copy2(plan->ND, dims, op->pstrs, tmp, op->strs, ptr, CFL_SIZE);
+
+	return tmp;
+}
+
+
+/**
+ * Computes a tensor contraction using (batched) matrix multiplications.
+ *
+ * out = in1 * in2 summed over all dimensions with zero output stride,
+ * or out += ... if accumulate is set.
+ *
+ * Returns false if the contraction is not handled.
+ */
+bool simple_zcontract(int D, const long dims[D], const long ostr[D], complex float* out, const long istr1[D], const complex float* in1, const long istr2[D], const complex float* in2, bool accumulate)
+{
+	if ((CONTRACT_MAX_DIMS < D) || (out == in1) || (out == in2))
+		return false;
+
+#ifdef USE_CUDA
+	if (cuda_ondevice(out) || cuda_ondevice(in1) || cuda_ondevice(in2))
+		return false;
+#endif
+	if (is_vptr(out) || is_vptr(in1) || is_vptr(in2))
+		return false;
+
+	// quick check before looking up a plan
+
+	if (CONTRACT_MIN_SIZE > md_calc_size(D, dims))
+		return false;
+
+	bool reduction = false;
+
+	for (int i = 0; i < D; i++)
+		if ((1 < dims[i]) && (0 == ostr[i]) && (0 != istr1[i]) && (0 != istr2[i]))
+			reduction = true;
+
+	if (!reduction)
+		return false;
+
+	struct zcontract_plan_s plan;
+	plan_get(&plan, D, dims, (const long*[OP_NUM]){ ostr, istr1, istr2 });
+
+	if (!plan.applicable)
+		return false;
+
+	const struct operand_s* op = plan.op;
+
+	const complex float* A = plan.swap ? in2 : in1;
+	const complex float* B = plan.swap ? in1 : in2;
+
+	complex float* tA = op[OP_A].pack ? pack(&plan, &op[OP_A], A) : NULL;
+	complex float* tB = op[OP_B].pack ? pack(&plan, &op[OP_B], B) : NULL;
+	complex float* tC = NULL;
+
+	if (op[OP_OUT].pack) {
+
+		long odims[plan.ND];
+		md_select_dims(plan.ND, md_nontriv_strides(plan.ND, op[OP_OUT].strs), odims, plan.ndims);
+
+		tC = accumulate ? pack(&plan, &op[OP_OUT], out) : md_alloc(plan.ND, odims, CFL_SIZE);
+	}
+
+	zcontract_batch(&plan, tC ?: out, tA ?: A, tB ?: B, accumulate);
+
+	if (NULL != tC) {
+
+		long odims[plan.ND];
+		md_select_dims(plan.ND, md_nontriv_strides(plan.ND, op[OP_OUT].strs), odims, plan.ndims);
+
+		md_copy2(plan.ND, odims, op[OP_OUT].strs, out, op[OP_OUT].pstrs, tC, CFL_SIZE);
+	}
+
+	md_free(tA);
+	md_free(tB);
+	md_free(tC);
+
+	return true;
+}
+
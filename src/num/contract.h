@@ -0,0 +1,5 @@
+
+extern _Bool simple_zcontract(int D, const long dims[__VLA(D)], const long ostr[__VLA(D)], _Complex float* out, const long istr1[__VLA(D)], const _Complex float* in1, const long istr2[__VLA(D)], const _Complex float* in2, _Bool accumulate);
+
+extern void zcontract_plan_cache_clear(void);
+
@@ -9,6 +9,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <complex.h>
+#include <math.h>
 
 #include "num/flpmath.h"
 #ifdef USE_CUDA
@@ -27,6 +28,7 @@
 #include "num/init.h"
 #include "num/vecops_strided.h"
 #include "num/vptr.h"
+#include "num/fft.h"
 
 #include "misc/nested.h"
 #include "misc/misc.h"
@@ -35,6 +37,9 @@
 #include "convcorr.h"
 
 static bool use_simple_convcorr = true;
+static _Thread_local bool convcorr_autotuning = false;
+
+bool use_convcorr_autotune = false;
 
 
 //#define CONVCORR_OPTIMIZE_CPU_ONLY
@@ -67,7 +72,16 @@ static void optimized_threeop_oii(int D, const long dim[D], const long ostr[D],
 
 
 
-zconvcorr_fwd_algo_f* algos_fwd_cpu[] = { zconvcorr_fwd_im2col_cf_cpu, };
+zconvcorr_fwd_algo_f* algos_fwd_cpu[] = {
+
+	zconvcorr_fwd_im2col_cf_cpu,
+	zconvcorr_fwd_winograd2_cf_cpu,
+	zconvcorr_fwd_winograd4_cf_cpu,
+	zconvcorr_fwd_fft_cf_cpu,
+};
+
+static const char* algos_fwd_cpu_names[] = { "im2col", "winograd2", "winograd4", "fft" };
+
 zconvcorr_bwd_krn_algo_f* algos_bwd_krn_cpu[] = { zconvcorr_bwd_krn_im2col_cf_cpu, };
 zconvcorr_bwd_in_algo_f* algos_bwd_in_cpu[] = {	zconvcorr_bwd_in_im2col_cf_cpu, };
 
@@ -97,6 +111,262 @@ zconvcorr_bwd_in_algo_f* algos_bwd_in_gpu[] = {
 
 
 
+/*
+ * Selection of the CPU algorithm for the forward convolution
+ *
+ * The choice is made once per shape and cached. By default, a cost model
+ * decides between direct computation, im2col, Winograd F(2x2,3x3) and FFT.
+ * With BART_CONVCORR_AUTOTUNE=1, all applicable algorithms are timed on the
+ * first call instead (including F(4x4,3x3), which loses accuracy in single
+ * precision and is therefore never chosen by the cost model).
+ *
+ * The FFT algorithm needs the spectrum of the kernel on the input grid
+ * (Co x Ci x input size), it is not used when that exceeds
+ * CONVCORR_FFT_MAX_BYTES.
+ *
+ * linop_conv (e.g. linop_conv_gaussian) does not use this code, it always
+ * uses the FFT-based plans in num/conv.c.
+ */
+#define CONVCORR_CACHE_SIZE 32
+#define CONVCORR_MAX_DIMS 16
+#define CONVCORR_FFT_MAX_BYTES (64L << 20)
+
+struct convcorr_choice_s {
+
+	bool valid;
+
+	int N;
+	long odims[CONVCORR_MAX_DIMS];
+	long idims[CONVCORR_MAX_DIMS];
+	long kdims[CONVCORR_MAX_DIMS];
+	long dilation[CONVCORR_MAX_DIMS];
+	long strides[CONVCORR_MAX_DIMS];
+	unsigned long flags;
+	bool conv;
+
+	int algo;	// -1: direct
+	bool tuned;
+	double time[1 + ARRAY_SIZE(algos_fwd_cpu)];	// direct and algorithms, < 0 if not applicable
+};
+
+static struct convcorr_choice_s convcorr_cache[CONVCORR_CACHE_SIZE];
+static int convcorr_cache_next = 0;
+
+
+static bool choice_matches(const struct convcorr_choice_s* ch, int N, const long odims[N], const long idims[N], const long kdims[N],
+			   unsigned long flags, const long dilation[N], const long strides[N], bool conv)
+{
+	return ch->valid && (ch->N == N) && (ch->flags == flags) && (ch->conv == conv)
+		&& md_check_equal_dims(N, ch->odims, odims, ~0UL)
+		&& md_check_equal_dims(N, ch->idims, idims, ~0UL)
+		&& md_check_equal_dims(N, ch->kdims, kdims, ~0UL)
+		&& md_check_equal_dims(N, ch->dilation, (NULL == dilation) ? MD_SINGLETON_DIMS(N) : dilation, ~0UL)
+		&& md_check_equal_dims(N, ch->strides, (NULL == strides) ? MD_SINGLETON_DIMS(N) : strides, ~0UL);
+}
+
+
+static int choose_fwd_algo_cpu(int N, const long odims[N], const long idims[N], const long kdims[N])
+{
+	if (N < 5)
+		return 0;
+
+	double Ci = idims[1];
+	double Co = odims[0];
+
+	double K = md_calc_size(3, kdims + 2);
+	double Po = md_calc_size(3, odims + 2);
+	double Pi = md_calc_size(3, idims + 2);
+
+	// few multiplications per output: im2col only adds copies
+
+	if (Ci * K < 8.)
+		return -1;
+
+	// FFT of input, kernel (Co x Ci) and product (Co)
+
+	double cost_gemm = Co * Ci * K * Po;
+	double cost_fft = (Ci + Co * Ci + Co) * 5. * Pi * log2(MAX(2., Pi)) + Co * Ci * Pi * 4.;
+
+	double fft_bytes = Co * Ci * Pi * CFL_SIZE;
+
+	if ((fft_bytes <= CONVCORR_FFT_MAX_BYTES) && (cost_fft < cost_gemm))
+		return 3;
+
+	if ((3 == kdims[2]) && (3 == kdims[3]) && (1 == kdims[4]) && (Ci * Co >= 16.))
+		return 1;
+
+	return 0;
+}
+
+
+static double time_fwd_algo_cpu(int i, int N,
+				long odims[N], const complex float* in, long idims[N], long istrs[N],
+				const complex float* krn, long kdims[N], long kstrs[N],
+				unsigned long flags, const long dilation[N], const long strides[N], bool conv,
+				const long tdims[2 * N], const long tistrs[2 * N], const long tkstrs[2 * N])
+{
+	long ostrs[N];
+	md_calc_strides(N, ostrs, odims, CFL_SIZE);
+
+	complex float* tmp = md_alloc(N, odims, CFL_SIZE);
+	md_clear(N, odims, tmp, CFL_SIZE);
+
+	double start = timestamp();
+	bool applicable = true;
+
+	if (-1 == i) {
+
+		long tostrs[2 * N];
+		md_singleton_strides(2 * N, tostrs);
+
+		for (int j = 0; j < N; j++)
+			tostrs[j] = ostrs[j];
+
+		convcorr_autotuning = true;
+		md_zfmac2(2 * N, tdims, tostrs, tmp, tistrs, in, tkstrs, krn);
+		convcorr_autotuning = false;
+
+	} else {
+
+		applicable = algos_fwd_cpu[i](N, odims, ostrs, tmp, idims, istrs, in, kdims, kstrs, krn, flags, dilation, strides, conv);
+	}
+
+	double t = timestamp() - start;
+
+	md_free(tmp);
+
+	return applicable ? t : -1.;
+}
+
+
+static int zconvcorr_fwd_select_cpu(int N,
+				long odims[N],
+				long idims[N], long istrs[N], const complex float* in,
+				long kdims[N], long kstrs[N], const complex float* krn,
+				unsigned long flags, const long dilation[N], const long strides[N], bool conv,
+				const long tdims[2 * N], const long tistrs[2 * N], const long tkstrs[2 * N])
+{
+	if (conv)
+		return -1;
+
+	if (N > CONVCORR_MAX_DIMS)
+		return 0;
+
+	int algo = 0;
+	bool found = false;
+
+#pragma omp critical(zconvcorr_algo_cache)
+	for (int i = 0; i < CONVCORR_CACHE_SIZE; i++) {
+
+		if (choice_matches(&convcorr_cache[i], N, odims, idims, kdims, flags, dilation, strides, conv)) {
+
+			algo = convcorr_cache[i].algo;
+			found = true;
+			break;
+		}
+	}
+
+	if (found)
+		return algo;
+
+	struct convcorr_choice_s ch = { .valid = true, .N = N, .flags = flags, .conv = conv, .tuned = use_convcorr_autotune };
+
+	md_copy_dims(N, ch.odims, odims);
+	md_copy_dims(N, ch.idims, idims);
+	md_copy_dims(N, ch.kdims, kdims);
+	md_copy_dims(N, ch.dilation, (NULL == dilation) ? MD_SINGLETON_DIMS(N) : dilation);
+	md_copy_dims(N, ch.strides, (NULL == strides) ? MD_SINGLETON_DIMS(N) : strides);
+
+	for (int i = 0; i < (int)ARRAY_SIZE(ch.time); i++)
+		ch.time[i] = -1.;
+
+	if (use_convcorr_autotune) {
+
+		// the fastest of the applicable algorithms
+
+		ch.algo = -1;
+
+		for (int i = -1; i < (int)ARRAY_SIZE(algos_fwd_cpu); i++) {
+
+			ch.time[i + 1] = time_fwd_algo_cpu(i, N, odims, in, idims, istrs, krn, kdims, kstrs,
+							   flags, dilation, strides, conv, tdims, tistrs, tkstrs);
+
+			if ((0. <= ch.time[i + 1]) && (ch.time[i + 1] < ch.time[ch.algo + 1]))
+				ch.algo = i;
+		}
+
+	} else {
+
+		ch.algo = choose_fwd_algo_cpu(N, odims, idims, kdims);
+	}
+
+	debug_printf(DP_DEBUG2, "zconvcorr_fwd: %s selected for shape %ld x %ld -> %ld.\n",
+		     (-1 == ch.algo) ? "direct" : algos_fwd_cpu_names[ch.algo],
+		     md_calc_size(N, idims), md_calc_size(N, kdims), md_calc_size(N, odims));
+
+#pragma omp critical(zconvcorr_algo_cache)
+	{
+		convcorr_cache[convcorr_cache_next] = ch;
+		convcorr_cache_next = (convcorr_cache_next + 1) % CONVCORR_CACHE_SIZE;
+	}
+
+	return ch.algo;
+}
+
+
+void zconvcorr_algo_cache_clear(void)
+{
+#pragma omp critical(zconvcorr_algo_cache)
+	for (int i = 0; i < CONVCORR_CACHE_SIZE; i++)
+		convcorr_cache[i].valid = false;
+}
+
+
+static void print_dims5(int dl, const char* name, const long dims[5])
+{
+	debug_printf(dl, "%s %3ldx%3ldx%3ldx%3ldx%3ld  ", name, dims[0], dims[1], dims[2], dims[3], dims[4]);
+}
+
+void zconvcorr_print_algo_selection(int dl)
+{
+	debug_printf(dl, "%-28s %-28s %-28s %-10s", "out", "in", "kernel", "selected");
+
+	debug_printf(dl, " %10s", "direct");
+
+	for (int i = 0; i < (int)ARRAY_SIZE(algos_fwd_cpu); i++)
+		debug_printf(dl, " %10s", algos_fwd_cpu_names[i]);
+
+	debug_printf(dl, "\n");
+
+#pragma omp critical(zconvcorr_algo_cache)
+	for (int i = 0; i < CONVCORR_CACHE_SIZE; i++) {
+
+		const struct convcorr_choice_s* ch = &convcorr_cache[i];
+
+		if (!ch->valid || (ch->N < 5))
+			continue;
+
+		print_dims5(dl, "", ch->odims);
+		print_dims5(dl, "", ch->idims);
+		print_dims5(dl, "", ch->kdims);
+
+		debug_printf(dl, "%-10s", (-1 == ch->algo) ? "direct" : algos_fwd_cpu_names[ch->algo]);
+
+		for (int j = 0; j < (int)ARRAY_SIZE(ch->time); j++) {
+
+			if (!ch->tuned)
+				debug_printf(dl, " %10s", "");
+			else if (ch->time[j] < 0.)
+				debug_printf(dl, " %10s", "-");
+			else
+				debug_printf(dl, " %9.4fs", ch->time[j]);
+		}
+
+		debug_printf(dl, "\n");
+	}
+}
+
+
 //detect if strides describe convolution
 static bool detect_convcorr(	int N,
 				long nodims[N], long nidims[N], long nkdims[N],
@@ -243,7 +513,7 @@ bool simple_zconvcorr(	int N, const long dims[N],
 			const long istrs1[N], const complex float* iptr1,
 			const long istrs2[N], const complex float* iptr2)
 {
-	if (!use_simple_convcorr)
+	if (!use_simple_convcorr || convcorr_autotuning)
 		return false;
 
 	if (is_vptr(optr) || is_vptr(iptr1) || is_vptr(iptr2))
@@ -349,13 +619,33 @@ static bool simple_zconvcorr_fwd(	int N, const long dims[N],
 
 	if (!cuda_ondevice(out))
 #endif
-		for (int i = 0; (unsigned long)i < sizeof(algos_fwd_cpu) / sizeof(algos_fwd_cpu[0]); i++)
+	{
+		int algo = zconvcorr_fwd_select_cpu(N, nodims, nidims, nistrs, in, nkdims, nkstrs, krn,
+						flags, dilation, strides, conv, tdims, tistrs, tkstrs);
+
+		// direct computation is faster
+
+		if (-1 == algo)
+			return false;
+
+		if (algos_fwd_cpu[algo](N, nodims, nostrs, out, nidims, nistrs, in, nkdims, nkstrs, krn, flags, dilation, strides, conv))
+			return true;
+
+		for (int i = 0; i < (int)ARRAY_SIZE(algos_fwd_cpu); i++) {
+
+			// loses accuracy, only used when chosen by autotuning
+
+			if (zconvcorr_fwd_winograd4_cf_cpu == algos_fwd_cpu[i])
+				continue;
+
 			if (algos_fwd_cpu[i](	N,
 						nodims, nostrs, out,
 						nidims, nistrs, in,
 						nkdims, nkstrs, krn,
 						flags, dilation, strides, conv))
 				return true;
+		}
+	}
 
 	return false;
 }
@@ -707,6 +997,439 @@ bool zconvcorr_fwd_im2col_cf_cpu(int N,
 }
 
 
+/*
+ * Winograd minimal filtering F(m x m, 3 x 3) [Lavin and Gray, CVPR 2016]
+ *
+ * Y = A^T [ (G g G^T) . (B^T d B) ] A
+ *
+ * The element-wise product is computed as one GEMM over channels per
+ * element of the (m + 2) x (m + 2) tile, i.e. (m + 2)^2 / m^2 instead
+ * of 9 multiplications per output for the channel mixing.
+ */
+struct winograd_s {
+
+	int m;
+	const float* BT;	// a x a
+	const float* G;		// a x 3
+	const float* AT;	// m x a
+};
+
+static const float winograd2_BT[] = {
+
+	1.,  0., -1.,  0.,
+	0.,  1.,  1.,  0.,
+	0., -1.,  1.,  0.,
+	0.,  1.,  0., -1.,
+};
+
+static const float winograd2_G[] = {
+
+	1.,  0.,  0.,
+	0.5, 0.5, 0.5,
+	0.5, -0.5, 0.5,
+	0.,  0.,  1.,
+};
+
+static const float winograd2_AT[] = {
+
+	1., 1.,  1.,  0.,
+	0., 1., -1., -1.,
+};
+
+static const float winograd4_BT[] = {
+
+	4.,  0., -5.,  0., 1., 0.,
+	0., -4., -4.,  1., 1., 0.,
+	0.,  4., -4., -1., 1., 0.,
+	0., -2., -1.,  2., 1., 0.,
+	0.,  2., -1., -2., 1., 0.,
+	0.,  4.,  0., -5., 0., 1.,
+};
+
+static const float winograd4_G[] = {
+
+	1. / 4., 0., 0.,
+	-1. / 6., -1. / 6., -1. / 6.,
+	-1. / 6., 1. / 6., -1. / 6.,
+	1. / 24., 1. / 12., 1. / 6.,
+	1. / 24., -1. / 12., 1. / 6.,
+	0., 0., 1.,
+};
+
+static const float winograd4_AT[] = {
+
+	1., 1.,  1., 1.,  1., 0.,
+	0., 1., -1., 2., -2., 0.,
+	0., 1.,  1., 4.,  4., 0.,
+	0., 1., -1., 8., -8., 1.,
+};
+
+static const struct winograd_s winograd2 = { 2, winograd2_BT, winograd2_G, winograd2_AT };
+static const struct winograd_s winograd4 = { 4, winograd4_BT, winograd4_G, winograd4_AT };
+
+// number of tiles transformed at once
+#define WINOGRAD_TILES 128
+
+
+static void winograd_krn(const struct winograd_s* w, long Co, long Ci, complex float* U, const complex float* krn)
+{
+	int a = w->m + 2;
+
+	for (long c = 0; c < Co * Ci; c++) {
+
+		for (int ey = 0; ey < a; ey++) {
+
+			for (int ex = 0; ex < a; ex++) {
+
+				complex float sum = 0.;
+
+				for (int ky = 0; ky < 3; ky++)
+					for (int kx = 0; kx < 3; kx++)
+						sum += w->G[ex * 3 + kx] * w->G[ey * 3 + ky] * krn[c + Co * Ci * (kx + 3 * ky)];
+
+				U[c + Co * Ci * (ex + a * ey)] = sum;
+			}
+		}
+	}
+}
+
+
+static void winograd_tiles(const struct winograd_s* w, long t0, long T,
+			   const long idims[5], const long odims[5], long tx, long ty,
+			   complex float* out, const complex float* in, const complex float* U,
+			   complex float* V, complex float* M)
+{
+	int m = w->m;
+	int a = m + 2;
+
+	long Ci = idims[1];
+	long Co = odims[0];
+
+	// input transform V[e] (Ci x T)
+
+	for (long t = 0; t < T; t++) {
+
+		long tt = t0 + t;
+
+		long x0 = (tt % tx) * m;
+		long y0 = ((tt / tx) % ty) * m;
+		long z = tt / (tx * ty);
+
+		for (long c = 0; c < Ci; c++) {
+
+			complex float d[a * a];
+
+			for (int j = 0; j < a; j++) {
+
+				for (int i = 0; i < a; i++) {
+
+					long x = x0 + i;
+					long y = y0 + j;
+
+					d[i + a * j] = ((x < idims[2]) && (y < idims[3]))
+						? in[c + Ci * (x + idims[2] * (y + idims[3] * z))] : 0.;
+				}
+			}
+
+			complex float tmp[a * a];
+
+			for (int j = 0; j < a; j++) {
+
+				for (int e = 0; e < a; e++) {
+
+					complex float sum = 0.;
+
+					for (int i = 0; i < a; i++)
+						sum += w->BT[e * a + i] * d[i + a * j];
+
+					tmp[e + a * j] = sum;
+				}
+			}
+
+			for (int f = 0; f < a; f++) {
+
+				for (int e = 0; e < a; e++) {
+
+					complex float sum = 0.;
+
+					for (int j = 0; j < a; j++)
+						sum += w->BT[f * a + j] * tmp[e + a * j];
+
+					V[c + Ci * (t + T * (e + a * f))] = sum;
+				}
+			}
+		}
+	}
+
+	// M[e] = U[e] V[e]
+
+	md_clear(1, MD_DIMS(Co * T * a * a), M, CFL_SIZE);
+
+	for (int e = 0; e < a * a; e++)
+		blas_matrix_zfmac(Co, T, Ci, M + Co * T * e, U + Co * Ci * e, 'N', V + Ci * T * e, 'N');
+
+	// output transform
+
+	for (long t = 0; t < T; t++) {
+
+		long tt = t0 + t;
+
+		long x0 = (tt % tx) * m;
+		long y0 = ((tt / tx) % ty) * m;
+		long z = tt / (tx * ty);
+
+		for (long c = 0; c < Co; c++) {
+
+			complex float tmp[m * a];
+
+			for (int f = 0; f < a; f++) {
+
+				for (int i = 0; i < m; i++) {
+
+					complex float sum = 0.;
+
+					for (int e = 0; e < a; e++)
+						sum += w->AT[i * a + e] * M[c + Co * (t + T * (e + a * f))];
+
+					tmp[i + m * f] = sum;
+				}
+			}
+
+			for (int j = 0; j < m; j++) {
+
+				long y = y0 + j;
+
+				if (y >= odims[3])
+					break;
+
+				for (int i = 0; i < m; i++) {
+
+					long x = x0 + i;
+
+					if (x >= odims[2])
+						break;
+
+					complex float sum = 0.;
+
+					for (int f = 0; f < a; f++)
+						sum += w->AT[j * a + f] * tmp[i + m * f];
+
+					out[c + Co * (x + odims[2] * (y + odims[3] * z))] += sum;
+				}
+			}
+		}
+	}
+}
+
+
+static bool zconvcorr_fwd_winograd_cf_cpu(const struct winograd_s* w, int N,
+				long odims[N], long ostrs[N], complex float* out,
+				long idims[N], long istrs[N], const complex float* in,
+				long kdims[N], long kstrs[N], const complex float* krn,
+				unsigned long flags, const long dilation[N], const long strides[N], bool conv)
+{
+#ifdef USE_CUDA
+	if (cuda_ondevice(out))
+		return false;
+#endif
+	if (5 > N)
+		return false;
+
+	if (!check_trivial_cf(5, odims, ostrs, idims, istrs, kdims, kstrs, flags, CFL_SIZE))
+		return false;
+
+	if (!check_trivial_strs_dil(5, dilation, strides))
+		return false;
+
+	if (conv || (3 != kdims[2]) || (3 != kdims[3]) || (1 != kdims[4]))
+		return false;
+
+	int a = w->m + 2;
+
+	long osize = md_calc_size(5, odims);
+	long ksize = md_calc_size(5, kdims);
+	long isize = md_calc_size(5, idims);
+
+	long Ci = idims[1];
+	long Co = odims[0];
+
+	long tx = (odims[2] + w->m - 1) / w->m;
+	long ty = (odims[3] + w->m - 1) / w->m;
+	long tiles = tx * ty * odims[4];
+
+	long mdims[N - 5];
+
+	md_tenmul_dims(N - 5, mdims, odims + 5, idims + 5, kdims + 5);
+
+	const long* idimsP = idims; // clang
+	const long* odimsP = odims;
+
+	NESTED(void, nary_zconvcorr_winograd, (struct nary_opt_data_s* data, void* ptr[]))
+	{
+		for (long i = 0; i < data->size; i++) {
+
+			complex float* U = md_alloc(1, MD_DIMS(Co * Ci * a * a), CFL_SIZE);
+
+			winograd_krn(w, Co, Ci, U, (const complex float*)ptr[2] + i * ksize);
+
+			complex float* optr = (complex float*)ptr[0] + i * osize;
+			const complex float* iptr = (const complex float*)ptr[1] + i * isize;
+
+#pragma omp parallel for
+			for (long t0 = 0; t0 < tiles; t0 += WINOGRAD_TILES) {
+
+				long T = MIN(WINOGRAD_TILES, tiles - t0);
+
+				complex float* V = md_alloc(1, MD_DIMS(Ci * T * a * a), CFL_SIZE);
+				complex float* M = md_alloc(1, MD_DIMS(Co * T * a * a), CFL_SIZE);
+
+				winograd_tiles(w, t0, T, idimsP, odimsP, tx, ty, optr, iptr, U, V, M);
+
+				md_free(V);
+				md_free(M);
+			}
+
+			md_free(U);
+		}
+	};
+
+	optimized_threeop_oii(N - 5, mdims, ostrs + 5, (void*)out, istrs + 5, (void*)in, kstrs + 5, (void*)krn,
+				(size_t[3]){ (size_t)(osize * (long)CFL_SIZE), (size_t)(isize * (long)CFL_SIZE), (size_t)(ksize * (long)CFL_SIZE) },
+				nary_zconvcorr_winograd);
+
+	debug_printf(DP_DEBUG3, "conv by %s F(%dx%d,3x3)\n", __func__, w->m, w->m);
+
+	return true;
+}
+
+
+bool zconvcorr_fwd_winograd2_cf_cpu(int N,
+				long odims[N], long ostrs[N], complex float* out,
+				long idims[N], long istrs[N], const complex float* in,
+				long kdims[N], long kstrs[N], const complex float* krn,
+				unsigned long flags, const long dilation[N], const long strides[N], bool conv)
+{
+	return zconvcorr_fwd_winograd_cf_cpu(&winograd2, N, odims, ostrs, out, idims, istrs, in, kdims, kstrs, krn, flags, dilation, strides, conv);
+}
+
+
+bool zconvcorr_fwd_winograd4_cf_cpu(int N,
+				long odims[N], long ostrs[N], complex float* out,
+				long idims[N], long istrs[N], const complex float* in,
+				long kdims[N], long kstrs[N], const complex float* krn,
+				unsigned long flags, const long dilation[N], const long strides[N], bool conv)
+{
+	return zconvcorr_fwd_winograd_cf_cpu(&winograd4, N, odims, ostrs, out, idims, istrs, in, kdims, kstrs, krn, flags, dilation, strides, conv);
+}
+
+
+/*
+ * Correlation by FFT over the input grid
+ *
+ * With the flipped kernel k'[j] = k[K - 1 - j], the valid correlation
+ * is out[p] = (in * k')[p + K - 1], where the circular convolution of
+ * the size of the input does not wrap around for valid outputs.
+ */
+bool zconvcorr_fwd_fft_cf_cpu(int N,
+				long odims[N], long ostrs[N], complex float* out,
+				long idims[N], long istrs[N], const complex float* in,
+				long kdims[N], long kstrs[N], const complex float* krn,
+				unsigned long flags, const long dilation[N], const long strides[N], bool conv)
+{
+#ifdef USE_CUDA
+	if (cuda_ondevice(out))
+		return false;
+#endif
+	if (5 > N)
+		return false;
+
+	if (!check_trivial_cf(5, odims, ostrs, idims, istrs, kdims, kstrs, flags, CFL_SIZE))
+		return false;
+
+	if (!check_trivial_strs_dil(5, dilation, strides))
+		return false;
+
+	if (conv)
+		return false;
+
+	long osize = md_calc_size(5, odims);
+	long ksize = md_calc_size(5, kdims);
+	long isize = md_calc_size(5, idims);
+
+	long Ci = idims[1];
+	long Co = odims[0];
+
+	long fdims[5] = { Co, Ci, idims[2], idims[3], idims[4] };	// kernel on input grid
+	long pdims[5] = { Co, 1, idims[2], idims[3], idims[4] };	// product
+
+	if (md_calc_size(5, fdims) * (long)CFL_SIZE > CONVCORR_FFT_MAX_BYTES)
+		return false;
+
+	float scale = 1. / (idims[2] * idims[3] * idims[4]);
+
+	long mdims[N - 5];
+
+	md_tenmul_dims(N - 5, mdims, odims + 5, idims + 5, kdims + 5);
+
+	const long* kdimsP = kdims; // clang
+	const long* idimsP = idims;
+	const long* odimsP = odims;
+
+	NESTED(void, nary_zconvcorr_fft, (struct nary_opt_data_s* data, void* ptr[]))
+	{
+		for (long i = 0; i < data->size; i++) {
+
+			const complex float* kptr = (const complex float*)ptr[2] + i * ksize;
+
+			complex float* kf = md_alloc(5, fdims, CFL_SIZE);
+			complex float* inf = md_alloc(5, idimsP, CFL_SIZE);
+			complex float* pf = md_alloc(5, pdims, CFL_SIZE);
+
+			md_clear(5, fdims, kf, CFL_SIZE);
+
+			long KX = kdimsP[2];
+			long KY = kdimsP[3];
+			long KZ = kdimsP[4];
+
+			for (long z = 0; z < KZ; z++)
+				for (long y = 0; y < KY; y++)
+					for (long x = 0; x < KX; x++)
+						for (long c = 0; c < Co * Ci; c++)
+							kf[c + Co * Ci * (x + fdims[2] * (y + fdims[3] * z))]
+								= scale * kptr[c + Co * Ci * ((KX - 1 - x) + KX * ((KY - 1 - y) + KY * (KZ - 1 - z)))];
+
+			fft(5, fdims, 28, kf, kf);
+			fft(5, idimsP, 28, inf, (const complex float*)ptr[1] + i * isize);
+
+			md_ztenmul(5, pdims, pf, idimsP, inf, fdims, kf);
+
+			ifft(5, pdims, 28, pf, pf);
+
+			long pstrs[5];
+			md_calc_strides(5, pstrs, pdims, CFL_SIZE);
+
+			long off = ((KX - 1) * pstrs[2] + (KY - 1) * pstrs[3] + (KZ - 1) * pstrs[4]) / (long)CFL_SIZE;
+
+			complex float* optr = (complex float*)ptr[0] + i * osize;
+
+			md_zadd2(5, odimsP, MD_STRIDES(5, odimsP, CFL_SIZE), optr, MD_STRIDES(5, odimsP, CFL_SIZE), optr, pstrs, pf + off);
+
+			md_free(kf);
+			md_free(inf);
+			md_free(pf);
+		}
+	};
+
+	optimized_threeop_oii(N - 5, mdims, ostrs + 5, (void*)out, istrs + 5, (void*)in, kstrs + 5, (void*)krn,
+				(size_t[3]){ (size_t)(osize * (long)CFL_SIZE), (size_t)(isize * (long)CFL_SIZE), (size_t)(ksize * (long)CFL_SIZE) },
+				nary_zconvcorr_fft);
+
+	debug_printf(DP_DEBUG3, "conv by %s \n", __func__);
+
+	return true;
+}
+
+
 bool zconvcorr_bwd_krn_im2col_cf_cpu(int N,
 				long odims[N], long ostrs[N], const complex float* out,
 				long idims[N], long istrs[N], const complex float* in,
@@ -3,6 +3,11 @@ extern _Bool simple_zconvcorr(	int N, const long dims[__VLA(N)],
 				const long istrs1[__VLA(N)], const _Complex float* iptr1,
 				const long istrs2[__VLA(N)], const _Complex float* iptr2);
 
+extern _Bool use_convcorr_autotune;
+
+extern void zconvcorr_algo_cache_clear(void);
+extern void zconvcorr_print_algo_selection(int dl);
+
 typedef _Bool zconvcorr_fwd_algo_f(	int N,
 					long odims[__VLA(N)], long ostrs[__VLA(N)], _Complex float* out,
 					long idims[__VLA(N)], long istrs[__VLA(N)], const _Complex float* in,
@@ -20,6 +25,9 @@ typedef _Bool zconvcorr_bwd_krn_algo_f(	int N,
 					unsigned long flags, const long dilation[__VLA2(N)], const long strides[__VLA2(N)], _Bool conv);
 
 zconvcorr_fwd_algo_f zconvcorr_fwd_im2col_cf_cpu;
+zconvcorr_fwd_algo_f zconvcorr_fwd_winograd2_cf_cpu;
+zconvcorr_fwd_algo_f zconvcorr_fwd_winograd4_cf_cpu;
+zconvcorr_fwd_algo_f zconvcorr_fwd_fft_cf_cpu;
 zconvcorr_bwd_in_algo_f zconvcorr_bwd_in_im2col_cf_cpu;
 zconvcorr_bwd_krn_algo_f zconvcorr_bwd_krn_im2col_cf_cpu;
 
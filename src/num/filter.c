@@ -12,6 +12,9 @@
 #include <assert.h>
 #include <complex.h>
 #include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "num/multind.h"
 #include "num/flpmath.h"
@@ -116,16 +119,137 @@ void weiszfeld(int iter, int N, int D, float x[D], const float in[N][D])
 	}
 }
 
-static complex float median_geometric_complex_float(int N, const complex float ar[N])
+/*
+ * Sliding window along dimension k: the window dimension M
+ * has the same stride, i.e. output j sees inputs j ... j + L - 1.
+ */
+static int sliding_dim(int D, int M, const long dim[D], const long istr[D])
+{
+	if (1 == dim[M])
+		return -1;
+
+	for (int k = 0; k < D; k++)
+		if ((k != M) && (1 < dim[k]) && (istr[k] == istr[M]))
+			return k;
+
+	return -1;
+}
+
+
+struct median_entry_s {
+
+	float key;
+	complex float val;
+};
+
+static struct median_entry_s median_entry(complex float val)
+{
+	return (struct median_entry_s){ .key = cabsf(val), .val = val };
+}
+
+// first position with a key not smaller than 'key'
+
+static int window_lower(int L, const struct median_entry_s win[L], float key)
+{
+	int a = 0;
+	int b = L;
+
+	while (a < b) {
+
+		int m = (a + b) / 2;
+
+		if (win[m].key < key)
+			a = m + 1;
+		else
+			b = m;
+	}
+
+	return a;
+}
+
+static void window_insert(int L, struct median_entry_s win[L + 1], struct median_entry_s e)
+{
+	int p = window_lower(L, win, e.key);
+
+	memmove(&win[p + 1], &win[p], (size_t)(L - p) * sizeof(struct median_entry_s));
+	win[p] = e;
+}
+
+static void window_remove(int L, struct median_entry_s win[L], complex float val)
+{
+	int p = window_lower(L, win, cabsf(val));
+
+	while ((p < L - 1) && (0 != memcmp(&win[p].val, &val, sizeof(complex float))))
+		p++;
+
+	assert(0 == memcmp(&win[p].val, &val, sizeof(complex float)));
+
+	memmove(&win[p], &win[p + 1], (size_t)(L - p - 1) * sizeof(struct median_entry_s));
+}
+
+static complex float window_median(int L, const struct median_entry_s win[L])
 {
-	complex float x;
+	if (1 == L % 2)
+		return win[(L - 1) / 2].val;
 
-	// Weiszfeld's algorithm
-	weiszfeld(10, N, 2, *(float(*)[2])&x, *(float(*)[N][2])ar);
+	return (win[(L - 1) / 2 + 0].val + win[(L - 1) / 2 + 1].val) / 2.;
+}
+
+/*
+ * Running median (by magnitude as in median_complex_float) of a
+ * line: the window is kept sorted, so that each step only needs
+ * to remove the oldest and insert the newest element. Magnitudes
+ * which are NaN cannot be sorted, lines with non-finite values are
+ * computed window by window with median_complex_float.
+ */
+static void median_line(int L, long N, long ostr, complex float* out, long istr, const complex float* in)
+{
+#define IN(i) (*(const complex float*)((const void*)in + (i) * istr))
+#define OUT(i) (*(complex float*)((void*)out + (i) * ostr))
+
+	bool finite = true;
+
+	for (long i = 0; i < N + L - 1; i++)
+		finite = finite && isfinite(crealf(IN(i))) && isfinite(cimagf(IN(i)));
+
+	if (!finite) {
+
+		complex float* tmp = xmalloc((size_t)L * sizeof(complex float));
+
+		for (long j = 0; j < N; j++) {
+
+			for (int i = 0; i < L; i++)
+				tmp[i] = IN(j + i);
+
+			OUT(j) = median_complex_float(L, tmp);
+		}
+
+		xfree(tmp);
+
+		return;
+	}
+
+	struct median_entry_s* win = xmalloc((size_t)(L + 1) * sizeof(struct median_entry_s));
+
+	for (int i = 0; i < L; i++)
+		window_insert(i, win, median_entry(IN(i)));
+
+	OUT(0) = window_median(L, win);
+
+	for (long j = 1; j < N; j++) {
+
+		window_remove(L, win, IN(j - 1));
+		window_insert(L - 1, win, median_entry(IN(j + L - 1)));
+
+		OUT(j) = window_median(L, win);
+	}
+#undef IN
+#undef OUT
 
-	return x;
+	xfree(win);
 }
 
+
 void md_medianz2(int D, int M, const long dim[D], const long ostr[D], complex float* optr, const long istr[D], const complex float* iptr)
 {
 	assert(M < D);
@@ -135,6 +259,28 @@ void md_medianz2(int D, int M, const long dim[D], const long ostr[D], complex fl
         long length = dim[M];
         long stride = istr[M];
 
+	int k = sliding_dim(D, M, dim, istr);
+
+	if (-1 != k) {
+
+		long dim2[D];
+		md_select_dims(D, ~(MD_BIT(M) | MD_BIT(k)), dim2, dim);
+
+		long lines = md_calc_size(D, dim2);
+
+#pragma omp parallel for
+		for (long l = 0; l < lines; l++) {
+
+			long pos[D];
+			md_unravel_index(D, pos, ~0UL, dim2, l);
+
+			median_line((int)length, dim[k], ostr[k], (void*)optr + md_calc_offset(D, ostr, pos),
+					istr[k], (const void*)iptr + md_calc_offset(D, istr, pos));
+		}
+
+		return;
+	}
+
 	long dim2[D];
 	md_select_dims(D, ~(1u << M), dim2, dim);
 
@@ -167,29 +313,127 @@ void md_medianz(int D, int M, const long dim[D], complex float* optr, const comp
 	md_medianz2(D, M, dim, ostr, optr, istr, iptr);
 }
 
+
+enum { WEISZFELD_BATCH = 64 };
+
+/*
+ * Weiszfeld's algorithm (as in weiszfeld) for a batch of P
+ * points at once. The samples are stored as re/im[N][P].
+ */
+static void weiszfeld_batch(int iter, int N, int P, float xr[P], float xi[P], const float re[N][P], const float im[N][P])
+{
+	bool done[P];
+	float sum[P];
+	float ar[P];
+	float ai[P];
+
+	for (int p = 0; p < P; p++) {
+
+		xr[p] = 0.;
+		xi[p] = 0.;
+		done[p] = false;
+	}
+
+	for (int l = 0; l < iter; l++) {
+
+		for (int p = 0; p < P; p++) {
+
+			sum[p] = 0.;
+			ar[p] = 0.;
+			ai[p] = 0.;
+		}
+
+		for (int i = 0; i < N; i++) {
+
+			for (int p = 0; p < P; p++) {
+
+				float d = sqrtf((xr[p] - re[i][p]) * (xr[p] - re[i][p]) + (xi[p] - im[i][p]) * (xi[p] - im[i][p]));
+
+				if (0. == d)
+					done[p] = true;
+
+				float w = (0. == d) ? 0. : (1. / d);
+
+				sum[p] += w;
+				ar[p] += re[i][p] * w;
+				ai[p] += im[i][p] * w;
+			}
+		}
+
+		for (int p = 0; p < P; p++) {
+
+			if (done[p])
+				continue;
+
+			xr[p] = ar[p] / sum[p];
+			xi[p] = ai[p] / sum[p];
+		}
+	}
+}
+
+
 void md_geometric_medianz2(int D, int M, const long dim[D], const long ostr[D], complex float* optr, const long istr[D], const complex float* iptr)
 {
 	assert(M < D);
-	const long* nstr[2] = { ostr, istr };
-	void* nptr[2] = { optr, (void*)iptr };
 
-	long dim2[D];
         long length = dim[M];
 	long stride = istr[M];
 
-	md_select_dims(D, ~(1u << M), dim2, dim);
+	// batch along the fastest non-trivial dimension
 
-	NESTED(void, nary_medianz, (void* ptr[]))
-	{
-		complex float tmp[length];
+	int b = -1;
 
-		for (long i = 0; i < length; i++)
-			tmp[i] = *((complex float*)(ptr[1] + i * stride));
+	for (int i = 0; i < D; i++)
+		if ((i != M) && (1 < dim[i]) && ((-1 == b) || (labs(istr[i]) < labs(istr[b]))))
+			b = i;
 
-		*(complex float*)ptr[0] = median_geometric_complex_float(length, tmp);
-	};
+	long bdim = (-1 == b) ? 1 : dim[b];
+	long bistr = (-1 == b) ? 0 : istr[b];
+	long bostr = (-1 == b) ? 0 : ostr[b];
 
-	md_nary(2, D, dim2, nstr, nptr, nary_medianz);
+	long dim2[D];
+	md_select_dims(D, ~(MD_BIT(M) | ((-1 == b) ? 0UL : MD_BIT(b))), dim2, dim);
+
+	long lines = md_calc_size(D, dim2);
+	long chunks = (bdim + WEISZFELD_BATCH - 1) / WEISZFELD_BATCH;
+
+#pragma omp parallel for collapse(2)
+	for (long l = 0; l < lines; l++) {
+		for (long c = 0; c < chunks; c++) {
+
+			long pos[D];
+			md_unravel_index(D, pos, ~0UL, dim2, l);
+
+			const void* in = (const void*)iptr + md_calc_offset(D, istr, pos) + c * WEISZFELD_BATCH * bistr;
+			void* out = (void*)optr + md_calc_offset(D, ostr, pos) + c * WEISZFELD_BATCH * bostr;
+
+			int P = MIN(WEISZFELD_BATCH, bdim - c * WEISZFELD_BATCH);
+
+			float (*re)[length][P] = xmalloc(sizeof *re);
+			float (*im)[length][P] = xmalloc(sizeof *im);
+
+			for (long i = 0; i < length; i++) {
+				for (int p = 0; p < P; p++) {
+
+					complex float v = *(const complex float*)(in + i * stride + p * bistr);
+
+					(*re)[i][p] = crealf(v);
+					(*im)[i][p] = cimagf(v);
+				}
+			}
+
+			float xr[P];
+			float xi[P];
+
+			weiszfeld_batch(10, length, P, xr, xi, *re, *im);
+
+			for (int p = 0; p < P; p++)
+				*(complex float*)(out + p * bostr) = xr[p] + 1.i * xi[p];
+
+			xfree(re);
+			xfree(im);
+		}
+	}
 }
 
 void md_geometric_medianz(int D, int M, const long dim[D], complex float* optr, const complex float* iptr)
@@ -206,7 +450,7 @@ void md_geometric_medianz(int D, int M, const long dim[D], complex float* optr,
 	md_calc_strides(D, istr, dim, CFL_SIZE);
 	md_calc_strides(D, ostr, dim2, CFL_SIZE);
 
-	md_medianz2(D, M, dim, ostr, optr, istr, iptr);
+	md_geometric_medianz2(D, M, dim, ostr, optr, istr, iptr);
 }
 
 
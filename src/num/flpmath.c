@@ -1169,6 +1169,9 @@ void md_ztenmul2(int D, const long max_dims[D], const long out_strs[D], complex
 		return;
 	}
 
+	if (simple_ztenmul(D, max_dims, out_strs, out, in1_strs, in1, in2_strs, in2))
+		return;
+
 	md_clear2(D, max_dims, out_strs, out, CFL_SIZE);
 	md_zfmac2(D, max_dims, out_strs, out, in1_strs, in1, in2_strs, in2);
 }
@@ -26,6 +26,7 @@
 #include "misc/mmio.h"
 
 #include "num/fft.h"
+#include "num/convcorr.h"
 
 #ifdef USE_CUDA
 #include "num/gpuops.h"
@@ -53,6 +54,19 @@ static void num_init_internal(void)
 	}
 		
 
+	const char* autotune_str;
+
+	if (NULL != (autotune_str = getenv("BART_CONVCORR_AUTOTUNE"))) {
+
+		long autotune = strtol(autotune_str, NULL, 10);
+
+		if ((1 != autotune) && (0 != autotune))
+			error("BART_CONVCORR_AUTOTUNE environment variable must be 0 or 1!\n");
+
+		use_convcorr_autotune = (1 == autotune);
+	}
+
+
 	const char* chunk_str;
 
 	if (NULL != (chunk_str = getenv("BART_PARALLEL_CHUNK_SIZE"))) {
@@ -190,6 +190,42 @@ void matf_mul(int A, int B, int C, float x[A][C], const float y[A][B], const flo
 }
 
 
+/*
+ * Integer matrix power by repeated squaring, i.e.
+ * O(log p) instead of O(p) matrix products.
+ */
+void matf_pow(int N, float out[N][N], const float in[N][N], int p)
+{
+	assert(0 <= p);
+
+	float base[N][N];
+	float tmp[N][N];
+
+	matf_copy(N, N, base, in);
+
+	for (int i = 0; i < N; i++)
+		for (int j = 0; j < N; j++)
+			out[i][j] = (i == j) ? 1. : 0.;
+
+	while (0 < p) {
+
+		if (1 == p % 2) {
+
+			matf_mul(N, N, N, tmp, out, base);
+			matf_copy(N, N, out, tmp);
+		}
+
+		p /= 2;
+
+		if (0 < p) {
+
+			matf_mul(N, N, N, tmp, base, base);
+			matf_copy(N, N, base, tmp);
+		}
+	}
+}
+
+
 
 bool mat_inverse(int N, complex float out[N][N], const complex float in[N][N])
 {
@@ -18,6 +18,7 @@ extern void mat_gaussian(int A, int B, complex float x[A][B]);
 extern void mat_mul(int A, int B, int C, complex float x[A][C], const complex float y[A][B], const complex float z[B][C]);
 
 extern void matf_mul(int A, int B, int C, float x[A][C], const float y[A][B], const float z[B][C]);
+extern void matf_pow(int N, float out[N][N], const float in[N][N], int p);
 
 #define MVLA(x) __restrict__ (A)
 extern void mat_muladd(int A, int B, int C, complex float x[MVLA(A)][C], const complex float y[MVLA(A)][B], const complex float z[MVLA(B)][C]);
@@ -3,6 +3,9 @@
  * a BSD-style license which can be found in the LICENSE file.
  */
 
+#include <complex.h>
+#include <math.h>
+
 #include "num/ode.h"
 #include "num/linalg.h"
 
@@ -67,6 +70,34 @@ void zmat_exp(int N, float t, complex float out[N][N], const complex float in[N]
 }
 
 
+// compute exp(tA) x without forming exp(tA)
+void zmat_expv(int N, float t, complex float out[N], const complex float in[N][N], const complex float x[N])
+{
+	float h = t / 10.;
+	float tol = 1.E-5;
+
+	// the tolerance is absolute, so integrate for a normalized vector
+
+	float norm = 0.;
+
+	for (int i = 0; i < N; i++)
+		norm += crealf(x[i] * conjf(x[i]));
+
+	norm = sqrtf(norm);
+
+	for (int i = 0; i < N; i++)
+		out[i] = (0. == norm) ? 0. : x[i] / norm;
+
+	if (0. == norm)
+		return;
+
+	zode_matrix_interval(h, tol, N, out, 0., t, in);
+
+	for (int i = 0; i < N; i++)
+		out[i] *= norm;
+}
+
+
 void mat_to_exp(int N, float st, float en, float out[N][N], float tol,
 		void CLOSURE_TYPE(f)(float* out, float t, const float* yn))
 {
@@ -19,6 +19,11 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "misc/misc.h"
 #include "misc/debug.h"
@@ -59,7 +64,15 @@ void init_mpi(int* argc, char*** argv)
 
 		mpi_initialized = true;
 
-		MPI_Init(argc, argv);
+		// only the main thread communicates,
+		// worker threads only run compute kernels
+
+		int provided;
+		MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED, &provided);
+
+		if (MPI_THREAD_FUNNELED > provided)
+			debug_printf(DP_WARN, "MPI does not support threads, OpenMP threads may not be safe.\n");
+
 		MPI_Comm_dup(MPI_COMM_WORLD, &comm);
 		MPI_Comm_rank(comm, &mpi_rank);
 		MPI_Comm_size(comm, &mpi_nprocs);
@@ -76,7 +89,28 @@ void init_mpi(int* argc, char*** argv)
 
 		int rank_on_node;
 		MPI_Comm_rank(node_comm, &rank_on_node);
-		
+
+		int ranks_on_node;
+		MPI_Comm_size(node_comm, &ranks_on_node);
+
+#ifdef _OPENMP
+		// Ranks keep their threads for compute kernels. If a rank
+		// is not bound to a subset of the cores, the cores of a node
+		// are divided among the ranks running on it.
+
+		if (NULL == getenv("OMP_NUM_THREADS")) {
+
+			int threads = omp_get_num_procs();
+
+			if (threads == sysconf(_SC_NPROCESSORS_ONLN))
+				threads = MAX(1, threads / ranks_on_node);
+
+			omp_set_num_threads(threads);
+		}
+
+		debug_printf(DP_DEBUG1, "MPI rank %d: %d of %d ranks on node, %d threads.\n",
+				mpi_rank, rank_on_node, ranks_on_node, omp_get_max_threads());
+#endif
 		int number_of_nodes = (rank_on_node == 0);
 
 		MPI_Allreduce(MPI_IN_PLACE, &number_of_nodes, 1, MPI_INT, MPI_SUM, comm);
@@ -516,92 +550,7 @@ static void mpi_allreduce_sum_gpu(int N, float vec[N], MPI_Comm comm)
 #endif
 
 #ifdef USE_MPI
-static void mpi_reduce_sum_kernel(unsigned long reduce_flags, long N, float vec[N])
-{
-	if (1 == mpi_get_num_procs())
-		error("MPI reduction requested but only run by one process!\n");
-
-	int tag = mpi_reduce_color(reduce_flags, vec);
-
-	MPI_Comm comm_sub;
-	MPI_Comm_split(mpi_get_comm(), tag, 0, &comm_sub);
-
-	if (0 < tag) {
-
-		vec = vptr_resolve(vec);
-
-		for (long n = 0; n < N; n += INT_MAX / 2)
-			mpi_allreduce_sum_gpu(MIN(N - n, INT_MAX / 2), vec + n, comm_sub);
-	}
-
-	MPI_Comm_free(&comm_sub);
-}
-#endif
-
-
-#ifdef USE_MPI
-void mpi_reduce_sum_vector(long N, float vec[N])
-{
-	if (1 == mpi_get_num_procs())
-		error("MPI reduction requested but only run by one process!\n");
-
-	for (long n = 0; n < N; n += INT_MAX / 2)
-		mpi_allreduce_sum_gpu(MIN(N - n, INT_MAX / 2), vec + n, mpi_get_comm());
-}
-#endif
-
-void mpi_reduce_sum(int N, unsigned long reduce_flags, const long dims[N], float* ptr)
-{
-	long tdims[N];
-	md_copy_dims(N, tdims, dims);
-
-	long strs[N];
-	md_calc_strides(N, strs, dims, FL_SIZE);
-
-	unsigned long block_flags = vptr_block_loop_flags(N, dims, strs, ptr, FL_SIZE);
-
-	long size = 1;
-
-	for (int i = 0; i < N; i++) {
-
-		if (MD_IS_SET(block_flags, i))
-			break;
-
-		if (strs[i] == size * (long)FL_SIZE) {
-
-			size *= tdims[i];
-			tdims[i] = 1;
-		}
-	}
-
-	long pos[N];
-	md_singleton_strides(N, pos);
-
-	do {
-#ifdef USE_MPI
-		mpi_reduce_sum_kernel(reduce_flags, size, &MD_ACCESS(N, strs, pos, ptr));
-#else
-		(void)reduce_flags;
-#endif
-	} while (md_next(N, tdims, ~0UL, pos));
-}
-
-void mpi_reduce_zsum(int N, unsigned long reduce_flags, const long dims[N], complex float* ptr)
-{
-	mpi_reduce_sum(N + 1, reduce_flags, MD_REAL_DIMS(N, dims), (float*)ptr);
-}
-
-void mpi_reduce_zsum_vector(long N, complex float ptr[N])
-{
-#ifdef USE_MPI
-	mpi_reduce_sum_vector(2 * N, (float*)ptr);
-#else
-	(void)N;
-	(void)ptr;
-#endif
-}
-
-#ifdef USE_MPI
+#ifdef USE_CUDA
 static void mpi_allreduce_sumD_gpu(int N, double vec[N], MPI_Comm comm)
 {
 #ifdef USE_CUDA
@@ -628,65 +577,149 @@ static void mpi_allreduce_sumD_gpu(int N, double vec[N], MPI_Comm comm)
 	MPI_Allreduce(MPI_IN_PLACE, vec, N, MPI_DOUBLE, MPI_SUM, comm);
 }
 #endif
+#endif
 
+/*
+ * Start the reduction of one block. The sub-communicator
+ * must be freed after the reduction has completed.
+ * Returns the number of requests added to req.
+ */
 #ifdef USE_MPI
-static void mpi_reduce_sumD_kernel(unsigned long reduce_flags, long N, double vec[N])
+static long mpi_reduce_sum_kernel(MPI_Comm* comm_sub, MPI_Request req[], unsigned long reduce_flags, long N, void* vec, MPI_Datatype type, size_t size)
 {
 	if (1 == mpi_get_num_procs())
 		error("MPI reduction requested but only run by one process!\n");
 
 	int tag = mpi_reduce_color(reduce_flags, vec);
 
-	MPI_Comm comm_sub;
-	MPI_Comm_split(mpi_get_comm(), tag, 0, &comm_sub);
+	MPI_Comm_split(mpi_get_comm(), tag, 0, comm_sub);
+
+	long R = 0;
 
 	if (0 < tag) {
 
-		double *vec2 = vptr_resolve(vec);
+		vec = vptr_resolve(vec);
 
+#ifdef USE_CUDA
+		if (cuda_ondevice(vec)) {
+
+			for (long n = 0; n < N; n += INT_MAX / 2) {
+
+				if (MPI_FLOAT == type)
+					mpi_allreduce_sum_gpu(MIN(N - n, INT_MAX / 2), (float*)vec + n, *comm_sub);
+				else
+					mpi_allreduce_sumD_gpu(MIN(N - n, INT_MAX / 2), (double*)vec + n, *comm_sub);
+			}
+
+			return 0;
+		}
+#endif
 		for (long n = 0; n < N; n += INT_MAX / 2)
-			mpi_allreduce_sumD_gpu(MIN(N - n, INT_MAX / 2), vec2 + n, comm_sub);
+			MPI_Iallreduce(MPI_IN_PLACE, vec + n * (long)size, MIN(N - n, INT_MAX / 2), type, MPI_SUM, *comm_sub, &req[R++]);
 	}
 
-	MPI_Comm_free(&comm_sub);
+	return R;
 }
 #endif
 
-void mpi_reduce_sumD(int N, unsigned long reduce_flags, const long dims[N], double* ptr)
+
+/*
+ * Reductions of all blocks are started before waiting for any of them,
+ * so that their communication overlaps.
+ */
+static void mpi_reduce_sum_blocks(int N, unsigned long reduce_flags, const long dims[N], void* ptr, size_t size)
 {
 	long tdims[N];
 	md_copy_dims(N, tdims, dims);
 
 	long strs[N];
-	md_calc_strides(N, strs, dims, DL_SIZE);
+	md_calc_strides(N, strs, dims, size);
 
-	unsigned long block_flags = vptr_block_loop_flags(N, dims, strs, ptr, DL_SIZE);
+	unsigned long block_flags = vptr_block_loop_flags(N, dims, strs, ptr, size);
 
-	long size = 1;
+	long bsize = 1;
 
 	for (int i = 0; i < N; i++) {
 
 		if (MD_IS_SET(block_flags, i))
 			break;
 
-		if (strs[i] == size * (long)DL_SIZE) {
+		if (strs[i] == bsize * (long)size) {
 
-			size *= tdims[i];
+			bsize *= tdims[i];
 			tdims[i] = 1;
 		}
 	}
 
+#ifdef USE_MPI
+	long blocks = md_calc_size(N, tdims);
+	long chunks = (bsize + INT_MAX / 2 - 1) / (INT_MAX / 2);
+
+	MPI_Comm* comms = xmalloc(sizeof(MPI_Comm) * (size_t)blocks);
+	MPI_Request* req = xmalloc(sizeof(MPI_Request) * (size_t)(blocks * chunks));
+
+	MPI_Datatype type = (DL_SIZE == size) ? MPI_DOUBLE : MPI_FLOAT;
+
+	long B = 0;
+	long R = 0;
+
 	long pos[N];
 	md_singleton_strides(N, pos);
 
 	do {
+		R += mpi_reduce_sum_kernel(&comms[B++], req + R, reduce_flags, bsize, ptr + md_calc_offset(N, strs, pos), type, size);
+
+	} while (md_next(N, tdims, ~0UL, pos));
+
+	MPI_Waitall((int)R, req, MPI_STATUSES_IGNORE);
+
+	for (long b = 0; b < B; b++)
+		MPI_Comm_free(&comms[b]);
+
+	xfree(req);
+	xfree(comms);
+#else
+	(void)reduce_flags;
+	(void)ptr;
+#endif
+}
+
+
 #ifdef USE_MPI
-		mpi_reduce_sumD_kernel(reduce_flags, size, &MD_ACCESS(N, strs, pos, ptr));
+void mpi_reduce_sum_vector(long N, float vec[N])
+{
+	if (1 == mpi_get_num_procs())
+		error("MPI reduction requested but only run by one process!\n");
+
+	for (long n = 0; n < N; n += INT_MAX / 2)
+		mpi_allreduce_sum_gpu(MIN(N - n, INT_MAX / 2), vec + n, mpi_get_comm());
+}
+#endif
+
+void mpi_reduce_sum(int N, unsigned long reduce_flags, const long dims[N], float* ptr)
+{
+	mpi_reduce_sum_blocks(N, reduce_flags, dims, ptr, FL_SIZE);
+}
+
+void mpi_reduce_zsum(int N, unsigned long reduce_flags, const long dims[N], complex float* ptr)
+{
+	mpi_reduce_sum(N + 1, reduce_flags, MD_REAL_DIMS(N, dims), (float*)ptr);
+}
+
+void mpi_reduce_zsum_vector(long N, complex float ptr[N])
+{
+#ifdef USE_MPI
+	mpi_reduce_sum_vector(2 * N, (float*)ptr);
 #else
-		(void)reduce_flags;
+	(void)N;
+	(void)ptr;
 #endif
+}
 
-	} while (md_next(N, tdims, ~0UL, pos));
+
+void mpi_reduce_sumD(int N, unsigned long reduce_flags, const long dims[N], double* ptr)
+{
+	mpi_reduce_sum_blocks(N, reduce_flags, dims, ptr, DL_SIZE);
 }
 
 void mpi_reduce_zsumD(int N, unsigned long reduce_flags, const long dims[N], complex double* ptr)
@@ -6,6 +6,7 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include "misc/misc.h"
 #include "misc/nested.h"
 
 #include "num/quadrature.h"
@@ -190,6 +191,105 @@ void ode_interval(float h, float tol, int N, float x[N], float st, float end,
 }
 
 
+/*
+ * Batched integration of W systems in lock-step. The state is
+ * stored as structure of arrays x[N][W], so that each stage of
+ * the Runge-Kutta method is a single vectorizable loop over all
+ * lanes. All lanes share one step size which is controlled by the
+ * largest local error estimate (the step is rejected if any lane
+ * exceeds the tolerance). The number of lanes is not bounded, so
+ * arrays of lanes are allocated on the heap.
+ */
+static float vec_norm_batch(int N, int W, const float x[N][W])
+{
+	float* nrm = *TYPE_ALLOC(float[W]);
+
+	for (int w = 0; w < W; w++)
+		nrm[w] = 0.;
+
+	for (int i = 0; i < N; i++)
+		for (int w = 0; w < W; w++)
+			nrm[w] += x[i][w] * x[i][w];
+
+	float ret = 0.;
+
+	for (int w = 0; w < W; w++)
+		ret = (ret < nrm[w]) ? nrm[w] : ret;
+
+	xfree(nrm);
+
+	return sqrtf(ret);
+}
+
+
+float dormand_prince_step2_batch(float h, int N, int W, float ynp[N][W], float tn, const float yn[N][W], float k[6][N][W],
+		void CLOSURE_TYPE(f)(float* out, float t, const float* yn))
+{
+	const float c[6] = { 1. / 5., 3. / 10., 4. / 5., 8. / 9., 1., 1. };
+
+	const float a[tridiag(7)] = {
+		1. / 5.,
+		3. / 40.,	9. / 40.,
+		44. / 45.,	-56. / 15.,	32. / 9.,
+		19372. / 6561.,	-25360. / 2187., 64448. / 6561., -212. / 729.,
+		9017. / 3168.,  -355. / 33.,	46732. / 5247.,	49. / 176.,	-5103. / 18656.,
+		35. / 384.,	0.,		500. / 1113.,	125. / 192.,	-2187. / 6784.,	11. / 84.,
+	};
+
+	const float b[7] = { 5179. / 57600., 0.,  7571. / 16695., 393. / 640., -92097. / 339200., 187. / 2100., 1. / 40. };
+
+	float (*tmp)[W] = *TYPE_ALLOC(float[N][W]);
+	runge_kutta_step(h, 7, a, b, c, N * W, 6, (float(*)[N * W])&k[0][0][0], &ynp[0][0], &tmp[0][0], tn, &yn[0][0], f);
+
+	vec_saxpy(N * W, &tmp[0][0], &tmp[0][0], -1., &ynp[0][0]);
+	float err = vec_norm_batch(N, W, (const float(*)[W])tmp);
+
+	xfree(tmp);
+
+	return err;
+}
+
+
+void ode_interval_batch(float h, float tol, int N, int W, float x[N][W], float st, float end,
+		void CLOSURE_TYPE(f)(float* out, float t, const float* yn))
+{
+	float (*k)[N][W] = *TYPE_ALLOC(float[6][N][W]);
+	float (*ynp)[W] = *TYPE_ALLOC(float[N][W]);
+
+	NESTED_CALL(f, (&k[0][0][0], st, &x[0][0]));
+
+	if (h > end - st)
+		h = end - st;
+
+	for (float t = st; t < end; ) {
+
+	repeat:
+		;
+		float err = dormand_prince_step2_batch(h, N, W, ynp, t, x, k, f);
+
+		float h_new = h * dormand_prince_scale(tol, err);
+
+		if (err > tol) {
+
+			h = h_new;
+			NESTED_CALL(f, (&k[0][0][0], t, &x[0][0]));	// recreate correct k[0] which has been overwritten
+			goto repeat;
+		}
+
+		t += h;
+		h = h_new;
+
+		if (t + h > end)
+			h = end - t;
+
+		vec_copy(N * W, &x[0][0], &ynp[0][0]);
+	}
+
+	xfree(k);
+	xfree(ynp);
+}
+
+
 void ode_interval2(float h, float tol,
 	int N, const float t[N + 1],
 	int M, float x[N + 1][M],
@@ -240,34 +340,44 @@ struct seq_data {
 
 	int N;
 	int P;
+	int W;
 
 	void CLOSURE_TYPE(f)(float* out, float t, const float* yn);
 	void CLOSURE_TYPE(pdy)(float* out, float t, const float* yn);
 	void CLOSURE_TYPE(pdp)(float* out, float t, const float* yn);
+
+	float* dy;	// [N][N][W]
+	float* dp;	// [P][N][W]
 };
 
 static void seq(const struct seq_data* data, float* out, float t, const float* yn)
 {
 	int N = data->N;
 	int P = data->P;
+	int W = data->W;
 
 	data->f(out, t, yn);
 
-	float dy[N][N];
-	data->pdy(&dy[0][0], t, yn);
+	float (*dy)[N][W] = (void*)data->dy;
+	data->pdy(&dy[0][0][0], t, yn);
 
-	float dp[P][N];
-	data->pdp(&dp[0][0], t, yn);
+	float (*dp)[N][W] = (void*)data->dp;
+	data->pdp(&dp[0][0][0], t, yn);
 
 	for (int i = 0; i < P; i++) {
 		for (int j = 0; j < N; j++) {
 
-			out[(1 + i) * N + j] = 0.;
+			float* o = out + ((1 + i) * N + j) * W;
+
+			for (int w = 0; w < W; w++)
+				o[w] = 0.;
 
 			for (int k = 0; k < N; k++)
-				out[(1 + i) * N + j] += dy[k][j] * yn[(1 + i) * N + k];
+				for (int w = 0; w < W; w++)
+					o[w] += dy[k][j][w] * yn[((1 + i) * N + k) * W + w];
 
-			out[(1 + i) * N + j] += dp[i][j];
+			for (int w = 0; w < W; w++)
+				o[w] += dp[i][j][w];
 		}
 	}
 }
@@ -278,7 +388,10 @@ void ode_direct_sa(float h, float tol, int N, int P, float x[P + 1][N],
 	void CLOSURE_TYPE(pdy)(float* out, float t, const float* yn),
 	void CLOSURE_TYPE(pdp)(float* out, float t, const float* yn))
 {
-	struct seq_data data2 = { N, P, f, pdy, pdp };
+	float dy[N][N];
+	float dp[P][N];
+
+	struct seq_data data2 = { N, P, 1, f, pdy, pdp, &dy[0][0], &dp[0][0] };
 
 	NESTED(void, seq2, (float* out, float t, const float* yn))
 	{
@@ -288,6 +401,31 @@ void ode_direct_sa(float h, float tol, int N, int P, float x[P + 1][N],
 	ode_interval(h, tol, N * (1 + P), &x[0][0], st, end, seq2);
 }
 
+// batched version: all arrays are stored as structure of arrays with W lanes,
+// i.e. pdy returns [N][N][W] and pdp returns [P][N][W]
+
+void ode_direct_sa_batch(float h, float tol, int N, int P, int W, float x[P + 1][N][W],
+	float st, float end,
+	void CLOSURE_TYPE(f)(float* out, float t, const float* yn),
+	void CLOSURE_TYPE(pdy)(float* out, float t, const float* yn),
+	void CLOSURE_TYPE(pdp)(float* out, float t, const float* yn))
+{
+	float (*dy)[N][W] = *TYPE_ALLOC(float[N][N][W]);
+	float (*dp)[N][W] = *TYPE_ALLOC(float[P][N][W]);
+
+	struct seq_data data2 = { N, P, W, f, pdy, pdp, &dy[0][0][0], &dp[0][0][0] };
+
+	NESTED(void, seq2, (float* out, float t, const float* yn))
+	{
+		seq(&data2, out, t, yn);
+	};
+
+	ode_interval_batch(h, tol, N * (1 + P), W, (float(*)[W])&x[0][0][0], st, end, seq2);
+
+	xfree(dy);
+	xfree(dp);
+}
+
 
 // the adjoint method for sensitivity analysis
 // void (*s)(void* data, float* out, float t)
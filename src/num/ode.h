@@ -15,6 +15,12 @@ extern float dormand_prince_scale(float tol, float err);
 extern void ode_interval(float h, float tol, int N, float x[N], float st, float end,
 		void CLOSURE_TYPE(f)(float* out, float t, const float* yn));
 
+extern float dormand_prince_step2_batch(float h, int N, int W, float ynp[N][W], float tn, const float yn[N][W], float k[6][N][W],
+		void CLOSURE_TYPE(f)(float* out, float t, const float* yn));
+
+extern void ode_interval_batch(float h, float tol, int N, int W, float x[N][W], float st, float end,
+		void CLOSURE_TYPE(f)(float* out, float t, const float* yn));
+
 extern void ode_interval2(float h, float tol,
 	int N, const float t[N + 1], int M, float x[N + 1][M],
 	void CLOSURE_TYPE(sys)(float dst[M], float t, const float in[M]));
@@ -27,6 +33,12 @@ extern void ode_direct_sa(float h, float tol, int N, int P, float x[P + 1][N],
 	void CLOSURE_TYPE(pdy)(float* out, float t, const float* yn),
 	void CLOSURE_TYPE(pdp)(float* out, float t, const float* yn));
 
+extern void ode_direct_sa_batch(float h, float tol, int N, int P, int W, float x[P + 1][N][W],
+	float st, float end,
+	void CLOSURE_TYPE(f)(float* out, float t, const float* yn),
+	void CLOSURE_TYPE(pdy)(float* out, float t, const float* yn),
+	void CLOSURE_TYPE(pdp)(float* out, float t, const float* yn));
+
 extern void ode_adjoint_sa(float h, float tol,
 	int N, const float t[N + 1],
 	int M, float x[N + 1][M], float z[N + 1][M],
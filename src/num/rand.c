@@ -80,6 +80,11 @@ void rand_state_update(struct bart_rand_state* state, unsigned long long seed)
 	state->ctr2 = 0;
 }
 
+long rand_state_size(void)
+{
+	return (long)sizeof(struct bart_rand_state);
+}
+
 struct bart_rand_state* rand_state_create(unsigned long long seed)
 {
 	if (cfl_loop_desc_active()) {
@@ -103,6 +108,11 @@ struct bart_rand_state* rand_state_create(unsigned long long seed)
 	return state;
 }
 
+struct bart_rand_state* rand_state_global(void)
+{
+	return &global_rand_state[cfl_loop_worker_id()];
+}
+
 static struct bart_rand_state get_worker_state(void)
 { 
 	struct bart_rand_state worker_state;
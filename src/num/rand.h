@@ -18,6 +18,8 @@ struct bart_rand_state;
 
 extern struct bart_rand_state* rand_state_create(unsigned long long seed);
 extern void rand_state_update(struct bart_rand_state* state, unsigned long long seed);
+extern long rand_state_size(void);
+extern struct bart_rand_state* rand_state_global(void);
 
 extern unsigned int rand_range(unsigned int range);
 extern unsigned int rand_range_state(struct bart_rand_state* state, unsigned int range);
@@ -44,6 +44,7 @@
 #include "num/reduce_md_wrapper.h"
 #include "num/md_wrapper.h"
 #include "num/convcorr.h"
+#include "num/contract.h"
 #include "num/vptr.h"
 #ifdef USE_CUDA
 #include "num/gpuops.h"
@@ -1326,6 +1327,9 @@ bool simple_zfmac(int N, const long dims[N], const long ostrs[N], complex float*
 	if (simple_zconvcorr(N, dims, ostrs, out, istrs1, in1, istrs2, in2))
 		return true;
 
+	if (simple_zcontract(N, dims, ostrs, out, istrs1, in1, istrs2, in2, true))
+		return true;
+
 	struct simple_z3op_check strided_calls[] = {
 		OPT_Z3OP(check_gemm,	blas_zfmac_cgemm, true, true, false, false, false),
 		OPT_Z3OP(check_gemv,	blas_zfmac_cgemv, true, true, false, false, false),
@@ -1341,6 +1345,17 @@ bool simple_zfmac(int N, const long dims[N], const long ostrs[N], complex float*
 				N, dims, ostrs, out, istrs1, in1, istrs2, in2, true, false);
 }
 
+/*
+ * tensor multiplication without accumulation, i.e. the output need not be cleared
+ */
+bool simple_ztenmul(int N, const long dims[N], const long ostrs[N], complex float* out, const long istrs1[N], const complex float* in1, const long istrs2[N], const complex float* in2)
+{
+	if (!use_strided_vecops)
+		return false;
+
+	return simple_zcontract(N, dims, ostrs, out, istrs1, in1, istrs2, in2, false);
+}
+
 bool simple_zfmacc(int N, const long dims[N], const long ostrs[N], complex float* out, const long istrs1[N], const complex float* in1, const long istrs2[N], const complex float* in2)
 {
 	struct simple_z3op_check strided_calls_direct[] = {
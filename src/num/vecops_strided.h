@@ -4,6 +4,7 @@ extern void deactivate_strided_vecops(void);
 
 #ifndef NO_BLAS
 extern _Bool simple_zfmac(int N, const long dims[__VLA(N)], const long ostrs[__VLA(N)], _Complex float* out, const long istrs1[__VLA(N)], const _Complex float* in1, const long istrs2[__VLA(N)], const _Complex float* in2);
+extern _Bool simple_ztenmul(int N, const long dims[__VLA(N)], const long ostrs[__VLA(N)], _Complex float* out, const long istrs1[__VLA(N)], const _Complex float* in1, const long istrs2[__VLA(N)], const _Complex float* in2);
 extern _Bool simple_zfmacc(int N, const long dims[__VLA(N)], const long ostrs[__VLA(N)], _Complex float* out, const long istrs1[__VLA(N)], const _Complex float* in1, const long istrs2[__VLA(N)], const _Complex float* in2);
 extern _Bool simple_fmac(int N, const long dims[__VLA(N)], const long ostrs[__VLA(N)], float* out, const long istrs1[__VLA(N)], const float* in1, const long istrs2[__VLA(N)], const float* in2);
 
@@ -23,6 +24,7 @@ extern _Bool simple_zfmaccD(int N, const long dims[__VLA(N)], const long ostrs[_
 #define simple_fmac(...) false
 #define simple_zfmac(...) false
 #define simple_zfmacc(...) false
+#define simple_ztenmul(...) false
 #define simple_fmacc(...) false
 #define simple_fmul(...) false
 #define simple_fmulc(...) false
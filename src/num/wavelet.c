@@ -16,6 +16,8 @@
 #include <complex.h>
 #include <assert.h>
 
+#include "misc/misc.h"
+
 #include "num/multind.h"
 //#include "num/parallel.h"
 
@@ -101,6 +103,176 @@ static long num_scale(long n)
 }
 
 
+/*
+ * Blocked variant of the lifting steps: B lines are gathered into
+ * a buffer x[n][B], so that each lifting step is a unit-stride loop
+ * across lines independent of the stride of the transform dimension.
+ */
+
+enum { CDF97_BLOCK = 16 };
+
+static void predict_block(int n, int B, float a, float x[n][B])
+{
+	for (int i = 1; i < n - 1; i += 2)
+		for (int k = 0; k < B; k++)
+			x[i][k] += a * (x[i - 1][k] + x[i + 1][k]);
+
+	if (0 == n % 2)
+		for (int k = 0; k < B; k++)
+			x[n - 1][k] += a * (x[n - 2][k] + x[0][k]);	// periodic
+}
+
+static void update_block(int n, int B, float a, float x[n][B])
+{
+	for (int i = 2; i < n - 1; i += 2)
+		for (int k = 0; k < B; k++)
+			x[i][k] += a * (x[i - 1][k] + x[i + 1][k]);
+
+	for (int k = 0; k < B; k++) {
+
+		if (0 == n % 2) {	// +-+-+-
+
+			x[0][k] += a * (x[n - 1][k] + x[1][k]);	// periodic
+
+		} else {		// +-+-+
+
+			x[0][k] += 2. * a * x[1][k];
+			x[n - 1][k] += 2. * a * x[n - 2][k];
+		}
+	}
+}
+
+static void scale_block(int n, int B, bool inv, float x[n][B])
+{
+	for (int i = 0; i < n; i++)
+		for (int k = 0; k < B; k++)
+			x[i][k] *= ((0 == i % 2) != inv) ? scale : (1. / scale);
+}
+
+static void cdf97_block(int n, int B, float x[n][B])
+{
+	predict_block(n, B, a[0], x);
+	update_block(n, B, a[1], x);
+	predict_block(n, B, a[2], x);
+	update_block(n, B, a[3], x);
+	scale_block(n, B, false, x);
+}
+
+static void icdf97_block(int n, int B, float x[n][B])
+{
+	scale_block(n, B, true, x);
+	update_block(n, B, -a[3], x);
+	predict_block(n, B, -a[2], x);
+	update_block(n, B, -a[1], x);
+	predict_block(n, B, -a[0], x);
+}
+
+static void cdf97_dim(int D, const long dims[D], int d, const long strs[D], void* ptr, bool inv)
+{
+	enum { B = CDF97_BLOCK };
+
+	int n = dims[d];
+
+	long ldims[D];
+	md_select_dims(D, ~MD_BIT(d), ldims, dims);
+
+	long L = md_calc_size(D, ldims);
+
+#pragma omp parallel for
+	for (long b = 0; b < (L + B - 1) / B; b++) {
+
+		int K = MIN((long)B, L - b * B);
+
+		float (*x)[n][B] = xmalloc(sizeof *x);
+
+		long off[B];
+
+		for (int k = 0; k < K; k++) {
+
+			long pos[D];
+			md_unravel_index(D, pos, ~0UL, ldims, b * B + k);
+
+			off[k] = md_calc_offset(D, strs, pos);
+		}
+
+		for (int i = 0; i < n; i++)
+			for (int k = 0; k < B; k++)
+				(*x)[i][k] = (k < K) ? *(float*)(ptr + off[k] + i * strs[d]) : 0.;
+
+		(inv ? icdf97_block : cdf97_block)(n, B, *x);
+
+		for (int i = 0; i < n; i++)
+			for (int k = 0; k < K; k++)
+				*(float*)(ptr + off[k] + i * strs[d]) = (*x)[i][k];
+
+		xfree(x);
+	}
+}
+
+/*
+ * Same recursion as md_wavtrafo2 (without resorting), but each
+ * level is computed with the blocked lifting steps.
+ */
+static void cdf97_rec(int D, const long dims[D], unsigned long flags, const long strs[D], void* ptr, bool inv)
+{
+	if (0 == flags)
+		return;
+
+	bool rec = true;
+
+	for (int i = 0; i < D; i++) {
+
+		if (1 == dims[i])
+			flags = MD_CLEAR(flags, i);
+
+		if (MD_IS_SET(flags, i))
+			rec &= (dims[i] > 32);
+	}
+
+	if (!inv)
+		for (int i = 0; i < D; i++)
+			if (MD_IS_SET(flags, i))
+				cdf97_dim(D, dims, i, strs, ptr, false);
+
+	if (rec) {
+
+		long dims2[D];
+		md_copy_dims(D, dims2, dims);
+
+		long strs2[D];
+		md_copy_strides(D, strs2, strs);
+
+		for (int i = 0; i < D; i++) {
+
+			if (MD_IS_SET(flags, i)) {
+
+				dims2[i] = num_scale(dims[i]);
+				strs2[i] *= 2;
+			}
+		}
+
+		cdf97_rec(D, dims2, flags, strs2, ptr, inv);
+	}
+
+	if (inv)
+		for (int i = 0; i < D; i++)
+			if (MD_IS_SET(flags, i))
+				cdf97_dim(D, dims, i, strs, ptr, true);
+}
+
+static void cdf97z_blocked(int D, const long dims[D], unsigned long flags, const long strs[D], complex float* x, bool inv)
+{
+	long dims2[D + 1];
+	dims2[0] = 2; // complex float
+	md_copy_dims(D, dims2 + 1, dims);
+
+	long strs2[D + 1];
+	strs2[0] = sizeof(float);
+	md_copy_strides(D, strs2 + 1, strs);
+
+	cdf97_rec(D + 1, dims2, flags << 1, strs2, (void*)x, inv);
+}
+
 
 
 static void resort(int n, int str, float* src)
@@ -252,22 +424,36 @@ void md_wavtrafoz(int D, const long dims[D], unsigned long flags, complex float*
 
 void md_cdf97z(int D, const long dims[D], unsigned long flags, complex float* data)
 {
-	md_wavtrafoz(D, dims, flags, data, cdf97_line_nosort, false, true);
+	md_cdf97z2(D, dims, flags, MD_STRIDES(D, dims, sizeof(complex float)), data);
 }
 
 void md_icdf97z(int D, const long dims[D], unsigned long flags, complex float* data)
 {
-	md_wavtrafoz(D, dims, flags, data, icdf97_line_nosort, true, true);
+	md_icdf97z2(D, dims, flags, MD_STRIDES(D, dims, sizeof(complex float)), data);
 }
 
 void md_cdf97z2(int D, const long dims[D], unsigned long flags, const long strs[D], complex float* data)
 {
-	md_wavtrafoz2(D, dims, flags, strs, data, cdf97_line_nosort, false, true);
+#ifdef USE_CUDA
+	if (cuda_ondevice(data)) {
+
+		md_wavtrafoz2(D, dims, flags, strs, data, cdf97_line_nosort, false, true);
+		return;
+	}
+#endif
+	cdf97z_blocked(D, dims, flags, strs, data, false);
 }
 
 void md_icdf97z2(int D, const long dims[D], unsigned long flags, const long strs[D], complex float* data)
 {
-	md_wavtrafoz2(D, dims, flags, strs, data, icdf97_line_nosort, true, true);
+#ifdef USE_CUDA
+	if (cuda_ondevice(data)) {
+
+		md_wavtrafoz2(D, dims, flags, strs, data, icdf97_line_nosort, true, true);
+		return;
+	}
+#endif
+	cdf97z_blocked(D, dims, flags, strs, data, true);
 }
 
 
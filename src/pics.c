@@ -25,6 +25,7 @@
 
 #include "iter/misc.h"
 #include "iter/monitor.h"
+#include "iter/checkpoint.h"
 
 #include "linops/linop.h"
 #include "linops/fmac.h"
@@ -164,7 +165,9 @@ static const struct linop_s* sense_nc_init(const long max_dims[DIMS], const long
 		}
 	}
 
-	const struct linop_s* nufft_op = nufft_create2(DIMS, ksp_dims2, coilim_dims,
+	// the operators for stacked slices need to be independent
+
+	const struct linop_s* nufft_op = (0 == (lowmem_stack & ~COIL_FLAG) ? nufft_create2_cached : nufft_create2)(DIMS, ksp_dims2, coilim_dims,
 						traj_dims, traj,
 						(weights ? wgs_dims : NULL), weights,
 						(basis ? basis_dims : NULL), basis, conf);
@@ -203,6 +206,152 @@ static const struct linop_s* sense_nc_init(const long max_dims[DIMS], const long
 }
 
 
+/*
+ * Coarse-to-fine warm start for Cartesian SENSE. Each level solves the
+ * l2-SENSE problem with CG on the center of k-space and a reduced image
+ * grid, and its result is Fourier interpolated to the next finer level.
+ * Coil sensitivities are downsampled by cropping their k-space center.
+ */
+static complex float* pics_multilevel(int L, const float levels[L], int iter, const struct sense_conf* conf,
+		unsigned long shared_img_flags, unsigned long map_flags,
+		const long max_dims[DIMS], const long map_dims[DIMS], const complex float* maps,
+		const long pat_dims[DIMS], const complex float* pattern,
+		const long ksp_dims[DIMS], const complex float* kspace, const long img_dims[DIMS])
+{
+	struct sense_conf lconf = *conf;
+	lconf.rwiter = 1;
+
+	// undo the modulation for the uncentered FFT
+
+	complex float* ksp = md_alloc(DIMS, ksp_dims, CFL_SIZE);
+	fftmod(DIMS, ksp_dims, FFT_FLAGS, ksp, kspace);
+
+	complex float* sens = md_alloc(DIMS, map_dims, CFL_SIZE);
+	ifftmod(DIMS, map_dims, FFT_FLAGS, sens, maps);
+
+	long x_dims[DIMS];
+	complex float* x = NULL;
+
+	for (int l = 0; l < L; l++) {
+
+		long lmax_dims[DIMS];
+		long lmap_dims[DIMS];
+		long lpat_dims[DIMS];
+		long lksp_dims[DIMS];
+		long limg_dims[DIMS];
+
+		multilevel_dims(DIMS, FFT_FLAGS, lmax_dims, max_dims, levels[l]);
+		multilevel_dims(DIMS, FFT_FLAGS, lmap_dims, map_dims, levels[l]);
+		multilevel_dims(DIMS, FFT_FLAGS, lpat_dims, pat_dims, levels[l]);
+		multilevel_dims(DIMS, FFT_FLAGS, lksp_dims, ksp_dims, levels[l]);
+		multilevel_dims(DIMS, FFT_FLAGS, limg_dims, img_dims, levels[l]);
+
+		debug_printf(DP_DEBUG1, "Multilevel: %ld %ld %ld\n", limg_dims[0], limg_dims[1], limg_dims[2]);
+
+		complex float* lksp = md_alloc(DIMS, lksp_dims, CFL_SIZE);
+		md_resize_center(DIMS, lksp_dims, lksp, ksp_dims, ksp, CFL_SIZE);
+		ifftmod(DIMS, lksp_dims, FFT_FLAGS, lksp, lksp);
+
+		complex float* lpat = md_alloc(DIMS, lpat_dims, CFL_SIZE);
+		md_resize_center(DIMS, lpat_dims, lpat, pat_dims, pattern, CFL_SIZE);
+
+		complex float* lmaps = md_alloc(DIMS, lmap_dims, CFL_SIZE);
+
+		const struct linop_s* res_op = linop_resize_fourier_create(DIMS, map_dims, lmap_dims, FFT_FLAGS);
+		linop_adjoint(res_op, DIMS, lmap_dims, lmaps, DIMS, map_dims, sens);
+		linop_free(res_op);
+
+		// cropping with a unitary FFT scales the values by sqrt(N / M)
+
+		float sc = sqrtf((float)md_calc_size(3, map_dims) / (float)md_calc_size(3, lmap_dims));
+
+		md_zsmul(DIMS, lmap_dims, lmaps, lmaps, 1. / sc);
+
+		// keep the support of masked sensitivities sharp
+
+		long msk_dims[DIMS];
+		long lmsk_dims[DIMS];
+
+		md_select_dims(DIMS, ~COIL_FLAG, msk_dims, map_dims);
+		md_select_dims(DIMS, ~COIL_FLAG, lmsk_dims, lmap_dims);
+
+		complex float* msk = md_alloc(DIMS, msk_dims, CFL_SIZE);
+		complex float* lmsk = md_alloc(DIMS, lmsk_dims, CFL_SIZE);
+
+		md_zrss(DIMS, map_dims, COIL_FLAG, msk, sens);
+		md_zsgreatequal(DIMS, msk_dims, msk, msk, 1.E-6);
+
+		res_op = linop_resize_fourier_create(DIMS, msk_dims, lmsk_dims, FFT_FLAGS);
+		linop_adjoint(res_op, DIMS, lmsk_dims, lmsk, DIMS, msk_dims, msk);
+		linop_free(res_op);
+
+		md_zabs(DIMS, lmsk_dims, lmsk, lmsk);
+		md_zsgreatequal(DIMS, lmsk_dims, lmsk, lmsk, 0.5 * sc);
+
+		md_zmul2(DIMS, lmap_dims, MD_STRIDES(DIMS, lmap_dims, CFL_SIZE), lmaps,
+				MD_STRIDES(DIMS, lmap_dims, CFL_SIZE), lmaps, MD_STRIDES(DIMS, lmsk_dims, CFL_SIZE), lmsk);
+
+		md_free(msk);
+		md_free(lmsk);
+
+		fftmod(DIMS, lmap_dims, FFT_FLAGS, lmaps, lmaps);
+
+		const struct linop_s* forward_op = sense_init(shared_img_flags, lmax_dims, map_flags, lmaps);
+		forward_op = linop_chain_FF(forward_op, linop_sampling_create(linop_codomain(forward_op)->dims, lpat_dims, lpat));
+
+		if (conf->rvc)
+			forward_op = linop_chain_FF(linop_realval_create(DIMS, limg_dims), forward_op);
+
+		md_free(lmaps);
+
+		complex float* start = NULL;
+
+		if (NULL != x) {
+
+			start = md_alloc(DIMS, limg_dims, CFL_SIZE);
+
+			res_op = linop_resize_fourier_create(DIMS, limg_dims, x_dims, FFT_FLAGS);
+			linop_forward(res_op, DIMS, limg_dims, start, DIMS, x_dims, x);
+			linop_free(res_op);
+
+			md_free(x);
+		}
+
+		struct iter_conjgrad_conf cgconf = iter_conjgrad_defaults;
+		cgconf.maxiter = iter;
+		cgconf.l2lambda = 0.;
+
+		const struct operator_p_s* po = sense_recon_create(&lconf, forward_op, lpat_dims,
+					iter2_conjgrad, CAST_UP(&cgconf), start, 0, NULL, NULL, NULL, NULL);
+
+		const struct operator_s* op = operator_p_bind(po, 1.);
+		operator_p_free(po);
+
+		x = md_alloc(DIMS, limg_dims, CFL_SIZE);
+		operator_apply(op, DIMS, limg_dims, x, DIMS, lksp_dims, lksp);
+		operator_free(op);
+
+		md_copy_dims(DIMS, x_dims, limg_dims);
+
+		md_free(start);
+		md_free(lpat);
+		md_free(lksp);
+	}
+
+	complex float* image_start = md_alloc(DIMS, img_dims, CFL_SIZE);
+
+	const struct linop_s* res_op = linop_resize_fourier_create(DIMS, img_dims, x_dims, FFT_FLAGS);
+	linop_forward(res_op, DIMS, img_dims, image_start, DIMS, x_dims, x);
+	linop_free(res_op);
+
+	md_free(x);
+	md_free(sens);
+	md_free(ksp);
+
+	return image_start;
+}
+
+
 int main_pics(int argc, char* argv[argc])
 {
 	const char* ksp_file = NULL;
@@ -278,6 +427,12 @@ int main_pics(int argc, char* argv[argc])
 
 	unsigned long mpi_flags = 0UL;
 
+	const char* checkpoint_file = NULL;
+	long checkpoint_mod = 10;
+
+	float ml_levels[8] = { 0. };
+	int ml_iter = 10;
+
 
 	const struct opt_s opts[] = {
 
@@ -340,6 +495,10 @@ int main_pics(int argc, char* argv[argc])
 		OPTL_FLVEC3(0, "fista_pqr", &fista.params, "p:q:r", "parameters for FISTA acceleration"),
 		OPTL_SET(0, "fista_last", &fista.last, "end iteration with call to data consistency"),
 		OPTL_INFILE(0, "motion-field", &motion_file, "file", "motion field"),
+		OPTL_STRING(0, "checkpoint", &checkpoint_file, "file", "checkpoint solver state to file and resume from it"),
+		OPTL_LONG(0, "checkpoint-mod", &checkpoint_mod, "mod", "write checkpoint every mod iterations (default: 10)"),
+		OPTL_FLVECN(0, "multilevel", ml_levels, "Warm start from coarse levels (fractions of the resolution, coarse to fine)"),
+		OPTL_PINT(0, "multilevel-iter", &ml_iter, "iter", "CG iterations on each coarse level (default: 10)"),
 	};
 
 
@@ -362,6 +521,14 @@ int main_pics(int argc, char* argv[argc])
 	if (0 != loop_flags)
 		error("Looping only supported via BART generic looping interface!\n");
 
+	if (NULL != checkpoint_file) {
+
+		if (cfl_loop_desc_active() || use_mpi)
+			error("Checkpoints are not supported with looping or MPI.\n");
+
+		iter_checkpoint_configure(checkpoint_file, checkpoint_mod);
+	}
+
 	if (0 <= bpsense_eps)
 		conf.bpsense = true;
 
@@ -796,6 +963,30 @@ int main_pics(int argc, char* argv[argc])
 			md_zsmul(DIMS, img_dims, image_start, image_start, 1. / scaling);
 	}
 
+	int ml_L = 0;
+
+	while ((ml_L < (int)ARRAY_SIZE(ml_levels)) && (0. != ml_levels[ml_L]))
+		ml_L++;
+
+	if (0 < ml_L) {
+
+		if ((NULL != traj_file) || (NULL != basis) || (NULL != motion) || use_mpi || conf.gpu)
+			error("Multilevel reconstruction is only supported for Cartesian SENSE on the CPU.\n");
+
+		if (conf.bpsense || conf.precond || ropts.teasl || (0 < ropts.svars))
+			error("Multilevel reconstruction is incompatible with the selected formulation.\n");
+
+		if (NULL != image_start)
+			error("Multilevel reconstruction and warm start are exclusive.\n");
+
+		for (int l = 0; l < ml_L; l++)
+			if ((1. <= ml_levels[l]) || ((0 < l) && (ml_levels[l] <= ml_levels[l - 1])))
+				error("Multilevel fractions must be increasing and smaller than one.\n");
+
+		image_start = pics_multilevel(ml_L, ml_levels, ml_iter, &conf, shared_img_flags, map_flags,
+				max_dims, map_dims, maps_p, pat_dims, pattern, ksp_dims, kspace_p, img_dims);
+	}
+
 	double maxeigen = 1.;
 
 	if (eigen && (ALGO_PRIDU != algo)) {
@@ -833,6 +1024,12 @@ int main_pics(int argc, char* argv[argc])
 	if (conf.bpsense || conf.precond)
 		assert((ALGO_ADMM == algo) || (ALGO_PRIDU == algo));
 
+	// other algorithms do not save their state, a nested
+	// solver (e.g. CG in ADMM) would be checkpointed instead
+
+	if ((NULL != checkpoint_file) && !((ALGO_CG == algo) || (ALGO_IST == algo) || (ALGO_FISTA == algo)))
+		error("Checkpoints are only supported for CG, IST, and FISTA.\n");
+
 
 	// choose step size
 
@@ -938,8 +1135,10 @@ int main_pics(int argc, char* argv[argc])
 			unmap_cfl(DIMS, img_dims, image_truth);
 	}
 
-	if (image_start)
+	if (NULL != image_start_file)
 		unmap_cfl(DIMS, img_dims, image_start);
+	else
+		md_free(image_start);
 
 	if (kspace_p != kspace)
 		md_free(kspace_p);
@@ -960,5 +1159,7 @@ int main_pics(int argc, char* argv[argc])
 
 	debug_printf(DP_INFO, "Total Time: %f\n", end_time - start_time);
 
+	iter_checkpoint_configure(NULL, 0);
+
 	return 0;
 }
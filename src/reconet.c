@@ -172,6 +172,10 @@ int main_reconet(int argc, char* argv[argc])
 
 		OPTL_SET(0, "load-memory", &(load_mem), "copy training data into memory"),
 		OPTL_SET(0, "lowmem", &(config.low_mem), "reduce memory usage by checkpointing"),
+		OPTL_FLOAT(0, "mem-budget", &(config.mem_budget), "MB", "checkpoint unrolled iterations to fit derivatives into memory budget"),
+
+		OPTL_SELECT(0, "quantize-int8", enum QUANT_TYPE, &(config.quantize), QUANT_INT8, "int8 inference of fused convolution layers (calibrated on first batch)"),
+		OPTL_SET(0, "quantize-report", &(config.quant_report), "compare quantized network with fp32"),
 
 		OPTL_SET(0, "test", &(test_defaults), "very small network for tests"),
 		OPTL_STRING(0, "export-graph", &graph_filename, "<file.dot>", "export graph for visualization"),
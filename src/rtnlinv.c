@@ -36,6 +36,10 @@
 #include <complex.h>
 #include <math.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "num/multind.h"
 #include "num/flpmath.h"
 #include "num/fft.h"
@@ -49,6 +53,7 @@
 #include "misc/utils.h"
 #include "misc/opts.h"
 #include "misc/debug.h"
+#include "misc/stream.h"
 
 #include "noir/recon.h"
 #include "noir/misc.h"
@@ -68,6 +73,76 @@ static const char help_str[] =
 
 
 
+/* Pick k-space of one frame and grid it onto the Cartesian grid.
+ * If the k-space is a stream, wait until the frame has arrived.
+ * Returns the time when the data was available.
+ */
+static double grid_frame(int frame, bool sms, stream_t strm_ksp,
+		const long ksp_dims[DIMS], const complex float* kspace,
+		const long ksp1_dims[DIMS], complex float* kspace1,
+		const struct linop_s* nufft_op, const struct operator_s* fftc, const complex float* fftc_mod,
+		const long kgrid1_dims[DIMS], complex float* kgrid1)
+{
+	long pos[DIMS] = { };
+	pos[TIME_DIM] = frame;
+
+	if (NULL != strm_ksp)
+		stream_sync(strm_ksp, DIMS, pos);
+
+	double arrival = timestamp();
+
+	md_slice(DIMS, TIME_FLAG, pos, ksp_dims, kspace1, kspace, CFL_SIZE);
+
+	if (sms)
+		fftmod(DIMS, ksp1_dims, SLICE_FLAG, kspace1, kspace1); // fftmod to get correct slice order in output
+
+	if (NULL == nufft_op) {
+
+		assert(kspace1 == kgrid1);
+		return arrival;
+	}
+
+	// grid data frame by frame
+	linop_adjoint(nufft_op, DIMS, kgrid1_dims, kgrid1, DIMS, ksp1_dims, kspace1);
+#if 1
+	md_zmul(DIMS, kgrid1_dims, kgrid1, kgrid1, fftc_mod);
+	fft_exec(fftc, kgrid1, kgrid1);
+	md_zmul(DIMS, kgrid1_dims, kgrid1, kgrid1, fftc_mod);
+	fftscale(DIMS, kgrid1_dims, FFT_FLAGS, kgrid1, kgrid1);
+#else
+	fftuc(DIMS, kgrid1_dims, FFT_FLAGS, kgrid1, kgrid1);
+#endif
+	if (!use_compat_to_version("v0.7.00")) {
+
+		float sc = 1.;
+		for (int i = 0; i < 3; i++)
+			if (1 != kgrid1_dims[i])
+				sc *= 2.;
+
+		md_zsmul(DIMS, kgrid1_dims, kgrid1, kgrid1, sqrtf(sc));
+	}
+
+	return arrival;
+}
+
+
+static void print_latency(int debug, long frames, float latency[frames])
+{
+	// quickselect returns the k-th largest element
+
+	float pct[3] = { 0.5, 0.9, 0.99 };
+	float val[3];
+
+	for (int i = 0; i < 3; i++)
+		val[i] = quickselect(latency, frames, (int)lroundf((1. - pct[i]) * (frames - 1)));
+
+	float max = quickselect(latency, frames, 0);
+
+	debug_printf(debug, "Frame latency: p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+			val[0] * 1.E3, val[1] * 1.E3, val[2] * 1.E3, max * 1.E3);
+}
+
+
 
 
 int main_rtnlinv(int argc, char* argv[argc])
@@ -146,7 +221,18 @@ int main_rtnlinv(int argc, char* argv[argc])
 
 
 	long ksp_dims[DIMS];
-	complex float* kspace = load_cfl(ksp_file, DIMS, ksp_dims);
+	complex float* kspace = load_async_cfl(ksp_file, DIMS, ksp_dims);
+
+	// frames are reconstructed and written as soon as they arrive
+
+	stream_t strm_ksp = stream_lookup(kspace);
+	bool real_time_stream = (NULL != strm_ksp);
+
+	if (real_time_stream && (TIME_FLAG != stream_get_flags(strm_ksp)))
+		error("Input must be streamed along the time dimension!\n");
+
+	if (real_time_stream && alt_scaling)
+		error("Streaming does not support alternative scaling!\n");
 
 	long frames = ksp_dims[TIME_DIM];
 
@@ -155,11 +241,8 @@ int main_rtnlinv(int argc, char* argv[argc])
 
 
 	// SMS
-	if (conf.sms) {
-
+	if (conf.sms)
 		debug_printf(DP_INFO, "SMS-NLINV reconstruction. Multiband factor: %ld\n", ksp_dims[SLICE_DIM]);
-		fftmod(DIMS, ksp_dims, SLICE_FLAG, kspace, kspace); // fftmod to get correct slice order in output
-	}
 
 	long pat_dims[DIMS];
 	complex float* pattern = NULL;
@@ -255,8 +338,19 @@ int main_rtnlinv(int argc, char* argv[argc])
 		img_output1_dims[MAPS_DIM] = 1;
 	}
 
-	complex float* img_output = create_cfl(img_file, DIMS, img_output_dims);
-	md_clear(DIMS, img_output_dims, img_output, CFL_SIZE);
+	complex float* img_output = NULL;
+
+	if (real_time_stream) {
+
+		img_output = create_async_cfl(img_file, TIME_FLAG, DIMS, img_output_dims);
+
+	} else {
+
+		img_output = create_cfl(img_file, DIMS, img_output_dims);
+		md_clear(DIMS, img_output_dims, img_output, CFL_SIZE);
+	}
+
+	stream_t strm_img = stream_lookup(img_output);
 
 	complex float* img1 = md_alloc(DIMS, img1_dims, CFL_SIZE);
 
@@ -327,9 +421,16 @@ int main_rtnlinv(int argc, char* argv[argc])
 
 		long wgh_dims[DIMS];
 		md_select_dims(DIMS, ~COIL_FLAG, wgh_dims, ksp_dims);
-		complex float* wgh = md_alloc(DIMS, wgh_dims, CFL_SIZE);
+		complex float* wgh = NULL;
+
+		// when streaming, the data is not there yet and we assume fully sampled spokes
+
+		if (!real_time_stream) {
+
+			wgh = md_alloc(DIMS, wgh_dims, CFL_SIZE);
+			estimate_pattern(DIMS, ksp_dims, COIL_FLAG, wgh, kspace);
+		}
 
-		estimate_pattern(DIMS, ksp_dims, COIL_FLAG, wgh, kspace);
 		pattern = compute_psf(DIMS, pat_dims, trj_dims, traj, trj_dims, NULL, wgh_dims, wgh, false, false);
 
 		md_free(wgh);
@@ -404,7 +505,6 @@ int main_rtnlinv(int argc, char* argv[argc])
 		nufft_ops[i] = NULL;
 
 	complex float* fftc_mod = NULL;
-	complex float* kgrid1 = NULL;
 	complex float* traj1 = NULL;
 
 	if (NULL != trajectory) { 	// Crecte nufft objects
@@ -423,8 +523,6 @@ int main_rtnlinv(int argc, char* argv[argc])
 			nufft_ops[i] = nufft_create(DIMS, ksp1_dims, kgrid1_dims, trj1_dims, traj1, NULL, nufft_conf);
 		}
 
-		kgrid1 = md_alloc(DIMS, kgrid1_dims, CFL_SIZE);
-
 		fftc = fft_measure_create(DIMS, kgrid1_dims, FFT_FLAGS, true, false);
 		fftc_mod = md_alloc(DIMS, kgrid1_dims, CFL_SIZE);
 
@@ -439,70 +537,76 @@ int main_rtnlinv(int argc, char* argv[argc])
 
 	complex float* img_output1 = md_alloc(DIMS, img_output1_dims, CFL_SIZE);
 	complex float* sens_output1 = md_alloc(DIMS, sens1_dims, CFL_SIZE);
-	complex float* kspace1 = md_alloc(DIMS, ksp1_dims, CFL_SIZE);
 
-	long pat1_dims[DIMS];
-	md_select_dims(DIMS, ~TIME_FLAG, pat1_dims, pat_dims);
+	// double buffer, so that the next frame can be gridded during
+	// the reconstruction of the current one
 
-	complex float* pattern1 = md_alloc(DIMS, pat1_dims, CFL_SIZE);
+	complex float* kgrid[2];
 
-	for (int frame = 0; frame < frames; ++frame) {
+	for (int i = 0; i < 2; i++)
+		kgrid[i] = md_alloc(DIMS, kgrid1_dims, CFL_SIZE);
 
-		debug_printf(DP_DEBUG1, "Reconstructing frame %d\n", frame);
+	complex float* kspace1 = (NULL != trajectory) ? md_alloc(DIMS, ksp1_dims, CFL_SIZE) : NULL;
 
-		// pick k-space and pattern for current frame
-		long pos[DIMS] = { };
-		pos[TIME_DIM] = frame;
+	long pat1_dims[DIMS];
+	md_select_dims(DIMS, ~TIME_FLAG, pat1_dims, pat_dims);
 
-		md_slice(DIMS, TIME_FLAG, pos, ksp_dims, kspace1, kspace, CFL_SIZE);
+	complex float* pattern1 = md_alloc(DIMS, pat1_dims, CFL_SIZE);
 
-		pos[TIME_DIM] = frame % turns;
-		md_slice(DIMS, TIME_FLAG, pos, pat_dims, pattern1, pattern, CFL_SIZE);
+	double* arrival = xmalloc((size_t)frames * sizeof(double));
+	float* latency = xmalloc((size_t)frames * sizeof(float));
 
-		if (NULL != trajectory)  {
+	arrival[0] = grid_frame(0, conf.sms, strm_ksp, ksp_dims, kspace, ksp1_dims, kspace1 ?: kgrid[0],
+				nufft_ops[0], fftc, fftc_mod, kgrid1_dims, kgrid[0]);
 
-			// grid data frame by frame
-			linop_adjoint(nufft_ops[frame % turns], DIMS, kgrid1_dims, kgrid1, DIMS, ksp1_dims, kspace1);
-#if 1
-			md_zmul(DIMS, kgrid1_dims, kgrid1, kgrid1, fftc_mod);
-			fft_exec(fftc, kgrid1, kgrid1);
-			md_zmul(DIMS, kgrid1_dims, kgrid1, kgrid1, fftc_mod);
-			fftscale(DIMS, kgrid1_dims, FFT_FLAGS, kgrid1, kgrid1);
-#else
-			fftuc(DIMS, kgrid1_dims, FFT_FLAGS, kgrid1, kgrid1);
+#ifdef _OPENMP
+	// keep all threads for the reconstruction while the next frame is gridded
+	int max_levels = omp_get_max_active_levels();
+	omp_set_max_active_levels(MAX(max_levels, omp_get_active_level() + 2));
 #endif
-			if (!use_compat_to_version("v0.7.00")) {
 
-				float sc = 1.;
-				for (int i = 0; i < 3; i++)
-					if (1 != kgrid1_dims[i])
-						sc *= 2.;
+	for (int frame = 0; frame < frames; ++frame) {
 
-				md_zsmul(DIMS, kgrid1_dims, kgrid1, kgrid1, sqrtf(sc));
-			}
-		} else {
+		debug_printf(DP_DEBUG1, "Reconstructing frame %d\n", frame);
 
-			kgrid1 = kspace1;
-		}
+		complex float* kgrid1 = kgrid[frame % 2];
+		complex float* kgrid2 = kgrid[(frame + 1) % 2];
 
+		// pick pattern for current frame
+		long pos[DIMS] = { };
+		pos[TIME_DIM] = frame % turns;
+		md_slice(DIMS, TIME_FLAG, pos, pat_dims, pattern1, pattern, CFL_SIZE);
 
 		if ((-1. == scaling) || alt_scaling)
 			scaling = 100. / md_znorm(DIMS, kgrid1_dims, kgrid1);
 
 		md_zsmul(DIMS, kgrid1_dims, kgrid1, kgrid1, scaling);
 
+		bool next = (frame + 1 < frames);
+
+#pragma omp parallel sections num_threads(2) if (next)
+		{
+#pragma omp section
+			{
 #ifdef USE_CUDA
-		if (bart_use_gpu) {
+			if (bart_use_gpu) {
 
-			complex float* kgrid1_gpu = md_alloc_gpu(DIMS, kgrid1_dims, CFL_SIZE);
-			md_copy(DIMS, kgrid1_dims, kgrid1_gpu, kgrid1, CFL_SIZE);
+				complex float* kgrid1_gpu = md_alloc_gpu(DIMS, kgrid1_dims, CFL_SIZE);
+				md_copy(DIMS, kgrid1_dims, kgrid1_gpu, kgrid1, CFL_SIZE);
 
-			noir_recon(&conf, sens1_dims, img1, sens1, ksens1, ref, pattern1, mask, kgrid1_gpu);
-			md_free(kgrid1_gpu);
+				noir_recon(&conf, sens1_dims, img1, sens1, ksens1, ref, pattern1, mask, kgrid1_gpu);
+				md_free(kgrid1_gpu);
 
-		} else
+			} else
 #endif
-			noir_recon(&conf, sens1_dims, img1, sens1, ksens1, ref, pattern1, mask, kgrid1);
+				noir_recon(&conf, sens1_dims, img1, sens1, ksens1, ref, pattern1, mask, kgrid1);
+			}
+
+#pragma omp section
+			if (next)
+				arrival[frame + 1] = grid_frame(frame + 1, conf.sms, strm_ksp, ksp_dims, kspace, ksp1_dims, kspace1 ?: kgrid2,
+							nufft_ops[(frame + 1) % turns], fftc, fftc_mod, kgrid1_dims, kgrid2);
+		}
 
 
 		// Temporal regularization
@@ -536,10 +640,29 @@ int main_rtnlinv(int argc, char* argv[argc])
 		if (out_sens)
 			md_copy_block(DIMS, pos2, sens_dims, sens, sens1_dims, sens1, CFL_SIZE);
 
+		if (NULL != strm_img)
+			stream_sync(strm_img, DIMS, pos2);
+
+		latency[frame] = timestamp() - arrival[frame];
+
+		debug_printf(DP_DEBUG2, "Frame %d latency: %.1f ms\n", frame, latency[frame] * 1.E3);
+
 		if (NULL != init_file_im)
 			conf.img_space_coils = false;
 	}
 
+#ifdef _OPENMP
+	omp_set_max_active_levels(max_levels);
+#endif
+
+	print_latency(real_time_stream ? DP_INFO : DP_DEBUG1, frames, latency);
+
+	xfree(arrival);
+	xfree(latency);
+
+	for (int i = 0; i < 2; i++)
+		md_free(kgrid[i]);
+
 	md_free(mask);
 	md_free(img1);
 	md_free(kspace1);
@@ -554,7 +677,6 @@ int main_rtnlinv(int argc, char* argv[argc])
 	if (NULL != trajectory) {
 
 		md_free(traj1);
-		md_free(kgrid1);
 		md_free(fftc_mod);
 
 		unmap_cfl(DIMS, trj_dims, traj);
@@ -52,12 +52,14 @@ int main_sake(int argc, char* argv[argc])
 	float alpha = 0.22;
 	int iter = 50;
 	float lambda = 1.;
+	bool fft = false;
 
 	const struct opt_s opts[] = {
 
 		OPT_INT('i', &iter, "iter", "number of iterations"),
 		OPT_FLOAT('s', &alpha, "size", "rel. size of the signal subspace"),
 		OPT_FLOAT('o', &lambda, "", "()"),
+		OPTL_SET(0, "fft", &fft, "implicit calibration matrix with FFT-based products (for 3D / many channels)"),
 	};
 
 	cmdline(&argc, argv, ARRAY_SIZE(args), args, help_str, ARRAY_SIZE(opts), opts);
@@ -71,9 +73,13 @@ int main_sake(int argc, char* argv[argc])
 	num_init();
 	
 	complex float* in_data = load_cfl(ksp_file, DIMS, dims);
+
+	if (fft && (1 != md_calc_size(DIMS - 4, dims + 4)))
+		error("--fft only supports single-frame data\n");
+
 	complex float* out_data = create_cfl(out_file, DIMS, dims);
 
-	lrmc(alpha, iter, lambda, DIMS, dims, out_data, in_data);
+	lrmc(alpha, iter, lambda, fft, DIMS, dims, out_data, in_data);
 
 	unmap_cfl(DIMS, dims, out_data);
 	unmap_cfl(DIMS, dims, in_data);
@@ -19,15 +19,20 @@
  */
 
 #include <stdlib.h>
+#include <stdbool.h>
 #include <assert.h>
 #include <math.h>
 #include <complex.h>
 
 #include "num/lapack.h"
 #include "num/linalg.h"
+#include "num/blas.h"
 #include "num/multind.h"
 #include "num/flpmath.h"
 #include "num/casorati.h"
+#include "num/fft.h"
+#include "num/ops.h"
+#include "num/rand.h"
 
 #include "misc/misc.h"
 #include "misc/debug.h"
@@ -190,7 +195,281 @@ static void lowrank(float alpha, int D, const long dims[D], complex float* matri
 
 
 
-void lrmc(float alpha, int iter, float lambda, int N, const long dims[N], complex float* out, const complex float* in)
+/* Implicit block-Hankel (calibration) matrix
+ *
+ * The products of the calibration matrix A with a kernel v
+ * (A v)(p) = sum_{k,c} x_c(p + k) v_c(k) and of its adjoint are
+ * computed as multi-channel correlations with FFTs. As p + k never
+ * leaves the data, circular correlations are exact if the result
+ * is restricted to valid positions p. The rank-r projection of A
+ * is A V V^H, where V are the leading right singular vectors which
+ * are computed with a (warm-started) randomized subspace iteration
+ * on A^H A. The projected matrix is mapped back to k-space
+ * (adjoint of the Hankel embedding) as sum_j (A v_j) * conj(v_j),
+ * i.e. also with FFTs. Neither A nor its SVD are formed.
+ */
+struct hankel_s {
+
+	long dims[4];
+	long kdims[4];
+	long vdims[4];
+
+	long M;		// columns of A
+	long P;		// size of subspace
+	long rank;
+
+	complex float* xf;	// FFT of data
+	complex float* wf;	// FFT of kernel
+	complex float* bf;	// FFT of A v
+	complex float* tmp;
+	complex float* valid;	// A v at valid positions
+
+	const struct operator_s* fft1;
+	const struct operator_s* ifft1;
+	const struct operator_s* fftc;
+	const struct operator_s* ifftc;
+
+	complex float* sub;	// [P][M]
+	bool warm;
+};
+
+#define SAKE_RAND_ITER 4
+#define SAKE_WARM_ITER 1
+
+
+static struct hankel_s* hankel_create(float alpha, const long dims[4])
+{
+	PTR_ALLOC(struct hankel_s, h);
+
+	long kern_min[4] = { 6, 6, 6, dims[3] };
+
+	md_copy_dims(4, h->dims, dims);
+	md_min_dims(4, ~0UL, h->kdims, kern_min, dims);
+
+	md_select_dims(4, 7, h->vdims, dims);
+
+	for (int i = 0; i < 3; i++)
+		h->vdims[i] = dims[i] - h->kdims[i] + 1;
+
+	h->M = md_calc_size(4, h->kdims);
+
+	long N = md_calc_size(3, h->vdims);
+	long mn = MIN(N, h->M);
+
+	h->rank = 0;
+
+	while ((h->rank < mn) && (h->rank < alpha * (float)mn))
+		h->rank++;
+
+	h->P = MIN(h->M, h->rank + MAX(h->rank / 4, 8L));
+
+	debug_printf(DP_DEBUG1, "Implicit calibration matrix %ldx%ld, rank %ld, subspace %ld.\n", N, h->M, h->rank, h->P);
+
+	long img_dims[4];
+	md_select_dims(4, 7, img_dims, dims);
+
+	h->xf = md_alloc(4, dims, CFL_SIZE);
+	h->wf = md_alloc(4, dims, CFL_SIZE);
+	h->tmp = md_alloc(4, dims, CFL_SIZE);
+	h->bf = md_alloc(4, img_dims, CFL_SIZE);
+	h->valid = md_alloc(4, h->vdims, CFL_SIZE);
+
+	h->fft1 = fft_create(4, img_dims, 7, h->bf, h->bf, false);
+	h->ifft1 = fft_create(4, img_dims, 7, h->bf, h->bf, true);
+	h->fftc = fft_create(4, dims, 7, h->tmp, h->tmp, false);
+	h->ifftc = fft_create(4, dims, 7, h->tmp, h->tmp, true);
+
+	h->sub = md_alloc(1, MD_DIMS(h->P * h->M), CFL_SIZE);
+	h->warm = false;
+
+	return PTR_PASS(h);
+}
+
+
+static void hankel_free(struct hankel_s* h)
+{
+	operator_free(h->fft1);
+	operator_free(h->ifft1);
+	operator_free(h->fftc);
+	operator_free(h->ifftc);
+
+	md_free(h->xf);
+	md_free(h->wf);
+	md_free(h->bf);
+	md_free(h->tmp);
+	md_free(h->valid);
+	md_free(h->sub);
+
+	xfree(h);
+}
+
+
+// h->bf = FFT(A v) and h->wf = FFT(conj(v))
+
+static void hankel_forward(struct hankel_s* h, const complex float* v)
+{
+	long img_dims[4];
+	md_select_dims(4, 7, img_dims, h->dims);
+
+	md_resize(4, h->dims, h->wf, h->kdims, v, CFL_SIZE);
+	md_zconj(4, h->dims, h->wf, h->wf);
+	fft_exec(h->fftc, h->wf, h->wf);
+
+	md_zmulc(4, h->dims, h->tmp, h->xf, h->wf);
+
+	long strs[4];
+	long img_strs[4];
+	md_calc_strides(4, strs, h->dims, CFL_SIZE);
+	md_calc_strides(4, img_strs, img_dims, CFL_SIZE);
+
+	md_clear(4, img_dims, h->bf, CFL_SIZE);
+	md_zadd2(4, h->dims, img_strs, h->bf, img_strs, h->bf, strs, h->tmp);
+
+	fft_exec(h->ifft1, h->bf, h->bf);
+
+	// restrict to valid positions
+
+	md_resize(4, h->vdims, h->valid, img_dims, h->bf, CFL_SIZE);
+	md_resize(4, img_dims, h->bf, h->vdims, h->valid, CFL_SIZE);
+	md_zsmul(4, img_dims, h->bf, h->bf, 1. / md_calc_size(3, img_dims));
+
+	fft_exec(h->fft1, h->bf, h->bf);
+}
+
+
+// z = A^H b (with h->bf = FFT(b))
+
+static void hankel_adjoint(struct hankel_s* h, complex float* z)
+{
+	long img_dims[4];
+	md_select_dims(4, 7, img_dims, h->dims);
+
+	long strs[4];
+	long img_strs[4];
+	md_calc_strides(4, strs, h->dims, CFL_SIZE);
+	md_calc_strides(4, img_strs, img_dims, CFL_SIZE);
+
+	md_zmulc2(4, h->dims, strs, h->tmp, strs, h->xf, img_strs, h->bf);
+	fft_exec(h->ifftc, h->tmp, h->tmp);
+
+	md_resize(4, h->kdims, z, h->dims, h->tmp, CFL_SIZE);
+	md_zconj(4, h->kdims, z, z);
+	md_zsmul(4, h->kdims, z, z, 1. / md_calc_size(3, img_dims));
+}
+
+
+static void hankel_normal(struct hankel_s* h, long P, complex float dst[P][h->M], const complex float src[P][h->M])
+{
+	for (long j = 0; j < P; j++) {
+
+		hankel_forward(h, src[j]);
+		hankel_adjoint(h, dst[j]);
+	}
+}
+
+
+// leading right singular vectors of A in the rows of h->sub
+
+static void hankel_subspace(struct hankel_s* h)
+{
+	long M = h->M;
+	long P = h->P;
+
+	complex float (*sub)[M] = (void*)h->sub;
+
+	if (!h->warm) {
+
+		gaussian_rand_vec(2 * P * M, (float*)h->sub);
+
+		float nrm[P];
+		gram_schmidt(P, M, nrm, sub);
+	}
+
+	PTR_ALLOC(complex float[P][M], tmp);
+
+	float nrm[P];
+
+	for (int it = 0; it < (h->warm ? SAKE_WARM_ITER : SAKE_RAND_ITER); it++) {
+
+		hankel_normal(h, P, *tmp, sub);
+		mat_copy(P, M, sub, *tmp);
+		gram_schmidt(P, M, nrm, sub);
+	}
+
+	// Rayleigh-Ritz
+
+	PTR_ALLOC(complex float[M][P], adj);
+	PTR_ALLOC(complex float[P][P], red);
+
+	hankel_normal(h, P, *tmp, sub);
+	mat_adjoint(P, M, *adj, sub);
+	blas_matrix_multiply(P, P, M, *red, *adj, *tmp);
+
+	float rval[P];
+	lapack_eig(P, rval, *red);
+
+	// descending order
+
+	for (long i = 0; i < P / 2; i++) {
+
+		for (long j = 0; j < P; j++) {
+
+			complex float t = (*red)[i][j];
+			(*red)[i][j] = (*red)[P - 1 - i][j];
+			(*red)[P - 1 - i][j] = t;
+		}
+	}
+
+	blas_matrix_multiply(M, P, P, *tmp, sub, *red);
+	mat_copy(P, M, sub, *tmp);
+
+	debug_printf(DP_DEBUG2, "SV: %e ... %e\n", sqrtf(MAX(0., rval[P - 1])), sqrtf(MAX(0., rval[P - h->rank])));
+
+	h->warm = true;
+
+	PTR_FREE(tmp);
+	PTR_FREE(adj);
+	PTR_FREE(red);
+}
+
+
+static void lowrank_fft(struct hankel_s* h, const long dims[4], complex float* matrix)
+{
+	// plans are in-place
+
+	md_copy(4, dims, h->xf, matrix, CFL_SIZE);
+	fft_exec(h->fftc, h->xf, h->xf);
+
+	hankel_subspace(h);
+
+	complex float (*sub)[h->M] = (void*)h->sub;
+
+	complex float* acc = md_alloc(4, dims, CFL_SIZE);
+	md_clear(4, dims, acc, CFL_SIZE);
+
+	long img_dims[4];
+	md_select_dims(4, 7, img_dims, dims);
+
+	long strs[4];
+	long img_strs[4];
+	md_calc_strides(4, strs, dims, CFL_SIZE);
+	md_calc_strides(4, img_strs, img_dims, CFL_SIZE);
+
+	for (long j = 0; j < h->rank; j++) {
+
+		hankel_forward(h, sub[j]);
+		md_zfmac2(4, dims, strs, acc, img_strs, h->bf, strs, h->wf);
+	}
+
+	fft_exec(h->ifftc, acc, acc);
+	md_zsmul(4, dims, matrix, acc, 1. / (double)(md_calc_size(3, img_dims) * md_calc_size(3, h->kdims))); // FIXME: not right at the border
+
+	md_free(acc);
+}
+
+
+
+void lrmc(float alpha, int iter, float lambda, bool fft, int N, const long dims[N], complex float* out, const complex float* in)
 {
 	long dims1[N];
 	md_select_dims(N, ~COIL_FLAG, dims1, dims);
@@ -207,6 +486,14 @@ void lrmc(float alpha, int iter, float lambda, int N, const long dims[N], comple
 
 	lowrank(-1., N, dims1, comp);
 
+	struct hankel_s* h = NULL;
+
+	if (fft) {
+
+		assert(1 == md_calc_size(N - 4, dims + 4));
+		h = hankel_create(alpha, dims);
+	}
+
 #ifdef RAVINE
 	complex float* o = md_alloc(N, dims, CFL_SIZE);
 	md_clear(N, dims, o, CFL_SIZE);
@@ -229,7 +516,11 @@ void lrmc(float alpha, int iter, float lambda, int N, const long dims[N], comple
 		else
 			data_consistency(dims, out, pattern, in, out);
 
-		lowrank(alpha, N, dims, out);
+		if (fft)
+			lowrank_fft(h, dims, out);
+		else
+			lowrank(alpha, N, dims, out);
+
 		md_zdiv2(N, dims, strs, out, strs, out, strs1, comp);
 #ifdef RAVINE
 		ravine(N, dims, &fl, out, o);
@@ -240,6 +531,9 @@ void lrmc(float alpha, int iter, float lambda, int N, const long dims[N], comple
 #ifdef RAVINE
 	md_free(o);
 #endif
+	if (fft)
+		hankel_free(h);
+
 	md_free(comp);
 	md_free(pattern);
 }
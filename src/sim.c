@@ -32,24 +32,15 @@
 static const char help_str[] = "simulation tool";
 
 
-// FIXME: Turn off sensitivity analysis if derivatives are not asked for
-static void perform_bloch_simulation(int N, struct sim_data* data, long mdims[N], complex float* mxy, long ddims[N], complex float* deriv)     // 4 Derivatives: dR1, dM0, dR2, dB1
+static void store_simulation(int N, int T, int P,
+		float m[T][P][3], float sa_r1[T][P][3], float sa_r2[T][P][3], float sa_m0[T][P][3],
+		float sa_b1[T][1][3], float sa_k[T][P][3], float sa_Om[T][P][3],
+		long mdims[N], complex float* mxy, long ddims[N], complex float* deriv)
 {
 	int D = ddims[READ_DIM];
-	int T = ddims[TE_DIM];
 
 	int A = 3;
 
-	float m[T][data->voxel.P][3];
-	float sa_r1[T][data->voxel.P][3];
-	float sa_r2[T][data->voxel.P][3];
-	float sa_m0[T][data->voxel.P][3];
-	float sa_b1[T][1][3];
-	float sa_Om[T][data->voxel.P][3];
-	float sa_k[T][data->voxel.P][3];	// [T][data->voxel.P - 1][A] is empty for k and Om
-
-	bloch_simulation2(data, T, data->voxel.P, &m, &sa_r1, &sa_r2, &sa_m0, &sa_b1, &sa_k, &sa_Om);
-
 	long pos[DIMS];
 	md_copy_dims(DIMS, pos, ddims);
 
@@ -71,7 +62,7 @@ static void perform_bloch_simulation(int N, struct sim_data* data, long mdims[N]
 
 			pos[TE_DIM] = i;
 
-			for (int p = 0; p < data->voxel.P; p++) {
+			for (int p = 0; p < P; p++) {
 
 				pos[MAPS_DIM] = 0;
 				pos[ITER_DIM] = p;
@@ -100,7 +91,7 @@ static void perform_bloch_simulation(int N, struct sim_data* data, long mdims[N]
 				if (0 == p)
 					deriv[ind] = (A == D) ? sa_b1[i][0][d] : (sa_b1[i][0][0] + 1.i * sa_b1[i][0][1]);
 
-				if (p < data->voxel.P - 1) {
+				if (p < P - 1) {
 
 					pos[MAPS_DIM] = 4;
 					ind = md_calc_offset(N, dstrs, pos) / (long)CFL_SIZE;
@@ -116,6 +107,50 @@ static void perform_bloch_simulation(int N, struct sim_data* data, long mdims[N]
 }
 
 
+// FIXME: Turn off sensitivity analysis if derivatives are not asked for
+static void perform_bloch_simulation(int N, struct sim_data* data, long mdims[N], complex float* mxy, long ddims[N], complex float* deriv)     // 4 Derivatives: dR1, dM0, dR2, dB1
+{
+	int T = ddims[TE_DIM];
+
+	float m[T][data->voxel.P][3];
+	float sa_r1[T][data->voxel.P][3];
+	float sa_r2[T][data->voxel.P][3];
+	float sa_m0[T][data->voxel.P][3];
+	float sa_b1[T][1][3];
+	float sa_Om[T][data->voxel.P][3];
+	float sa_k[T][data->voxel.P][3];	// [T][data->voxel.P - 1][A] is empty for k and Om
+
+	bloch_simulation2(data, T, data->voxel.P, &m, &sa_r1, &sa_r2, &sa_m0, &sa_b1, &sa_k, &sa_Om);
+
+	store_simulation(N, T, data->voxel.P, m, sa_r1, sa_r2, sa_m0, sa_b1, sa_k, sa_Om, mdims, mxy, ddims, deriv);
+}
+
+
+// W voxels in lock-step (single pool Bloch model, ODE)
+static void perform_bloch_simulation_batch(int N, struct sim_data* data, int W, const struct simdata_voxel voxel[W], long mdims[N], complex float* mxy[W], long ddims[N], complex float* deriv[W])
+{
+	int T = ddims[TE_DIM];
+
+	float (*m)[W][T][3] = xmalloc(sizeof *m);
+	float (*sa_r1)[W][T][3] = xmalloc(sizeof *sa_r1);
+	float (*sa_r2)[W][T][3] = xmalloc(sizeof *sa_r2);
+	float (*sa_m0)[W][T][3] = xmalloc(sizeof *sa_m0);
+	float (*sa_b1)[W][T][3] = xmalloc(sizeof *sa_b1);
+
+	bloch_simulation_batch(data, W, voxel, T, m, sa_r1, sa_r2, sa_m0, sa_b1);
+
+	for (int w = 0; w < W; w++)
+		store_simulation(N, T, 1, (void*)(*m)[w], (void*)(*sa_r1)[w], (void*)(*sa_r2)[w], (void*)(*sa_m0)[w],
+				(void*)(*sa_b1)[w], NULL, NULL, mdims, mxy[w], ddims, (NULL == deriv) ? NULL : deriv[w]);
+
+	xfree(m);
+	xfree(sa_r1);
+	xfree(sa_r2);
+	xfree(sa_m0);
+	xfree(sa_b1);
+}
+
+
 int main_sim(int argc, char* argv[argc])
 {
 	const char* out_signal = NULL;
@@ -148,6 +183,7 @@ int main_sim(int argc, char* argv[argc])
 	float kpools[4] = { 0., 0., 0., 0. };
 
 	bool split_dim = false;
+	int batch = 1;
 
 	struct opt_s seq_opts[] = {
 
@@ -161,6 +197,7 @@ int main_sim(int argc, char* argv[argc])
 		OPTL_FLOAT(0, "TE", &(data.seq.te), "float", "Echo time [s]"),
 		OPTL_INT(0, "Nspins", &(data.seq.spin_num), "int", "Number of averaged spins"),
 		OPTL_INT(0, "Nrep", &(data.seq.rep_num), "int", "Number of repetitions"),
+		OPTL_INT(0, "Ndummy", &(data.seq.dummy_num), "int", "Number of dummy repetitions before the first readout"),
 		OPTL_SET(0, "pinv", &(data.seq.perfect_inversion), "Use perfect inversions"),
 		OPTL_FLOAT(0, "ipl", &(data.seq.inversion_pulse_length), "float", "Inversion Pulse Length [s]"),
 		OPTL_FLOAT(0, "isp", &(data.seq.inversion_spoiler), "float", "Inversion Spoiler Gradient Length [s]"),
@@ -187,6 +224,7 @@ int main_sim(int argc, char* argv[argc])
 		OPTL_FLOAT(0, "ode-tol", &(data.other.ode_tol), "", "ODE tolerance value [def: 1e-5]"),
 		OPTL_FLOAT(0, "stm-tol", &(data.other.stm_tol), "", "STM tolerance value [def: 1e-6]"),
 		OPTL_FLOAT(0, "sampling-rate", &(data.other.sampling_rate), "", "Sampling rate of RF pulse used for ROT simulation in Hz [def: 1e6 Hz]"),
+		OPTL_INT(0, "batch", &batch, "", "Number of voxels simulated in lock-step (ODE, single pool) [def: 1]"),
 	};
 	const int N_other_opts = ARRAY_SIZE(other_opts);
 
@@ -256,6 +294,9 @@ int main_sim(int argc, char* argv[argc])
 	if ((mdims[TE_DIM] < 1) || (mdims[COEFF_DIM] < 1) || (mdims[COEFF2_DIM] < 1))
 		error("invalid parameter range\n");
 
+	if (batch < 1)
+		error("Batch size must be positive.\n");
+
 	// Allocate output file for signal and optional derivatives
 
 	complex float* signals = create_cfl(out_signal, DIMS, mdims);
@@ -289,9 +330,70 @@ int main_sim(int argc, char* argv[argc])
 
 	long pos[DIMS] = { };
 
+	long V = mdims[COEFF_DIM] * mdims[COEFF2_DIM];
+
 	// Starting time of simulation
 	double start = timestamp();
-	do {
+
+	if (1 < batch) {
+
+		if ((MODEL_BLOCH != data.seq.model) || (SIM_ODE != data.seq.type) || (1 != data.voxel.P) || (SEQ_CEST == data.seq.seq_type))
+			error("Batched simulation requires the single pool Bloch model with the ODE solver.\n");
+
+		struct simdata_voxel* voxel = *TYPE_ALLOC(struct simdata_voxel[batch]);
+		long (*bpos)[DIMS] = *TYPE_ALLOC(long[batch][DIMS]);
+
+		complex float** btm = *TYPE_ALLOC(complex float*[batch]);
+		complex float** btd = *TYPE_ALLOC(complex float*[batch]);
+
+		for (int w = 0; w < batch; w++) {
+
+			btm[w] = md_calloc(DIMS, tmdims, CFL_SIZE);
+			btd[w] = md_calloc(DIMS, tddims, CFL_SIZE);
+		}
+
+		bool more = true;
+
+		while (more) {
+
+			int W = 0;
+
+			while (more && (W < batch)) {
+
+				voxel[W] = data.voxel;
+				voxel[W].r1[0] = 1. / (T1[0] + (T1[1] - T1[0]) / T1[2] * (float)pos[COEFF_DIM]);
+				voxel[W].r2[0] = 1. / (T2[0] + (T2[1] - T2[0]) / T2[2] * (float)pos[COEFF2_DIM]);
+
+				md_copy_dims(DIMS, bpos[W], pos);
+				W++;
+
+				more = md_next(DIMS, mdims, ~(READ_FLAG|MAPS_FLAG|TE_FLAG|ITER_FLAG), pos);
+			}
+
+			perform_bloch_simulation_batch(DIMS, &data, W, voxel, tmdims, btm, tddims, (NULL != deriv) ? btd : NULL);
+
+			for (int w = 0; w < W; w++) {
+
+				md_copy_block(DIMS, bpos[w], mdims, signals, tmdims, btm[w], CFL_SIZE);
+
+				if (NULL != deriv)
+					md_copy_block(DIMS, bpos[w], ddims, deriv, tddims, btd[w], CFL_SIZE);
+			}
+		}
+
+		for (int w = 0; w < batch; w++) {
+
+			md_free(btm[w]);
+			md_free(btd[w]);
+		}
+
+		xfree(voxel);
+		xfree(bpos);
+		xfree(btm);
+		xfree(btd);
+
+	} else do {
+
 		data.voxel.r1[0] = 1. / (T1[0] + (T1[1] - T1[0]) / T1[2] * (float)pos[COEFF_DIM]);
 		data.voxel.r2[0] = 1. / (T2[0] + (T2[1] - T2[0]) / T2[2] * (float)pos[COEFF2_DIM]);
 
@@ -321,6 +423,7 @@ int main_sim(int argc, char* argv[argc])
 	double end = timestamp();
 
 	debug_printf(DP_INFO, "%f\n", end - start);
+	debug_printf(DP_INFO, "Throughput: %.1f voxels/s\n", (double)V / (end - start));
 
 	md_free(tm);
 	md_free(td);
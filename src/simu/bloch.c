@@ -103,6 +103,57 @@ void bloch_b1_pdp(float out[3][3], const float in[3], float r1, float r2, const
 }
 
 
+// Batched versions for W voxels stored as structure of arrays
+
+void bloch_ode_batch(int W, float out[3][W], const float in[3][W], const float r1[W], const float r2[W], const float gb[3][W])
+{
+	float m0 = 1.;
+
+	for (int w = 0; w < W; w++) {
+
+		out[0][w] = in[1][w] * gb[2][w] - in[2][w] * gb[1][w] - in[0][w] * r2[w];
+		out[1][w] = in[2][w] * gb[0][w] - in[0][w] * gb[2][w] - in[1][w] * r2[w];
+		out[2][w] = in[0][w] * gb[1][w] - in[1][w] * gb[0][w] - (in[2][w] - m0) * r1[w];
+	}
+}
+
+void bloch_pdy_batch(int W, float out[3][3][W], const float r1[W], const float r2[W], const float gb[3][W])
+{
+	for (int w = 0; w < W; w++) {
+
+		out[0][0][w] = -r2[w];
+		out[0][1][w] = -gb[2][w];
+		out[0][2][w] = gb[1][w];
+
+		out[1][0][w] = gb[2][w];
+		out[1][1][w] = -r2[w];
+		out[1][2][w] = -gb[0][w];
+
+		out[2][0][w] = -gb[1][w];
+		out[2][1][w] = gb[0][w];
+		out[2][2][w] = -r1[w];
+	}
+}
+
+void bloch_b1_pdp_batch(int W, float out[3][3][W], const float in[3][W], complex float b1)
+{
+	float m0 = 1.;
+
+	for (int w = 0; w < W; w++) {
+
+		out[0][0][w] = 0.;
+		out[0][1][w] = 0.;
+		out[0][2][w] = -(in[2][w] - m0);
+		out[1][0][w] = -in[0][w];
+		out[1][1][w] = -in[1][w];
+		out[1][2][w] = 0.;
+		out[2][0][w] = in[2][w] * cimagf(b1);
+		out[2][1][w] = in[2][w] * crealf(b1);
+		out[2][2][w] = -cimagf(b1) * in[0][w] - crealf(b1) * in[1][w];
+	}
+}
+
+
 void bloch_relaxation(float out[3], float t, const float in[3], float r1, float r2, const float gb[3])
 {
 	float m0 = 1.;
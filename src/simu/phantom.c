@@ -551,6 +551,181 @@ static complex float krn_poly(void* _data, int s, const double mpos[3])
 	return val;
 }
 
+
+/*
+ * Batched k-space sampling of polygon phantoms. For a block of sample
+ * positions, all positions shifted by the Fourier coefficients of the
+ * coil sensitivities are collected and each polygon is evaluated once
+ * for all of them. The coils then only combine the shared values
+ * instead of evaluating the polygons again for every coil.
+ */
+#define POLY_BLOCK 256
+
+static void sample_kpoly(const long dims[DIMS], complex float* out, const long tstrs[DIMS], const complex float* traj, const struct poly* poly)
+{
+	int C = dims[COIL_DIM];
+	int S = dims[COEFF_DIM];
+
+	assert(C <= MAX_COILS);
+	assert(poly->coeff == (1 < S));
+	assert((NULL == traj) || ((0 == tstrs[COIL_DIM]) && (0 == tstrs[COEFF_DIM])));
+
+	// shifts and weights of the sensitivity convolution kernel
+
+	int K = 1;
+
+	if (1 < C) {
+
+		switch (poly->stype) {
+
+		case HEAD_3D_64CH:
+
+			K = COIL_COEFF * COIL_COEFF * COIL_COEFF;
+			break;
+
+		case HEAD_2D_8CH:
+
+			K = COIL_COEFF * COIL_COEFF;
+			break;
+
+		case DEFAULT:
+		default:
+
+			error("Please specify a sensitivity type.\n");
+		}
+	}
+
+	double shift[K][3];
+	complex float wgh[C][K];
+
+	long sh = (COIL_COEFF - 1) / 2;
+	bool three_d = (COIL_COEFF * COIL_COEFF * COIL_COEFF == K);
+
+	for (int k = 0; k < K; k++) {
+
+		if (1 == K) {
+
+			shift[k][0] = 0.;
+			shift[k][1] = 0.;
+			shift[k][2] = 0.;
+
+			wgh[0][k] = 1.;
+			break;
+		}
+
+		int ij = three_d ? (k / COIL_COEFF) : k;
+		int i = ij / COIL_COEFF;
+		int j = ij % COIL_COEFF;
+		int m = three_d ? (k % COIL_COEFF) : sh;
+
+		shift[k][0] = (double)(i - sh) / 4.;
+		shift[k][1] = (double)(j - sh) / 4.;
+		shift[k][2] = (double)(m - sh) / 4.;
+
+		for (int c = 0; c < C; c++)
+			wgh[c][k] = three_d ? sens64_coeff[c][i][j][m] : sens_coeff[c][i][j];
+	}
+
+	long sdims[DIMS];
+	md_select_dims(DIMS, ~(COIL_FLAG | COEFF_FLAG), sdims, dims);
+
+	long ostrs[DIMS];
+	md_calc_strides(DIMS, ostrs, dims, CFL_SIZE);
+
+	long L = md_calc_size(DIMS, sdims);
+	int B = MAX(1, POLY_BLOCK / K);
+
+#pragma omp parallel for
+	for (long l0 = 0; l0 < L; l0 += B) {
+
+		int Bl = MIN(B, L - l0);
+
+		double qs[Bl * K][3];
+		long offs[Bl];
+
+		for (int b = 0; b < Bl; b++) {
+
+			long pos[DIMS];
+			md_unravel_index(DIMS, pos, ~0UL, sdims, l0 + b);
+
+			offs[b] = md_calc_offset(DIMS, ostrs, pos) / (long)CFL_SIZE;
+
+			double mpos[3];
+
+			if (NULL == traj) {
+
+				for (int d = 0; d < 3; d++)
+					mpos[d] = (double)(pos[d] - dims[d] / 2) / 2.;
+
+			} else {
+
+				assert(0 == pos[0]);
+
+				for (int d = 0; d < 3; d++)
+					mpos[d] = creal((&MD_ACCESS(DIMS, tstrs, pos, traj))[d]) / 2.;
+			}
+
+			for (int k = 0; k < K; k++)
+				for (int d = 0; d < 3; d++)
+					qs[b * K + k][d] = mpos[d] + shift[k][d];
+		}
+
+		complex double val[Bl * K];
+		complex double tmp[Bl * K];
+
+		for (int s = 0; s < S; s++) {
+
+			if (poly->coeff) {
+
+				// Constrain to 1 allows geometry separation by intensity
+
+				const struct poly1* p = &(*poly->p)[s];
+
+				kpolygon_batch(p->N, *p->pg, Bl * K, val, qs);
+
+				for (int n = 0; n < Bl * K; n++)
+					val[n] *= p->coeff / cabsf(p->coeff);
+
+			} else {
+
+				for (int n = 0; n < Bl * K; n++)
+					val[n] = 0.;
+
+				for (int i = 0; i < poly->P; i++) {
+
+					const struct poly1* p = &(*poly->p)[i];
+
+					kpolygon_batch(p->N, *p->pg, Bl * K, tmp, qs);
+
+					for (int n = 0; n < Bl * K; n++)
+						val[n] += p->coeff * tmp[n];
+				}
+			}
+
+			for (int b = 0; b < Bl; b++) {
+
+				for (int c = 0; c < C; c++) {
+
+					complex double acc = 0.;
+
+					for (int k = 0; k < K; k++)
+						acc += wgh[c][k] * val[b * K + k];
+
+					out[offs[b] + c * ostrs[COIL_DIM] / (long)CFL_SIZE + s * ostrs[COEFF_DIM] / (long)CFL_SIZE] = acc;
+				}
+			}
+		}
+	}
+}
+
+static void sample_poly(const long dims[DIMS], complex float* out, const long tstrs[DIMS], const complex float* traj, struct poly* poly)
+{
+	if (poly->kspace)
+		sample_kpoly(dims, out, tstrs, traj, poly);
+	else
+		sample(dims, out, tstrs, traj, poly, krn_poly, false);
+}
+
 void calc_star(const long dims[DIMS], complex float* out, bool kspace, const long tstrs[DIMS], const complex float* traj, struct pha_opts* popts)
 {
 	bool coeff = (dims[COEFF_DIM] > 1);
@@ -573,17 +748,7 @@ void calc_star(const long dims[DIMS], complex float* out, bool kspace, const lon
 				} } }
 	};
 
-	struct data data = {
-
-		.traj = traj,
-		.tstrs = tstrs,
-		.sens = (dims[COIL_DIM] > 1),
-		.dims = { dims[0], dims[1], dims[2] },
-		.data = &poly,
-		.fun = krn_poly,
-	};
-
-	my_sample(dims, out, &data, kspace ? kkernel : xkernel);
+	sample_poly(dims, out, tstrs, traj, &poly);
 }
 
 #define ARRAY_SLICE(x, a, b) ({ __auto_type __x = &(x); assert((0 <= a) && (a < b) && (b <= ARRAY_SIZE(*__x))); ((__typeof__((*__x)[0]) (*)[b - a])&((*__x)[a])); })
@@ -626,7 +791,7 @@ static void calc_bart2(const long dims[DIMS], complex float* out, bool kspace, c
 		}
 	}
 
-	sample(dims, out, tstrs, traj, &poly, krn_poly, kspace);
+	sample_poly(dims, out, tstrs, traj, &poly);
 }
 
 
@@ -800,7 +965,7 @@ static void calc_brain2(const long dims[DIMS], complex float* out, bool kspace,
 		}
 	}
 
-	sample(dims, out, tstrs, traj, &poly, krn_poly, kspace);
+	sample_poly(dims, out, tstrs, traj, &poly);
 }
 
 void calc_brain(const long dims[DIMS], complex float* out, bool kspace, const long tstrs[DIMS], const complex float* traj, struct pha_opts* popts)
@@ -897,7 +1062,7 @@ void calc_cfl_geom(const long dims[DIMS], complex float* out, bool kspace, const
 		}
 	}
 
-	sample(dims, out, tstrs, traj, &poly, krn_poly, kspace);
+	sample_poly(dims, out, tstrs, traj, &poly);
 }
 
 
@@ -5,11 +5,14 @@
 
 
 #include <complex.h>
+#include <stdbool.h>
 #include <assert.h>
 #include <math.h>
 
 #include "num/specfun.h"
 
+#include "misc/misc.h"
+
 #include "geom/polygon.h"
 
 #include "simu/shape.h"
@@ -99,3 +102,135 @@ complex double kpolygon(int N, const double pg0[N][2], const double q0[3])
 //	return kpolygon1(N, pg, (double[]){ 0., 0. }, q0);
 }
 
+
+
+
+/*
+ * Reduce to [-pi, pi]. The phase arguments can be large, so this is
+ * done in double precision. Adding and subtracting 1.5 * 2^52 rounds
+ * to the nearest integer without a library call.
+ */
+static inline double reduce_2pi(double x)
+{
+	double n = (x * (0.5 / M_PI) + 0x1.8p52) - 0x1.8p52;
+
+	return x - 2. * M_PI * n;
+}
+
+/*
+ * Single-precision sine and cosine on [-pi, pi]. Reflection to
+ * [-pi/2, pi/2] and Taylor series, branch-free so that the edge loop
+ * below can be vectorized.
+ */
+static inline float reflect_pi2(float x)
+{
+	return (fabsf(x) > (float)(M_PI / 2.)) ? (copysignf((float)M_PI, x) - x) : x;
+}
+
+static inline float sin_reduced(float x)
+{
+	float y = reflect_pi2(x);
+	float y2 = y * y;
+
+	return y * (1.f + y2 * (-1.f / 6.f + y2 * (1.f / 120.f + y2 * (-1.f / 5040.f
+		+ y2 * (1.f / 362880.f + y2 * (-1.f / 39916800.f))))));
+}
+
+static inline float cos_reduced(float x)
+{
+	float y = reflect_pi2(x);
+	float y2 = y * y;
+
+	float c = 1.f + y2 * (-1.f / 2.f + y2 * (1.f / 24.f + y2 * (-1.f / 720.f
+		+ y2 * (1.f / 40320.f + y2 * (-1.f / 3628800.f + y2 * (1.f / 479001600.f))))));
+
+	return (fabsf(x) > (float)(M_PI / 2.)) ? -c : c;
+}
+
+
+/*
+ * Evaluates kpolygon for M k-space positions at once. The edges are
+ * stored as structure of arrays and the inner loop over edges computes
+ * the phases in double precision (where large arguments would otherwise
+ * lose all accuracy) and the trigonometric functions in single
+ * precision. Sums over edges cancel strongly and are accumulated in
+ * double precision. The default cost model at -O2 does not vectorize
+ * loops with a remainder, so we ask for the dynamic one here.
+ */
+__attribute__((optimize("-fvect-cost-model=dynamic")))
+void kpolygon_batch(int N, const double pg[N][2], int M, complex double out[M], const double q0[M][3])
+{
+	double cg[2] = { 0., 0. };
+
+	for (int i = 0; i < N; i++) {
+
+		cg[0] += pg[i][0];
+		cg[1] += pg[i][1];
+	}
+
+	cg[0] /= N;
+	cg[1] /= N;
+
+	double (*edges)[4][N] = xmalloc(sizeof *edges);
+
+	for (int i = 0; i < N; i++) {
+
+		int j = (i - 1 + N) % N;
+
+		(*edges)[0][i] = pg[i][0] - pg[j][0];
+		(*edges)[1][i] = pg[i][1] - pg[j][1];
+		(*edges)[2][i] = pg[i][0] + pg[j][0] - 2. * cg[0];
+		(*edges)[3][i] = pg[i][1] + pg[j][1] - 2. * cg[1];
+	}
+
+	const double* ex = (*edges)[0];
+	const double* ey = (*edges)[1];
+	const double* rx = (*edges)[2];
+	const double* ry = (*edges)[3];
+
+	double area = polygon_area(N, pg);
+
+	for (int m = 0; m < M; m++) {
+
+		assert(0. == q0[m][2]);
+
+		double q[2] = { -q0[m][0] * M_PI, -q0[m][1] * M_PI };
+		double q2 = q[0] * q[0] + q[1] * q[1];
+
+		if (0. == q2) {
+
+			out[m] = area / 4.;
+			continue;
+		}
+
+		double s0r = 0.;
+		double s0i = 0.;
+		double s1r = 0.;
+		double s1i = 0.;
+
+#pragma omp simd reduction(+:s0r,s0i,s1r,s1i)
+		for (int i = 0; i < N; i++) {
+
+			double a = q[0] * ex[i] + q[1] * ey[i];
+			double b = q[0] * rx[i] + q[1] * ry[i];
+
+			float fb = (float)reduce_2pi(b);
+			float sa = sin_reduced((float)reduce_2pi(a));
+
+			double sc = (0. == a) ? 1. : (sa / a);
+			double xr = sc * cos_reduced(fb);
+			double xi = sc * sin_reduced(fb);
+
+			s0r += ex[i] * xr;
+			s0i += ex[i] * xi;
+			s1r += ey[i] * xr;
+			s1i += ey[i] * xi;
+		}
+
+		complex double sum = -q[1] * (s0r + 1.i * s0i) + q[0] * (s1r + 1.i * s1i);
+
+		out[m] = cexp(-M_PI * 2.i * sdot(cg, q0[m])) * sum / (8.i * q2);
+	}
+
+	xfree(edges);
+}
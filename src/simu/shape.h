@@ -3,4 +3,5 @@
 
 extern complex double xpolygon(int N, const double pg[N][2], const double p[3]);
 extern complex double kpolygon(int N, const double pg[N][2], const double q[3]);
+extern void kpolygon_batch(int N, const double pg[N][2], int M, complex double out[M], const double q[M][3]);
 
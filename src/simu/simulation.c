@@ -10,6 +10,7 @@
 #include <complex.h>
 #include <math.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "misc/debug.h"
 #include "misc/mri.h"
@@ -54,6 +55,7 @@ void debug_sim(struct sim_data* data)
         debug_printf(DP_INFO, "\tTR:%f\n", data->seq.tr);
         debug_printf(DP_INFO, "\tTE:%f\n", data->seq.te);
         debug_printf(DP_INFO, "\t#Rep:%d\n", data->seq.rep_num);
+        debug_printf(DP_INFO, "\t#Dummies:%d\n", data->seq.dummy_num);
         debug_printf(DP_INFO, "\t#Spins:%d\n", data->seq.spin_num);
         debug_printf(DP_INFO, "\tIPL:%f\n", data->seq.inversion_pulse_length);
         debug_printf(DP_INFO, "\tISP:%f\n", data->seq.inversion_spoiler);
@@ -114,6 +116,7 @@ const struct simdata_seq simdata_seq_defaults = {
 	.tr = 0.004,
 	.te = 0.002,
 	.rep_num = 1,
+	.dummy_num = 0,
 	.spin_num = 1,
 
         .perfect_inversion = false,
@@ -716,9 +719,135 @@ static void ode2stm(int N, int P, float out[P * N + 1], float in[P][N])
 }
 
 
+/* ------------ STM Cache -------------- */
+
+/*
+ * Within one simulation the same sequence blocks are requested
+ * several times, e.g. the TE relaxation for both RF phases of
+ * bSSFP or all spins of a slice profile without slice-selection
+ * gradient. Their matrix exponentials are cached, keyed by block
+ * type, timing, gradient moments, RF phase, and voxel parameters.
+ * Free relaxation is time-invariant and only keyed by its duration.
+ */
+
+enum stm_block { STM_RF, STM_RELAX };
+
+struct stm_key {
+
+	enum stm_block block;
+
+	float st;
+	float end;
+	float r2spoil;
+	float mom;
+	float mom_sl;
+	float phase;
+	float flipangle;
+
+	struct simdata_voxel voxel;
+};
+
+#define STM_CACHE_SIZE 8
+
+struct stm_cache {
+
+	int M;
+	int used;
+	int next;
+
+	struct stm_key key[STM_CACHE_SIZE];
+	float* matrix[STM_CACHE_SIZE];
+};
+
+
+static struct stm_cache* stm_cache_create(int M)
+{
+	struct stm_cache* cache = xmalloc(sizeof *cache);
+
+	cache->M = M;
+	cache->used = 0;
+	cache->next = 0;
+
+	for (int i = 0; i < STM_CACHE_SIZE; i++)
+		cache->matrix[i] = NULL;
+
+	return cache;
+}
+
+static void stm_cache_free(struct stm_cache* cache)
+{
+	for (int i = 0; i < STM_CACHE_SIZE; i++)
+		if (NULL != cache->matrix[i])
+			xfree(cache->matrix[i]);
+
+	xfree(cache);
+}
+
+static void stm_block(struct sim_data* data, struct stm_cache* cache, enum stm_block block, int M, float matrix[M][M], float st, float end, float r2spoil)
+{
+	struct stm_key key;
+	memset(&key, 0, sizeof key);	// compared with memcmp
+
+	key.block = block;
+	key.mom = data->grad.mom;
+	key.voxel = data->voxel;
+
+	if (STM_RF == block) {
+
+		key.st = data->pulse.rf_start;
+		key.end = data->pulse.rf_end;
+		key.mom_sl = data->grad.mom_sl;
+		key.phase = data->pulse.phase;
+		key.flipangle = CAST_UP(&data->pulse.sinc)->flipangle;
+
+	} else {
+
+		key.end = end - st;
+		key.r2spoil = r2spoil;
+	}
+
+	if (NULL != cache) {
+
+		assert(M == cache->M);
+
+		for (int i = 0; i < cache->used; i++) {
+
+			if (0 == memcmp(&key, &cache->key[i], sizeof key)) {
+
+				matf_copy(M, M, matrix, (const float (*)[M])cache->matrix[i]);
+
+				data->seq.pulse_applied = (STM_RF == block);
+				return;
+			}
+		}
+	}
+
+	if (STM_RF == block)
+		rf_pulse(data, 0., 0., M, 1, NULL, matrix);
+	else
+		relaxation2(data, 0., 0., M, 1, NULL, st, end, matrix, r2spoil);
+
+	if (NULL == cache)
+		return;
+
+	int i = cache->next;
+
+	if (NULL == cache->matrix[i])
+		cache->matrix[i] = xmalloc(sizeof(float[M][M]));
+
+	cache->key[i] = key;
+	matf_copy(M, M, (float (*)[M])cache->matrix[i], matrix);
+
+	cache->next = (i + 1) % STM_CACHE_SIZE;
+
+	if (cache->used < STM_CACHE_SIZE)
+		cache->used++;
+}
+
+
 /* ------------ Structural Elements -------------- */
 
-static void prepare_sim(struct sim_data* data, int N, int P, float (*mte)[P * N + 1][P * N + 1], float (*mtr)[P * N + 1][P * N + 1])
+static void prepare_sim(struct sim_data* data, struct stm_cache* cache, int N, int P, float (*mte)[P * N + 1][P * N + 1], float (*mtr)[P * N + 1][P * N + 1])
 {
         switch (data->seq.type) {
 
@@ -738,7 +867,7 @@ static void prepare_sim(struct sim_data* data, int N, int P, float (*mte)[P * N
 
                 // Matrix: 0 -> T_RF
                 float mrf[M][M];
-                rf_pulse(data, 0., 0., M, 1, NULL, mrf);
+                stm_block(data, cache, STM_RF, M, mrf, data->pulse.rf_start, data->pulse.rf_end, 0.);
 
                 // Matrix: T_RF -> TE
                 float mrel[M][M];
@@ -752,13 +881,13 @@ static void prepare_sim(struct sim_data* data, int N, int P, float (*mte)[P * N
 			// Time-independent gradient integral
 			data->grad.mom = -data->grad.mom_sl * (0.5 * data->pulse.rf_end) / (data->seq.te - data->pulse.rf_end);
 
-			relaxation2(data, 0, 0, M, 1, NULL, data->pulse.rf_end, data->seq.te, mrel, 0.);
+			stm_block(data, cache, STM_RELAX, M, mrel, data->pulse.rf_end, data->seq.te, 0.);
 
 			data->grad.mom = 0.; // [rad/s]
 
 		} else {
 
-	                relaxation2(data, 0., 0., M, 1, NULL, data->pulse.rf_end, data->seq.te, mrel, 0.);
+	                stm_block(data, cache, STM_RELAX, M, mrel, data->pulse.rf_end, data->seq.te, 0.);
 		}
 
                 // Join matrices: 0 -> TE
@@ -788,13 +917,13 @@ static void prepare_sim(struct sim_data* data, int N, int P, float (*mte)[P * N
 				// Time-independent gradient integral
                                 data->grad.mom = -data->grad.mom_sl * (0.5 * data->pulse.rf_end) / (data->seq.tr - data->seq.te);
 
-                                relaxation2(data, 0., 0., M, 1, NULL, data->seq.te, data->seq.tr, *mtr, r2spoil);
+                                stm_block(data, cache, STM_RELAX, M, *mtr, data->seq.te, data->seq.tr, r2spoil);
 
                                 data->grad.mom = 0.;
 
                         } else {
 
-                                relaxation2(data, 0., 0., M, 1, NULL, data->seq.te, data->seq.tr, *mtr, r2spoil);
+                                stm_block(data, cache, STM_RELAX, M, *mtr, data->seq.te, data->seq.tr, r2spoil);
                         }
                 }
 
@@ -886,6 +1015,80 @@ static void run_sim(struct sim_data* data, int pools,
 }
 
 
+/*
+ * Dummy repetitions without readout. For the STM simulation all
+ * TR blocks are identical (for bSSFP pairs of blocks with
+ * alternating RF phase), so the propagator for D repetitions is
+ * computed by repeated squaring in O(log D) matrix products.
+ */
+static void dummy_scans(struct sim_data* data, int pools, float h, float tol, int N, int P, float xp[P][N],
+			float xstm[P * N + 1], float mte[2][P * N + 1][P * N + 1], float mtr[P * N + 1][P * N + 1])
+{
+	int D = data->seq.dummy_num;
+
+	assert(0 <= D);
+
+	bool bssfp = (   (SEQ_BSSFP == data->seq.seq_type)
+		      || (SEQ_IRBSSFP == data->seq.seq_type));
+
+	if (SIM_STM != data->seq.type) {
+
+		for (int r = 0; r < D; r++) {
+
+			if (bssfp)
+				data->pulse.phase = M_PI * r;
+
+			run_sim(data, pools, NULL, NULL, NULL, NULL, NULL, NULL, NULL, h, tol, N, P, xp, xstm, mte[r % 2], mtr);
+		}
+
+		return;
+	}
+
+	if (0 == D)
+		return;
+
+	int M = P * N + 1;
+
+	float (*block)[M][M] = xmalloc(sizeof *block);
+	float (*jump)[M][M] = xmalloc(sizeof *jump);
+
+	// Single TR: 0 -> TR
+
+	matf_mul(M, M, M, *block, mte[0], mtr);
+
+	if (bssfp) {
+
+		float (*block2)[M][M] = xmalloc(sizeof *block2);
+		float (*tmp)[M][M] = xmalloc(sizeof *tmp);
+
+		// Two TRs with RF phase 0 and PI
+
+		matf_mul(M, M, M, *tmp, mte[1], mtr);
+		matf_mul(M, M, M, *block2, *block, *tmp);
+
+		matf_pow(M, *jump, *block2, D / 2);
+
+		if (1 == D % 2) {
+
+			matf_mul(M, M, M, *tmp, *jump, *block);
+			matf_copy(M, M, *jump, *tmp);
+		}
+
+		xfree(block2);
+		xfree(tmp);
+
+	} else {
+
+		matf_pow(M, *jump, *block, D);
+	}
+
+	apply_sim_matrix(M, xstm, *jump);
+
+	xfree(block);
+	xfree(jump);
+}
+
+
 /* ------------ Sequence Specific Blocks -------------- */
 
 void inversion(const struct sim_data* data, float h, float tol, int N, int P, float xp[P][N], float st, float end)
@@ -939,7 +1142,7 @@ static void alpha_half_preparation(const struct sim_data* data, int pools, float
 
 	if (0. < data->seq.prep_pulse_length) {
 
-		prepare_sim(&prep_data, N, P, NULL, NULL);
+		prepare_sim(&prep_data, NULL, N, P, NULL, NULL);
 
 		run_sim(&prep_data, pools, NULL, NULL, NULL, NULL, NULL, NULL, NULL, h, tol, N, P, xp, NULL, NULL, NULL);
 
@@ -1050,6 +1253,8 @@ void bloch_simulation2(const struct sim_data* _data, int R, int pools, float (*m
 	float (*Fsa_k)[R * A][S][pools][3] = xmalloc(sizeof *Fsa_k);
 	float (*Fsa_Om)[R * A][S][pools][3] = xmalloc(sizeof *Fsa_Om);
 
+	struct stm_cache* cache = (SIM_STM == data.seq.type) ? stm_cache_create(M) : NULL;
+
 	for (int s = 0; s < S; s++) {
 
                 float h = 0.0001;
@@ -1134,11 +1339,11 @@ void bloch_simulation2(const struct sim_data* _data, int R, int pools, float (*m
                     || (SEQ_IRBSSFP == data.seq.seq_type)) {
 
                         data.pulse.phase = M_PI;
-                        prepare_sim(&data, N, P, &mte[1], NULL);
+                        prepare_sim(&data, cache, N, P, &mte[1], NULL);
                         data.pulse.phase = 0.;
                 }
 
-		prepare_sim(&data, N, P, &mte[0], &mtr);
+		prepare_sim(&data, cache, N, P, &mte[0], &mtr);
 
 		if ((SEQ_CEST == data.seq.seq_type ) && data.cest.ref_scan) {
 
@@ -1148,6 +1353,9 @@ void bloch_simulation2(const struct sim_data* _data, int R, int pools, float (*m
 			reset_xp(N, data.voxel.P, xp, data.voxel.m0);
 		}
 
+		if (SEQ_CEST != data.seq.seq_type)
+			dummy_scans(&data, pools, h, tol, N, P, xp, xstm, mte, mtr);
+
                 // Loop over Pulse Blocks
 
                 for (int r = 0; r < data.seq.rep_num; r++) {
@@ -1166,9 +1374,9 @@ void bloch_simulation2(const struct sim_data* _data, int R, int pools, float (*m
                         if (   (SEQ_BSSFP == data.seq.seq_type)
                             || (SEQ_IRBSSFP == data.seq.seq_type)) {
 
-                                data.pulse.phase = M_PI * r;
+                                data.pulse.phase = M_PI * (r + data.seq.dummy_num);
 
-				odd = (1 == r % 2);
+				odd = (1 == (r + data.seq.dummy_num) % 2);
                         }
 
 			if (SEQ_CEST == data.seq.seq_type) {
@@ -1202,6 +1410,9 @@ void bloch_simulation2(const struct sim_data* _data, int R, int pools, float (*m
 			Fmxy, Fsa_r1, Fsa_r2, Fsa_b1, Fsa_m0, Fsa_k, Fsa_Om,
 			m_state, sa_r1_state, sa_r2_state, sa_m0_state, sa_b1_state, sa_k_state, sa_om_state);
 
+	if (NULL != cache)
+		stm_cache_free(cache);
+
 	xfree(Fmxy);
 	xfree(Fsa_r1);
 	xfree(Fsa_r2);
@@ -1211,6 +1422,390 @@ void bloch_simulation2(const struct sim_data* _data, int R, int pools, float (*m
         xfree(Fsa_Om);
 }
 
+/* ------------ Batched Simulation -------------- */
+
+/*
+ * Simulation of W voxels in lock-step with the ODE solver for the
+ * single-pool Bloch model. All voxels share the sequence timing,
+ * only relaxation, B1, and off-resonance differ per lane. The state
+ * is kept as structure of arrays xp[P][N][W] and the RF field is
+ * evaluated once per stage for all lanes.
+ */
+
+static void ode_batch(struct sim_data* data, int W, const struct simdata_voxel voxel[W], float h, float tol, float xp[4][3][W], float st, float end, float r2spoil)
+{
+	float* r1 = *TYPE_ALLOC(float[W]);
+	float* r2 = *TYPE_ALLOC(float[W]);
+	float* b1 = *TYPE_ALLOC(float[W]);
+	float* gz = *TYPE_ALLOC(float[W]);
+
+	for (int w = 0; w < W; w++) {
+
+		r1[w] = voxel[w].r1[0];
+		r2[w] = voxel[w].r2[0] + r2spoil;
+		b1[w] = voxel[w].b1;
+		gz[w] = voxel[w].w;
+	}
+
+	// clang workaround: VLAs cannot be captured
+	const float* r1p = r1;
+	const float* r2p = r2;
+	const float* b1p = b1;
+	const float* gzp = gz;
+
+	void* gb_eff_p = *TYPE_ALLOC(float[3][W]);
+
+	__block complex float w1;
+
+	NESTED(void, call_fun, (float* out, float t, const float* in))
+	{
+		float (*gb_eff)[W] = gb_eff_p;
+
+		float gb[3];
+		compute_fields(data, gb, t);
+
+		w1 = gb[0] - 1.i * gb[1];
+
+		for (int w = 0; w < W; w++) {
+
+			gb_eff[0][w] = gb[0] * b1p[w];
+			gb_eff[1][w] = gb[1] * b1p[w];
+			gb_eff[2][w] = gb[2] + gzp[w];
+		}
+
+		bloch_ode_batch(W, (float(*)[W])out, (const float(*)[W])in, r1p, r2p, (const float(*)[W])gb_eff);
+	};
+
+	NESTED(void, call_pdy, (float* out, float t, const float* in))
+	{
+		(void)t; (void)in;
+
+		bloch_pdy_batch(W, (float(*)[3][W])out, r1p, r2p, (const float(*)[W])gb_eff_p);
+	};
+
+	NESTED(void, call_pdp, (float* out, float t, const float* in))
+	{
+		(void)t;
+
+		bloch_b1_pdp_batch(W, (float(*)[3][W])out, (const float(*)[W])in, w1);
+	};
+
+	ode_direct_sa_batch(h, tol, 3, 3, W, xp, st, end, call_fun, call_pdy, call_pdp);
+
+	xfree(r1);
+	xfree(r2);
+	xfree(b1);
+	xfree(gz);
+	xfree(gb_eff_p);
+}
+
+
+static void rf_pulse_batch(struct sim_data* data, int W, const struct simdata_voxel voxel[W], float h, float tol, float xp[4][3][W])
+{
+	data->seq.pulse_applied = true;
+
+	// Off-resonance is added per voxel
+	data->grad.gb[2] = data->grad.mom_sl;
+
+	if (0. == data->pulse.rf_end) {
+
+		for (int w = 0; w < W; w++) {
+
+			for (int p = 0; p < 4; p++) {
+
+				float x[3] = { xp[p][0][w], xp[p][1][w], xp[p][2][w] };
+
+				bloch_excitation2(x, x, DEG2RAD(CAST_UP(&data->pulse.sinc)->flipangle), data->pulse.phase);
+
+				for (int i = 0; i < 3; i++)
+					xp[p][i][w] = x[i];
+			}
+		}
+
+	} else {
+
+		ode_batch(data, W, voxel, h, tol, xp, data->pulse.rf_start, data->pulse.rf_end, 0.);
+	}
+
+	data->grad.gb[2] = 0.;
+}
+
+
+static void relaxation_batch(struct sim_data* data, int W, const struct simdata_voxel voxel[W], float h, float tol, float xp[4][3][W], float st, float end, float r2spoil)
+{
+	data->seq.pulse_applied = false;
+
+	// Off-resonance is added per voxel
+	data->grad.gb[2] = data->grad.mom;
+
+	if (0. == data->pulse.rf_end) {
+
+		assert(0. <= (end - st));
+
+		for (int w = 0; w < W; w++) {
+
+			float gb[3] = { data->grad.gb[0], data->grad.gb[1], data->grad.gb[2] + voxel[w].w };
+
+			for (int p = 0; p < 4; p++) {
+
+				float x[3] = { xp[p][0][w], xp[p][1][w], xp[p][2][w] };
+				float x2[3];
+
+				bloch_relaxation(x2, end - st, x, voxel[w].r1[0], voxel[w].r2[0] + r2spoil, gb);
+
+				for (int i = 0; i < 3; i++)
+					xp[p][i][w] = x2[i];
+			}
+		}
+
+	} else {
+
+		ode_batch(data, W, voxel, h, tol, xp, st, end, r2spoil);
+	}
+
+	data->grad.gb[2] = 0.;
+}
+
+
+static void inversion_batch(const struct sim_data* data, int W, const struct simdata_voxel voxel[W], float h, float tol, float xp[4][3][W], float st, float end)
+{
+	struct sim_data inv_data = *data;
+
+	inv_data.grad.mom_sl = 0.;
+
+	if (data->seq.perfect_inversion) {
+
+		for (int w = 0; w < W; w++) {
+
+			for (int p = 0; p < 4; p++) {
+
+				float x[3] = { xp[p][0][w], xp[p][1][w], xp[p][2][w] };
+
+				bloch_excitation2(x, x, M_PI, 0.);
+
+				for (int i = 0; i < 3; i++)
+					xp[p][i][w] = x[i];
+			}
+		}
+
+		relaxation_batch(&inv_data, W, voxel, h, tol, xp, st, end, 0.);
+
+	} else {
+
+		inv_data.pulse.type = PULSE_HS;
+
+		inv_data.pulse.hs = pulse_hypsec_defaults;
+		CAST_UP(&inv_data.pulse.hs)->duration = data->seq.inversion_pulse_length;
+		inv_data.pulse.rf_end = data->seq.inversion_pulse_length;
+
+		rf_pulse_batch(&inv_data, W, voxel, h, tol, xp);
+
+		relaxation_batch(&inv_data, W, voxel, h, tol, xp, st, end, 10000.);
+	}
+}
+
+
+static void run_sim_batch(struct sim_data* data, int W, const struct simdata_voxel voxel[W], float h, float tol, float xp[4][3][W], float (*xte)[W][4][3])
+{
+	rf_pulse_batch(data, W, voxel, h, tol, xp);
+
+	if ((0 != data->grad.mom_sl) && (data->seq.te != data->pulse.rf_end)) {
+
+		// Slice-Rewinder
+		data->grad.mom = -data->grad.mom_sl * (0.5 * data->pulse.rf_end) / (data->seq.te - data->pulse.rf_end);
+
+		relaxation_batch(data, W, voxel, h, tol, xp, data->pulse.rf_end, data->seq.te, 0.);
+
+		data->grad.mom = 0.;
+
+	} else {
+
+		relaxation_batch(data, W, voxel, h, tol, xp, data->pulse.rf_end, data->seq.te, 0.);
+	}
+
+	if (NULL != xte)
+		for (int w = 0; w < W; w++)
+			for (int p = 0; p < 4; p++)
+				for (int i = 0; i < 3; i++)
+					(*xte)[w][p][i] = xp[p][i][w];
+
+	float r2spoil = 0.;
+
+	if (   (SEQ_FLASH == data->seq.seq_type)
+	    || (SEQ_IRFLASH == data->seq.seq_type))
+		r2spoil = 10000.;
+
+	if (   (   (SEQ_BSSFP == data->seq.seq_type)
+		|| (SEQ_IRBSSFP == data->seq.seq_type))
+	    && (data->seq.te != data->seq.tr)) {
+
+		data->grad.mom = -data->grad.mom_sl * (0.5 * data->pulse.rf_end) / (data->seq.tr - data->seq.te);
+
+		relaxation_batch(data, W, voxel, h, tol, xp, data->seq.te, data->seq.tr, r2spoil);
+
+		data->grad.mom = 0.;
+
+	} else {
+
+		relaxation_batch(data, W, voxel, h, tol, xp, data->seq.te, data->seq.tr, r2spoil);
+	}
+}
+
+
+static void alpha_half_preparation_batch(const struct sim_data* data, int W, const struct simdata_voxel voxel[W], float h, float tol, float xp[4][3][W])
+{
+	struct sim_data prep_data = *data;
+
+	assert(0. <= data->seq.prep_pulse_length);
+
+	prep_data.seq.type = SIM_ODE;
+	CAST_UP(&prep_data.pulse.sinc)->flipangle = CAST_UP(&data->pulse.sinc)->flipangle / 2.;
+	prep_data.pulse.phase = M_PI;
+	prep_data.seq.te = (data->pulse.rf_end + data->seq.prep_pulse_length) / 2.;
+	prep_data.seq.tr = data->seq.prep_pulse_length;
+
+	if (0. < data->seq.prep_pulse_length) {
+
+		prepare_sim(&prep_data, NULL, 3, 4, NULL, NULL);
+
+		run_sim_batch(&prep_data, W, voxel, h, tol, xp, NULL);
+
+	} else {
+
+		for (int w = 0; w < W; w++) {
+
+			for (int p = 0; p < 4; p++) {
+
+				float x[3] = { xp[p][0][w], xp[p][1][w], xp[p][2][w] };
+
+				bloch_excitation2(x, x, DEG2RAD(CAST_UP(&prep_data.pulse.sinc)->flipangle), prep_data.pulse.phase);
+
+				for (int i = 0; i < 3; i++)
+					xp[p][i][w] = x[i];
+			}
+		}
+	}
+}
+
+
+void bloch_simulation_batch(const struct sim_data* _data, int W, const struct simdata_voxel voxel[W], int R,
+			float (*m_state)[W][R][3], float (*sa_r1_state)[W][R][3], float (*sa_r2_state)[W][R][3],
+			float (*sa_m0_state)[W][R][3], float (*sa_b1_state)[W][R][3])
+{
+	struct sim_data data = *_data;
+
+	assert(MODEL_BLOCH == data.seq.model);
+	assert(SIM_ODE == data.seq.type);
+	assert(SEQ_CEST != data.seq.seq_type);
+	assert(R == data.seq.rep_num);
+
+	float tol = _data->other.ode_tol;
+
+	int N = 3;
+	int P = 4;
+
+	int A = data.seq.averaged_spokes;
+
+	float default_slice_thickness = 0.001; // [m]
+
+	data.seq.rep_num *= A;
+	data.seq.averaged_spokes = 1;
+
+	int S = data.seq.spin_num;
+
+	float (*Fmxy)[W][R * A][S][1][3] = xmalloc(sizeof *Fmxy);
+	float (*Fsa_r1)[W][R * A][S][1][3] = xmalloc(sizeof *Fsa_r1);
+	float (*Fsa_r2)[W][R * A][S][1][3] = xmalloc(sizeof *Fsa_r2);
+	float (*Fsa_b1)[W][R * A][S][1][3] = xmalloc(sizeof *Fsa_b1);
+
+	// not used for a single pool, but read by sum_up_signal
+	float (*Fzero)[R * A][S][1][3] = xmalloc(sizeof *Fzero);
+
+	for (int r = 0; r < R * A; r++)
+		for (int s = 0; s < S; s++)
+			for (int i = 0; i < 3; i++)
+				(*Fzero)[r][s][0][i] = 0.;
+
+	float (*xte)[W][P][N] = xmalloc(sizeof *xte);
+
+	for (int s = 0; s < S; s++) {
+
+		float h = 0.0001;
+
+		if (1 != S) {
+
+			assert(1 == S % 2);
+			assert(0. != _data->seq.slice_thickness);
+
+			data.grad.mom_sl = (_data->grad.sl_gradient_strength * _data->seq.slice_thickness * GAMMA_H1) / (S - 1) * (s - (int)(S / 2.));
+
+		} else {
+
+			data.seq.slice_thickness = default_slice_thickness;
+			data.grad.mom_sl = _data->grad.sl_gradient_strength * _data->seq.slice_thickness * GAMMA_H1;
+		}
+
+		float (*xp)[N][W] = *TYPE_ALLOC(float[P][N][W]);
+
+		for (int p = 0; p < P; p++)
+			for (int n = 0; n < N; n++)
+				for (int w = 0; w < W; w++)
+					xp[p][n][w] = 0.;
+
+		for (int w = 0; w < W; w++)
+			xp[0][2][w] = 1.;
+
+		data.pulse.phase = 0;
+
+		if (   (SEQ_IRBSSFP == data.seq.seq_type)
+		    || (SEQ_IRFLASH == data.seq.seq_type))
+			inversion_batch(&data, W, voxel, h, tol, xp, 0., data.seq.inversion_spoiler);
+
+		if (   (SEQ_BSSFP == data.seq.seq_type)
+		    || (SEQ_IRBSSFP == data.seq.seq_type))
+			alpha_half_preparation_batch(&data, W, voxel, h, tol, xp);
+
+		prepare_sim(&data, NULL, N, P, NULL, NULL);
+
+		int D = data.seq.dummy_num;
+
+		for (int r = 0; r < D + data.seq.rep_num; r++) {
+
+			if (   (SEQ_BSSFP == data.seq.seq_type)
+			    || (SEQ_IRBSSFP == data.seq.seq_type))
+				data.pulse.phase = M_PI * r;
+
+			if (r < D) {
+
+				run_sim_batch(&data, W, voxel, h, tol, xp, NULL);
+				continue;
+			}
+
+			run_sim_batch(&data, W, voxel, h, tol, xp, xte);
+
+			for (int w = 0; w < W; w++)
+				collect_signal(&data, P, 1, &(*Fmxy)[w][r - D][s], &(*Fsa_r1)[w][r - D][s], &(*Fsa_r2)[w][r - D][s], &(*Fsa_b1)[w][r - D][s], NULL, NULL, NULL, (*xte)[w]);
+		}
+
+		xfree(xp);
+	}
+
+	float D = (float)S / (data.seq.slice_thickness / default_slice_thickness);
+
+	for (int w = 0; w < W; w++)
+		sum_up_signal(voxel[w].m0[0], R, S, A, D, 1,
+				&(*Fmxy)[w], &(*Fsa_r1)[w], &(*Fsa_r2)[w], &(*Fsa_b1)[w], Fzero, Fzero, Fzero,
+				(void*)&(*m_state)[w], (void*)&(*sa_r1_state)[w], (void*)&(*sa_r2_state)[w], (void*)&(*sa_m0_state)[w], (void*)&(*sa_b1_state)[w], NULL, NULL);
+
+	xfree(xte);
+	xfree(Fmxy);
+	xfree(Fsa_r1);
+	xfree(Fsa_r2);
+	xfree(Fsa_b1);
+	xfree(Fzero);
+}
+
+
 // Wrapper for single pool simulation
 void bloch_simulation(const struct sim_data* data, int R, float (*m)[R][3], float (*sa_r1)[R][3], float (*sa_r2)[R][3], float (*sa_m0)[R][3],	float (*sa_b1)[R][3])
 {
@@ -36,6 +36,7 @@ struct simdata_seq {
 	float tr;
 	float te;
 	int rep_num;
+	int dummy_num;
 	int spin_num;
 
 	bool perfect_inversion;
@@ -134,6 +135,7 @@ extern void relaxation2(struct sim_data* data, float h, float tol, int N, int P,
 extern void inversion(const struct sim_data* data, float h, float tol, int N, int P, float xp[P][N], float st, float end);
 extern void bloch_simulation(const struct sim_data* _data, int R, float (*m_state)[R][3], float (*sa_r1_state)[R][3], float (*sa_r2_state)[R][3], float (*sa_m0_state)[R][3],	float (*sa_b1_state)[R][3]);
 extern void bloch_simulation2(const struct sim_data* _data, int R, int pools, float (*m_state)[R][pools][3], float (*sa_r1_state)[R][pools][3], float (*sa_r2_state)[R][pools][3], float (*sa_m0_state)[R][pools][3], float (*sa_b1_state)[R][1][3], float (*sa_k_state)[R][pools][3], float (*sa_om_state)[R][pools][3]);
+extern void bloch_simulation_batch(const struct sim_data* data, int W, const struct simdata_voxel voxel[W], int R, float (*m_state)[W][R][3], float (*sa_r1_state)[W][R][3], float (*sa_r2_state)[W][R][3], float (*sa_m0_state)[W][R][3], float (*sa_b1_state)[W][R][3]);
 
 extern void mat_exp_simu(struct sim_data* data, float r2spoil, int N, float st, float end, float out[N][N]);
 extern void apply_sim_matrix(int N, float m[N], float matrix[N][N]);
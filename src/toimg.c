@@ -43,59 +43,103 @@ static const char help_str[] = "Create magnitude images as png or proto-dicom.\n
 				"be used for the image, and the other dimensions\n"
 				"will be looped over.";
 
-// from view:src/draw.c
-static double clamp(double a, double b, double x)
+/*
+ * Magnitude, scaling and windowing as in view:src/draw.c, but as
+ * simple passes over contiguous memory so that the compiler can
+ * vectorize them. Only the (optional) gamma needs a separate pass.
+ */
+__attribute__((optimize("-fvect-cost-model=dynamic")))
+static void toimg_window(long N, uint16_t out[N], const complex float in[N], bool use_windowing, double gamma, double contrast, double window, float scale, double max_val)
 {
-	return (x < a) ? a : ((x > b) ? b : x);
-}
+	double* val = xmalloc((size_t)N * sizeof(double));
 
-static double windowing(double g, double a, double b, double x)
-{
-	return pow(clamp(0., 1., (x - a) / (b - a)), g);
+	for (long i = 0; i < N; i++) {
+
+		double re = crealf(in[i]);
+		double im = cimagf(in[i]);
+
+		float mag = sqrt(re * re + im * im);
+
+		val[i] = mag / scale;
+	}
+
+	if (use_windowing) {
+
+		for (long i = 0; i < N; i++) {
+
+			double x = (val[i] - contrast) / (window - contrast);
+
+			val[i] = (x < 0.) ? 0. : ((x > 1.) ? 1. : x);
+		}
+
+		if (1. != gamma)
+			for (long i = 0; i < N; i++)
+				val[i] = pow(val[i], gamma);
+	}
+
+	for (long i = 0; i < N; i++)
+		out[i] = (uint16_t)(max_val * val[i]);
+
+	xfree(val);
 }
 
-static void toimg(bool dicom, bool use_windowing, const char* name, long inum, float gamma, float contrast, float window, float scale, long h, long w, const complex float* data)
-{
-	int len = strlen(name);
-	assert(len >= 1);
+// transpose and convert to 24 bit gray RGB or 16 bit little endian
 
+static void toimg_pack(bool dicom, long h, long w, unsigned char* buf, const uint16_t val[w][h])
+{
 	int nr_bytes = dicom ? 2 : 3;
-	unsigned char (*buf)[h][w][nr_bytes] = TYPE_ALLOC(unsigned char[h][w][nr_bytes]);
-
-	float max_val = dicom ? 65535. : 255.;
 
-	for (int i = 0; i < h; i++) {
+	for (long i = 0; i < h; i++) {
 
-		for (int j = 0; j < w; j++) {
+		for (long j = 0; j < w; j++) {
 
-			double val = cabsf(data[j * h + i]) / scale;
-			unsigned int value = (unsigned int)(max_val * (use_windowing ? windowing(gamma, contrast, window, val) : val));
+			unsigned char* px = buf + (i * w + j) * nr_bytes;
+			unsigned int value = val[j][i];
 
 			if (!dicom) {
 
-				(*buf)[i][j][0] = value;
-				(*buf)[i][j][1] = value;
-				(*buf)[i][j][2] = value;
+				px[0] = value;
+				px[1] = value;
+				px[2] = value;
 
 			} else {
 
-				(*buf)[i][j][0] = (value >> 0) & 0xFF;
-				(*buf)[i][j][1] = (value >> 8) & 0xFF;
+				px[0] = (value >> 0) & 0xFF;
+				px[1] = (value >> 8) & 0xFF;
 			}
 		}
 	}
+}
+
+static void toimg(bool dicom, bool fast_png, bool use_windowing, const char* name, long inum, float gamma, float contrast, float window, float scale, long h, long w, const complex float* data, unsigned char* frame)
+{
+	int len = strlen(name);
+	assert(len >= 1);
+
+	int nr_bytes = dicom ? 2 : 3;
+	unsigned char (*buf)[h][w][nr_bytes] = (NULL != frame) ? (void*)frame : TYPE_ALLOC(unsigned char[h][w][nr_bytes]);
+
+	uint16_t (*val)[w][h] = TYPE_ALLOC(uint16_t[w][h]);
+
+	toimg_window(h * w, &(*val)[0][0], data, use_windowing, gamma, contrast, window, scale, dicom ? 65535. : 255.);
+	toimg_pack(dicom, h, w, &(*buf)[0][0][0], *val);
+
+	xfree(val);
+
+	if (NULL != frame)
+		return;
 
 #ifdef NO_PNG
 	assert(dicom);
 	dicom_write(name, w, h, inum, &(*buf)[0][0][0]);
 #else
-	(dicom  ? dicom_write : png_write_rgb24)(name, w, h, inum, &(*buf)[0][0][0]);
+	(dicom  ? dicom_write : (fast_png ? png_write_rgb24_fast : png_write_rgb24))(name, w, h, inum, &(*buf)[0][0][0]);
 #endif
 	free(buf);
 }
 
 
-static void toimg_stack(const char* name, bool dicom, bool dim_names, bool single_scale, bool use_windowing, float gamma, float contrast, float window, const long dims[DIMS], const complex float* data)
+static void toimg_stack(const char* name, bool dicom, bool multiframe, bool fast_png, bool dim_names, bool single_scale, bool use_windowing, float gamma, float contrast, float window, const long dims[DIMS], const complex float* data)
 {
 	long data_size = md_calc_size(DIMS, dims); 
 
@@ -115,6 +159,8 @@ static void toimg_stack(const char* name, bool dicom, bool dim_names, bool singl
 	}
 
 	float max = 0.;
+
+#pragma omp parallel for reduction(max:max)
 	for (long i = 0; i < data_size; i++)
 		max = MAX(cabsf(data[i]), max);
 
@@ -131,6 +177,15 @@ static void toimg_stack(const char* name, bool dicom, bool dim_names, bool singl
 
 	debug_printf(DP_INFO, "Writing %ld image(s)...", num_imgs);
 
+	double start = timestamp();
+
+	// all frames of a multi-frame DICOM are converted in parallel and written at once
+
+	unsigned char* frames = NULL;
+
+	if (multiframe)
+		frames = xmalloc((size_t)(num_imgs * img_size * 2));
+
 #pragma omp parallel for
 	for (long i = 0; i < num_imgs; i++) {
 
@@ -148,6 +203,12 @@ static void toimg_stack(const char* name, bool dicom, bool dim_names, bool singl
 			scale = 1.;
 
 
+		if (multiframe) {
+
+			toimg(dicom, fast_png, use_windowing, name, i, gamma, contrast, window, scale, sq_dims[0], sq_dims[1], data + i * img_size, frames + i * img_size * 2);
+			continue;
+		}
+
 		char *name_i = NULL;
 
 		if (!dim_names) {
@@ -167,11 +228,26 @@ static void toimg_stack(const char* name, bool dicom, bool dim_names, bool singl
 			name_i = construct_filename(DIMS, loop_dims, pos, name, dicom ? "dcm" : "png");
 		}
 
-		toimg(dicom, use_windowing, name_i, i, gamma, contrast, window, scale, sq_dims[0], sq_dims[1], data + i * img_size);
+		toimg(dicom, fast_png, use_windowing, name_i, i, gamma, contrast, window, scale, sq_dims[0], sq_dims[1], data + i * img_size, NULL);
 		xfree(name_i);
 	}
 
+	if (multiframe) {
+
+		char* name_mf = xmalloc((size_t)(len + 5));
+		sprintf(name_mf, "%s.dcm", name);
+
+		if (0 != dicom_write_multiframe(name_mf, sq_dims[1], sq_dims[0], num_imgs, frames))
+			error("Writing %s failed.\n", name_mf);
+
+		xfree(name_mf);
+		xfree(frames);
+	}
+
+	double elapsed = timestamp() - start;
+
 	debug_printf(DP_INFO, "done.\n");
+	debug_printf(DP_DEBUG1, "%.3f s, %.1f frames/s\n", elapsed, num_imgs / elapsed);
 }
 
 
@@ -193,6 +269,8 @@ int main_toimg(int argc, char* argv[argc])
 	bool single_scale = true;
 	bool dicom = false;
 	bool dim_names = false;
+	bool multiframe = false;
+	bool fast_png = false;
 
 	const struct opt_s opts[] = {
 
@@ -203,6 +281,8 @@ int main_toimg(int argc, char* argv[argc])
 		OPT_CLEAR('m', &single_scale, "re-scale each image"),
 		OPT_SET('W', &use_windowing, "use dynamic windowing"),
 		OPT_SET('D', &dim_names, "Include dimensions in output filenames"),
+		OPTL_SET(0, "multiframe", &multiframe, "write a single multi-frame DICOM"),
+		OPTL_SET(0, "fast-png", &fast_png, "faster PNG compression (larger files)"),
 	};
 
 	cmdline(&argc, argv, ARRAY_SIZE(args), args, help_str, ARRAY_SIZE(opts), opts);
@@ -223,10 +303,13 @@ int main_toimg(int argc, char* argv[argc])
 		*ext = '\0';
 	}
 
+	if (multiframe && !dicom)
+		error("Multi-frame output requires DICOM.\n");
+
 	long dims[DIMS];
 	complex float* data = load_cfl(in_file, DIMS, dims);
 
-	toimg_stack(out_prefix, dicom, dim_names, single_scale, use_windowing, gamma, contrast, window, dims, data);
+	toimg_stack(out_prefix, dicom, multiframe, fast_png, dim_names, single_scale, use_windowing, gamma, contrast, window, dims, data);
 
 	unmap_cfl(DIMS, dims, data);
 
@@ -86,24 +86,82 @@ static int coord(int j, int x, int flen, int l)
 }
 
 
+/*
+ * The filters are applied to whole rows along the contiguous
+ * dimension k, so the inner loops are unit-stride and vectorize.
+ * The symmetric boundary is handled once per row (and not for every
+ * sample) by computing the mirrored index with coord(). For k = 1,
+ * i.e. when transforming along the contiguous dimension, interior
+ * and boundary coefficients are computed separately.
+ */
+
+static void wavelet_down_line(long x, long ostr, complex float* out, long istr, const complex float* in, int flen, const float filter[flen])
+{
+	long bs = bandsize(x, flen);
+
+	// interior: 0 <= 2 j + 1 - (flen - 1) and 2 j + 1 < x
+
+	long j0 = MIN(bs, (flen - 1) / 2);
+	long j1 = MAX(j0, MIN(bs, x / 2));
+
+	for (long j = 0; j < bs; j++) {
+
+		if ((j0 <= j) && (j < j1))
+			continue;
+
+		complex float acc = 0.;
+
+		for (int l = 0; l < flen; l++)
+			acc += in[istr * coord(j, x, flen, l)] * filter[flen - l - 1];
+
+		out[ostr * j] = acc;
+	}
+
+	for (long j = j0; j < j1; j++)
+		out[ostr * j] = 0.;
+
+	for (int l = 0; l < flen; l++) {
+
+		float f = filter[flen - l - 1];
+		long o = 1 - (flen - 1) + l;
+
+		for (long j = j0; j < j1; j++)
+			out[ostr * j] += in[istr * (2 * j + o)] * f;
+	}
+}
+
 static void wavelet_down3(const long dims[3], const long out_str[3], complex float* out, const long in_str[3], const complex float* in, int flen, const float filter[flen])
 {
-#pragma omp parallel for collapse(3)
+	assert(CFL_SIZE == out_str[0]);
+	assert(CFL_SIZE == in_str[0]);
+
+	if (1 == dims[0]) {
+
+#pragma omp parallel for
+		for (int i = 0; i < dims[2]; i++)
+			wavelet_down_line(dims[1], out_str[1] / (long)CFL_SIZE, access(out_str, out, i, 0, 0),
+					in_str[1] / (long)CFL_SIZE, caccess(in_str, in, i, 0, 0), flen, filter);
+
+		return;
+	}
+
+#pragma omp parallel for collapse(2)
 	for (int i = 0; i < dims[2]; i++) {
 
 		for (int j = 0; j < bandsize(dims[1], flen); j++) {
 
-			for (int k = 0; k < dims[0]; k++) {
+			complex float* o = access(out_str, out, i, j, 0);
 
-				*access(out_str, out, i, j, k) = 0.;
+			for (long k = 0; k < dims[0]; k++)
+				o[k] = 0.;
 
-				for (int l = 0; l < flen; l++) {
+			for (int l = 0; l < flen; l++) {
 
-					int n = coord(j, dims[1], flen, l);
-	
-					*access(out_str, out, i, j, k) +=
-						*(caccess(in_str, in, i, n, k)) * filter[flen - l - 1];
-				}
+				const complex float* x = caccess(in_str, in, i, coord(j, dims[1], flen, l), 0);
+				float f = filter[flen - l - 1];
+
+				for (long k = 0; k < dims[0]; k++)
+					o[k] += x[k] * f;
 			}
 		}
 	}
@@ -113,30 +171,54 @@ static void wavelet_up3(const long dims[3], const long out_str[3], complex float
 {
 //	md_clear2(3, dims, out_str, out, CFL_SIZE);
 
-#pragma omp parallel for collapse(3)
+	assert(CFL_SIZE == out_str[0]);
+	assert(CFL_SIZE == in_str[0]);
+
+	long bs = bandsize(dims[1], flen);
+
+#pragma omp parallel for collapse(2)
 	for (int i = 0; i < dims[2]; i++) {
 
 		for (int n = 0; n < dims[1]; n++) {
 
-			for (int k = 0; k < dims[0]; k++) {
+			complex float* o = access(out_str, out, i, n, 0);
+
+			int odd = (n + 1) % 2;
 
-		//		*access(out_str, out, i, j, k) = 0.;
+			if (1 == dims[0]) {
 
-				int odd = (n + 1) % 2;
+				complex float acc = *o;
 
 				for (int l = odd; l < flen; l += 2) {
 
 					int j = (n + l - 1) / 2;
-#if 0
-					assert(1 == (n + l) % 2);
-					assert(n == coord(j, dims[1], flen, flen - l - 1));
-#endif
-					if ((j < 0) || (bandsize(dims[1], flen) <= j))
+
+					if ((j < 0) || (bs <= j))
 						continue;
 
-					*access(out_str, out, i, n, k) +=
-						*caccess(in_str, in, i, j, k) * filter[flen - l - 1];
+					acc += *caccess(in_str, in, i, j, 0) * filter[flen - l - 1];
 				}
+
+				*o = acc;
+
+				continue;
+			}
+
+			for (int l = odd; l < flen; l += 2) {
+
+				int j = (n + l - 1) / 2;
+#if 0
+				assert(1 == (n + l) % 2);
+				assert(n == coord(j, dims[1], flen, flen - l - 1));
+#endif
+				if ((j < 0) || (bs <= j))
+					continue;
+
+				const complex float* x = caccess(in_str, in, i, j, 0);
+				float f = filter[flen - l - 1];
+
+				for (long k = 0; k < dims[0]; k++)
+					o[k] += x[k] * f;
 			}
 		}
 	}
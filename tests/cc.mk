@@ -43,6 +43,16 @@ tests/test-cc-svd-matrix: cc extract fmac transpose nrmse $(TESTS_OUT)/shepploga
 	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
 	touch $@
 
+tests/test-cc-stream: cc copy repmat nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
+	$(TOOLDIR)/repmat 13 3 $(TESTS_OUT)/shepplogan_coil_ksp.ra ksp.ra		;\
+	$(TOOLDIR)/cc -G -p 4 ksp.ra ksp-cc.ra						;\
+	$(TOOLDIR)/copy --stream 8192 -- ksp.ra - |					 \
+	$(TOOLDIR)/cc --stream 8192 -G -p 4 -- - - |					 \
+	$(TOOLDIR)/nrmse -t 0.000001 -- - ksp-cc.ra					;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
 tests/test-cc-rovir: bart $(TESTS_OUT)/shepplogan_coil_ksp.ra
 	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP) ; export BART_TOOLBOX_DIR=$(ROOTDIR)	;\
 	$(ROOTDIR)/bart ones 2 16 8 o							;\
@@ -90,5 +100,5 @@ tests/test-cc-rovir-noncart: bart
 
 
 TESTS += tests/test-cc-svd tests/test-cc-geom tests/test-cc-esp tests/test-cc-svd-matrix
-TESTS += tests/test-cc-rovir tests/test-cc-rovir-noncart
+TESTS += tests/test-cc-rovir tests/test-cc-rovir-noncart tests/test-cc-stream
 
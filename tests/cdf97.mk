@@ -7,5 +7,22 @@ tests/test-cdf97: cdf97 nrmse $(TESTS_OUT)/shepplogan.ra
 	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
 	touch $@
 
-TESTS += tests/test-cdf97
+tests/test-cdf97-batch: phantom noise repmat transpose cdf97 slice nrmse
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
+	$(TOOLDIR)/phantom -x 97 p.ra							;\
+	$(TOOLDIR)/noise -s 1 -n 1 p.ra n.ra						;\
+	$(TOOLDIR)/repmat 2 5 n.ra r.ra							;\
+	$(TOOLDIR)/noise -s 2 -n 1 r.ra r2.ra						;\
+	$(TOOLDIR)/transpose 1 2 r2.ra t.ra						;\
+	$(TOOLDIR)/cdf97 5 t.ra w.ra							;\
+	$(TOOLDIR)/cdf97 -i 5 w.ra a.ra							;\
+	$(TOOLDIR)/nrmse -t 0.000001 t.ra a.ra						;\
+	$(TOOLDIR)/slice 1 3 w.ra w1.ra							;\
+	$(TOOLDIR)/slice 1 3 t.ra t1.ra							;\
+	$(TOOLDIR)/cdf97 5 t1.ra a1.ra							;\
+	$(TOOLDIR)/nrmse -t 0. w1.ra a1.ra						;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+TESTS += tests/test-cdf97 tests/test-cdf97-batch
 
@@ -47,8 +47,55 @@ tests/test-ecalib-gpu: ecalib pocsense nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra
 	$(TOOLDIR)/nrmse -t 0.00001 coils1.ra coils2.ra					;\
 	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
 	touch $@
+tests/test-ecalib-frames: ecalib noise join slice nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra
+	set -e ; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
+	$(TOOLDIR)/noise -s 1 -n 100 $(TESTS_OUT)/shepplogan_coil_ksp.ra ksp0.ra	;\
+	$(TOOLDIR)/noise -s 2 -n 100 $(TESTS_OUT)/shepplogan_coil_ksp.ra ksp1.ra	;\
+	$(TOOLDIR)/join 10 ksp0.ra ksp1.ra ksp.ra					;\
+	$(TOOLDIR)/ecalib -m1 ksp.ra coils.ra						;\
+	$(TOOLDIR)/ecalib -m1 ksp1.ra coils1.ra						;\
+	$(TOOLDIR)/slice 10 1 coils.ra coils2.ra					;\
+	$(TOOLDIR)/nrmse -t 0. coils1.ra coils2.ra					;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+tests/test-ecalib-warm-start: ecalib noise join slice pocsense nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra
+	set -e ; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
+	$(TOOLDIR)/noise -s 1 -n 100 $(TESTS_OUT)/shepplogan_coil_ksp.ra ksp0.ra	;\
+	$(TOOLDIR)/noise -s 2 -n 100 $(TESTS_OUT)/shepplogan_coil_ksp.ra ksp1.ra	;\
+	$(TOOLDIR)/join 10 ksp0.ra ksp1.ra ksp.ra					;\
+	$(TOOLDIR)/ecalib -m1 --warm-start ksp.ra coils.ra				;\
+	$(TOOLDIR)/ecalib -m1 ksp1.ra coils1.ra						;\
+	$(TOOLDIR)/slice 10 1 coils.ra coils2.ra					;\
+	$(TOOLDIR)/nrmse -t 0.05 coils1.ra coils2.ra					;\
+	$(TOOLDIR)/pocsense -i1 ksp1.ra coils2.ra proj.ra				;\
+	$(TOOLDIR)/nrmse -t 0.05 proj.ra $(TESTS_OUT)/shepplogan_coil_ksp.ra		;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+tests/test-ecalib-fft-gram: ecalib nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra
+	set -e ; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
+	$(TOOLDIR)/ecalib -m1 $(TESTS_OUT)/shepplogan_coil_ksp.ra coils1.ra		;\
+	$(TOOLDIR)/ecalib -m1 --fft-gram $(TESTS_OUT)/shepplogan_coil_ksp.ra coils2.ra	;\
+	$(TOOLDIR)/ecalib -m1 --fft-gram --subspace=60 $(TESTS_OUT)/shepplogan_coil_ksp.ra coils3.ra	;\
+	$(TOOLDIR)/nrmse -t 0.0001 coils1.ra coils2.ra					;\
+	$(TOOLDIR)/nrmse -t 0.001 coils1.ra coils3.ra					;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+tests/test-calmat-gram: calmat transpose fmac squeeze nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra
+	set -e ; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
+	$(TOOLDIR)/calmat -k4:3:1 -r12:10:1 $(TESTS_OUT)/shepplogan_coil_ksp.ra cm.ra	;\
+	$(TOOLDIR)/transpose 1 2 cm.ra cmT.ra						;\
+	$(TOOLDIR)/fmac -C -s1 cm.ra cmT.ra gram.ra					;\
+	$(TOOLDIR)/squeeze gram.ra gram1.ra						;\
+	$(TOOLDIR)/calmat -G -k4:3:1 -r12:10:1 $(TESTS_OUT)/shepplogan_coil_ksp.ra gram2.ra	;\
+	$(TOOLDIR)/nrmse -t 0.000001 gram1.ra gram2.ra					;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
 
 
 TESTS += tests/test-ecalib tests/test-ecalib-auto tests/test-ecalib-rotation
-TESTS += tests/test-ecalib-rotation2
+TESTS += tests/test-ecalib-rotation2 tests/test-ecalib-frames tests/test-ecalib-warm-start
+TESTS += tests/test-ecalib-fft-gram tests/test-calmat-gram
 TESTS_GPU += tests/test-ecalib-gpu
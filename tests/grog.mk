@@ -76,7 +76,20 @@ tests/test-grog-input-dims: traj repmat reshape phantom transpose calc grog nrms
 	touch $@
 
 
+# Tabulated shift operators agree with exact ones
+tests/test-grog-table: traj phantom calc grog nrmse
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP) 	;\
+	$(TOOLDIR)/traj -x 32 -y 57 -o2 -r t.ra 	;\
+	$(TOOLDIR)/phantom -k -s 8 -t t.ra k.ra		;\
+	$(TOOLDIR)/calc zround t.ra t2.ra		;\
+	$(TOOLDIR)/grog t.ra k.ra t2.ra k2.ra 		;\
+	$(TOOLDIR)/grog -q20 t.ra k.ra t2.ra k3.ra 	;\
+	$(TOOLDIR)/nrmse -t 0.005 k2.ra k3.ra 		;\
+	rm *.ra; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+
 TESTS += tests/test-grog
 TESTS += tests/test-grog-repeat tests/test-grog-repeat2
-TESTS += tests/test-grog-input-dims
+TESTS += tests/test-grog-input-dims tests/test-grog-table
 
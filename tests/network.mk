@@ -242,6 +242,48 @@ tests/test-reconet-nnvn-train-max-eigen: nrmse $(TESTS_OUT)/pattern.ra reconet \
 	rm *.ra ; rm *.hdr ; rm *.cfl ; cd .. ; rmdir $(TESTS_TMP)
 	touch $@
 
+tests/test-reconet-nnvn-train-checkpoint: nrmse $(TESTS_OUT)/pattern.ra reconet \
+	$(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_ref.ra $(TESTS_OUT)/train_sens.ra
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP); export OMP_NUM_THREADS=2 													;\
+	$(TOOLDIR)/reconet --network varnet --test -n -t --train-algo e=4 -b2 --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_sens.ra weights0 $(TESTS_OUT)/train_ref.ra		;\
+	$(TOOLDIR)/reconet --network varnet --test -n -t --train-algo e=2,checkpoint=ck -b2 --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_sens.ra weights1 $(TESTS_OUT)/train_ref.ra	;\
+	$(TOOLDIR)/reconet --network varnet --test -n -t --train-algo e=4,checkpoint=ck -b2 --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_sens.ra weights2 $(TESTS_OUT)/train_ref.ra	;\
+	$(TOOLDIR)/nrmse -t 0. weights0 weights2					;\
+	rm ck *.hdr ; rm *.cfl ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+tests/test-reconet-nnvn-train-mem-budget: nrmse $(TESTS_OUT)/pattern.ra reconet \
+	$(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_ref.ra $(TESTS_OUT)/train_sens.ra
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP); export OMP_NUM_THREADS=2 													;\
+	$(TOOLDIR)/reconet --network varnet --test -n -t --train-algo e=2 -b2 --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_sens.ra weights0 $(TESTS_OUT)/train_ref.ra		;\
+	$(TOOLDIR)/reconet --network varnet --test -n -t --train-algo e=2 -b2 --mem-budget=0.1 --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_sens.ra weights1 $(TESTS_OUT)/train_ref.ra	;\
+	$(TOOLDIR)/nrmse -t 0.000001 weights0 weights1					;\
+	rm *.hdr ; rm *.cfl ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+tests/test-reconet-nnmodl-quantize: nrmse $(TESTS_OUT)/pattern.ra reconet \
+	$(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_ref.ra $(TESTS_OUT)/train_sens.ra \
+	$(TESTS_OUT)/test_kspace.ra $(TESTS_OUT)/test_sens.ra
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP); export OMP_NUM_THREADS=2 													;\
+	$(TOOLDIR)/reconet --network modl --test -t -n --train-algo e=2 -b2 --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_sens.ra weights $(TESTS_OUT)/train_ref.ra		;\
+	$(TOOLDIR)/reconet --network modl --test -a -n --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/test_kspace.ra $(TESTS_OUT)/test_sens.ra weights out32.ra					;\
+	$(TOOLDIR)/reconet --network modl --test -a -n --quantize-int8 --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/test_kspace.ra $(TESTS_OUT)/test_sens.ra weights out8.ra		;\
+	$(TOOLDIR)/nrmse -t 0.01 out32.ra out8.ra					;\
+	rm *.ra ; rm *.hdr ; rm *.cfl ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+# default depth of the residual block (five layers), errors of all quantized layers accumulate
+tests/test-reconet-nnmodl-quantize-depth: nrmse $(TESTS_OUT)/pattern.ra reconet \
+	$(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_ref.ra $(TESTS_OUT)/train_sens.ra \
+	$(TESTS_OUT)/test_kspace.ra $(TESTS_OUT)/test_sens.ra
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP); export OMP_NUM_THREADS=2 													;\
+	$(TOOLDIR)/reconet --network modl --resnet-block F=8 -I2 -t -n --train-algo e=10 -b2 --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_sens.ra weights $(TESTS_OUT)/train_ref.ra		;\
+	$(TOOLDIR)/reconet --network modl --resnet-block F=8 -I2 -a -n --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/test_kspace.ra $(TESTS_OUT)/test_sens.ra weights out32.ra					;\
+	$(TOOLDIR)/reconet --network modl --resnet-block F=8 -I2 -a -n --quantize-int8 --pattern=$(TESTS_OUT)/pattern.ra $(TESTS_OUT)/test_kspace.ra $(TESTS_OUT)/test_sens.ra weights out8.ra		;\
+	$(TOOLDIR)/nrmse -t 0.02 out32.ra out8.ra					;\
+	rm *.ra ; rm *.hdr ; rm *.cfl ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
 tests/test-reconet-nnunet-train: nrmse $(TESTS_OUT)/pattern.ra reconet \
 	$(TESTS_OUT)/train_kspace.ra $(TESTS_OUT)/train_ref.ra $(TESTS_OUT)/train_sens.ra \
 	$(TESTS_OUT)/test_kspace.ra $(TESTS_OUT)/test_ref.ra $(TESTS_OUT)/test_sens.ra
@@ -424,11 +466,15 @@ tests/test-reconet-nnmodl-train-tensorflow2-gpu: nrmse $(TESTS_OUT)/pattern.ra r
 
 TESTS += tests/test-reconet-nnvn-train
 TESTS += tests/test-reconet-nnvn-train-max-eigen
+TESTS += tests/test-reconet-nnvn-train-checkpoint
+TESTS += tests/test-reconet-nnvn-train-mem-budget
 TESTS += tests/test-reconet-nnmodl-train
 TESTS += tests/test-reconet-nnmodl-train-noncart
 TESTS += tests/test-reconet-nnmodl-train-noncart-init
 TESTS += tests/test-reconet-nnvn-train-noncart-init
 TESTS += tests/test-reconet-nnmodl-train-basis
+TESTS += tests/test-reconet-nnmodl-quantize
+TESTS += tests/test-reconet-nnmodl-quantize-depth
 ifeq ($(MPI),1)
 TESTS_SLOW += tests/test-reconet-nnvn-train-mpi
 TESTS_SLOW += tests/test-reconet-nnmodl-train-mpi
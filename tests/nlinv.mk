@@ -10,6 +10,15 @@ tests/test-nlinv: normalize nlinv pocsense nrmse $(TESTS_OUT)/shepplogan_coil_ks
 	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
 	touch $@
 
+tests/test-nlinv-multilevel: normalize nlinv pocsense nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra
+	set -e ; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
+	$(TOOLDIR)/nlinv -i10 --multilevel 0.5 $(TESTS_OUT)/shepplogan_coil_ksp.ra r.ra c.ra	;\
+	$(TOOLDIR)/normalize 8 c.ra c_norm.ra						;\
+	$(TOOLDIR)/pocsense -i1 $(TESTS_OUT)/shepplogan_coil_ksp.ra c_norm.ra proj.ra	;\
+	$(TOOLDIR)/nrmse -t 0.05 proj.ra $(TESTS_OUT)/shepplogan_coil_ksp.ra		;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
 tests/test-nlinv-reg: normalize nlinv pocsense nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra
 	set -e ; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
 	$(TOOLDIR)/nlinv -i10 -RW:3:0:0.1 --liniter=50 $(TESTS_OUT)/shepplogan_coil_ksp.ra r.ra c.ra	;\
@@ -405,7 +414,7 @@ TESTS += tests/test-nlinv-maps-dims tests/test-nlinv-noncart-maps-dims
 TESTS += tests/test-nlinv-pf-vcc
 TESTS += tests/test-nlinv-pics tests/test-nlinv-pics-psf-based
 TESTS += tests/test-nlinv-basis-noncart
-TESTS += tests/test-nlinv-ksens
+TESTS += tests/test-nlinv-ksens tests/test-nlinv-multilevel
 TESTS += tests/test-nlinv-psf-noncart tests/test-nlinv-sms-noncart-psf
 TESTS += tests/test-ncalib tests/test-ncalib-noncart
 TESTS += tests/test-nlinv-reg tests/test-nlinv-reg2 tests/test-nlinv-reg3 tests/test-nlinv-reg4
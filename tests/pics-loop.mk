@@ -102,7 +102,33 @@ tests/test-pics-eulermaruyama-loop-fail: bart
 	touch $@
 
 
-TESTS += tests/test-pics-cart-loop tests/test-pics-cart-loop_range tests/test-pics-cart-slice tests/test-pics-eulermaruyama-loop tests/test-pics-eulermaruyama-loop-fail
+# the NUFFT is reused across iterations, with an update for the second trajectory
+
+tests/test-pics-noncart-loop: traj scale phantom join slice pics nrmse bart
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)								;\
+	$(ROOTDIR)/bart traj -r -x64 -y21 t.ra									;\
+	$(ROOTDIR)/bart scale 0.5 t.ra t1.ra									;\
+	$(ROOTDIR)/bart scale -- -0.5 t.ra t2.ra								;\
+	$(ROOTDIR)/bart phantom -S4 -x64 s.ra									;\
+	$(ROOTDIR)/bart phantom -k -s4 -t t1.ra k1.ra								;\
+	$(ROOTDIR)/bart phantom -k -s4 -t t2.ra k2.ra								;\
+	$(ROOTDIR)/bart join 13 t1.ra t1.ra t2.ra tp.ra								;\
+	$(ROOTDIR)/bart join 13 k1.ra k1.ra k2.ra kp.ra								;\
+	$(ROOTDIR)/bart pics -S -i10 -t t1.ra k1.ra s.ra r1.ra							;\
+	$(ROOTDIR)/bart pics -S -i10 -t t2.ra k2.ra s.ra r2.ra							;\
+	$(ROOTDIR)/bart join 13 r1.ra r1.ra r2.ra ref.ra							;\
+	$(ROOTDIR)/bart -l 8192 -e 3 pics -S -i10 -t tp.ra kp.ra s.ra rp.ra					;\
+	$(ROOTDIR)/bart nrmse -t 1e-6 ref.ra rp.ra								;\
+	$(ROOTDIR)/bart -l 8192 -e 3 pics -S -i10 -t t1.ra kp.ra s.ra rp1.ra					;\
+	$(ROOTDIR)/bart slice 13 0 rp1.ra rp10.ra								;\
+	$(ROOTDIR)/bart slice 13 1 rp1.ra rp11.ra								;\
+	$(ROOTDIR)/bart nrmse -t 1e-6 r1.ra rp10.ra								;\
+	$(ROOTDIR)/bart nrmse -t 1e-6 r1.ra rp11.ra								;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+
+TESTS += tests/test-pics-cart-loop tests/test-pics-cart-loop_range tests/test-pics-cart-slice tests/test-pics-eulermaruyama-loop tests/test-pics-eulermaruyama-loop-fail tests/test-pics-noncart-loop
 
 ifeq ($(OMP),1)
 TESTS_SLOW += tests/test-pics-cart-loop_range-omp tests/test-pics-eulermaruyama-loop-omp
@@ -190,6 +190,15 @@ tests/test-pics-warmstart: pics ones nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra $
 	touch $@
 
 
+tests/test-pics-multilevel: pics nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra $(TESTS_OUT)/coils.ra
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
+	$(TOOLDIR)/pics -S -r0.001 $(TESTS_OUT)/shepplogan_coil_ksp.ra $(TESTS_OUT)/coils.ra reco.ra	;\
+	$(TOOLDIR)/pics -S -r0.001 -i3 --multilevel 0.25,0.5 $(TESTS_OUT)/shepplogan_coil_ksp.ra $(TESTS_OUT)/coils.ra reco2.ra	;\
+	$(TOOLDIR)/nrmse -t 0.06 reco.ra reco2.ra					;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+
 tests/test-pics-timedim: phantom fmac fft pics nrmse
 	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
 	$(TOOLDIR)/phantom -s4 -m coils.ra						;\
@@ -683,10 +692,40 @@ tests/test-pics-pridu-admm: phantom ones pics nrmse
 	touch $@
 
 
+tests/test-pics-checkpoint: phantom upat squeeze fmac pics nrmse
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)						;\
+	$(TOOLDIR)/phantom -k -s8 k.ra								;\
+	$(TOOLDIR)/phantom -S8 s.ra								;\
+	$(TOOLDIR)/upat -y 2 p.ra								;\
+	$(TOOLDIR)/squeeze p.ra p2.ra								;\
+	$(TOOLDIR)/fmac k.ra p2.ra kp.ra							;\
+	$(TOOLDIR)/pics -i20 -l2 -r0.01 kp.ra s.ra x.ra						;\
+	$(TOOLDIR)/pics -i10 -l2 -r0.01 --checkpoint ck --checkpoint-mod 5 kp.ra s.ra x1.ra	;\
+	$(TOOLDIR)/pics -i20 -l2 -r0.01 --checkpoint ck --checkpoint-mod 5 kp.ra s.ra x2.ra	;\
+	$(TOOLDIR)/nrmse -t 0. x.ra x2.ra							;\
+	rm ck *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+tests/test-pics-checkpoint-fista: phantom upat squeeze fmac pics nrmse
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)						;\
+	$(TOOLDIR)/phantom -k -s8 k.ra								;\
+	$(TOOLDIR)/phantom -S8 s.ra								;\
+	$(TOOLDIR)/upat -y 2 p.ra								;\
+	$(TOOLDIR)/squeeze p.ra p2.ra								;\
+	$(TOOLDIR)/fmac k.ra p2.ra kp.ra							;\
+	$(TOOLDIR)/pics -w1. -i30 -S -e -n -l1 -r0.01 --fista kp.ra s.ra x.ra				;\
+	$(TOOLDIR)/pics -w1. -i12 -S -e -n -l1 -r0.01 --fista --checkpoint ck --checkpoint-mod 4 kp.ra s.ra x1.ra	;\
+	$(TOOLDIR)/pics -w1. -i30 -S -e -n -l1 -r0.01 --fista --checkpoint ck --checkpoint-mod 4 kp.ra s.ra x2.ra	;\
+	$(TOOLDIR)/nrmse -t 0. x.ra x2.ra							;\
+	rm ck *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+
 TESTS += tests/test-pics-pi tests/test-pics-noncart tests/test-pics-cs tests/test-pics-pics
 TESTS += tests/test-pics-poisson-wavl1 tests/test-pics-joint-wavl1 tests/test-pics-bpwavl1
 TESTS += tests/test-pics-weights tests/test-pics-noncart-weights
-TESTS += tests/test-pics-warmstart
+TESTS += tests/test-pics-warmstart tests/test-pics-checkpoint tests/test-pics-checkpoint-fista
+TESTS += tests/test-pics-multilevel
 TESTS += tests/test-pics-timedim tests/test-pics-bp-noncart
 TESTS += tests/test-pics-basis tests/test-pics-basis-noncart tests/test-pics-basis-noncart-memory tests/test-pics-basis-noncart2
 #TESTS += tests/test-pics-lowmem
@@ -23,6 +23,22 @@ tests/test-python-bart-io-kwargs: $(ROOTDIR)/python/bart.py $(TESTS_OUT)/shepplo
 	rm *.cfl *.hdr ; cd .. ; rmdir $(TESTS_TMP)
 	touch $@
 
+# needs libbart.so (make shared-lib) in the root directory or BART_LIBRARY
+tests/test-python-bart-embed: $(ROOTDIR)/python/bart_embed.py
+	BART_LIBRARY=$${BART_LIBRARY:-$(ROOTDIR)/libbart.so} PYTHONPATH=$(ROOTDIR)/python python3 -c "import ctypes; import threading;	\
+		import numpy as np; import bart_embed;								\
+		x = np.asfortranarray(np.random.randn(128, 128, 8) + 1j * np.random.randn(128, 128, 8), dtype=np.complex64);	\
+		y = bart_embed.bart(1, 'scale 2', x);								\
+		assert np.allclose(y, 2 * x);									\
+		assert (not y.flags.owndata) and isinstance(y.base.base, ctypes.Array);			\
+		assert ctypes.addressof(y.base.base) == y.ctypes.data;						\
+		xs = [x, 3 * x]; r = [None, None];								\
+		ts = [threading.Thread(target=lambda i=i: r.__setitem__(i, bart_embed.bart(1, 'fft -u 7', xs[i]))) for i in range(2)];	\
+		[t.start() for t in ts]; [t.join() for t in ts];						\
+		assert all(np.allclose(r[i], bart_embed.bart(1, 'fft -u 7', xs[i])) for i in range(2))"
+	touch $@
+
 TESTS_PYTHON += tests/test-python-bart
 TESTS_PYTHON += tests/test-python-bart-io tests/test-python-bart-io-kwargs
+TESTS_PYTHON += tests/test-python-bart-embed
 
@@ -111,9 +111,21 @@ tests/test-rtnlinv-noncart-maps-dims: traj phantom rtnlinv show
 	touch $@
 
 
+tests/test-rtnlinv-stream: traj phantom copy rtnlinv nrmse
+	set -e ; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
+	$(TOOLDIR)/traj -o2 -r -x32 -y11 -t4 traj.ra					;\
+	$(TOOLDIR)/phantom -s4 -k -t traj.ra ksp.ra					;\
+	$(TOOLDIR)/rtnlinv -N -S -i6 -t traj.ra ksp.ra r.ra				;\
+	$(TOOLDIR)/copy --stream 1024 ksp.ra - | $(TOOLDIR)/rtnlinv -N -S -i6 -t traj.ra - - | $(TOOLDIR)/copy - r2.ra	;\
+	$(TOOLDIR)/nrmse -t 0. r.ra r2.ra						;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+
 
 TESTS += tests/test-rtnlinv tests/test-rtnlinv-precomp tests/test-rtnlinv-nlinv-noncart tests/test-rtnlinv-nlinv-pseudocart
 TESTS += tests/test-rtnlinv-nlinv-sms
 TESTS += tests/test-rtnlinv-maps-dims tests/test-rtnlinv-noncart-maps-dims
+TESTS += tests/test-rtnlinv-stream
 #TESTS += tests/test-rtnlinv-precomp
 
@@ -0,0 +1,17 @@
+
+
+tests/test-sake-fft: resize poisson squeeze fmac sake nrmse $(TESTS_OUT)/shepplogan_coil_ksp.ra
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)					;\
+	$(TOOLDIR)/resize -c 0 32 1 32 $(TESTS_OUT)/shepplogan_coil_ksp.ra ksp1.ra	;\
+	$(TOOLDIR)/poisson -Y32 -Z32 -y1.2 -z1.2 -C12 -e -v p.ra			;\
+	$(TOOLDIR)/squeeze p.ra p2.ra							;\
+	$(TOOLDIR)/fmac ksp1.ra p2.ra ksp.ra						;\
+	$(TOOLDIR)/sake -i10 ksp.ra reco1.ra						;\
+	$(TOOLDIR)/sake -i10 --fft ksp.ra reco2.ra					;\
+	$(TOOLDIR)/nrmse -t 0.01 reco1.ra reco2.ra					;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+
+TESTS += tests/test-sake-fft
+
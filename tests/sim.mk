@@ -333,6 +333,35 @@ tests/test-sim-bmc-bloch: sim extract slice nrmse
 	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
 	touch $@
 
+tests/test-sim-ode-batch: sim nrmse
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)	;\
+	$(TOOLDIR)/sim --ODE --seq IR-BSSFP,TR=0.0045,TE=0.00225,Nrep=200,ipl=0.01,ppl=0.00225,Trf=0.001,FA=45,BWTP=4 -1 0.5:3:3 -2 0.05:1:3 s.ra d.ra ;\
+	$(TOOLDIR)/sim --ODE --seq IR-BSSFP,TR=0.0045,TE=0.00225,Nrep=200,ipl=0.01,ppl=0.00225,Trf=0.001,FA=45,BWTP=4 -1 0.5:3:3 -2 0.05:1:3 --other batch=4 s_batch.ra d_batch.ra ;\
+	$(TOOLDIR)/nrmse -t 0.001 s.ra s_batch.ra			;\
+	$(TOOLDIR)/nrmse -t 0.001 d.ra d_batch.ra			;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+tests/test-sim-ode-batch-flash: sim nrmse
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)	;\
+	$(TOOLDIR)/sim --ODE --seq IR-FLASH,TR=0.0041,TE=0.0025,Nrep=200,ipl=0.01,ppl=0,Trf=0.001,FA=8,BWTP=4 -1 0.5:3:3 -2 0.05:1:3 s.ra d.ra ;\
+	$(TOOLDIR)/sim --ODE --seq IR-FLASH,TR=0.0041,TE=0.0025,Nrep=200,ipl=0.01,ppl=0,Trf=0.001,FA=8,BWTP=4 -1 0.5:3:3 -2 0.05:1:3 --other batch=5 s_batch.ra d_batch.ra ;\
+	$(TOOLDIR)/nrmse -t 0.001 s.ra s_batch.ra			;\
+	$(TOOLDIR)/nrmse -t 0.001 d.ra d_batch.ra			;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+tests/test-sim-stm-dummies: sim extract nrmse
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)	;\
+	$(TOOLDIR)/sim --STM --seq IR-BSSFP,TR=0.003,TE=0.0015,Nrep=300,ipl=0.01,isp=0.005,ppl=0,Trf=0.001,FA=8,BWTP=4 -1 1.25:1.25:1 -2 0.045:0.045:1 s.ra d.ra ;\
+	$(TOOLDIR)/sim --STM --seq IR-BSSFP,TR=0.003,TE=0.0015,Nrep=45,Ndummy=255,ipl=0.01,isp=0.005,ppl=0,Trf=0.001,FA=8,BWTP=4 -1 1.25:1.25:1 -2 0.045:0.045:1 s2.ra d2.ra ;\
+	$(TOOLDIR)/extract 5 255 300 s.ra s3.ra				;\
+	$(TOOLDIR)/extract 5 255 300 d.ra d3.ra				;\
+	$(TOOLDIR)/nrmse -t 0.0001 s3.ra s2.ra				;\
+	$(TOOLDIR)/nrmse -t 0.0001 d3.ra d2.ra				;\
+	rm *.ra ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
 TESTS += tests/test-sim-to-signal-irflash tests/test-sim-to-signal-flash
 TESTS += tests/test-sim-to-signal-irbSSFP
 TESTS += tests/test-sim-spoke-averaging-3 tests/test-sim-to-signal-irbSSFP-averaged-spokes
@@ -348,3 +377,4 @@ TESTS += tests/test-sim-split-dim-mag tests/test-sim-split-dim-deriv
 TESTS += tests/test-sim-ode-stm-flash-te-eq-trf-eq-tr tests/test-sim-ode-stm-bssfp-te-eq-trf-eq-tr tests/test-sim-ode-rot-flash-te-eq-trf-ep-tr
 TESTS += tests/test-sim-ode-deriv-r1 tests/test-sim-ode-deriv-r2 tests/test-sim-ode-deriv-b1 tests/test-sim-ode-stm-deriv
 TESTS += tests/test-sim-bmc-signal tests/test-sim-bmc-deriv tests/test-sim-bmc-stm-ode tests/test-sim-bmc-bloch
+TESTS += tests/test-sim-ode-batch tests/test-sim-ode-batch-flash tests/test-sim-stm-dummies
@@ -118,11 +118,24 @@ tests/test-stream-binary5: phantom copy nrmse trx
 	rm *.ra	; rm phantom.bstrm; cd .. ; rmdir $(TESTS_TMP)
 	touch $@
 
+tests/test-stream-writeback: phantom copy nrmse mandelbrot
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)			;\
+	$(TOOLDIR)/phantom -s3 phantom.ra 				;\
+	$(TOOLDIR)/copy --stream 9 -- phantom.ra - | \
+	BART_WRITEBACK=1 $(TOOLDIR)/copy -- - phantom2.ra		;\
+	$(TOOLDIR)/nrmse -t 0 phantom.ra phantom2.ra			;\
+	$(TOOLDIR)/mandelbrot -s 64 -n 20 -I m.ra			;\
+	BART_WRITEBACK=1 $(TOOLDIR)/mandelbrot -s 64 -n 20 -I m2.ra	;\
+	$(TOOLDIR)/nrmse -t 0 m.ra m2.ra				;\
+	rm *.ra	; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
 
 .PHONY: tests/test-stream
 tests/test-stream: tests/test-pipe tests/test-stream1 tests/test-stream2 tests/test-stream3 tests/test-stream4 tests/test-stream5 \
 	tests/test-stream-loop tests/test-stream-loop-ref tests/test-stream-binary tests/test-stream-binary2 \
-	tests/test-stream-binary3 tests/test-stream-binary4 tests/test-stream-binary5
+	tests/test-stream-binary3 tests/test-stream-binary4 tests/test-stream-binary5 \
+	tests/test-stream-writeback
 
 
 TESTS += tests/test-stream
@@ -0,0 +1,15 @@
+
+# five frames of 32x32 pixels (2 bytes each) plus the NumberOfFrames tag (10 bytes)
+tests/test-toimg-multiframe: phantom repmat toimg
+	set -e; mkdir $(TESTS_TMP) ; cd $(TESTS_TMP)						;\
+	$(TOOLDIR)/phantom -x32 p.ra								;\
+	$(TOOLDIR)/repmat 10 5 p.ra p5.ra							;\
+	$(TOOLDIR)/toimg p.ra single.dcm							;\
+	$(TOOLDIR)/toimg --multiframe p5.ra multi.dcm						;\
+	[ `wc -c < multi.dcm` -eq $$((`wc -c < single.dcm` + 4 * 2 * 32 * 32 + 10)) ]		;\
+	rm *.ra *.dcm ; cd .. ; rmdir $(TESTS_TMP)
+	touch $@
+
+
+TESTS += tests/test-toimg-multiframe
+
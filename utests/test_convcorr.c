@@ -5,9 +5,13 @@
  * Authors: Moritz Blumenthal
  */
 
+#include <complex.h>
+
 #include "num/flpmath.h"
 #include "num/multind.h"
 #include "num/convcorr.h"
+#include "num/rand.h"
+#include "num/vecops_strided.h"
 
 #include "utest.h"
 
@@ -231,3 +235,120 @@ static bool test_convcorr_cf_dil_strs(void)
 }
 UT_REGISTER_TEST(test_convcorr_cf_dil_strs);
 
+
+
+static bool test_convcorr_cf_3x3(void)
+{
+	enum { N = 6 };
+	long odims[N] = { 4, 1, 7, 6, 1, 2 };
+	long idims[N] = { 1, 3, 9, 8, 1, 2 };
+	long kdims[N] = { 4, 3, 3, 3, 1, 1 };
+
+	// im2col, Winograd F(2x2,3x3) and F(4x4,3x3), FFT
+
+	bool test = test_zconvcorr_fwd(	N,
+					odims, MD_STRIDES(N, odims, CFL_SIZE),
+					idims, MD_STRIDES(N, idims, CFL_SIZE),
+					kdims, MD_STRIDES(N, kdims, CFL_SIZE),
+					28, NULL, NULL, false,
+					1.e-5, false, 4);
+
+	UT_RETURN_ASSERT(test);
+}
+
+UT_REGISTER_TEST(test_convcorr_cf_3x3);
+
+
+static bool test_convcorr_select(void)
+{
+	enum { N = 5 };
+	long odims[N] = { 4, 1, 34, 34, 1 };
+	long idims[N] = { 1, 4, 64, 64, 1 };
+	long kdims[N] = { 4, 4, 31, 31, 1 };
+
+	long tdims[2 * N];
+	long tostrs[2 * N];
+	long tistrs[2 * N];
+	long tkstrs[2 * N];
+
+	calc_convcorr_geom_strs_dil(N, 28, tdims, tostrs, tkstrs, tistrs,
+				    odims, MD_STRIDES(N, odims, CFL_SIZE),
+				    kdims, MD_STRIDES(N, kdims, CFL_SIZE),
+				    idims, MD_STRIDES(N, idims, CFL_SIZE),
+				    NULL, NULL, false, false);
+
+	complex float* in = md_alloc(N, idims, CFL_SIZE);
+	complex float* krn = md_alloc(N, kdims, CFL_SIZE);
+
+	md_gaussian_rand(N, idims, in);
+	md_gaussian_rand(N, kdims, krn);
+
+	complex float* ref = md_alloc(N, odims, CFL_SIZE);
+	complex float* out = md_alloc(N, odims, CFL_SIZE);
+
+	md_clear(N, odims, ref, CFL_SIZE);
+
+	deactivate_strided_vecops();
+	md_zfmac2(2 * N, tdims, tostrs, ref, tistrs, in, tkstrs, krn);
+	activate_strided_vecops();
+
+	bool test = true;
+
+	for (int i = 0; i < 2; i++) {
+
+		zconvcorr_algo_cache_clear();
+
+		bool autotune = use_convcorr_autotune;
+		use_convcorr_autotune = (1 == i);
+
+		// first call selects (and times) the algorithm, second uses the cache
+
+		for (int j = 0; j < 2; j++) {
+
+			md_clear(N, odims, out, CFL_SIZE);
+			md_zfmac2(2 * N, tdims, tostrs, out, tistrs, in, tkstrs, krn);
+
+			test = test && (1.e-5 > md_znrmse(N, odims, ref, out));
+		}
+
+		use_convcorr_autotune = autotune;
+	}
+
+	zconvcorr_algo_cache_clear();
+
+	md_free(in);
+	md_free(krn);
+	md_free(ref);
+	md_free(out);
+
+	UT_RETURN_ASSERT(test);
+}
+
+UT_REGISTER_TEST(test_convcorr_select);
+
+
+static bool test_convcorr_fft_limit(void)
+{
+	// kernel spectrum of 16 x 16 x 64^3 complex floats (512 MB)
+
+	enum { N = 5 };
+	long odims[N] = { 16, 1, 60, 60, 60 };
+	long idims[N] = { 1, 16, 64, 64, 64 };
+	long kdims[N] = { 16, 16, 5, 5, 5 };
+
+	complex float* in = md_alloc(N, idims, CFL_SIZE);
+	complex float* krn = md_alloc(N, kdims, CFL_SIZE);
+	complex float* out = md_alloc(N, odims, CFL_SIZE);
+
+	bool applied = zconvcorr_fwd_fft_cf_cpu(N, odims, MD_STRIDES(N, odims, CFL_SIZE), out,
+						idims, MD_STRIDES(N, idims, CFL_SIZE), in,
+						kdims, MD_STRIDES(N, kdims, CFL_SIZE), krn,
+						28, NULL, NULL, false);
+	md_free(in);
+	md_free(krn);
+	md_free(out);
+
+	UT_RETURN_ASSERT(!applied);
+}
+
+UT_REGISTER_TEST(test_convcorr_fft_limit);
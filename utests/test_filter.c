@@ -7,9 +7,16 @@
  */
 
 #include <math.h>
+#include <complex.h>
+#include <string.h>
 
+#include "num/multind.h"
+#include "num/flpmath.h"
+#include "num/rand.h"
 #include "num/filter.h"
 
+#include "misc/misc.h"
+
 #include "utest.h"
 
 
@@ -41,11 +48,133 @@ static bool test_geometric_median(void)
 	};
 
 	const complex float g = 0.5 + 0.5i;
-	complex float m = median_complex_float(4, vec);
+	complex float m;
+
+	md_geometric_medianz(1, 0, MD_DIMS(4), &m, vec);
 
-	return cabsf(m - g);
+	return (cabsf(m - g) < 1.E-3);
 }
 
 
 UT_REGISTER_TEST(test_geometric_median);
 
+
+
+
+// sliding window as used by the filter command
+
+static bool test_median_sliding(bool geom)
+{
+	enum { D = 3 };
+	long dims[D] = { 3, 20, 1 };
+
+	const int L = 6;
+
+	complex float* in = md_alloc(D, dims, CFL_SIZE);
+	md_gaussian_rand(D, dims, in);
+
+	long wdims[D] = { 3, dims[1] - L + 1, L };
+
+	long istrs[D];
+	md_calc_strides(D, istrs, dims, CFL_SIZE);
+	istrs[2] = istrs[1];
+
+	long odims[D] = { 3, dims[1] - L + 1, 1 };
+
+	long ostrs[D];
+	md_calc_strides(D, ostrs, odims, CFL_SIZE);
+
+	complex float* out = md_alloc(D, odims, CFL_SIZE);
+
+	(geom ? md_geometric_medianz2 : md_medianz2)(D, 2, wdims, ostrs, out, istrs, in);
+
+	bool ok = true;
+
+	for (long j = 0; j < odims[1]; j++) {
+
+		for (long c = 0; c < 3; c++) {
+
+			complex float win[L];
+
+			for (int i = 0; i < L; i++)
+				win[i] = in[c + 3 * (j + i)];
+
+			complex float ref;
+
+			if (geom)
+				weiszfeld(10, L, 2, *(float(*)[2])&ref, *(float(*)[L][2])win);
+			else
+				ref = median_complex_float(L, win);
+
+			ok &= (cabsf(out[c + 3 * j] - ref) < 1.E-5);
+		}
+	}
+
+	md_free(in);
+	md_free(out);
+
+	return ok;
+}
+
+static bool test_median_sliding_window(void)
+{
+	return test_median_sliding(false);
+}
+
+UT_REGISTER_TEST(test_median_sliding_window);
+
+static bool test_geometric_median_sliding_window(void)
+{
+	return test_median_sliding(true);
+}
+
+UT_REGISTER_TEST(test_geometric_median_sliding_window);
+
+static bool test_median_sliding_nan(void)
+{
+	enum { D = 3 };
+	long dims[D] = { 1, 20, 1 };
+
+	const int L = 5;
+
+	complex float* in = md_alloc(D, dims, CFL_SIZE);
+	md_gaussian_rand(D, dims, in);
+
+	in[7] = NAN;
+
+	long wdims[D] = { 1, dims[1] - L + 1, L };
+
+	long istrs[D];
+	md_calc_strides(D, istrs, dims, CFL_SIZE);
+	istrs[2] = istrs[1];
+
+	long odims[D] = { 1, dims[1] - L + 1, 1 };
+
+	long ostrs[D];
+	md_calc_strides(D, ostrs, odims, CFL_SIZE);
+
+	complex float* out = md_alloc(D, odims, CFL_SIZE);
+
+	md_medianz2(D, 2, wdims, ostrs, out, istrs, in);
+
+	bool ok = true;
+
+	for (long j = 0; j < odims[1]; j++) {
+
+		complex float win[L];
+
+		for (int i = 0; i < L; i++)
+			win[i] = in[j + i];
+
+		complex float ref = median_complex_float(L, win);
+
+		ok &= (0 == memcmp(&out[j], &ref, sizeof(complex float)));
+	}
+
+	md_free(in);
+	md_free(out);
+
+	return ok;
+}
+
+UT_REGISTER_TEST(test_median_sliding_nan);
@@ -785,3 +785,131 @@ static bool test_blas_threadsave_gemv3(void) {
 }
 
 UT_REGISTER_TEST(test_blas_threadsave_gemv3);
+
+
+
+static bool test_contract_flags(int D, const long dims[D], unsigned long oflags, unsigned long iflags1, unsigned long iflags2, bool fmac)
+{
+	long odims[D];
+	long idims1[D];
+	long idims2[D];
+
+	md_select_dims(D, oflags, odims, dims);
+	md_select_dims(D, iflags1, idims1, dims);
+	md_select_dims(D, iflags2, idims2, dims);
+
+	long ostrs[D];
+	long istrs1[D];
+	long istrs2[D];
+
+	md_calc_strides(D, ostrs, odims, CFL_SIZE);
+	md_calc_strides(D, istrs1, idims1, CFL_SIZE);
+	md_calc_strides(D, istrs2, idims2, CFL_SIZE);
+
+	complex float* in1 = md_alloc(D, idims1, CFL_SIZE);
+	complex float* in2 = md_alloc(D, idims2, CFL_SIZE);
+	complex float* out0 = md_alloc(D, odims, CFL_SIZE);
+	complex float* out1 = md_alloc(D, odims, CFL_SIZE);
+	complex float* out2 = md_alloc(D, odims, CFL_SIZE);
+
+	md_gaussian_rand(D, idims1, in1);
+	md_gaussian_rand(D, idims2, in2);
+	md_gaussian_rand(D, odims, out0);
+
+	md_copy(D, odims, out1, out0, CFL_SIZE);
+
+	deactivate_strided_vecops();
+
+	if (fmac)
+		md_zfmac2(D, dims, ostrs, out1, istrs1, in1, istrs2, in2);
+	else
+		md_ztenmul(D, odims, out1, idims1, in1, idims2, in2);
+
+	activate_strided_vecops();
+
+	float err = 0.;
+
+	// the second run uses the cached plan
+
+	for (int i = 0; i < 2; i++) {
+
+		md_copy(D, odims, out2, out0, CFL_SIZE);
+
+		if (fmac)
+			md_zfmac2(D, dims, ostrs, out2, istrs1, in1, istrs2, in2);
+		else
+			md_ztenmul(D, odims, out2, idims1, in1, idims2, in2);
+
+		err += md_znrmse(D, odims, out1, out2);
+	}
+
+	md_free(in1);
+	md_free(in2);
+	md_free(out0);
+	md_free(out1);
+	md_free(out2);
+
+	debug_printf(DP_DEBUG1, "contraction error: %e\n", err);
+
+	return (err < 1.E-5);
+}
+
+
+static bool test_contract_batch_inner(void)
+{
+	// batch dimension is the fastest
+
+	long dims[4] = { 16, 12, 12, 12 };
+
+	return test_contract_flags(4, dims, 1 + 2 + 8, 1 + 2 + 4, 1 + 4 + 8, false);
+}
+
+UT_REGISTER_TEST(test_contract_batch_inner);
+
+
+static bool test_contract_transposed_out(void)
+{
+	// N is the fastest dimension of the output
+
+	long dims[4] = { 20, 30, 25, 3 };
+
+	return test_contract_flags(4, dims, 1 + 4 + 8, 2 + 4 + 8, 1 + 2 + 8, false);
+}
+
+UT_REGISTER_TEST(test_contract_transposed_out);
+
+
+static bool test_contract_pack(void)
+{
+	// M group interleaved with K in first input
+
+	long dims[5] = { 7, 9, 11, 13, 2 };
+
+	return test_contract_flags(5, dims, 1 + 4 + 8 + 16, 1 + 2 + 4 + 16, 2 + 8 + 16, false);
+}
+
+UT_REGISTER_TEST(test_contract_pack);
+
+
+static bool test_contract_gemm(void)
+{
+	long dims1[4] = { 40, 48, 3, 36 };
+	long dims2[4] = { 40, 36, 3, 48 };
+
+	return    test_contract_flags(4, dims1, 1 + 4 + 8, 1 + 2 + 4, 2 + 4 + 8, false)
+	       && test_contract_flags(4, dims2, 1 + 2 + 4, 1 + 4 + 8, 2 + 4 + 8, false);
+}
+
+UT_REGISTER_TEST(test_contract_gemm);
+
+
+static bool test_contract_fmac(void)
+{
+	long dims1[5] = { 7, 9, 11, 13, 2 };
+	long dims2[5] = { 17, 19, 21, 1, 2 };
+
+	return    test_contract_flags(5, dims1, 1 + 4 + 8 + 16, 1 + 2 + 4 + 16, 2 + 8 + 16, true)
+	       && test_contract_flags(5, dims2, 2 + 4 + 16, 1 + 2 + 16, 1 + 4 + 16, true);
+}
+
+UT_REGISTER_TEST(test_contract_fmac);
@@ -7,11 +7,14 @@
  */
 
 #include <math.h>
+#include <complex.h>
 
 #include "geom/polygon.h"
 #include "geom/polyhedron.h"
 #include "geom/triangle.h"
 
+#include "simu/shape.h"
+
 #include "utest.h"
 
 
@@ -81,3 +84,35 @@ UT_REGISTER_TEST(test_polyhedron_volume);
 
 
 
+
+
+
+static bool test_kpolygon_batch(void)
+{
+	double pg[8][2] = {
+		{ -0.5, -0.5 }, {  0.0, -0.3 }, { +0.5, -0.5 }, {  0.3,  0.0 },
+		{ +0.5, +0.5 }, {  0.0, +0.3 }, { -0.5, +0.5 }, { -0.3,  0.0 },
+	};
+
+	enum { M = 7 };
+
+	double q[M][3] = {
+		{ 0., 0., 0. }, { 0.25, 0., 0. }, { 0., -1., 0. }, { 1.5, 2.5, 0. },
+		{ -10.25, 3., 0. }, { 31.5, -32., 0. }, { 120., 97.75, 0. },
+	};
+
+	complex double out[M];
+	kpolygon_batch(8, pg, M, out, q);
+
+	for (int m = 0; m < M; m++) {
+
+		complex double ref = kpolygon(8, pg, q[m]);
+
+		if (cabs(out[m] - ref) > 1.E-6 * cabs(ref))
+			return false;
+	}
+
+	return true;
+}
+
+UT_REGISTER_TEST(test_kpolygon_batch);
@@ -636,4 +636,48 @@ static bool test_logm(void)
 }
 
 
-UT_REGISTER_TEST(test_logm);
\ No newline at end of file
+UT_REGISTER_TEST(test_logm);
+
+static bool test_matf_pow(void)
+{
+	enum { N = 3 };
+
+	const float A[N][N] = {
+		{ 0.9, 0.1, 0. },
+		{ -0.1, 0.8, 0.2 },
+		{ 0.05, 0., 0.95 },
+	};
+
+	float ref[N][N];
+	float tmp[N][N];
+
+	for (int i = 0; i < N; i++)
+		for (int j = 0; j < N; j++)
+			ref[i][j] = (i == j) ? 1. : 0.;
+
+	for (int p = 0; p < 13; p++) {
+
+		matf_mul(N, N, N, tmp, ref, A);
+		matf_copy(N, N, ref, tmp);
+	}
+
+	float B[N][N];
+	matf_pow(N, B, A, 13);
+
+	float err = 0.;
+
+	for (int i = 0; i < N; i++)
+		for (int j = 0; j < N; j++)
+			err += powf(ref[i][j] - B[i][j], 2.);
+
+	matf_pow(N, B, A, 0);
+
+	for (int i = 0; i < N; i++)
+		for (int j = 0; j < N; j++)
+			err += powf(((i == j) ? 1. : 0.) - B[i][j], 2.);
+
+	return (err < 1.E-10);
+}
+
+
+UT_REGISTER_TEST(test_matf_pow);
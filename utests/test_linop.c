@@ -408,3 +408,71 @@ static bool test_linop_gradient(void)
 
 
 UT_REGISTER_TEST(test_linop_gradient);
+
+
+static bool test_linop_gradient_fused_flags(unsigned long flags)
+{
+	enum { N = 5 };
+	long idims[N] = { 5, 3, 4, 2, 1 };
+
+	const float scales[3] = { 1., 0.5, 2. };
+	complex float zscales[3] = { 1., 0.5, 2. };
+
+	int D = bitcount(flags);
+
+	long odims[N + 1] = { 5, 3, 4, 2, 1, D };
+
+	auto lop_ref = linop_grad_create(N, idims, N, flags);
+	lop_ref = linop_chain_FF(lop_ref, linop_cdiag_create(N + 1, odims, MD_BIT(N), zscales));
+
+	auto lop_fused = linop_grad_fused_create(N, idims, flags, D, scales);
+
+	complex float* src = md_alloc(N, idims, CFL_SIZE);
+	complex float* gsrc = md_alloc(N + 1, odims, CFL_SIZE);
+	complex float* dst1 = md_alloc(N + 1, odims, CFL_SIZE);
+	complex float* dst2 = md_alloc(N + 1, odims, CFL_SIZE);
+
+	md_gaussian_rand(N, idims, src);
+	md_gaussian_rand(N + 1, odims, gsrc);
+
+	linop_forward(lop_ref, N + 1, odims, dst1, N, idims, src);
+	linop_forward(lop_fused, N + 1, odims, dst2, N, idims, src);
+
+	bool ok = (UT_TOL > md_znrmse(N + 1, odims, dst1, dst2));
+
+	linop_adjoint(lop_ref, N, idims, dst1, N + 1, odims, gsrc);
+	linop_adjoint(lop_fused, N, idims, dst2, N + 1, odims, gsrc);
+
+	ok &= (UT_TOL > md_znrmse(N, idims, dst1, dst2));
+
+	linop_normal(lop_ref, N, idims, dst1, src);
+	linop_normal(lop_fused, N, idims, dst2, src);
+
+	ok &= (UT_TOL > md_znrmse(N, idims, dst1, dst2));
+
+	ok &= (UT_TOL > linop_test_adjoint(lop_fused));
+
+	md_free(src);
+	md_free(gsrc);
+	md_free(dst1);
+	md_free(dst2);
+
+	linop_free(lop_ref);
+	linop_free(lop_fused);
+
+	return ok;
+}
+
+static bool test_linop_gradient_fused(void)
+{
+	bool ok = true;
+
+	ok &= test_linop_gradient_fused_flags(MD_BIT(1) | MD_BIT(2) | MD_BIT(3));
+	ok &= test_linop_gradient_fused_flags(MD_BIT(0) | MD_BIT(2));
+	ok &= test_linop_gradient_fused_flags(MD_BIT(0) | MD_BIT(4));
+
+	UT_RETURN_ASSERT(ok);
+}
+
+
+UT_REGISTER_TEST(test_linop_gradient_fused);
@@ -41,3 +41,44 @@ static bool test_zmat_exp(void)
 }
 
 UT_REGISTER_TEST(test_zmat_exp);
+
+
+static bool test_zmat_expv(void)
+{
+	enum { N = 5 };
+
+	complex float A[N][N];
+	complex float x[N];
+
+	for (int i = 0; i < N; i++) {
+
+		x[i] = cosf(i) + 1.i * sinf(2. * i);
+
+		for (int j = 0; j < N; j++)
+			A[i][j] = 0.3 * sinf(i + 3. * j) - 0.2i * cosf(2. * i - j);
+	}
+
+	complex float E[N][N];
+	zmat_exp(N, 1., E, A);
+
+	// E[i] = exp(A) e_i
+
+	complex float y[N];
+	zmat_expv(N, 1., y, A, x);
+
+	float err = 0.;
+
+	for (int j = 0; j < N; j++) {
+
+		complex float ref = 0.;
+
+		for (int i = 0; i < N; i++)
+			ref += E[i][j] * x[i];
+
+		err += powf(cabsf(ref - y[j]), 2.);
+	}
+
+	return (err < 1.E-8);
+}
+
+UT_REGISTER_TEST(test_zmat_expv);
@@ -118,3 +118,67 @@ static bool test_memcfl_write(void)
 UT_REGISTER_TEST(test_memcfl_write);
 
 
+
+
+static bool test_memcfl_detach(void)
+{
+	io_reserve_output("test.mem");
+
+	long dims[2] = { 10, 5 };
+	complex float* x = create_cfl("test.mem", 2, dims);
+
+	for (int i = 0; i < 50; i++)
+		x[i] = i;
+
+	unmap_cfl(2, dims, x);
+
+	long dims2[3];
+	complex float* y = memcfl_detach("test.mem", 3, dims2);
+
+	bool ok = (x == y) && (10 == dims2[0]) && (5 == dims2[1]) && (1 == dims2[2]);
+
+	ok = ok && !memcfl_exists("test.mem");
+
+	xfree(y);
+
+	io_memory_cleanup();
+
+	return ok;
+}
+
+
+UT_REGISTER_TEST(test_memcfl_detach);
+
+
+static bool test_memcfl_shared(void)
+{
+	long dims[2] = { 10, 5 };
+	complex float* x = xmalloc((size_t)io_calc_size(2, dims, sizeof(complex float)));
+
+	memcfl_register("test1.mem", 2, dims, x, false);
+	memcfl_register("test2.mem", 2, dims, x, false);
+
+	unmap_cfl(2, dims, x);
+	unmap_cfl(2, dims, x);
+
+	io_reserve_input("test1.mem");
+	io_reserve_input("test2.mem");
+
+	long dims2[2];
+	complex float* y1 = load_cfl("test1.mem", 2, dims2);
+	complex float* y2 = load_cfl("test2.mem", 2, dims2);
+
+	unmap_cfl(2, dims, y1);
+	unmap_cfl(2, dims, y2);
+
+	memcfl_unlink("test1.mem");
+	memcfl_unlink("test2.mem");
+
+	xfree(x);
+	io_memory_cleanup();
+
+	return true;
+}
+
+
+UT_REGISTER_TEST(test_memcfl_shared);
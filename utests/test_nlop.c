@@ -1377,6 +1377,63 @@ static bool test_nlop_checkpointing(void)
 UT_REGISTER_TEST(test_nlop_checkpointing);
 
 
+static bool test_checkpoint_plan(void)
+{
+	// no checkpointing if memory suffices
+
+	auto plan = checkpoint_plan(16, 100, 10, 1600);
+
+	if ((0 != plan.segments) || (0 != plan.recompute) || (1600 != plan.memory))
+		return false;
+
+	// fewest recomputations within budget
+
+	plan = checkpoint_plan(16, 100, 10, 1000);
+
+	if ((plan.memory > 1000) || (plan.recompute != plan.segments * plan.length))
+		return false;
+
+	for (int length = 1; length <= 16; length++)
+		for (int segments = 1; segments * length <= 16; segments++)
+			if (   (segments * 10 + (16 - segments * length + length) * 100 <= 1000)
+			    && (segments * length < plan.recompute))
+				return false;
+
+	// least memory if budget can not be met: sqrt(N) segments
+
+	plan = checkpoint_plan(16, 100, 100, 0);
+
+	return (4 == plan.segments) && (4 == plan.length) && (800 == plan.memory);
+}
+
+UT_REGISTER_TEST(test_checkpoint_plan);
+
+
+static bool test_nlop_der_memory(void)
+{
+	enum { N = 3 };
+	long dims[N] = { 10, 10, 10 };
+
+	auto nlop = nlop_tenmul_create(N, dims, dims, dims);
+
+	long mem = nlop_der_memory(nlop, MD_BIT(0), MD_BIT(0));
+	long mem1 = nlop_der_memory(nlop, MD_BIT(0), MD_BIT(0) | MD_BIT(1));
+
+	nlop_free(nlop);
+
+	if (-1 == mem)
+		return true;
+
+	// one input is stored for each derivative
+
+	long size = md_calc_size(N, dims) * (long)CFL_SIZE;
+
+	return (size <= mem) && (mem < 2 * size) && (2 * size <= mem1);
+}
+
+UT_REGISTER_TEST(test_nlop_der_memory);
+
+
 static bool test_mriop_normalinv_config(bool batch_independent, bool share_pattern)
 {
 	// Here we test the basic case of a fully sampled k-space
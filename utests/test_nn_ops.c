@@ -837,3 +837,128 @@ static bool test_nlop_cardioid(void)
 
 
 UT_REGISTER_TEST(test_nlop_cardioid);
+
+
+static bool test_conv_fused_generic(bool batchnorm, bool bias, enum ACTIVATION activation, enum PADDING conv_pad)
+{
+	enum { N = 5 };
+	long idims[N] = { 3, 8, 7, 1, 2 };
+	long kdims[N] = { 4, 3, 3, 1, 1 };
+
+	const struct nlop_s* ref = nlop_from_linop_F(linop_identity_create(N, idims));
+
+	ref = append_convcorr_layer_generic(ref, 0, 14, MD_BIT(0), 0, N, kdims, NULL, NULL, false, conv_pad);
+
+	if (batchnorm)
+		ref = append_batchnorm_layer(ref, 0, ~MD_BIT(0), STAT_TEST);
+
+	if (bias)
+		ref = append_activation_bias(ref, 0, activation, MD_BIT(0));
+	else
+		ref = append_activation(ref, 0, activation, MD_BIT(0));
+
+	const struct nlop_s* fused = nlop_from_linop_F(linop_identity_create(N, idims));
+
+	fused = append_convcorr_bias_act_layer_generic(fused, 0, 14, MD_BIT(0), 0, N, kdims, NULL, NULL, false, conv_pad, batchnorm, bias, activation, STAT_TEST);
+
+	int II = nlop_get_nr_in_args(ref);
+	int OO = nlop_get_nr_out_args(ref);
+
+	void* args1[OO + II];
+	void* args2[OO + II];
+
+	bool ok = (II == nlop_get_nr_in_args(fused)) && (OO == nlop_get_nr_out_args(fused));
+
+	for (int i = 0; ok && (i < II); i++) {
+
+		auto iov = nlop_generic_domain(ref, i);
+
+		args1[OO + i] = md_alloc(iov->N, iov->dims, CFL_SIZE);
+		args2[OO + i] = args1[OO + i];
+
+		md_gaussian_rand(iov->N, iov->dims, args1[OO + i]);
+	}
+
+	// positive variance
+
+	if (ok && batchnorm) {
+
+		complex float* stats = args1[OO + 2];
+
+		for (int c = 0; c < kdims[0]; c++)
+			stats[kdims[0] + c] = 0.5 + 0.1 * c;
+	}
+
+	for (int o = 0; ok && (o < OO); o++) {
+
+		auto iov = nlop_generic_codomain(ref, o);
+
+		args1[o] = md_alloc(iov->N, iov->dims, CFL_SIZE);
+		args2[o] = md_alloc(iov->N, iov->dims, CFL_SIZE);
+	}
+
+	if (ok) {
+
+		nlop_generic_apply_no_derivative_unchecked(ref, OO + II, args1);
+		nlop_generic_apply_no_derivative_unchecked(fused, OO + II, args2);
+	}
+
+	for (int o = 0; ok && (o < OO); o++) {
+
+		auto iov = nlop_generic_codomain(ref, o);
+
+		float err = md_znrmse(iov->N, iov->dims, args1[o], args2[o]);
+
+		debug_printf(DP_DEBUG1, "fused conv output %d: %e\n", o, err);
+
+		ok = ok && (UT_TOL > err);
+	}
+
+	// derivatives are computed by the unfused layer
+
+	if (ok && batchnorm) {
+
+		auto iov = nlop_generic_domain(ref, 2);
+
+		ref = nlop_set_input_const_F(ref, 2, iov->N, iov->dims, true, args1[OO + 2]);
+		fused = nlop_set_input_const_F(fused, 2, iov->N, iov->dims, true, args1[OO + 2]);
+
+		// derivatives of statistics are zero (nrmse undefined)
+
+		ref = nlop_del_out_F(ref, 1);
+		fused = nlop_del_out_F(fused, 1);
+	}
+
+	ok = ok && compare_nlops(ref, fused, true, true, true, UT_TOL);
+
+	for (int i = 0; i < OO + II; i++) {
+
+		if (i >= OO)
+			md_free(args1[i]);
+		else {
+
+			md_free(args1[i]);
+			md_free(args2[i]);
+		}
+	}
+
+	nlop_free(ref);
+	nlop_free(fused);
+
+	return ok;
+}
+
+static bool test_conv_fused(void)
+{
+	bool ok = true;
+
+	ok = ok && test_conv_fused_generic(false, true, ACT_RELU, PAD_VALID);
+	ok = ok && test_conv_fused_generic(true, true, ACT_RELU, PAD_SAME);
+	ok = ok && test_conv_fused_generic(true, false, ACT_LRELU, PAD_SAME);
+	ok = ok && test_conv_fused_generic(false, false, ACT_LIN, PAD_SAME);
+
+	UT_RETURN_ASSERT(ok);
+}
+
+
+UT_REGISTER_TEST(test_conv_fused);
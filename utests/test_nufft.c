@@ -7,6 +7,7 @@
  */
 
 #include <complex.h>
+#include <math.h>
 #include <assert.h>
 
 #include "num/multind.h"
@@ -251,6 +252,59 @@ static bool test_nufft_basis_toeplitz(void)
 
 
 
+static bool test_nufft_update_spokes(void)
+{
+	enum { S = 8 };
+
+	long ksp3_dims[N] = { 1, 4, S, 1, 1, 1, 1, 1 };
+	long trj3_dims[N] = { 3, 4, S, 1, 1, 1, 1, 1 };
+
+	complex float traj1[S][4][3];
+	complex float traj2[S][4][3];
+	complex float weights[S][4];
+
+	for (int s = 0; s < S; s++) {
+
+		for (int r = 0; r < 4; r++) {
+
+			traj1[s][r][0] = (r - 2) * cosf(s * 0.4);
+			traj1[s][r][1] = (r - 2) * sinf(s * 0.4);
+			traj1[s][r][2] = 0.;
+
+			for (int i = 0; i < 3; i++)
+				traj2[s][r][i] = traj1[s][r][i] + (((2 > i) && (2 == s % 5)) ? 0.3 : 0.);
+
+			weights[s][r] = 0.5 + 0.1 * r + 0.05 * s;
+		}
+	}
+
+	struct nufft_conf_s conf = nufft_conf_defaults;
+	conf.toeplitz = true;
+
+	struct linop_s* op1 = nufft_create2(N, ksp3_dims, cim_dims, trj3_dims, &traj1[0][0][0], ksp3_dims, &weights[0][0], NULL, NULL, conf);
+
+	// two of eight spokes change: incremental PSF update
+
+	nufft_update_traj(op1, N, trj3_dims, &traj2[0][0][0], ksp3_dims, &weights[0][0], NULL, NULL);
+
+	struct linop_s* op2 = nufft_create2(N, ksp3_dims, cim_dims, trj3_dims, &traj2[0][0][0], ksp3_dims, &weights[0][0], NULL, NULL, conf);
+
+	complex float src[64];
+	complex float dst1[64];
+	complex float dst2[64];
+
+	md_gaussian_rand(N, cim_dims, src);
+
+	linop_normal(op1, N, cim_dims, dst1, src);
+	linop_normal(op2, N, cim_dims, dst2, src);
+
+	linop_free(op1);
+	linop_free(op2);
+
+	return md_znrmse(N, cim_dims, dst1, dst2) < 1.E-5;
+}
+
+
 UT_REGISTER_TEST(test_nufft_forward);
 UT_REGISTER_TEST(test_nufft_adjoint);
 UT_REGISTER_TEST(test_nufft_normal);
@@ -262,3 +316,4 @@ UT_REGISTER_TEST(test_nufft_basis_normal);
 UT_REGISTER_TEST(test_nufft_basis_toeplitz);
 
 
+UT_REGISTER_TEST(test_nufft_update_spokes);
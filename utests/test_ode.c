@@ -206,3 +206,53 @@ static bool test_ode_matrix_adjoint(void)
 
 UT_REGISTER_TEST(test_ode_matrix_adjoint);
 
+
+
+static bool test_ode_batch(void)
+{
+	enum { W = 5 };
+
+	float om[W] = { 0., 1., 2., 4., 8. };
+	float r[W] = { 0.1, 0.5, 1., 2., 3. };
+
+	// damped oscillators with different parameters per lane
+
+	float x[2][W];
+
+	for (int w = 0; w < W; w++) {
+
+		x[0][w] = 1.;
+		x[1][w] = 0.;
+	}
+
+	float h = 0.1;
+	float tol = 1.E-5;
+
+	const float* omp = om;	// clang workaround
+	const float* rp = r;
+
+	NESTED(void, sys, (float* out, float t, const float* in))
+	{
+		(void)t;
+
+		for (int w = 0; w < W; w++) {
+
+			out[0 * W + w] = -rp[w] * in[0 * W + w] + omp[w] * in[1 * W + w];
+			out[1 * W + w] = -omp[w] * in[0 * W + w] - rp[w] * in[1 * W + w];
+		}
+	};
+
+	ode_interval_batch(h, tol, 2, W, x, 0., 1., sys);
+
+	for (int w = 0; w < W; w++) {
+
+		float ref[2] = { expf(-r[w]) * cosf(om[w]), -expf(-r[w]) * sinf(om[w]) };
+
+		if (1.E-4 < fabsf(x[0][w] - ref[0]) + fabsf(x[1][w] - ref[1]))
+			return false;
+	}
+
+	return true;
+}
+
+UT_REGISTER_TEST(test_ode_batch);
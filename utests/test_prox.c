@@ -274,3 +274,36 @@ static bool test_nonneg_stack(void)
 }
 
 UT_REGISTER_TEST(test_nonneg_stack);
+
+
+
+static bool test_thresh_joint(void)
+{
+	enum { N = 4 };
+	long dims[N] = { 7, 3, 5, 2 };
+	unsigned long flags = MD_BIT(1) | MD_BIT(3);
+
+	complex float* src = md_alloc(N, dims, CFL_SIZE);
+	complex float* dst = md_alloc(N, dims, CFL_SIZE);
+	complex float* ref = md_alloc(N, dims, CFL_SIZE);
+
+	md_gaussian_rand(N, dims, src);
+
+	md_zsoftthresh(N, dims, 0.5 * 1.5, flags, ref, src);
+
+	auto p = prox_thresh_create(N, dims, 1.5, flags);
+
+	operator_p_apply(p, 0.5, N, dims, dst, N, dims, src);
+
+	operator_p_free(p);
+
+	float err = md_znrmse(N, dims, ref, dst);
+
+	md_free(src);
+	md_free(dst);
+	md_free(ref);
+
+	UT_RETURN_ASSERT(err < 1.E-6);
+}
+
+UT_REGISTER_TEST(test_thresh_joint);